@@ -14,7 +14,7 @@ block layout :
 |             Data Section             |              Offset Section             |              Extra |
 ----------------------------------------------------------------------------------------------------------------------------
 | Entry #1 | Entry #2 | ... | Entry #N | Offset #1 | Offset #2 | ... | Offset #N | num_of_elements(2B) |
-hash(optional)(4B) |
+crc32c(optional)(4B) |
 ----------------------------------------------------------------------------------------------------------------------------
 -----------------------------------------------------------------------
 |                           Entry #1                            | ... |
@@ -48,11 +48,18 @@ class Block : public std::enable_shared_from_this<Block> {
   Block() = default;
   explicit Block(size_t capacity) : capacity_(capacity) {}
   std::vector<uint8_t> Encode();
-  static std::shared_ptr<Block> Decode(const std::vector<uint8_t> &encoded, bool with_hashi = false);
+  // with_hash: the encoded data ends with its crc32c, which is verified if verify_checksum
+  static std::shared_ptr<Block> Decode(const std::vector<uint8_t> &encoded, bool with_hash = false,
+                                       bool verify_checksum = true);
   size_t GetOffsetAt(size_t index) const;
   size_t GetCurSize() const { return data_.size() + offsets_.size() * sizeof(uint16_t) + sizeof(uint16_t); }
+  // bytes the block holds in memory
+  size_t MemoryUsage() const { return sizeof(Block) + data_.capacity() + offsets_.capacity() * sizeof(uint16_t); }
   bool AddEntry(const std::string &key, const std::string &value);
   std::optional<size_t> FindEntryIdx(const std::string &key) const;
+  // return the index of the first entry whose key is not less than key, or the number of entries
+  size_t LowerBoundIdx(const std::string &key) const;
+  size_t NumEntries() const { return offsets_.size(); }
   std::optional<std::string> FindValue(const std::string &key) const;
   bool IsEmpty() const { return offsets_.empty(); }
   std::string GetFirstKey() const;
@@ -1,9 +1,17 @@
+#pragma once
+
 #include <block/Block.h>
+#include <block/SecondaryCache.h>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <utility>
+#include <vector>
+
+/** Blocks of a higher priority are evicted after the ones of a lower priority, see BlockCache */
+enum class CachePriority { kLow = 0, kNormal = 1, kHigh = 2 };
+
 class CacheNode {
  private:
   int sst_id_;
@@ -11,20 +19,29 @@ class CacheNode {
   std::list<size_t> history_;
   size_t k_;  // k for lru_k algorithm
   std::shared_ptr<Block> block_;
+  CachePriority priority_;
+  size_t charge_ = 0;  // memory usage of the block
 
  public:
-  CacheNode(int sst_id, int block_id, int k) : sst_id_(sst_id), block_id_(block_id), k_(k) {}
+  CacheNode(int sst_id, int block_id, int k, CachePriority priority = CachePriority::kNormal)
+      : sst_id_(sst_id), block_id_(block_id), k_(k), priority_(priority) {}
   void AddTimeStamp(size_t time) {
     history_.push_back(time);
     if (history_.size() > k_) {
       history_.pop_front();
     }
   }
-  void SetBlock(std::shared_ptr<Block> block) { block_ = std::move(block); }
+  void SetBlock(std::shared_ptr<Block> block) {
+    charge_ = block->MemoryUsage();
+    block_ = std::move(block);
+  }
+  size_t GetCharge() const { return charge_; }
   std::shared_ptr<Block> GetBlock() { return block_; }
   int GetSSTId() { return sst_id_; }
   int GetBlockId() { return block_id_; }
   std::list<size_t> &GetHistory() { return history_; }
+  CachePriority GetPriority() const { return priority_; }
+  void SetPriority(CachePriority priority) { priority_ = priority; }
 };
 
 struct PairHash {
@@ -43,25 +60,71 @@ struct PairEqual {
   }
 };
 
+/** BlockCache is an LRU-K cache of the decoded blocks, shared by all the SSTs.
+ * Each priority keeps its own cold and hot lists. A priority may reserve a fraction of the capacity:
+ * eviction picks the lowest priority holding more blocks than its reserve, so e.g. the index partitions
+ * (high) survive a scan inserting its blocks as low. Pinned blocks are never evicted and do not count
+ * towards the capacity, they are kept until every SST object of their id which took a pin reference releases it.
+ * The capacity is a number of blocks, a byte limit can be set on top of it, e.g. by the WriteBufferManager.
+ * With a SecondaryCache set, the evicted blocks which are not low priority are offered to it
+ * after the lock is released */
 class BlockCache {
  private:
+  static constexpr size_t kNumPriorities = 3;
+
   size_t capacity_;
   size_t k_;
   size_t timestamp_;
+  size_t max_bytes_;    // the unpinned blocks are evicted to stay within it
+  size_t usage_bytes_;  // memory of the cached blocks, pinned ones included
+  size_t reserved_[kNumPriorities];  // blocks of each priority protected from eviction
+  double reserved_ratios_[kNumPriorities];  // reserved_ as fractions of the capacity
   mutable std::mutex mutex_;
   std::unordered_map<std::pair<int, int>, std::list<CacheNode>::iterator, PairHash, PairEqual> cache_map_;
-  std::list<CacheNode> cold_list_;  // store CacheNode access less than k times
-  std::list<CacheNode> hot_list_;   // store CacheNode access equal to or more than k times
+  std::list<CacheNode> cold_lists_[kNumPriorities];  // store CacheNode access less than k times
+  std::list<CacheNode> hot_lists_[kNumPriorities];   // store CacheNode access equal to or more than k times
+  std::unordered_map<std::pair<int, int>, std::shared_ptr<Block>, PairHash, PairEqual> pinned_map_;
+  // pin references of each SST id, e.g. a table opened twice by racing readers holds two
+  std::unordered_map<int, size_t> pin_refs_;
+  std::shared_ptr<SecondaryCache> secondary_cache_;
+  std::vector<CacheNode> demoted_;  // evicted blocks waiting to be offered to secondary_cache_
   mutable size_t total_requests_;
   mutable size_t hit_requests_;
-  void Evict();
+  // make room for a block of the incoming priority, kNumPriorities when there is no incoming block
+  void Evict(size_t incoming);
+  void EvictFrom(size_t priority);
   void RecordAccess(std::list<CacheNode>::iterator it);
+  void InternalPut(int sst_id, int block_id, std::shared_ptr<Block> block, CachePriority priority, bool pinned);
+  void Insert(int sst_id, int block_id, std::shared_ptr<Block> block, CachePriority priority);
+  // offer the evicted blocks to the secondary cache, caller should not hold mutex_
+  void Demote();
+  size_t InternalUsage(size_t priority) const;
 
  public:
-  BlockCache(size_t capacity, size_t k)
-      : capacity_(capacity), k_(k), timestamp_(0), total_requests_(0), hit_requests_(0) {}
+  // high_pri_ratio and low_pri_ratio are the fractions of the capacity reserved for the high and low priority
+  // blocks, throws if they add up to more than 1
+  BlockCache(size_t capacity, size_t k, double high_pri_ratio = 0, double low_pri_ratio = 0);
   ~BlockCache() = default;
   std::shared_ptr<Block> Get(int sst_id, int block_id);
-  void Put(int sst_id, int block_id, std::shared_ptr<Block> block);
+  // a block already cached keeps its place, it is only raised to a higher priority or pinned
+  void Put(int sst_id, int block_id, std::shared_ptr<Block> block, CachePriority priority = CachePriority::kNormal,
+           bool pinned = false);
+  // take a pin reference on the blocks of the SST, released by Unpin()
+  void Pin(int sst_id);
+  // release a pin reference, the pinned blocks of the SST are released with the last one, or when it took none.
+  // They stay cached as high priority blocks
+  void Unpin(int sst_id);
+  void SetSecondaryCache(std::shared_ptr<SecondaryCache> secondary_cache);
+  // nullptr if there is no secondary cache
+  std::shared_ptr<SecondaryCache> GetSecondaryCache() const;
+  // evict blocks until the cache holds at most max_bytes, the pinned blocks cannot be evicted
+  void SetMaxBytes(size_t max_bytes);
+  // the reserves of the priorities keep their fraction of the capacity, blocks are evicted to fit in it
+  void SetCapacity(size_t capacity);
+  size_t GetCapacity() const;
+  size_t GetUsageBytes() const;
   double GetHitRate() const;
-};
\ No newline at end of file
+  // number of unpinned blocks of the priority
+  size_t GetUsage(CachePriority priority) const;
+  size_t GetPinnedCount() const;
+};
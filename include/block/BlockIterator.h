@@ -27,8 +27,14 @@ class BlockIterator {
   value_type *operator->() const;
   BlockIterator &operator++();
   BlockIterator operator++(int) = delete;
+  // step back through the offset array, stepping back from the first entry makes the iterator end,
+  // stepping back from the end reaches the last entry
+  BlockIterator &operator--();
+  BlockIterator operator--(int) = delete;
   bool operator==(const BlockIterator &other) const;
   bool operator!=(const BlockIterator &other) const;
   value_type &operator*() const;
-  bool IsEnd();
+  bool IsEnd() const;
+  // positioned at the last entry of the block, the next step ends the iterator
+  bool IsLast() const;
 };
\ No newline at end of file
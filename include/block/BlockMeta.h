@@ -9,7 +9,7 @@
 
  * Meta Section layout:
  * --------------------------------------------------------------------------------------------------------------
- * | num_entries (32) | MetaEntry | ... | MetaEntry | Hash (32) |
+ * | num_entries (32) | MetaEntry | ... | MetaEntry | crc32c (32) |
  * --------------------------------------------------------------------------------------------------------------
 
  * MetaEntry layout:
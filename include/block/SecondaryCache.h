@@ -0,0 +1,73 @@
+#pragma once
+
+#include <block/Block.h>
+#include <utils/Macro.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** SecondaryCache is the on-disk tier behind the BlockCache, meant for a local disk faster than the SST volumes.
+ * Blocks evicted from memory are compressed with zlib and appended to a single cache file used as a ring of
+ * capacity bytes, the oldest records are overwritten when it wraps around. The index of the file is kept in memory,
+ * the file is truncated when the cache is opened.
+ * Admission: a block is written the second time it is evicted, so blocks read once (e.g. by a scan) are only
+ * remembered in a bounded list of keys and never reach the disk */
+class SecondaryCache {
+ private:
+  using Key = std::pair<int, int>;  // sst id and block id
+  struct KeyHash {
+    size_t operator()(const Key &key) const {
+      return std::hash<int>{}(key.first) ^ (std::hash<int>{}(key.second) * 31);
+    }
+  };
+  struct Handle {
+    size_t offset_;
+    size_t size_;   // size of the whole record
+    bool written_;  // false while the record is written, the range is reserved but not readable yet
+  };
+
+  std::string path_;
+  int fd_ = -1;
+  size_t capacity_;
+  mutable std::mutex mutex_;
+  size_t write_offset_ = 0;
+  std::unordered_map<Key, Handle, KeyHash> index_;
+  std::map<size_t, Key> records_;  // offset to key of the indexed or reserved records, to drop the overwritten ones
+  // keys evicted once, oldest first
+  std::list<Key> admission_list_;
+  std::unordered_map<Key, std::list<Key>::iterator, KeyHash> admission_map_;
+  size_t admission_capacity_;
+  mutable size_t total_requests_ = 0;
+  mutable size_t hit_requests_ = 0;
+
+ private:
+  // reserve size bytes of the file and drop the records it overlaps, caller should hold mutex_
+  size_t Allocate(size_t size);
+  // whether the key was evicted before, otherwise remember it, caller should hold mutex_
+  bool Admit(const Key &key);
+
+ public:
+  // admission_entries bounds the number of keys remembered by the admission policy
+  SecondaryCache(std::string path, size_t capacity, size_t admission_entries = SECONDARY_CACHE_ADMISSION_ENTRIES);
+  ~SecondaryCache();
+  SecondaryCache(const SecondaryCache &) = delete;
+  SecondaryCache &operator=(const SecondaryCache &) = delete;
+
+  // offer a block evicted from the BlockCache, returns whether it was written
+  bool Insert(int sst_id, int block_id, const std::shared_ptr<Block> &block);
+  // nullptr if the block is not cached, or its record was overwritten or is corrupted
+  std::shared_ptr<Block> Lookup(int sst_id, int block_id);
+  // forget the blocks of an SST, e.g. once its file is removed
+  void Erase(int sst_id);
+
+  size_t GetCapacity() const { return capacity_; }
+  size_t Size() const;  // number of cached blocks
+  double GetHitRate() const;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <lsm/ColumnFamily.h>
+#include <lsm/MergeIterator.h>
+#include <sst/AsyncBlockReader.h>
+#include <sst/SSTIterator.h>
+#include <utils/Options.h>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+class LSMEngine;
+
+/** Awaitables of the coroutine API of LSMEngine, e.g. co_await engine.GetAsync(key).
+ * A coroutine suspends only when blocks it needs are not in the block cache, the blocks are read by
+ * the AsyncBlockReader and the coroutine resumes on its completion thread.
+ * Lookups served by the memtable or the block cache complete inline.
+ * The awaitables refer to the engine, they must be awaited before the engine is destroyed */
+
+// suspend until the blocks are in the block cache, does not suspend when all of them are cached.
+// A coroutine suspended for a read resumes on the thread which completes it
+class BlockReadAwaitable {
+ private:
+  struct State {
+    std::atomic<size_t> remaining_;
+    std::mutex mutex_;
+    std::exception_ptr error_;  // the first error of the reads
+  };
+
+  AsyncBlockReader *reader_ = nullptr;
+  std::vector<BlockReadRequest> requests_;
+  ReadOptions options_;
+  std::shared_ptr<State> state_;
+
+ public:
+  BlockReadAwaitable() = default;
+  BlockReadAwaitable(AsyncBlockReader *reader, std::vector<BlockReadRequest> requests, const ReadOptions &options);
+
+  bool await_ready() const noexcept { return requests_.empty(); }
+  bool await_suspend(std::coroutine_handle<> handle);
+  void await_resume();
+};
+
+// result of co_await LSMEngine::GetAsync()
+class GetAwaitable {
+ private:
+  LSMEngine *engine_;
+  ColumnFamily *cf_;
+  std::string key_;
+  ReadOptions options_;
+  bool in_memtable_ = false;  // resolved by the memtable
+  std::optional<ColumnFamily::Lookup> lookup_;
+  std::vector<std::shared_ptr<SST>> ssts_;  // taken with the memtable, the lookup reads them once resumed
+  BlockReadAwaitable reads_;
+
+ public:
+  GetAwaitable(LSMEngine *engine, ColumnFamily *cf, std::string key, const ReadOptions &options);
+
+  bool await_ready();
+  bool await_suspend(std::coroutine_handle<> handle) { return reads_.await_suspend(handle); }
+  std::optional<std::string> await_resume();
+};
+
+class AsyncLSMIterator;
+
+// result of co_await AsyncLSMIterator::Next()
+class NextAwaitable {
+ private:
+  AsyncLSMIterator *iter_;
+  BlockReadAwaitable reads_;
+
+ public:
+  explicit NextAwaitable(AsyncLSMIterator *iter) : iter_(iter) {}
+
+  bool await_ready();
+  bool await_suspend(std::coroutine_handle<> handle) { return reads_.await_suspend(handle); }
+  void await_resume();
+};
+
+/** AsyncLSMIterator iterates forward like MergeIterator, but moving to the next key is awaited:
+ * the next block of each SST is read asynchronously as soon as the iterator enters the current one,
+ * a step into a block still being read waits for it.
+ * It must not outlive the LSMEngine which created it */
+class AsyncLSMIterator {
+  friend class NextAwaitable;
+  using value_type = std::pair<std::string, std::string>;
+
+ private:
+  AsyncBlockReader *reader_;
+  MergeIterator iter_;
+  std::vector<SSTIterator *> sst_iters_;  // the SST children of iter_, owned by it
+  std::vector<size_t> prefetched_;        // the block last prefetched for each of sst_iters_
+  ReadOptions options_;
+
+ public:
+  AsyncLSMIterator(AsyncBlockReader *reader, MergeIterator iter, std::vector<SSTIterator *> sst_iters,
+                   const ReadOptions &options);
+  AsyncLSMIterator(const AsyncLSMIterator &) = delete;
+  AsyncLSMIterator &operator=(const AsyncLSMIterator &) = delete;
+  AsyncLSMIterator(AsyncLSMIterator &&) = default;
+  AsyncLSMIterator &operator=(AsyncLSMIterator &&) = default;
+
+  bool IsEnd() const { return iter_.IsEnd(); }
+  value_type operator*() const { return *iter_; }
+  value_type *operator->() const { return iter_.operator->(); }
+  // co_await it.Next() moves to the next key
+  NextAwaitable Next() { return NextAwaitable(this); }
+};
+
+// result of co_await LSMEngine::ScanAsync()
+class ScanAwaitable {
+ private:
+  LSMEngine *engine_;
+  ColumnFamily *cf_;
+  std::string key_;
+  ReadOptions options_;
+  BlockReadAwaitable reads_;
+
+ public:
+  ScanAwaitable(LSMEngine *engine, ColumnFamily *cf, std::string key, const ReadOptions &options);
+
+  bool await_ready();
+  bool await_suspend(std::coroutine_handle<> handle) { return reads_.await_suspend(handle); }
+  AsyncLSMIterator await_resume();
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <lsm/WriteController.h>
+#include <memoryTable/MemoryTable.h>
+#include <sst/BlobFile.h>
+#include <sst/TableCache.h>
+#include <utils/Options.h>
+#include <functional>
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+/** ColumnFamily is a logical dataset inside one LSMEngine, with its own memtable, SSTs and options.
+ * The column families of an engine share its block cache, async reader and memory budget.
+ * SST ids are unique across the column families, so their blocks never collide in the shared block cache.
+ * The default column family keeps its SSTs in the data directory, the others in data_dir/cf_<name> */
+class ColumnFamily {
+  friend class LSMEngine;
+  friend class GetAwaitable;
+  friend class ScanAwaitable;
+
+ private:
+  std::string name_;
+  std::string dir_;
+  ColumnFamilyOptions options_;
+  MemoryTable memtable_;
+  std::list<size_t> l0_sst_ids_;             // SST ids of L0, the newest first
+  // rw-mutex to protect l0_sst_ids_ and l0_bytes_. A flush adds its SST and drops the flushed memtable under it,
+  // so the readers holding it from the memtable to taking the SSTs see every write once
+  std::shared_mutex mutex_;
+  size_t l0_bytes_;                          // size of the L0 SST files
+  std::shared_ptr<TableCache> table_cache_;  // SSTs are opened on demand through the table cache
+  // serializes the flushes, a compaction holds it to take its inputs and output id and to install the output,
+  // so that the SST ids follow the age of the data
+  std::mutex flush_mutex_;
+  // serializes the compactions and the changes of the options they read while merging, taken before flush_mutex_
+  std::mutex compaction_mutex_;
+  std::unique_ptr<TTLCompactionFilter> ttl_filter_;  // nullptr if options_.ttl is 0
+  // prefixes the keys of the column family in the row cache. A flush or compaction which changes values,
+  // i.e. runs filters, assigns a new id instead of erasing the cached rows one by one
+  std::atomic<uint32_t> row_cache_id_;
+  std::atomic<uint64_t> compaction_bytes_written_;
+  // the blob files by number. The map is replaced as a whole, so an iterator keeps reading the blob files
+  // that existed when it was created, even if a compaction deletes them meanwhile
+  using BlobFiles = std::map<uint64_t, std::shared_ptr<BlobFileReader>>;
+  std::shared_ptr<const BlobFiles> blob_files_;
+  mutable std::mutex blob_mutex_;  // protects the pointer blob_files_
+
+ private:
+  /** A stored value is the user value, prefixed by its type when the column family has a merge operator or blob
+   * files, followed by its write time when it has a TTL. An empty stored value is a deletion.
+   * The user value of kBlobIndex is an encoded BlobIndex */
+  enum class ValueType : char { kDeletion = 0, kValue = 1, kMerge = 2, kBlobIndex = 3 };
+
+  // ids of the files in dir named prefix followed by the id
+  static std::vector<size_t> ListFileIds(const std::string &dir, const std::string &prefix);
+  std::shared_ptr<SSTBuilder> NewSSTBuilder() const;
+  bool HasValueType() const { return options_.merge_operator != nullptr || options_.enable_blob_files; }
+  std::string Encode(ValueType type, const std::string &value, uint64_t write_time) const;
+  // returns the type of the stored value, the user value and write time are set for a value or a merge operand
+  ValueType Decode(const std::string &stored, std::string *value, uint64_t *write_time) const;
+  // the value stored for a put
+  std::string EncodeValue(const std::string &value) const;
+  // the value stored for a merge, existing is the value of the key in the active memtable if any.
+  // Successive merges are combined right away, so the memtable holds one entry per key
+  std::string EncodeMerge(const std::string &key, const std::optional<std::string> &existing,
+                          const std::string &operand) const;
+  bool UsesRowCache() const { return options_.row_cache && ttl_filter_ == nullptr; }
+  // whether flushes need to call FilterValue()
+  bool HasFilter() const { return ttl_filter_ != nullptr || options_.compaction_filter != nullptr; }
+  // the stored value a flush or compaction writes for a live entry, nullopt to remove it
+  std::optional<std::string> FilterValue(const std::string &key, const std::string &stored) const;
+  // the stored value a compaction writes for the versions of a key (the newest first), nullopt to drop it.
+  // A bottommost compaction sees every version, so the merge operands are resolved. Otherwise older SSTs may
+  // still hold the key: deletions are written as such, and the operands not preceded by a value are combined
+  // into one operand
+  std::optional<std::string> CompactVersions(const std::string &key, const std::vector<std::string> &versions,
+                                             bool bottommost = true) const;
+  // resolves the versions of the merge iterators, nullptr if the newest version is the value
+  std::function<std::optional<std::string>(const std::string &, const std::vector<std::string> &)> ValueReader()
+      const;
+  std::string GetBlobPath(uint64_t file_number) const;
+  std::shared_ptr<const BlobFiles> GetBlobFiles() const;
+  // register a finished blob file, before the SSTs referencing it are visible
+  void AddBlobFile(uint64_t file_number);
+  // delete blob files no SST references anymore
+  void RemoveBlobFiles(const std::vector<uint64_t> &file_numbers);
+  std::string ReadBlob(const std::string &encoded_index, const BlobFiles &blob_files) const;
+  // the stored value a flush or compaction writes with blob files: a large value is written to builder and
+  // replaced by its index, as is the value of an index into a blob file numbered below relocate_before.
+  // The blob files referenced by the result are added to referenced if set
+  std::string SeparateValue(const std::string &stored, BlobFileBuilder *builder, uint64_t relocate_before = 0,
+                            std::set<uint64_t> *referenced = nullptr) const;
+  // bytes the flushes and a compaction of L0 would have to write
+  size_t PendingBytes();
+  // how the backlog of the column family stalls the writes, see the triggers of ColumnFamilyOptions.
+  // severity is set to how far a slowdown is between its slowdown and stop triggers, in [0, 1)
+  WriteStall GetWriteStall(double *severity);
+
+ public:
+  // load the ids of the SSTs in dir, the SSTs themselves are opened lazily
+  ColumnFamily(std::string name, std::string dir, const ColumnFamilyOptions &options,
+               std::shared_ptr<TableCache> table_cache, uint32_t row_cache_id,
+               WriteBufferManager *write_buffer_manager = nullptr);
+  ColumnFamily(const ColumnFamily &) = delete;
+  ColumnFamily &operator=(const ColumnFamily &) = delete;
+
+  const std::string &GetName() const { return name_; }
+  const ColumnFamilyOptions &GetOptions() const { return options_; }
+  // bytes of the SSTs and blob files written by the compactions since the column family was opened
+  uint64_t GetCompactionBytesWritten() const { return compaction_bytes_written_; }
+  size_t GetBlobFileCount() const { return GetBlobFiles()->size(); }
+
+  // ids of the SST files in dir
+  static std::vector<size_t> ListSSTIds(const std::string &dir);
+  // numbers of the blob files in dir, they share the sequence of the SST ids
+  static std::vector<size_t> ListBlobFileNumbers(const std::string &dir);
+
+  /** Lookup resolves a key from its stored versions, added from the newest to the oldest.
+   * Merge operands are stacked until a value, a deletion or an expired entry is found.
+   * Blob indexes are read from blob_files, or from the blob files of the column family at that time if unset */
+  class Lookup {
+   private:
+    const ColumnFamily &cf_;
+    std::string key_;
+    std::vector<std::string> operands_;  // the newest first
+    std::optional<std::string> base_;
+    std::shared_ptr<const BlobFiles> blob_files_;
+
+   public:
+    Lookup(const ColumnFamily &cf, std::string key, std::shared_ptr<const BlobFiles> blob_files = nullptr)
+        : cf_(cf), key_(std::move(key)), blob_files_(std::move(blob_files)) {}
+    const std::string &GetKey() const { return key_; }
+    // returns true once the older versions do not matter anymore
+    bool Add(const std::string &stored);
+    // the value of the key, once Add() returned true or all the versions were added
+    std::optional<std::string> Finish() const;
+    // the operands added combined into one, the merge operator being associative. At least one should be added
+    std::string CombineOperands() const;
+  };
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <utils/Options.h>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+/** SortedRun is a sorted sequence of keys in a column family, i.e. one SST of L0 */
+struct SortedRun {
+  size_t sst_id_;
+  size_t size_;  // bytes of the SST file
+};
+
+enum class CompactionReason { kSizeAmplification, kSizeRatio, kRunCount };
+
+/** CompactionPick tells to merge the num_runs_ newest sorted runs */
+struct CompactionPick {
+  size_t num_runs_;
+  CompactionReason reason_;
+};
+
+/** UniversalCompactionPicker chooses the sorted runs a universal (tiered) compaction merges.
+ * Runs are only merged with runs of similar size, so a key is rewritten about once per size tier instead of
+ * on every compaction, trading read and space amplification for less write amplification.
+ * Once there are trigger runs, in order:
+ * 1. all the runs, when the runs newer than the oldest add up to max_size_amplification_percent of its size;
+ * 2. the runs picked from the newest run on, or else from the first run where at least min_merge_width of them
+ *    are, while the next run is at most size_ratio percent larger than the runs picked so far;
+ * 3. enough of the newest runs to get below trigger runs.
+ * The order of the SST ids is the age order of the runs when the column family is reopened, and the merge
+ * output gets the largest id: the merged runs always include the newest one, the runs newer than those picked
+ * by the size ratio are merged along. They are usually the smallest ones */
+class UniversalCompactionPicker {
+ private:
+  UniversalCompactionOptions options_;
+  size_t trigger_;
+
+ public:
+  UniversalCompactionPicker(const UniversalCompactionOptions &options, size_t trigger);
+
+  // runs are ordered from the newest to the oldest, nullopt when no compaction is needed
+  std::optional<CompactionPick> Pick(const std::vector<SortedRun> &runs) const;
+};
@@ -1,42 +1,257 @@
 #pragma once
 
+#include <lsm/Awaitable.h>
+#include <lsm/ColumnFamily.h>
+#include <lsm/CompactionPicker.h>
 #include <lsm/MergeIterator.h>
+#include <lsm/RowCache.h>
+#include <lsm/WriteBatch.h>
+#include <lsm/WriteAheadLog.h>
+#include <lsm/WriteController.h>
+#include <lsm/WriteQueue.h>
 #include <memoryTable/MemoryTable.h>
+#include <memoryTable/WriteBufferManager.h>
+#include <sst/AsyncBlockReader.h>
 #include <sst/SST.h>
 #include <sst/SSTIterator.h>
+#include <sst/TableCache.h>
+#include <utils/Options.h>
+#include <utils/PrefixExtractor.h>
+#include <atomic>
+#include <limits>
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 using SST_ID = size_t;
+constexpr SST_ID NO_SST = std::numeric_limits<SST_ID>::max();
+
+/** LSMEngine holds one or more column families, see ColumnFamily.
+ * The methods without a column family work on the default column family.
+ * Writes go through a WriteQueue to the write-ahead log in data_dir/wal, then to the memtables. Every entry gets
+ * a sequence number, and each column family records the last one its flushes wrote to SSTs: reopening the engine
+ * replays the logs from there, so a crash loses no write and applies none twice */
 class LSMEngine {
+  friend class GetAwaitable;
+  friend class ScanAwaitable;
+
  private:
   std::string data_dir_;  // directory to store SST files
-  MemoryTable memtable_;
-  std::list<size_t> l0_sst_ids_;                           // list of SST IDs in L0 level
-  std::unordered_map<SST_ID, std::shared_ptr<SST>> ssts_;  // map from SST ID to SST
-  std::shared_mutex mutex_;                                // rw-mutex to protect L0_sst_ids_ and ssts_
+  Options options_;       // the column family options in it are those the default column family was opened with
+  std::mutex options_mutex_;  // serializes SetDBOptions()
   std::shared_ptr<BlockCache> block_cache_;
+  std::shared_ptr<AsyncBlockReader> async_reader_;  // reads the candidate blocks of a lookup together
+  std::unique_ptr<RowCache> row_cache_;             // results of point lookups, see ColumnFamilyOptions::row_cache
+  std::atomic<SST_ID> next_sst_id_;                 // SST ids are unique across the column families
+  std::atomic<uint32_t> next_row_cache_id_;
+  std::unique_ptr<WriteBufferManager> write_buffer_manager_;  // the memtables of all the column families
+  std::unique_ptr<WriteController> write_controller_;         // stalls the writes by the backlog
+  // writes take it exclusively and point lookups shared, so a WriteBatch is seen as a whole
+  std::shared_mutex write_mutex_;
+  std::shared_mutex column_families_mutex_;  // rw-mutex to protect column_families_
+  std::map<std::string, std::unique_ptr<ColumnFamily>> column_families_;
+  ColumnFamily *default_column_family_;
+  std::string wal_dir_;  // the log files, and the last sequence number flushed by each column family
+  std::unique_ptr<WriteQueue> write_queue_;
+  // protects the fields of the log below. Creating and dropping a column family take it as well as
+  // column_families_mutex_, so either one is enough to read column_families_
+  std::mutex wal_mutex_;
+  std::unique_ptr<LogWriter> log_writer_;
+  uint64_t next_log_number_;
+  uint64_t log_last_sequence_;             // of the last entry written to the current log
+  std::map<uint64_t, uint64_t> old_logs_;  // number of the logs before the current one, to their last sequence
+  uint64_t first_log_number_;              // the logs numbered below were left by the previous run
+  // entries of those logs, with their sequence numbers, for the column families not open yet
+  std::map<std::string, std::vector<std::pair<uint64_t, LogRecord::Entry>>> pending_recovery_;
+  std::atomic<uint64_t> applied_sequence_;  // the writes up to it are in the memtables
+
+ private:
+  std::string ColumnFamilyDir(const std::string &name) const;
+  static std::string RowCacheKey(const ColumnFamily &cf, const std::string &key);
+  // called by the writers of key once the memtable is updated
+  void InvalidateRow(ColumnFamily &cf, const std::string &key);
+  std::string LogPath(uint64_t number) const;
+  std::string FlushedSequencePath(const std::string &name) const;
+  // the last sequence number the flushes of the column family wrote to SSTs, 0 if none.
+  // sst_id is set to the SST of the last flush, NO_SST if there is none
+  uint64_t ReadFlushedSequence(const std::string &name, SST_ID *sst_id = nullptr) const;
+  // durable once it returns
+  void WriteFlushedSequence(const std::string &name, uint64_t sequence, SST_ID sst_id = NO_SST);
+  std::string CompactionPath(const std::string &name) const;
+  // the compaction of the column family recorded by WriteCompaction() and not removed yet, false if none.
+  // output_id is NO_SST when the compaction wrote no SST
+  bool ReadCompaction(const std::string &name, SST_ID *output_id, std::vector<SST_ID> *input_ids) const;
+  // record that the complete output replaces the inputs, durable once it returns
+  void WriteCompaction(const std::string &name, SST_ID output_id, const std::vector<SST_ID> &input_ids);
+  // forget the compaction once its inputs are deleted, durable once it returns
+  void RemoveCompaction(const std::string &name);
+  // replace the file of the log directory with the data, durable once it returns
+  void WriteWalFile(const std::string &filename, const std::vector<uint64_t> &data);
+  // a flush or a compaction builds its SST under this name and renames it once it is recorded
+  static std::string TmpSSTPath(const std::string &sst_path);
+  // rename the SST left under its temporary name by a flush whose flushed sequence was written, or by a recorded
+  // compaction whose inputs are deleted then, delete those of the flushes and compactions which did not get that far
+  void RecoverTmpSSTs(const std::string &name, const TableCache &table_cache);
+  // read the logs of the previous run into old_logs_ and pending_recovery_, returns the last sequence number used
+  uint64_t RecoverLogs();
+  // the stages of write_queue_: write the batches of a group to the log, then apply them to the memtables
+  void WriteLog(const std::vector<WriteQueue::Writer *> &group);
+  void ApplyGroup(const std::vector<WriteQueue::Writer *> &group);
+  // apply one entry to the memtable of cf, caller should hold write_mutex_ or own cf alone
+  void ApplyEntry(ColumnFamily *cf, WriteBatch::EntryType type, const std::string &key, const std::string &value,
+                  uint64_t sequence);
+  // delete the old logs whose writes are all flushed
+  void DeleteObsoleteLogs();
+  // the lookup of Get() without the row cache
+  std::optional<std::string> GetUncached(ColumnFamily &cf, const std::string &key, const ReadOptions &options);
+  // search the SSTs only, from the newest to the oldest
+  // resolves the lookup with the SSTs of GetSSTs(), which has already been given the versions in the memtable.
+  // The methods taking cf below are called with cf.mutex_ held shared since the memtable was read
+  static std::optional<std::string> GetFromSST(const std::vector<std::shared_ptr<SST>> &ssts,
+                                               ColumnFamily::Lookup *lookup, const ReadOptions &options);
+  // the SSTs of cf from the newest to the oldest
+  std::vector<std::shared_ptr<SST>> GetSSTs(ColumnFamily &cf);
+  // the blocks which may hold the keys and are not in the block cache
+  std::vector<BlockReadRequest> CollectBlockReads(ColumnFamily &cf, const std::vector<std::string> &keys,
+                                                  const ReadOptions &options);
+  // the blocks a seek to key reads and are not in the block cache
+  std::vector<BlockReadRequest> CollectSeekReads(ColumnFamily &cf, const std::string &key,
+                                                 const ReadOptions &options);
+  // read the blocks of CollectBlockReads() concurrently, when there is more than one of them
+  void PrefetchBlocks(const std::vector<BlockReadRequest> &requests, const ReadOptions &options);
+  // merge all the memtables and SSTs, positioned at the first key not less than key, or at the first key
+  // SSTs rejected by sst_filter are left out of the merge, the SST children are returned in sst_iters if set
+  HeapIterator NewHeapIterator(ColumnFamily &cf, const std::optional<std::string> &key, const ReadOptions &options,
+                               const std::function<bool(const SST &)> &sst_filter = nullptr,
+                               std::vector<SSTIterator *> *sst_iters = nullptr);
+  // flush the largest memtable when the write buffer manager asks for it: when the memtables of all the column
+  // families allocate Options::db_write_buffer_size bytes, or reach the memory budget
+  void MaybeFlush();
+  // set the state of the write controller from the column families, caller should hold column_families_mutex_
+  void UpdateWriteStall();
+  // called by the writers before a write of bytes: sleeps while writes are delayed.
+  // Flushes and compactions run in the writers, so a stopped writer drains the backlog itself,
+  // the other writers wait for it on the flush mutex of the column family
+  void MaybeStallWrite(size_t bytes);
+  // flush and compact the column families past a stop trigger until they are below it
+  void DrainBacklog();
+  // flush the oldest memtable, returns whether an SST was written
+  bool FlushMemtable(ColumnFamily *cf);
+  // run the compactions the compaction style of the column family asks for after a flush
+  void MaybeCompact(ColumnFamily *cf);
+  // merge the sorted runs picked by UniversalCompactionPicker, until none is picked.
+  // Caller should hold the compaction mutex of the column family and flush_lock on its flush mutex
+  void CompactUniversal(ColumnFamily *cf, std::unique_lock<std::mutex> *flush_lock);
+  // delete the oldest SSTs past the size or the age limit of FifoCompactionOptions.
+  // Caller should hold the compaction and the flush mutex of the column family
+  void CompactFifo(ColumnFamily *cf);
+  // merge consecutive SSTs of L0 into one, bottommost if they include the oldest one.
+  // Caller should hold the compaction mutex of the column family and flush_lock on its flush mutex, which is
+  // released during the merge and held again on return
+  void CompactRuns(ColumnFamily *cf, std::unique_lock<std::mutex> *flush_lock, const std::vector<SST_ID> &input_ids,
+                   bool bottommost);
+  // delete the files of SSTs no longer in L0
+  void RemoveSSTFiles(ColumnFamily *cf, const std::vector<SST_ID> &sst_ids);
+  // the builder of the blob file of a flush or compaction, nullptr if the column family has no blob files
+  std::unique_ptr<BlobFileBuilder> NewBlobFileBuilder(ColumnFamily *cf);
 
  public:
-  explicit LSMEngine(std::string data_dir);
+  explicit LSMEngine(std::string data_dir, std::shared_ptr<const PrefixExtractor> prefix_extractor = nullptr);
+  LSMEngine(std::string data_dir, const ColumnFamilyOptions &default_options);
+  LSMEngine(std::string data_dir, const Options &options);
   ~LSMEngine();
 
-  std::optional<std::string> Get(const std::string &key);
-  void Put(const std::string &key, const std::string &value);
+  // create a column family, or open it if its directory already exists, throws if it is open already.
+  // Opening it replays its writes the log holds and its SSTs do not
+  ColumnFamily *CreateColumnFamily(const std::string &name, const ColumnFamilyOptions &options = ColumnFamilyOptions());
+  // nullptr if the column family is not open
+  ColumnFamily *GetColumnFamily(const std::string &name);
+  ColumnFamily *DefaultColumnFamily() { return default_column_family_; }
+  // remove the column family with all its SSTs, its pointer must not be used anymore
+  void DropColumnFamily(const std::string &name);
+  // change options of an open column family by name, e.g. {{"write_buffer_size", "8388608"}},
+  // see SetColumnFamilyOptions(). They apply from the next write, flush or compaction
+  void SetOptions(ColumnFamily *cf, const std::unordered_map<std::string, std::string> &values);
+  // change options of the engine by name, e.g. {{"block_cache_capacity", "4096"}}, see SetDBOptions()
+  void SetDBOptions(const std::unordered_map<std::string, std::string> &values);
+  // the current options, the column family options in it are those of the default column family
+  Options GetDBOptions();
+
+  // apply the whole batch atomically
+  void Write(const WriteBatch &batch, const WriteOptions &options = WriteOptions());
+
+  std::optional<std::string> Get(const std::string &key, const ReadOptions &options = ReadOptions());
+  std::optional<std::string> Get(ColumnFamily *cf, const std::string &key, const ReadOptions &options = ReadOptions());
+  // look up all the keys, the blocks they need are read concurrently, the result is in the order of keys
+  std::vector<std::optional<std::string>> MultiGet(const std::vector<std::string> &keys,
+                                                   const ReadOptions &options = ReadOptions());
+  std::vector<std::optional<std::string>> MultiGet(ColumnFamily *cf, const std::vector<std::string> &keys,
+                                                   const ReadOptions &options = ReadOptions());
+  // co_await GetAsync(key) suspends the coroutine while the blocks are read instead of blocking the thread
+  GetAwaitable GetAsync(const std::string &key, const ReadOptions &options = ReadOptions());
+  GetAwaitable GetAsync(ColumnFamily *cf, const std::string &key, const ReadOptions &options = ReadOptions());
+  // co_await ScanAsync(key) returns an iterator positioned at the first key not less than key,
+  // an empty key starts from the first key
+  ScanAwaitable ScanAsync(const std::string &key, const ReadOptions &options = ReadOptions());
+  ScanAwaitable ScanAsync(ColumnFamily *cf, const std::string &key, const ReadOptions &options = ReadOptions());
+  void Put(const std::string &key, const std::string &value, const WriteOptions &options = WriteOptions());
+  void Put(ColumnFamily *cf, const std::string &key, const std::string &value,
+           const WriteOptions &options = WriteOptions());
   // void PutBatch(const std::vector<std::pair<std::string, std::string>> &batch);
-  void Remove(const std::string &key);
+  void Remove(const std::string &key, const WriteOptions &options = WriteOptions());
+  void Remove(ColumnFamily *cf, const std::string &key, const WriteOptions &options = WriteOptions());
+  // combine operand with the value of key by the merge operator of the column family, without reading it.
+  // The operands are resolved lazily by reads, flushes and compactions
+  void Merge(const std::string &key, const std::string &operand, const WriteOptions &options = WriteOptions());
+  void Merge(ColumnFamily *cf, const std::string &key, const std::string &operand,
+             const WriteOptions &options = WriteOptions());
   // void RemoveBatch(const std::vector<std::string> &keys);
   // void Clear();
   void Flush();
+  // the flush is followed by the compactions the compaction style of the column family triggers
+  void Flush(ColumnFamily *cf);
+  // flush the memtables of all the column families
   void FlushAll();
+  // merge all the SSTs of the column family into one, dropping the deleted, overwritten, expired
+  // and filtered entries. Flushes of the column family wait for the compaction.
+  // With CompactionStyle::kFifo, the SSTs are not merged: only the ones past the retention limits are deleted
+  void Compact();
+  void Compact(ColumnFamily *cf);
 
   std::string GetSSTPath(SST_ID sst_id);
+  const RowCache &GetRowCache() const { return *row_cache_; }
+  // e.g. to set the memory budget, see WriteBufferManager
+  WriteBufferManager &GetWriteBufferManager() { return *write_buffer_manager_; }
+  // e.g. for the stall statistics, see WriteStallStats
+  WriteController &GetWriteController() { return *write_controller_; }
+  // e.g. for how the writes were grouped, see WriteQueueStats
+  WriteQueue &GetWriteQueue() { return *write_queue_; }
+  // put an on-disk tier behind the block cache, nullptr removes it
+  void SetSecondaryCache(std::shared_ptr<SecondaryCache> secondary_cache) {
+    block_cache_->SetSecondaryCache(std::move(secondary_cache));
+  }
 
-  MergeIterator Begin();
+  MergeIterator Begin(const ReadOptions &options = ReadOptions());
+  MergeIterator Begin(ColumnFamily *cf, const ReadOptions &options = ReadOptions());
   MergeIterator End();
+  // position at the first key which is not less than key
+  MergeIterator Seek(const std::string &key, const ReadOptions &options = ReadOptions());
+  MergeIterator Seek(ColumnFamily *cf, const std::string &key, const ReadOptions &options = ReadOptions());
+  // position at the last key, iterate backward with operator--
+  MergeIterator SeekToLast(const ReadOptions &options = ReadOptions());
+  MergeIterator SeekToLast(ColumnFamily *cf, const ReadOptions &options = ReadOptions());
+  // position at the last key which is not greater than key
+  MergeIterator SeekForPrev(const std::string &key, const ReadOptions &options = ReadOptions());
+  MergeIterator SeekForPrev(ColumnFamily *cf, const std::string &key, const ReadOptions &options = ReadOptions());
+  // iterate the keys starting with prefix, it is end when no key has the prefix
+  MergeIterator ScanPrefix(const std::string &prefix, const ReadOptions &options = ReadOptions());
+  MergeIterator ScanPrefix(ColumnFamily *cf, const std::string &prefix, const ReadOptions &options = ReadOptions());
 
   std::optional<std::pair<MergeIterator, MergeIterator>> LSMItersMonotonyPredicate(
       const std::function<int(const std::string &)> &predicate);
@@ -47,20 +262,63 @@ class LSM {
   LSMEngine engine_;
 
  public:
-  explicit LSM(std::string data_dir);
+  explicit LSM(std::string data_dir, std::shared_ptr<const PrefixExtractor> prefix_extractor = nullptr);
+  LSM(std::string data_dir, const ColumnFamilyOptions &default_options);
+  LSM(std::string data_dir, const Options &options);
   ~LSM();
 
-  std::optional<std::string> Get(const std::string &key);
-  void Put(const std::string &key, const std::string &value);
+  ColumnFamily *CreateColumnFamily(const std::string &name, const ColumnFamilyOptions &options = ColumnFamilyOptions());
+  ColumnFamily *GetColumnFamily(const std::string &name);
+  ColumnFamily *DefaultColumnFamily();
+  void DropColumnFamily(const std::string &name);
+  void Write(const WriteBatch &batch, const WriteOptions &options = WriteOptions());
+
+  std::optional<std::string> Get(const std::string &key, const ReadOptions &options = ReadOptions());
+  std::optional<std::string> Get(ColumnFamily *cf, const std::string &key, const ReadOptions &options = ReadOptions());
+  std::vector<std::optional<std::string>> MultiGet(const std::vector<std::string> &keys,
+                                                   const ReadOptions &options = ReadOptions());
+  std::vector<std::optional<std::string>> MultiGet(ColumnFamily *cf, const std::vector<std::string> &keys,
+                                                   const ReadOptions &options = ReadOptions());
+  GetAwaitable GetAsync(const std::string &key, const ReadOptions &options = ReadOptions());
+  GetAwaitable GetAsync(ColumnFamily *cf, const std::string &key, const ReadOptions &options = ReadOptions());
+  ScanAwaitable ScanAsync(const std::string &key, const ReadOptions &options = ReadOptions());
+  ScanAwaitable ScanAsync(ColumnFamily *cf, const std::string &key, const ReadOptions &options = ReadOptions());
+  void Put(const std::string &key, const std::string &value, const WriteOptions &options = WriteOptions());
+  void Put(ColumnFamily *cf, const std::string &key, const std::string &value,
+           const WriteOptions &options = WriteOptions());
   // void PutBatch(const std::vector<std::pair<std::string, std::string>> &batch);
-  void Remove(const std::string &key);
+  void Remove(const std::string &key, const WriteOptions &options = WriteOptions());
+  void Remove(ColumnFamily *cf, const std::string &key, const WriteOptions &options = WriteOptions());
+  void Merge(const std::string &key, const std::string &operand, const WriteOptions &options = WriteOptions());
+  void Merge(ColumnFamily *cf, const std::string &key, const std::string &operand,
+             const WriteOptions &options = WriteOptions());
   // void RemoveBatch(const std::vector<std::string> &keys);
 
   using LSMIterator = MergeIterator;
-  LSMIterator Begin();
+  LSMIterator Begin(const ReadOptions &options = ReadOptions());
+  LSMIterator Begin(ColumnFamily *cf, const ReadOptions &options = ReadOptions());
   LSMIterator End();
+  LSMIterator Seek(const std::string &key, const ReadOptions &options = ReadOptions());
+  LSMIterator Seek(ColumnFamily *cf, const std::string &key, const ReadOptions &options = ReadOptions());
+  LSMIterator SeekToLast(const ReadOptions &options = ReadOptions());
+  LSMIterator SeekToLast(ColumnFamily *cf, const ReadOptions &options = ReadOptions());
+  LSMIterator SeekForPrev(const std::string &key, const ReadOptions &options = ReadOptions());
+  LSMIterator SeekForPrev(ColumnFamily *cf, const std::string &key, const ReadOptions &options = ReadOptions());
+  LSMIterator ScanPrefix(const std::string &prefix, const ReadOptions &options = ReadOptions());
+  LSMIterator ScanPrefix(ColumnFamily *cf, const std::string &prefix, const ReadOptions &options = ReadOptions());
   void Flush();
+  void Flush(ColumnFamily *cf);
   void FlushAll();
+  void Compact();
+  void Compact(ColumnFamily *cf);
+  const RowCache &GetRowCache() const;
+  WriteBufferManager &GetWriteBufferManager();
+  WriteController &GetWriteController();
+  WriteQueue &GetWriteQueue();
+  void SetSecondaryCache(std::shared_ptr<SecondaryCache> secondary_cache);
+  void SetOptions(ColumnFamily *cf, const std::unordered_map<std::string, std::string> &values);
+  void SetDBOptions(const std::unordered_map<std::string, std::string> &values);
+  Options GetDBOptions();
   std::optional<std::pair<MergeIterator, MergeIterator>> LSMItersMonotonyPredicate(
       const std::function<int(const std::string &)> &predicate);
-};
\ No newline at end of file
+};
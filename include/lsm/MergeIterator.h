@@ -1,35 +1,40 @@
 #pragma once
 
 #include <memoryTable/HeapIterator.h>
+#include <functional>
 
 /** use MergeIterator to iterate LSMEngine
-    MergeIterator contains 2 HeapIterators
-    the mem_table_iter_ is constructed from memtable, which combines <key, value> pairs from Active SkipList and Frozen
-   SkipList
-    the sst_iter_ is constructed from All the SST we have
+    MergeIterator contains one HeapIterator whose children are the skiplists of the memtable (newest first)
+    followed by all the SSTs (newest first), so that a deletion in the memtable also hides the older values in SSTs.
+    The children are positioned lazily, Seek() repositions every child in O(log n) and rebuilds the heap.
+    An optional monotony predicate bounds the range: the iterator ends at the first key outside of it
+    (predicate(key) != 0), in both directions.
+    Moving backward switches the HeapIterator to a max-heap, see HeapIterator for the details
     */
 class MergeIterator {
   using value_type = std::pair<std::string, std::string>;
 
  private:
-  HeapIterator mem_table_iter_;
-  HeapIterator sst_iter_;
-  bool choose_mem_table_ = false;
-  mutable std::shared_ptr<value_type> current_value_;
-  void UpdateCurrent() const;
-  // choose which iterator to use
-  bool ChooseIter();
-  // Skip the key in sst_iter_ which is the same as the key in mem_table_iter_
-  void SkipSSTIter();
+  HeapIterator iter_;
+  std::function<int(const std::string &)> predicate_;
 
  public:
   MergeIterator() = default;
-  MergeIterator(const HeapIterator &mem_table_iter, const HeapIterator &sst_iter);
+  explicit MergeIterator(HeapIterator iter, std::function<int(const std::string &)> predicate = nullptr);
   bool IsEnd() const;
 
+  void SeekToFirst();
+  void SeekToLast();
+  // position at the first key which is not less than key
+  void Seek(const std::string &key);
+  // position at the last key which is not greater than key
+  void SeekForPrev(const std::string &key);
+
   value_type operator*() const;
   MergeIterator &operator++();
   MergeIterator operator++(int) = delete;
+  MergeIterator &operator--();
+  MergeIterator operator--(int) = delete;
   bool operator==(const MergeIterator &other) const;
   bool operator!=(const MergeIterator &other) const;
   value_type *operator->() const;
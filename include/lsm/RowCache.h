@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** RowCache caches the results of point lookups, key -> value or key -> absent, so that a hot key is
+ * served with one hash lookup instead of searching the memtable and the SSTs.
+ * It is sized in bytes and split into shards, each with its own lock and LRU list.
+ * Writers Erase() the key after updating the memtable. A lookup reads the generation of the key's shard
+ * before it starts, its result is only inserted if no Erase() happened in the shard meanwhile,
+ * so a result computed before a write never overrides the write */
+class RowCache {
+ private:
+  struct Entry {
+    std::string key_;
+    std::optional<std::string> value_;
+    size_t charge_;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_list_;  // front is the most recently used entry
+    std::unordered_map<std::string, std::list<Entry>::iterator> map_;
+    size_t usage_ = 0;
+    uint64_t generation_ = 0;  // incremented by every Erase()
+  };
+
+  std::atomic<size_t> capacity_;
+  std::atomic<size_t> shard_capacity_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<size_t> total_requests_;
+  std::atomic<size_t> hit_requests_;
+
+ private:
+  Shard &GetShard(const std::string &key) const;
+  // caller should hold the mutex of the shard
+  void EraseEntry(Shard &shard, std::list<Entry>::iterator it);
+
+ public:
+  explicit RowCache(size_t capacity, size_t num_shards);
+
+  // nullopt on a miss, a cached absent key is an empty inner optional
+  std::optional<std::optional<std::string>> Get(const std::string &key);
+  // read it before the lookup whose result is inserted
+  uint64_t GetGeneration(const std::string &key) const;
+  // insert the result of a lookup which started at generation, unless the key was erased since then
+  void Insert(const std::string &key, const std::optional<std::string> &value, uint64_t generation);
+  void Erase(const std::string &key);
+
+  size_t GetCapacity() const { return capacity_; }
+  // the least recently used entries are evicted to fit in the new capacity
+  void SetCapacity(size_t capacity);
+  size_t GetUsage() const;
+  double GetHitRate() const;
+};
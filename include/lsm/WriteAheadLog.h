@@ -0,0 +1,67 @@
+#pragma once
+
+#include <lsm/WriteBatch.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** LogRecord is a WriteBatch as written to the write-ahead log, with the names of its column families.
+ * Its entries take the consecutive sequence numbers from sequence_.
+ * Encoded as | sequence (64) | count (32) | entries |, an entry as
+ * | type (8) | name size (32) | name | key size (32) | key | value size (32) | value | */
+struct LogRecord {
+  struct Entry {
+    WriteBatch::EntryType type_;
+    std::string column_family_;
+    std::string key_;
+    std::string value_;
+  };
+
+  uint64_t sequence_ = 0;
+  std::vector<Entry> entries_;
+
+  std::string Encode() const;
+  // throws std::runtime_error if payload is not a record
+  static LogRecord Decode(const std::string &payload);
+};
+
+/** LogWriter appends records to a new log file, the log files are numbered in the order they are created.
+ * Record layout: | crc32c of the payload (32) | payload size (32) | payload |. Not thread-safe */
+class LogWriter {
+ private:
+  std::string path_;
+  uint64_t number_;
+  int fd_;
+  uint64_t size_;
+
+ public:
+  // throws std::runtime_error if the file cannot be created
+  LogWriter(std::string path, uint64_t number);
+  ~LogWriter();
+  LogWriter(const LogWriter &) = delete;
+  LogWriter &operator=(const LogWriter &) = delete;
+
+  // append the records with one write, they are in the page cache once it returns
+  void Append(const std::vector<std::string> &payloads);
+  // make the records appended so far durable
+  void Sync();
+
+  uint64_t GetNumber() const { return number_; }
+  uint64_t GetSize() const { return size_; }
+};
+
+/** LogReader reads the records of a log file in order. A record cut or corrupted by a crash ends the log,
+ * together with everything after it */
+class LogReader {
+ private:
+  std::string data_;
+  size_t offset_;
+
+ public:
+  // throws std::runtime_error if the file cannot be read
+  explicit LogReader(const std::string &path);
+
+  // false at the end of the log
+  bool ReadRecord(std::string *payload);
+};
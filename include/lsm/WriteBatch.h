@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class ColumnFamily;
+
+/** WriteBatch collects puts, removes and merges, possibly of several column families,
+ * LSMEngine::Write() applies them atomically: point lookups see either all of the batch or none of it,
+ * and recovery from the write-ahead log replays all of it or none of it.
+ * A nullptr column family is the default one */
+class WriteBatch {
+ public:
+  enum class EntryType { kPut, kRemove, kMerge };
+
+  struct Entry {
+    EntryType type_;
+    ColumnFamily *column_family_;
+    std::string key_;
+    std::string value_;  // the merge operand of a merge, empty for a remove
+  };
+
+ private:
+  std::vector<Entry> entries_;
+  size_t data_size_ = 0;
+
+ public:
+  void Put(const std::string &key, const std::string &value) { Put(nullptr, key, value); }
+  void Put(ColumnFamily *column_family, const std::string &key, const std::string &value);
+  void Remove(const std::string &key) { Remove(nullptr, key); }
+  void Remove(ColumnFamily *column_family, const std::string &key);
+  void Merge(const std::string &key, const std::string &operand) { Merge(nullptr, key, operand); }
+  void Merge(ColumnFamily *column_family, const std::string &key, const std::string &operand);
+  void Clear() {
+    entries_.clear();
+    data_size_ = 0;
+  }
+
+  size_t Count() const { return entries_.size(); }
+  // bytes of the keys and values of the entries
+  size_t GetDataSize() const { return data_size_; }
+  // in the order they were added, a later entry of a key overrides the earlier ones
+  const std::vector<Entry> &GetEntries() const { return entries_; }
+};
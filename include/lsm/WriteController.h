@@ -0,0 +1,52 @@
+#pragma once
+
+#include <utils/Macro.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+enum class WriteStall { kNone = 0, kDelayed = 1, kStopped = 2 };
+
+/** WriteStallStats are the stalls the writers went through since the engine was opened */
+struct WriteStallStats {
+  uint64_t delayed_writes = 0;  // writes which slept because of a slowdown
+  uint64_t delay_micros = 0;
+  uint64_t stopped_writes = 0;  // writes which waited for the backlog to be drained
+  uint64_t stop_micros = 0;
+};
+
+/** WriteController paces the writers of an engine by the backlog of its column families,
+ * see the slowdown and stop triggers of ColumnFamilyOptions.
+ * Past a slowdown trigger the writes are spaced to a rate falling from delayed_write_rate bytes per second
+ * at the trigger down to a tenth of it at the stop trigger (the severity goes from 0 to 1), so that latency
+ * degrades gradually. Writers are only put to sleep once they are at least LSM_MIN_WRITE_DELAY_MICROS ahead
+ * of the rate, smaller delays are carried over to the following writes. Past a stop trigger writes wait */
+class WriteController {
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  mutable std::mutex mutex_;
+  uint64_t delayed_write_rate_;
+  WriteStall state_;
+  double severity_;
+  Clock::time_point next_write_time_;  // when the rate allows the next write to start
+  WriteStallStats stats_;
+
+ public:
+  explicit WriteController(uint64_t delayed_write_rate = LSM_DELAYED_WRITE_RATE);
+
+  // severity is how far the worst backlog is between its slowdown and stop triggers, in [0, 1)
+  void SetState(WriteStall state, double severity = 0);
+  WriteStall GetState() const;
+  uint64_t GetDelayedWriteRate() const;
+  void SetDelayedWriteRate(uint64_t delayed_write_rate);
+  // the current rate of delayed writes in bytes per second
+  uint64_t GetCurrentRate() const;
+  // reserve the time to write bytes, returns the microseconds the writer should sleep first
+  uint64_t GetDelay(size_t bytes);
+
+  void RecordDelay(uint64_t micros);
+  void RecordStop(uint64_t micros);
+  WriteStallStats GetStats() const;
+};
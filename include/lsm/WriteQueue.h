@@ -0,0 +1,63 @@
+#pragma once
+
+#include <lsm/WriteBatch.h>
+#include <utils/Options.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/** WriteQueueStats count the writes through a WriteQueue since it was created */
+struct WriteQueueStats {
+  uint64_t writes = 0;  // batches written
+  uint64_t groups = 0;  // groups they were written in, a group has one log write and at most one sync
+};
+
+/** WriteQueue pipelines the writers of an engine in two stages: the log stage writes the batches to the
+ * write-ahead log, the memtable stage inserts them into the memtables.
+ * The first writer waiting for the log stage is the leader: it takes the batches queued behind it, up to
+ * max_group_bytes, as one group, assigns their sequence numbers and runs the log stage for all of them.
+ * Once done it hands the log stage over to the next leader and runs the memtable stage of its group, so the
+ * memtable inserts of a group overlap the log write and sync of the next one. Each stage runs one group at a time,
+ * the groups go through both in the order they were formed, so the memtables see the batches in sequence order.
+ * The followers sleep until their group is in the memtables */
+class WriteQueue {
+ public:
+  struct Writer {
+    const WriteBatch *batch_;
+    WriteOptions options_;
+    uint64_t sequence_ = 0;  // of the first entry of the batch, the entries take consecutive numbers
+    bool done_ = false;
+    std::exception_ptr error_;
+  };
+  // runs a stage for a group, an exception fails the writes of the whole group
+  using Stage = std::function<void(const std::vector<Writer *> &group)>;
+
+ private:
+  Stage log_stage_;
+  Stage memtable_stage_;
+  size_t max_group_bytes_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Writer *> queue_;  // writers waiting for the log stage, the front one leads the next group
+  bool logging_;                // a group is in the log stage
+  uint64_t next_group_;         // ticket of the next group formed
+  uint64_t applying_group_;     // ticket of the group the memtable stage takes next
+  uint64_t last_sequence_;      // of the last entry of the last group formed
+  WriteQueueStats stats_;
+
+ public:
+  // last_sequence is the sequence number of the last entry written before, e.g. found in the log at recovery
+  WriteQueue(Stage log_stage, Stage memtable_stage, uint64_t last_sequence = 0,
+             size_t max_group_bytes = LSM_MAX_WRITE_GROUP_BYTES);
+
+  // returns once the batch is in the memtables, rethrows what failed the stages of its group
+  void Write(const WriteBatch &batch, const WriteOptions &options = WriteOptions());
+
+  uint64_t GetLastSequence();
+  WriteQueueStats GetStats();
+};
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <type/BaseIterator.h>
+#include <functional>
 #include <memory>
-#include <queue>
+#include <optional>
 #include <string>
+#include <vector>
 struct SearchItem {
   std::string key_;
   std::string value_;
@@ -16,25 +19,90 @@ bool operator<(const SearchItem &lhs, const SearchItem &rhs);
 bool operator>(const SearchItem &lhs, const SearchItem &rhs);
 bool operator==(const SearchItem &lhs, const SearchItem &rhs);
 
+/** VectorIterator iterates over materialized <key, value> pairs which are sorted by key */
+class VectorIterator : public BaseIterator {
+  using ValueType = std::pair<std::string, std::string>;
+
+ private:
+  std::shared_ptr<const std::vector<ValueType>> items_;
+  size_t pos_;
+
+ public:
+  explicit VectorIterator(std::shared_ptr<const std::vector<ValueType>> items);
+
+  bool IsValid() const override;
+  std::string GetKey() const override;
+  std::string GetValue() const override;
+  void Next() override;
+  void Prev() override;
+  void SeekToFirst() override;
+  void SeekToLast() override;
+  void Seek(const std::string &key) override;
+  void SeekForPrev(const std::string &key) override;
+  std::unique_ptr<BaseIterator> Clone() const override;
+};
+
+/** HeapIterator merges several sorted sources with a heap.
+ * children_ are ordered by priority: for the same key, the child with the smaller index is the newer one and wins.
+ * Only the newest version of each key is returned, keys whose newest value is empty (deleted) are skipped.
+ * An optional value reader maps the versions of a key (the newest first) to the returned value,
+ * keys it maps to nullopt are skipped too, e.g. expired entries. It also sees the deleted versions.
+ * Moving forward the heap is a min-heap on keys, moving backward it is a max-heap,
+ * switching the direction repositions every child around the current key */
 class HeapIterator {
   using ValueType = std::pair<std::string, std::string>;
 
+ public:
+  using ValueReader = std::function<std::optional<std::string>(const std::string &, const std::vector<std::string> &)>;
+
  private:
-  std::priority_queue<SearchItem, std::vector<SearchItem>, std::greater<>> heap_;
+  std::vector<std::unique_ptr<BaseIterator>> children_;
+  // the head of each valid child, idx_ is the position of the child in children_
+  std::vector<SearchItem> heap_;
+  bool forward_ = true;
   std::shared_ptr<ValueType> current_;  // store the current value
+  ValueReader value_reader_;
  private:
+  // heap order of the current direction, the item on top has the highest priority
+  bool HeapLess(const SearchItem &lhs, const SearchItem &rhs) const;
+  void HeapPush(SearchItem item);
+  void HeapPop();
   void UpdateCurrent();
+  void RebuildHeap();
+  // move every child positioned at the current key one step in the current direction
+  void PopCurrentKey();
+  void SkipDeleted();
+  // the values of the current key in the children, the newest first
+  std::vector<std::string> CurrentVersions() const;
+  // reposition the children around the current key when the direction changes
+  void SwitchDirection(bool forward);
 
  public:
   HeapIterator() = default;
+  // items with the same idx_ belong to the same source, the smaller idx_ the newer
   explicit HeapIterator(const std::vector<SearchItem> &items);
+  // children should already be positioned, e.g. by SeekToFirst() or Seek()
+  explicit HeapIterator(std::vector<std::unique_ptr<BaseIterator>> children, ValueReader value_reader = nullptr);
+  HeapIterator(const HeapIterator &other);
+  HeapIterator &operator=(const HeapIterator &other);
+  HeapIterator(HeapIterator &&other) = default;
+  HeapIterator &operator=(HeapIterator &&other) = default;
   ~HeapIterator() = default;
 
+  void SeekToFirst();
+  void SeekToLast();
+  // position at the first key which is not less than key
+  void Seek(const std::string &key);
+  // position at the last key which is not greater than key
+  void SeekForPrev(const std::string &key);
+
   HeapIterator &operator++();
   HeapIterator operator++(int) = delete;
+  HeapIterator &operator--();
+  HeapIterator operator--(int) = delete;
   bool operator==(const HeapIterator &other) const;
   bool operator!=(const HeapIterator &other) const;
   ValueType *operator->() const;
   ValueType &operator*() const;
   bool IsEnd() const;
-};
\ No newline at end of file
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <skiplist/SkipList.h>
+#include <type/BaseIterator.h>
+#include <type/KeyComparator.h>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+
+using StringSkipList = SkipList<std::string, std::string, KeyComparator<std::string>>;
+
+/** MemTableIterator walks one skiplist of the MemoryTable without copying it.
+ * Frozen skiplists are immutable so they are read without lock,
+ * for the active skiplist the table lock is taken in shared mode for each step only,
+ * so holding an iterator never blocks writers */
+class MemTableIterator : public BaseIterator {
+ private:
+  std::shared_ptr<StringSkipList> table_;
+  StringSkipList::Iterator iter_;
+  std::shared_ptr<std::shared_mutex> mutex_;  // lock of the active table, nullptr for frozen tables
+
+ private:
+  // caller should hold the lock
+  bool InternalIsValid() const;
+
+ public:
+  MemTableIterator(std::shared_ptr<StringSkipList> table, std::shared_ptr<std::shared_mutex> mutex);
+  MemTableIterator(const MemTableIterator &other) = default;
+  ~MemTableIterator() override = default;
+
+  bool IsValid() const override;
+  std::string GetKey() const override;
+  std::string GetValue() const override;
+  void Next() override;
+  void Prev() override;
+  void SeekToFirst() override;
+  void SeekToLast() override;
+  void Seek(const std::string &key) override;
+  void SeekForPrev(const std::string &key) override;
+  std::unique_ptr<BaseIterator> Clone() const override;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <memoryTable/MemTableIterator.h>
+#include <type/BaseIterator.h>
+#include <utils/Options.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** MemTableRep holds the entries of one table of a MemoryTable, a deletion is an entry with an empty value.
+ * The MemoryTable serializes the writes and holds the lock of the active table around every call,
+ * frozen tables are only read. See MemTableRepType for the representations */
+class MemTableRep {
+ public:
+  using Entry = std::pair<std::string, std::string>;
+
+  MemTableRep() = default;
+  virtual ~MemTableRep() = default;
+  MemTableRep(const MemTableRep &) = delete;
+  MemTableRep &operator=(const MemTableRep &) = delete;
+
+  virtual void Put(const std::string &key, const std::string &value) = 0;
+  virtual std::optional<std::string> Get(const std::string &key) = 0;
+  // bytes of the keys and values
+  virtual size_t UsedBytes() const = 0;
+  // the memory the table really holds, the entries with their nodes
+  virtual size_t AllocatedBytes() const = 0;
+  virtual void Clear() = 0;
+  // an iterator in key order. mutex is the lock of the active table, which the iterator takes when it reads the
+  // table, nullptr for a frozen table
+  virtual std::unique_ptr<BaseIterator> NewIterator(const std::shared_ptr<std::shared_mutex> &mutex) = 0;
+  // the entries whose key starts with prefix, in key order
+  virtual std::vector<Entry> ScanPrefix(const std::string &prefix) = 0;
+  // the entries for which predicate returns 0, in key order. predicate is monotone:
+  // positive for the keys before the range and negative for the keys after it
+  virtual std::vector<Entry> ScanMonotony(const std::function<int(const std::string &)> &predicate) = 0;
+  // called by the flush of a frozen table before it is read, without the locks of the MemoryTable:
+  // the table is no longer written but it is still read
+  virtual void PrepareFlush() {}
+};
+
+std::shared_ptr<MemTableRep> NewMemTableRep(MemTableRepType type);
+
+/** SkipListRep keeps the entries sorted on insert, its iterators see the writes made after they are created */
+class SkipListRep : public MemTableRep {
+ private:
+  std::shared_ptr<StringSkipList> list_;
+
+ public:
+  SkipListRep();
+
+  void Put(const std::string &key, const std::string &value) override;
+  std::optional<std::string> Get(const std::string &key) override;
+  size_t UsedBytes() const override;
+  size_t AllocatedBytes() const override;
+  void Clear() override;
+  std::unique_ptr<BaseIterator> NewIterator(const std::shared_ptr<std::shared_mutex> &mutex) override;
+  std::vector<Entry> ScanPrefix(const std::string &prefix) override;
+  std::vector<Entry> ScanMonotony(const std::function<int(const std::string &)> &predicate) override;
+};
+
+/** HashTableRep keeps the entries in a hash table, Put() and Get() cost O(1) and no key comparison.
+ * Each ordered read, i.e. the flush, a scan or an iterator, sorts a copy of the entries which is dropped
+ * with the read, so the table holds no memory AllocatedBytes() does not count. An iterator reads the entries
+ * as of its creation */
+class HashTableRep : public MemTableRep {
+ private:
+  std::unordered_map<std::string, std::string> table_;
+  size_t used_bytes_;
+
+ private:
+  // a sorted copy of the entries, owned by the caller
+  std::shared_ptr<const std::vector<Entry>> Sorted() const;
+
+ public:
+  HashTableRep();
+
+  void Put(const std::string &key, const std::string &value) override;
+  std::optional<std::string> Get(const std::string &key) override;
+  size_t UsedBytes() const override { return used_bytes_; }
+  size_t AllocatedBytes() const override;
+  void Clear() override;
+  std::unique_ptr<BaseIterator> NewIterator(const std::shared_ptr<std::shared_mutex> &mutex) override;
+  std::vector<Entry> ScanPrefix(const std::string &prefix) override;
+  std::vector<Entry> ScanMonotony(const std::function<int(const std::string &)> &predicate) override;
+};
+
+/** VectorRep appends the entries in write order, a Put() does no ordering work and a key written again takes
+ * one more entry. The flush sorts the entries with MEMTABLE_VECTOR_SORT_THREADS threads and drops the older
+ * versions of each key, their bytes stay counted until the table is released. Until then Get() scans the entries
+ * from the newest one, and an ordered read sorts a copy which is dropped with the read */
+class VectorRep : public MemTableRep {
+ private:
+  std::vector<Entry> entries_;  // in write order, empty once sorted_ holds them all
+  size_t used_bytes_;
+  size_t allocated_bytes_;
+  // the readers of the active table share its lock, a frozen table is read while the flush sorts it
+  std::shared_mutex mutex_;
+  bool sorted_all_;                                   // set by PrepareFlush()
+  std::shared_ptr<const std::vector<Entry>> sorted_;  // the newest version of each key in key order, once sorted_all_
+
+ private:
+  // sorted_ once the table is sorted, a sorted copy owned by the caller before
+  std::shared_ptr<const std::vector<Entry>> Sorted();
+
+ public:
+  VectorRep();
+
+  void Put(const std::string &key, const std::string &value) override;
+  std::optional<std::string> Get(const std::string &key) override;
+  size_t UsedBytes() const override { return used_bytes_; }
+  size_t AllocatedBytes() const override { return allocated_bytes_; }
+  void Clear() override;
+  std::unique_ptr<BaseIterator> NewIterator(const std::shared_ptr<std::shared_mutex> &mutex) override;
+  std::vector<Entry> ScanPrefix(const std::string &prefix) override;
+  std::vector<Entry> ScanMonotony(const std::function<int(const std::string &)> &predicate) override;
+  void PrepareFlush() override;
+};
@@ -1,20 +1,32 @@
 #pragma once
 
 #include <memoryTable/HeapIterator.h>
+#include <memoryTable/MemTableIterator.h>
+#include <memoryTable/MemTableRep.h>
+#include <memoryTable/WriteBufferManager.h>
 #include <skiplist/SkipList.h>
 #include <sst/SST.h>
 #include <type/KeyComparator.h>
+#include <utils/Macro.h>
+#include <atomic>
 #include <list>
 
-using StringSkipList = SkipList<std::string, std::string, KeyComparator<std::string>>;
-
+/** MemoryTable holds the writes of a column family until they are flushed: one active table and the frozen tables
+ * waiting for a flush, from the newest to the oldest. The tables are MemTableReps of rep_type_ */
 class MemoryTable {
  private:
-  std::shared_ptr<StringSkipList> current_table_;
-  std::list<std::shared_ptr<StringSkipList>> frozen_tables_;
+  MemTableRepType rep_type_;
+  std::shared_ptr<MemTableRep> current_table_;
+  std::list<std::shared_ptr<MemTableRep>> frozen_tables_;
   size_t frozen_bytes_;
+  size_t frozen_allocated_bytes_;
+  WriteBufferManager *write_buffer_manager_;  // charged with the allocated bytes of the tables, may be nullptr
+  std::atomic<size_t> table_size_limit_;      // bytes the active table allocates before it is frozen
   std::shared_mutex frozen_tables_mutex_;
-  std::shared_mutex current_table_mutex_;
+  std::shared_ptr<std::shared_mutex> current_table_mutex_;  // shared with the iterators of the active table
+  // first and last sequence numbers of the writes of the active table, 0 when it has none
+  std::pair<uint64_t, uint64_t> current_sequences_;
+  std::list<std::pair<uint64_t, uint64_t>> frozen_sequences_;  // those of frozen_tables_, in the same order
 
  private:
   // Internal Version of functions don't need to get lock
@@ -23,16 +35,35 @@ class MemoryTable {
   std::optional<std::string> FrozenGet(const std::string &key);
   void InternalRemove(const std::string &key);
   void InternalFrozenCurrentTable();
+  // record the sequence number of a write to the active table, 0 is not recorded
+  void UpdateSequence(uint64_t sequence);
+  // report the growth of the active table since it allocated before bytes, and freeze it once it is full.
+  // Called with current_table_mutex_ held
+  void AfterWrite(size_t before);
 
  public:
-  MemoryTable();
-  ~MemoryTable() = default;
+  explicit MemoryTable(WriteBufferManager *write_buffer_manager = nullptr,
+                       size_t table_size_limit = LSM_PER_MEM_SIZE_LIMIT,
+                       MemTableRepType rep_type = MemTableRepType::kSkipList);
+  ~MemoryTable();
+
+  // applies from the next write, the active table is frozen then if it is above the new limit
+  void SetTableSizeLimit(size_t table_size_limit) { table_size_limit_ = table_size_limit; }
+  size_t GetTableSizeLimit() const { return table_size_limit_; }
 
-  void Put(const std::string &key, const std::string &value);
+  // sequence is the number the write-ahead log gave the write, 0 for none.
+  // Sequence numbers given to a memtable must increase
+  void Put(const std::string &key, const std::string &value, uint64_t sequence = 0);
   void PutBatch(const std::vector<std::pair<std::string, std::string>> &batch);
 
   std::optional<std::string> Get(const std::string &key);
-  void Remove(const std::string &key);
+  // visit the values of key from the newest table to the oldest until visit returns true,
+  // returns whether it did
+  bool GetVersions(const std::string &key, const std::function<bool(const std::string &)> &visit);
+  // put combine(the value of key in the active table, nullopt if none) as one atomic step
+  void Merge(const std::string &key, const std::function<std::string(const std::optional<std::string> &)> &combine,
+             uint64_t sequence = 0);
+  void Remove(const std::string &key, uint64_t sequence = 0);
   void RemoveBatch(const std::vector<std::string> &keys);
 
   void Clear();
@@ -41,13 +72,32 @@ class MemoryTable {
 
   HeapIterator Begin();
   HeapIterator End();
+  // one lazy iterator per table, ordered from the newest table to the oldest one
+  std::vector<std::unique_ptr<BaseIterator>> NewIterators();
 
   size_t GetCurSize();
   size_t GetFrozenSize();
+  // number of frozen tables waiting for a flush
+  size_t GetFrozenCount();
   size_t GetTotalSize();
+  // bytes allocated by the active and frozen tables, nodes and towers included
+  size_t GetAllocatedBytes();
 
-  std::shared_ptr<SST> FlushLast(const std::shared_ptr<SSTBuilder> &builder, const std::string &sst_path, size_t sst_id,
-                                 std::shared_ptr<BlockCache> block_cache);
+  // build an SST from the oldest table, nullptr if the memtable is empty. filter maps each live value to the value
+  // written, a value it maps to nullopt is written as a deletion since older SSTs may still hold the key.
+  // The table stays readable until ReleaseLast() is called once the SST is visible, so that no read misses its keys.
+  // Flushes must not run concurrently
+  std::shared_ptr<SST> FlushLast(
+      const std::shared_ptr<SSTBuilder> &builder, const std::string &sst_path, size_t sst_id,
+      std::shared_ptr<BlockCache> block_cache,
+      const std::function<std::optional<std::string>(const std::string &, const std::string &)> &filter = nullptr);
+  // drop the oldest table, which FlushLast() flushed
+  void ReleaseLast();
+  // the last sequence number of the oldest table, the one FlushLast() flushes, 0 if it has none
+  uint64_t GetFlushingSequence();
+  // the smallest sequence number still in the memtable, 0 if it has none:
+  // every write before it is flushed
+  uint64_t GetOldestSequence();
 
   std::optional<std::pair<HeapIterator, HeapIterator>> ItersMonotonyPredicate(
       const std::function<int(const std::string &)> &predicate);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <block/BlockCache.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/** WriteBufferManager accounts the memory of the memtables of all the column families of an engine,
+ * as the bytes their skiplists allocate rather than the bytes of the keys and values.
+ * The memtables should be flushed once they allocate buffer_size bytes.
+ * A memory budget can additionally bound the memtables, the block cache and the index and filter memory
+ * of the open SSTs together: the block cache is shrunk to what the others leave of the budget,
+ * and the memtables are flushed when they and the SSTs alone reach it, unless the memtables are below
+ * an eighth of the budget */
+class WriteBufferManager {
+ private:
+  std::atomic<size_t> buffer_size_;
+  std::atomic<size_t> memory_budget_;  // 0 disables it
+  std::shared_ptr<BlockCache> block_cache_;
+  std::atomic<size_t> memory_used_;   // bytes allocated by the active and frozen memtables
+  std::atomic<size_t> cache_limit_;   // the last byte limit given to the block cache
+
+ public:
+  WriteBufferManager(size_t buffer_size, size_t memory_budget = 0, std::shared_ptr<BlockCache> block_cache = nullptr);
+
+  // called by the memtables when their skiplists allocate or release memory
+  void ReserveMem(size_t bytes) { memory_used_ += bytes; }
+  void FreeMem(size_t bytes) { memory_used_ -= bytes; }
+  size_t MemoryUsage() const { return memory_used_; }
+  size_t GetBufferSize() const { return buffer_size_; }
+  void SetBufferSize(size_t buffer_size) { buffer_size_ = buffer_size; }
+  size_t GetMemoryBudget() const { return memory_budget_; }
+  // 0 removes the budget and the byte limit of the block cache
+  void SetMemoryBudget(size_t memory_budget);
+  // called after writes with the index and filter memory of the open SSTs.
+  // Resizes the block cache to the budget and returns whether the memtables should be flushed
+  bool ShouldFlush(size_t table_memory);
+};
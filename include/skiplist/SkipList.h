@@ -55,14 +55,20 @@ class SkipListIterator {
     return *this;
   }
 
-  bool operator==(const SKIPLIST_ITERATOR_TYPE &other) { return current_ == other.current_; }
+  // follow the backward link of level 0, stepping back from the first element reaches the head node
+  SKIPLIST_ITERATOR_TYPE &operator--() {
+    current_ = current_->backward_[0].lock();
+    return *this;
+  }
 
-  bool operator!=(const SKIPLIST_ITERATOR_TYPE &other) { return current_ != other.current_; }
+  bool operator==(const SKIPLIST_ITERATOR_TYPE &other) const { return current_ == other.current_; }
 
-  K GetKey() { return current_->key_; }
-  V GetValue() { return current_->value_; }
+  bool operator!=(const SKIPLIST_ITERATOR_TYPE &other) const { return current_ != other.current_; }
 
-  bool IsValid() { return current_ != nullptr; }
+  K GetKey() const { return current_->key_; }
+  V GetValue() const { return current_->value_; }
+
+  bool IsValid() const { return current_ != nullptr; }
   bool IsEnd() { return current_ == nullptr || current_->key == KeyComparator::MaxValue(); }
 };
 
@@ -76,7 +82,8 @@ class SkipList {
   int max_level_;
   int level_;
   K tail_key_;
-  size_t used_bytes_;
+  size_t used_bytes_;       // bytes of the keys and values
+  size_t allocated_bytes_;  // bytes allocated for the nodes, including the towers and the head and tail nodes
 
   std::uniform_int_distribution<int> dist_01_;
   std::uniform_int_distribution<int> dist_level_;
@@ -86,6 +93,8 @@ class SkipList {
 
  private:
   int RandomLevel();
+  // bytes allocated for a node with level pointers, an estimate of the allocator and shared_ptr overhead
+  static size_t NodeBytes(int level, const K &key, const V &value);
   // private version of Search, used by Put and Remove, returns the node before the target node
   // will record the last node at each level in last_
   std::optional<std::shared_ptr<SkipListNode<K, V>>> InternalSearch(const K &key);
@@ -99,6 +108,8 @@ class SkipList {
   bool Put(const K &key, const V &value);
   bool Remove(const K &key);
   size_t UsedBytes() const { return used_bytes_; }
+  // the memory the skiplist really holds, several times UsedBytes() for small entries
+  size_t AllocatedBytes() const { return allocated_bytes_; }
   std::vector<std::pair<K, V>> Dump();
   void Clear();
 
@@ -106,6 +117,14 @@ class SkipList {
   using Iterator = SkipListIterator<K, V, KeyComparator>;
   Iterator Begin() { return Iterator(head_->forward_[0]); };
   Iterator End() { return Iterator(tail_); };
+  // the last element, or REnd() if the skiplist is empty
+  Iterator RBegin() { return Iterator(tail_->backward_[0].lock()); };
+  // the head node which is before the first element
+  Iterator REnd() { return Iterator(head_); };
+  // find the first element that is not less than key by searching from the top level
+  Iterator Seek(const K &key);
+  // find the last element that is not greater than key, returns REnd() if there is no such element
+  Iterator SeekForPrev(const K &key);
 
   std::optional<std::pair<Iterator, Iterator>> ItersMonotonyPredicate(
       std::function<int(const K &)> predicate);
@@ -122,19 +141,17 @@ class SkipList {
     return Iterator(p);
   }
 
-  // find the first element that is greater than key
+  // find the first element which does not start with preffix and is greater than it
   template <typename U = K>
   std::enable_if_t<std::is_same_v<U, std::string>, Iterator> EndPreffix(const K &preffix) {
+    // keys with the same preffix are adjacent, so it is a level search as well,
+    // compare() checks the preffix without building a substring for each node
     auto p = head_;
     for (int i = level_; i >= 0; i--) {
-      while (comp_(p->forward_[i]->key_, preffix) < 0) {
+      while (p->forward_[i] != tail_ && p->forward_[i]->key_.compare(0, preffix.size(), preffix) <= 0) {
         p = p->forward_[i];
       }
     }
-    p = p->forward_[0];
-    while (p != tail_ && p->key_.substr(0, preffix.size()) == preffix) {
-      p = p->forward_[0];
-    }
-    return Iterator(p);
+    return Iterator(p->forward_[0]);
   }
 };
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <block/Block.h>
+#include <sst/SST.h>
+#include <utils/Options.h>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct BlockReadRequest {
+  std::shared_ptr<SST> sst_;
+  size_t block_idx_;
+};
+
+/** AsyncBlockReader reads many SST blocks at once and completes them into the BlockCache.
+ * Reads are submitted to an io_uring, so a single thread can keep many reads in flight,
+ * a completion thread decodes the blocks and runs the callbacks.
+ * When io_uring is not available (old kernel, seccomp) a pool of threads doing pread is used instead */
+class AsyncBlockReader {
+ public:
+  // block is nullptr if the read failed, error holds the reason
+  using Callback = std::function<void(std::shared_ptr<Block> block, std::exception_ptr error)>;
+
+ private:
+  struct Request;
+  struct IoUring;
+
+  size_t queue_depth_;
+  std::unique_ptr<IoUring> ring_;  // nullptr if the thread pool is used
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  size_t in_flight_;  // submitted to the ring and not completed yet
+  std::deque<std::unique_ptr<Request>> pending_;  // requests waiting for room in the ring, or for a worker
+  bool stop_;
+  std::vector<std::thread> threads_;  // the completion thread, or the workers of the thread pool
+
+ private:
+  // move pending requests to the ring while it has room, called with mutex_ held,
+  // returns the requests which could not be submitted with the reason
+  std::vector<std::pair<std::unique_ptr<Request>, std::exception_ptr>> SubmitPending();
+  static void Fail(std::vector<std::pair<std::unique_ptr<Request>, std::exception_ptr>> failed);
+  void CompletionLoop();
+  void WorkerLoop();
+  // called once the data of the request is read, bytes_read < 0 is an error number
+  void Complete(std::unique_ptr<Request> request, ssize_t bytes_read);
+
+ public:
+  // queue_depth bounds the reads in flight, num_threads is the size of the fallback thread pool
+  AsyncBlockReader(size_t queue_depth, size_t num_threads, bool use_io_uring = true);
+  ~AsyncBlockReader();
+  AsyncBlockReader(const AsyncBlockReader &) = delete;
+  AsyncBlockReader &operator=(const AsyncBlockReader &) = delete;
+
+  // submit the read and return immediately without blocking, the callback runs on another thread,
+  // a block already in the block cache completes inline. Callbacks may submit more reads
+  void Submit(const BlockReadRequest &request, const ReadOptions &options, Callback callback);
+  // read all the blocks concurrently and wait for them, the result is in the order of requests
+  std::vector<std::shared_ptr<Block>> ReadBlocks(const std::vector<BlockReadRequest> &requests,
+                                                 const ReadOptions &options = ReadOptions());
+  bool UsesIoUring() const { return ring_ != nullptr; }
+};
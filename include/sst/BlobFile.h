@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** BlobIndex is what an SST stores instead of a value written to a blob file.
+ * Encoded as | file_number (64) | offset (64) | size (32) |, offset_ is where the value starts in the file */
+struct BlobIndex {
+  uint64_t file_number_;
+  uint64_t offset_;
+  uint32_t size_;
+
+  static constexpr size_t ENCODED_SIZE = 2 * sizeof(uint64_t) + sizeof(uint32_t);
+
+  std::string Encode() const;
+  // throws std::runtime_error if encoded is not a blob index
+  static BlobIndex Decode(const std::string &encoded);
+};
+
+/** BlobFileBuilder writes the large values of a flush or a compaction to a new blob file.
+ * A blob file is append-only and never modified once finished, it is deleted when no SST references it anymore.
+ * Record layout: | crc32c of the value (32) | value |. The file is only created on the first Add(),
+ * and removed when the builder is destroyed without Finish() */
+class BlobFileBuilder {
+ private:
+  std::string path_;
+  uint64_t file_number_;
+  int fd_;
+  uint64_t file_size_;
+  bool finished_;
+
+ public:
+  BlobFileBuilder(std::string path, uint64_t file_number);
+  ~BlobFileBuilder();
+  BlobFileBuilder(const BlobFileBuilder &) = delete;
+  BlobFileBuilder &operator=(const BlobFileBuilder &) = delete;
+
+  // append value, returns the index the SST keeps for it
+  BlobIndex Add(const std::string &value);
+  // sync the file, returns false if nothing was added and there is no file
+  bool Finish();
+
+  uint64_t GetFileNumber() const { return file_number_; }
+  uint64_t GetFileSize() const { return file_size_; }
+};
+
+/** BlobFileReader reads the values of a finished blob file with positional reads, it is thread-safe.
+ * The file stays readable through an open reader after it is deleted */
+class BlobFileReader {
+ private:
+  uint64_t file_number_;
+  int fd_;
+  uint64_t file_size_;
+
+ public:
+  // throws std::runtime_error if the file cannot be opened
+  BlobFileReader(const std::string &path, uint64_t file_number);
+  ~BlobFileReader();
+  BlobFileReader(const BlobFileReader &) = delete;
+  BlobFileReader &operator=(const BlobFileReader &) = delete;
+
+  // throws std::runtime_error when the index is out of the file or the checksum does not match
+  std::string Read(const BlobIndex &index) const;
+
+  uint64_t GetFileNumber() const { return file_number_; }
+  uint64_t GetFileSize() const { return file_size_; }
+};
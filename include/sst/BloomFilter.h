@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/** BloomFilter of an SST, built from the hashes of all the keys (and their prefixes).
+ * Probes are derived from one 32-bit hash by double hashing.
+ * Layout: | bit array | num_probes (1B) | */
+class BloomFilter {
+ public:
+  // stable across processes since the filter is persisted, unlike std::hash
+  static uint32_t Hash(std::string_view key);
+
+  static std::vector<uint8_t> Build(const std::vector<uint32_t> &hashes, size_t bits_per_key);
+  // false means the key is definitely not in the filter, an empty filter matches everything
+  static bool MayContain(const std::vector<uint8_t> &filter, uint32_t hash);
+};
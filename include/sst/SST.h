@@ -1,15 +1,36 @@
 #pragma once
 /**
  * SSTable layout:
- * -------------------------------------------------------------------------------------------
- * |         Block Section         |          Meta Section         |          Extra          |
- * -------------------------------------------------------------------------------------------
- * | data block | ... | data block |            metadata           | meta block offset (u32) |
- * -------------------------------------------------------------------------------------------
+ * ---------------------------------------------------------------------------------------------------------------
+ * |         Block Section         |     Index Section     | Filter Section | Meta Section |         Extra         |
+ * ---------------------------------------------------------------------------------------------------------------
+ * | data block | ... | data block | partition | partition |     filter     |   metadata   |  see Extra layout     |
+ * ---------------------------------------------------------------------------------------------------------------
+
+ * Extra layout:
+ * ----------------------------------------------------------------------------------------------------------------
+ * | filter offset (u32) | num_blocks (u32) | index_partition_size (u32) | meta block offset (u32) |
+ * | checksum type (u32) | format version (u32) |
+ * ----------------------------------------------------------------------------------------------------------------
+ * every data block, index partition and the metadata end with a crc32c checksum (checksum type 1)
+
+ * Without index partitions (index_partition_size = 0), the metadata has one MetaEntry per data block.
+ * With index partitions, the metadata is a top-level index with one MetaEntry per partition, the i-th data
+ * block is the (i % index_partition_size)-th entry of the (i / index_partition_size)-th partition.
+ * Partitions are encoded as data blocks, the key of an entry is the last key of the data block:
+ * --------------------------------------------------------------------------------------------------------------
+ * | last_key | offset (4B) | size (4B) | first_key |
+ * --------------------------------------------------------------------------------------------------------------
+
+ * Filter Section layout:
+ * --------------------------------------------------------------------------------------------------------------
+ * | extractor_name_len (2B) | extractor_name (extractor_name_len) | bloom filter (see BloomFilter) |
+ * --------------------------------------------------------------------------------------------------------------
+ * the bloom filter holds every key, and the prefix of every key when the SST is built with a prefix extractor
 
  * Meta Section layout:
  * --------------------------------------------------------------------------------------------------------------
- * | num_entries (32) | MetaEntry | ... | MetaEntry | Hash (32) |
+ * | num_entries (32) | MetaEntry | ... | MetaEntry | crc32c (32) |
  * --------------------------------------------------------------------------------------------------------------
 
  * MetaEntry layout:
@@ -22,8 +43,11 @@
 #include <block/BlockCache.h>
 #include <block/BlockMeta.h>
 #include <utils/File.h>
+#include <utils/Options.h>
+#include <utils/PrefixExtractor.h>
 #include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -31,7 +55,9 @@ class SSTIterator;
 
 /** SST Class is a descriptor for SSTable(sorted string table) file, which contains metadata and data blocks
  * the metadata always store in memory
- * but the blocks is loaded into memory only when it was needed*/
+ * but the blocks is loaded into memory only when it was needed.
+ * With a partitioned index only the top-level index is kept in memory,
+ * the index partitions are loaded through the block cache like the data blocks*/
 class SST : public std::enable_shared_from_this<SST> {
   friend class SSTBuilder;
   friend std::optional<std::pair<SSTIterator, SSTIterator>> SSTItersMonotonyPredicate(
@@ -39,15 +65,30 @@ class SST : public std::enable_shared_from_this<SST> {
 
  private:
   FileObj file_;
-  std::vector<BlockMeta> meta_;
+  std::vector<BlockMeta> meta_;  // meta of the data blocks, or of the index partitions
+  size_t num_blocks_;
+  size_t index_partition_size_;  // number of data blocks per index partition, 0 if the index is not partitioned
   uint32_t meta_offset_;
+  uint32_t filter_offset_;
+  std::vector<uint8_t> bloom_filter_;
+  std::string prefix_extractor_name_;  // empty if the filter holds whole keys only
   size_t sst_id_;
   std::string first_key_;
   std::string last_key_;
   std::shared_ptr<BlockCache> block_cache_;
+  bool pin_index_ = false;  // the index partitions are pinned in the block cache until the SST is closed
+
+ private:
+  // size of the block or partition meta_[idx] points to
+  size_t MetaEntrySize(size_t idx) const;
+  // index of the first meta_ entry whose last key is not less than key
+  size_t FindMetaIndex(const std::string &key) const;
+  std::shared_ptr<Block> ReadIndexPartition(size_t partition_idx, const ReadOptions &options);
+  BlockMeta ReadIndexEntry(size_t block_idx, size_t *block_size, const ReadOptions &options);
 
  public:
   SST() = default;
+  ~SST();
 
   // Open an existing SST file
   static std::shared_ptr<SST> Open(size_t sst_id, FileObj file, std::shared_ptr<BlockCache> block_cache);
@@ -55,14 +96,38 @@ class SST : public std::enable_shared_from_this<SST> {
   static std::shared_ptr<SST> CreateSSTWithMetaOnly(size_t sst_id, size_t file_size, const std::string &first_key,
                                                     const std::string &last_key,
                                                     std::shared_ptr<BlockCache> block_cache);
-  std::shared_ptr<Block> ReadBlock(size_t block_idx);
-  size_t FindBlockIndex(const std::string &key);
+  std::shared_ptr<Block> ReadBlock(size_t block_idx, const ReadOptions &options = ReadOptions());
+  // the cached block, nullptr if it is not in the block cache
+  std::shared_ptr<Block> GetCachedBlock(size_t block_idx);
+  // position of the block_idx-th block in the file, used to read blocks asynchronously
+  void GetBlockHandle(size_t block_idx, size_t *offset, size_t *size, const ReadOptions &options = ReadOptions());
+  // decode the block read from the file and insert it into the block cache
+  std::shared_ptr<Block> LoadBlock(size_t block_idx, const std::vector<uint8_t> &block_data,
+                                   const ReadOptions &options = ReadOptions());
+  // read the blocks from the first_idx-th one with a single read of about max_bytes, at least one block is read,
+  // the blocks are verified and inserted into the block cache, returns the number of blocks read
+  size_t ReadAhead(size_t first_idx, size_t max_bytes, const ReadOptions &options = ReadOptions());
+  // pin the index partitions read from now on, the flat index and the bloom filter are always in memory.
+  // Each SST object holds its own pin reference, so another object of the same id does not unpin its partitions
+  void SetPinIndex(bool pin);
+  int GetFileHandle() const { return file_.NativeHandle(); }
+  size_t FindBlockIndex(const std::string &key, const ReadOptions &options = ReadOptions());
+  // offset, first key and last key of the block_idx-th block
+  BlockMeta GetBlockMeta(size_t block_idx);
   size_t NumBlocks() const;
+  // 0 if the index is not partitioned
+  size_t NumIndexPartitions() const;
   std::string GetFirstKey() const;
   std::string GetLastKey() const;
   size_t GetSSTSize() const;
+  // memory held by the open SST: its index (or top-level index) and bloom filter, the cached blocks excluded
+  size_t GetMemoryUsage() const;
   size_t GetSSTId() const;
-  SSTIterator Get(const std::string &key);
+  // false means the SST does not contain key, checked with the bloom filter only
+  bool KeyMayMatch(const std::string &key) const;
+  // false means the SST has no key starting with prefix, checked without reading any block
+  bool PrefixMayMatch(const std::string &prefix, const PrefixExtractor *extractor) const;
+  SSTIterator Get(const std::string &key, const ReadOptions &options = ReadOptions());
   SSTIterator Begin();  // NOLINT
   SSTIterator End();    // NOLINT
 };
@@ -75,13 +140,25 @@ class SSTBuilder {
   std::vector<BlockMeta> meta_;
   std::vector<uint8_t> data_;  // encoded SST data
   size_t block_size_;
-  std::vector<uint32_t> key_hashes_;
+  std::vector<uint32_t> key_hashes_;  // hashes of the keys and prefixes for the bloom filter
+  std::shared_ptr<const PrefixExtractor> prefix_extractor_;
+  std::optional<std::string> last_prefix_;  // prefix of the last added key
+  size_t index_partition_size_ = 0;
+  bool direct_io_ = false;
+
+ private:
+  // encode the index partitions into data_, returns the top-level index, or nullopt if a partition is too large
+  std::optional<std::vector<BlockMeta>> BuildIndexPartitions(std::vector<uint8_t> *data) const;
 
  public:
-  explicit SSTBuilder(size_t block_size);
+  explicit SSTBuilder(size_t block_size, std::shared_ptr<const PrefixExtractor> prefix_extractor = nullptr);
   void Add(const std::string &key, const std::string &value);  // add key-value pair
   size_t EstimateSize() const;
   void FinishBlock();
   std::shared_ptr<SST> Build(size_t sst_id, const std::string &path, std::shared_ptr<BlockCache> block_cache);
   size_t GetBlockSize() const { return block_size_; }
+  // partition the index when the SST has more than partition_size blocks, 0 disables it
+  void SetIndexPartitionSize(size_t partition_size) { index_partition_size_ = partition_size; }
+  // write the SST with O_DIRECT, the returned SST reads with O_DIRECT as well
+  void SetDirectIO(bool direct_io) { direct_io_ = direct_io; }
 };
\ No newline at end of file
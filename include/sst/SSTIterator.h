@@ -1,33 +1,66 @@
 #pragma once
 
+#include <block/BlockIterator.h>
 #include <sst/SST.h>
-class SSTIterator {
+#include <type/BaseIterator.h>
+class SSTIterator : public BaseIterator {
   friend class SST;
 
  private:
   std::shared_ptr<SST> sst_;
   size_t block_idx_;
   std::shared_ptr<BlockIterator> block_iter_;
+  ReadOptions read_options_;
+  // readahead of sequential scans, the window doubles every time the scan reaches the end of the prefetched blocks
+  size_t sequential_blocks_;  // blocks entered by Next() since the last seek
+  size_t readahead_end_;      // the blocks before it were prefetched
+  size_t readahead_size_;     // bytes of the next readahead
+
+ private:
+  void ResetReadahead();
+  // read the block_idx_-th block entered by Next(), prefetch the following blocks once the scan is sequential
+  std::shared_ptr<Block> ReadNextBlock();
+  // position at the idx-th entry of the block_idx-th block
+  void SeekToEntry(size_t block_idx, size_t idx);
+  void Invalidate();
 
  public:
   using value_type = std::pair<std::string, std::string>;
 
-  explicit SSTIterator(std::shared_ptr<SST> sst);
-  SSTIterator(std::shared_ptr<SST> sst, const std::string &key);
+  explicit SSTIterator(std::shared_ptr<SST> sst, const ReadOptions &options = ReadOptions());
+  // position at the first key which is not less than key
+  SSTIterator(std::shared_ptr<SST> sst, const std::string &key, const ReadOptions &options = ReadOptions());
+  // copies do not share the block iterator, so they can move independently
+  SSTIterator(const SSTIterator &other);
+  SSTIterator &operator=(const SSTIterator &other);
+  ~SSTIterator() override = default;
 
-  void SeekFirst();
-  void Seek(const std::string &key);
+  void SeekToFirst() override;
+  void SeekToLast() override;
+  void Seek(const std::string &key) override;
+  // position at the last key which is not greater than key
+  void SeekForPrev(const std::string &key) override;
+  void Next() override;
+  void Prev() override;
   bool IsEnd();
-  bool IsValid() const;
+  bool IsValid() const override;
 
-  std::string GetKey();
-  std::string GetValue();
+  std::string GetKey() const override;
+  std::string GetValue() const override;
+  std::shared_ptr<SST> GetSST() const { return sst_; }
+  // the block after the current one if it is not in the block cache yet, lets async scans read it first
+  std::optional<size_t> NextBlockToRead() const;
+  // whether the next step leaves the current block
+  bool AtBlockEnd() const;
   void SetBlockIdx(size_t block_idx);
   void SetBlockIter(std::shared_ptr<BlockIterator> block_iter);
+  std::unique_ptr<BaseIterator> Clone() const override;
 
   SSTIterator &operator++();
   SSTIterator operator++(int) = delete;
+  SSTIterator &operator--();
+  SSTIterator operator--(int) = delete;
   bool operator==(const SSTIterator &other) const;
   bool operator!=(const SSTIterator &other) const;
   value_type operator*() const;
-};
\ No newline at end of file
+};
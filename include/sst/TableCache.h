@@ -0,0 +1,55 @@
+#pragma once
+
+#include <block/BlockCache.h>
+#include <sst/SST.h>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/** TableCache bounds the number of SSTs that are open at the same time.
+ * An SST is opened (file handle + decoded meta) lazily on its first access and kept in an LRU list,
+ * once more than capacity_ tables are open the least recently used one is closed.
+ * Iterators hold a shared_ptr to their SST, so an evicted table stays usable until its last reader is done */
+class TableCache {
+ private:
+  std::string data_dir_;
+  size_t capacity_;
+  std::shared_ptr<BlockCache> block_cache_;
+  bool direct_io_;         // open the SSTs with O_DIRECT
+  bool pin_index_blocks_;  // the tables pin their index partitions in the block cache
+  mutable std::mutex mutex_;
+  std::list<std::shared_ptr<SST>> lru_list_;  // front is the most recently used table
+  std::unordered_map<size_t, std::list<std::shared_ptr<SST>>::iterator> table_map_;
+  size_t total_requests_;
+  size_t hit_requests_;
+  size_t memory_usage_;  // SST::GetMemoryUsage() of the open tables
+
+ private:
+  // insert a table as the most recently used one, caller should hold mutex_
+  void InternalInsert(const std::shared_ptr<SST> &sst);
+  void Evict();
+
+ public:
+  TableCache(std::string data_dir, size_t capacity, std::shared_ptr<BlockCache> block_cache,
+             bool direct_io = false, bool pin_index_blocks = false);
+  ~TableCache() = default;
+
+  // return the opened SST, open it from disk if it is not cached
+  std::shared_ptr<SST> FindTable(size_t sst_id);
+  // register a table which is already opened, e.g. the one just built by flush
+  void Insert(const std::shared_ptr<SST> &sst);
+  // close the table, used when the SST file is going to be removed
+  void Erase(size_t sst_id);
+
+  std::string GetSSTPath(size_t sst_id) const;
+  const std::string &GetDataDir() const { return data_dir_; }
+  size_t Size() const;
+  // memory held by the open tables, see SST::GetMemoryUsage()
+  size_t GetMemoryUsage() const;
+  size_t GetCapacity() const { return capacity_; }
+  bool UsesDirectIO() const { return direct_io_; }
+  double GetHitRate() const;
+};
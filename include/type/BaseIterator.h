@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+/** BaseIterator is the common interface of every sorted source merged by HeapIterator,
+ * e.g. the skiplists of the memtable and the SSTs. A source is positioned lazily, so seeking costs
+ * O(log n) in the source instead of a full scan */
+class BaseIterator {
+ public:
+  BaseIterator() = default;
+  virtual ~BaseIterator() = default;
+
+  virtual bool IsValid() const = 0;
+  virtual std::string GetKey() const = 0;
+  virtual std::string GetValue() const = 0;
+  virtual void Next() = 0;
+  // step back, the iterator becomes invalid when it leaves the first entry
+  virtual void Prev() = 0;
+  // position at the first entry of the source
+  virtual void SeekToFirst() = 0;
+  // position at the last entry of the source
+  virtual void SeekToLast() = 0;
+  // position at the first entry whose key is not less than key
+  virtual void Seek(const std::string &key) = 0;
+  // position at the last entry whose key is not greater than key
+  virtual void SeekForPrev(const std::string &key) = 0;
+  // an independent copy which is positioned at the same entry
+  virtual std::unique_ptr<BaseIterator> Clone() const = 0;
+};
@@ -15,4 +15,19 @@ template <typename T>
 typename std::enable_if<std::is_same<T, std::string>::value, size_t>::type
 GetSize(const T& value) {
     return value.size();
-}
\ No newline at end of file
+}
+
+// heap bytes owned by the value besides sizeof(value), integral types own none
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, size_t>::type
+GetAllocatedSize(const T& value) {
+    return 0;
+}
+
+// strings short enough for the small string buffer own no heap memory
+template <typename T>
+typename std::enable_if<std::is_same<T, std::string>::value, size_t>::type
+GetAllocatedSize(const T& value) {
+    static const size_t kInlineCapacity = std::string().capacity();
+    return value.capacity() > kInlineCapacity ? value.capacity() + 1 : 0;
+}
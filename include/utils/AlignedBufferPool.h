@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+class AlignedBufferPool;
+
+/** AlignedBuffer is a buffer whose address and size are multiples of the pool alignment,
+ * as required by direct I/O. It returns to its pool when destroyed */
+class AlignedBuffer {
+  friend class AlignedBufferPool;
+
+ private:
+  AlignedBufferPool *pool_;
+  uint8_t *data_;
+  size_t capacity_;
+
+  AlignedBuffer(AlignedBufferPool *pool, uint8_t *data, size_t capacity)
+      : pool_(pool), data_(data), capacity_(capacity) {}
+
+ public:
+  AlignedBuffer(const AlignedBuffer &) = delete;
+  AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+  AlignedBuffer(AlignedBuffer &&other) noexcept;
+  AlignedBuffer &operator=(AlignedBuffer &&other) noexcept;
+  ~AlignedBuffer();
+
+  uint8_t *Data() const { return data_; }
+  size_t Capacity() const { return capacity_; }
+};
+
+/** AlignedBufferPool reuses aligned buffers so direct reads do not allocate for every block.
+ * Free buffers are kept by capacity, at most max_cached_bytes are kept, larger buffers are freed */
+class AlignedBufferPool {
+ private:
+  size_t alignment_;
+  size_t max_cached_bytes_;
+  size_t cached_bytes_;
+  std::mutex mutex_;
+  std::multimap<size_t, uint8_t *> free_buffers_;  // capacity -> buffer
+
+ public:
+  AlignedBufferPool(size_t alignment, size_t max_cached_bytes);
+  ~AlignedBufferPool();
+  AlignedBufferPool(const AlignedBufferPool &) = delete;
+  AlignedBufferPool &operator=(const AlignedBufferPool &) = delete;
+
+  // the shared pool used by DirectFileOperator
+  static AlignedBufferPool &Default();
+
+  // a buffer of at least size bytes, size is rounded up to the alignment
+  AlignedBuffer Acquire(size_t size);
+  void Release(uint8_t *data, size_t capacity);
+  size_t GetAlignment() const { return alignment_; }
+  size_t GetCachedBytes();
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/** CompactionFilter is called for every live entry a flush or compaction writes,
+ * it may keep the entry, remove it, or replace its value.
+ * Deleted entries are never passed to the filter */
+class CompactionFilter {
+ public:
+  enum class Decision { kKeep, kRemove, kChangeValue };
+
+  CompactionFilter() = default;
+  virtual ~CompactionFilter() = default;
+
+  virtual std::string Name() const = 0;
+  // *new_value is the value written for kChangeValue, an empty new value removes the entry
+  virtual Decision Filter(const std::string &key, const std::string &value, std::string *new_value) const = 0;
+};
+
+/** TTLCompactionFilter removes the entries written more than ttl seconds ago.
+ * A value written with a TTL carries its write time: the user value followed by a fixed 8-byte timestamp
+ * in seconds, see AppendWriteTime(). The filter only accepts values in this format */
+class TTLCompactionFilter : public CompactionFilter {
+ private:
+  uint64_t ttl_;
+
+ public:
+  explicit TTLCompactionFilter(uint64_t ttl) : ttl_(ttl) {}
+
+  std::string Name() const override { return "ttl:" + std::to_string(ttl_); }
+  Decision Filter(const std::string &key, const std::string &value, std::string *new_value) const override;
+
+  // whether a value written with a timestamp is older than the TTL
+  bool IsExpired(const std::string &value, uint64_t now) const;
+
+  // seconds since epoch
+  static uint64_t Now();
+  static std::string AppendWriteTime(const std::string &value, uint64_t write_time);
+  static uint64_t GetWriteTime(const std::string &value);
+  // the user value without its timestamp
+  static std::string StripWriteTime(const std::string &value);
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/** CRC32C (Castagnoli) checksum of the on-disk blocks and metadata.
+ * Uses the SSE4.2 crc32 instruction when the CPU supports it, and a table based implementation otherwise,
+ * both produce the same value on every platform */
+class Crc32c {
+ public:
+  // extend crc with data[0, n)
+  static uint32_t Extend(uint32_t crc, const uint8_t *data, size_t n);
+  static uint32_t Value(const uint8_t *data, size_t n) { return Extend(0, data, n); }
+  // the table based implementation, always available
+  static uint32_t ExtendPortable(uint32_t crc, const uint8_t *data, size_t n);
+  // whether the hardware implementation is used
+  static bool IsHardwareAccelerated();
+};
@@ -1,7 +1,15 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include "NoCopyable.h"
@@ -17,29 +25,26 @@ class FileOperator : public NoCopyable {
   virtual bool Write(size_t offset, const void *data, size_t size) = 0;
   virtual std::vector<uint8_t> Read(size_t offset, size_t size) = 0;
   virtual bool Sync() = 0;
+  // a file descriptor for positional reads (pread, io_uring), -1 if the file is not open
+  virtual int NativeHandle() const = 0;
 };
 
+/** StdFileOperator does buffered positional I/O on a single descriptor, which NativeHandle() also hands
+ * to the asynchronous readers, so a table never holds a second descriptor for the same file */
 class StdFileOperator : public FileOperator {
  private:
-  std::fstream file_;
+  int fd_ = -1;
   std::filesystem::path file_path_;
 
  public:
   StdFileOperator() = default;
-  ~StdFileOperator() override {
-    if (file_.is_open()) {
-      Close();
-    }
-  }
+  ~StdFileOperator() override { Close(); }
 
   bool Open(const std::string &filename, bool create) override {
+    Close();
     file_path_ = std::filesystem::path(filename);
-    if (create) {
-      file_.open(file_path_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
-    } else {
-      file_.open(file_path_, std::ios::in | std::ios::out | std::ios::binary);
-    }
-    return file_.is_open();
+    fd_ = ::open(filename.c_str(), O_RDWR | (create ? O_CREAT | O_TRUNC : 0), 0644);
+    return fd_ >= 0;
   }
 
   bool Create(const std::string &filename, const std::vector<uint8_t> &data) override {
@@ -50,43 +55,100 @@ class StdFileOperator : public FileOperator {
     return true;
   }
   void Close() override {
-    if (file_.is_open()) {
-      Sync();
-      file_.close();
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
     }
   }
   size_t Size() override {
-    file_.seekg(0, std::ios::end);
-    return static_cast<size_t>(file_.tellg());
+    struct stat st {};
+    if (::fstat(fd_, &st) != 0) {
+      throw std::runtime_error("Failed to stat file " + file_path_.string() + ": " + strerror(errno));
+    }
+    return static_cast<size_t>(st.st_size);
   }
 
   bool Write(size_t offset, const void *data, size_t size) override {
-    file_.seekp(static_cast<std::streamoff>(offset), std::ios::beg);
-    file_.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
-    this->Sync();
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    size_t done = 0;
+    while (done < size) {
+      ssize_t n = ::pwrite(fd_, bytes + done, size - done, static_cast<off_t>(offset + done));
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::runtime_error("Failed to write file " + file_path_.string() + ": " + strerror(errno));
+      }
+      done += n;
+    }
     return true;
   }
   std::vector<uint8_t> Read(size_t offset, size_t size) override {
     std::vector<uint8_t> result(size);
-    file_.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
-    file_.read(reinterpret_cast<char *>(result.data()), static_cast<std::streamsize>(size));
-    return result;
-  }
-  bool Sync() override {
-    if (!file_.is_open()) {
-      return false;
+    size_t done = 0;
+    while (done < size) {
+      ssize_t n = ::pread(fd_, result.data() + done, size - done, static_cast<off_t>(offset + done));
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::runtime_error("Failed to read file " + file_path_.string() + ": " + strerror(errno));
+      }
+      if (n == 0) {
+        break;
+      }
+      done += n;
     }
-    file_.flush();
-    return file_.good();
+    return result;
   }
+  // pwrite leaves nothing buffered in the process, durability is up to SyncPath
+  bool Sync() override { return fd_ >= 0; }
+  int NativeHandle() const override { return fd_; }
+};
+
+/** DirectFileOperator bypasses the page cache with O_DIRECT, the block cache is then the only cache of SST data.
+ * Every read and write is widened to aligned extents using buffers from AlignedBufferPool::Default(),
+ * and the requested range is sliced out. When the file system does not support O_DIRECT,
+ * the file is opened normally and the same aligned I/O is used */
+class DirectFileOperator : public FileOperator {
+ private:
+  int fd_ = -1;
+  bool direct_ = false;  // whether O_DIRECT is enabled for fd_
+  std::filesystem::path file_path_;
+
+ private:
+  // read the aligned extent [offset, offset + size) into buffer, bytes after the end of file are zero
+  void ReadAligned(size_t offset, size_t size, uint8_t *buffer);
+
+ public:
+  DirectFileOperator() = default;
+  ~DirectFileOperator() override;
+
+  bool Open(const std::string &filename, bool create) override;
+  bool Create(const std::string &filename, const std::vector<uint8_t> &data) override;
+  void Close() override;
+  size_t Size() override;
+  bool Write(size_t offset, const void *data, size_t size) override;
+  std::vector<uint8_t> Read(size_t offset, size_t size) override;
+  bool Sync() override;
+  int NativeHandle() const override { return fd_; }
+  bool IsDirect() const { return direct_; }
 };
 
 class FileObj {
   private: 
   std::unique_ptr<FileOperator> file_operator_;
   size_t size_{};
+
+  static std::unique_ptr<FileOperator> NewFileOperator(bool direct_io) {
+    if (direct_io) {
+      return std::make_unique<DirectFileOperator>();
+    }
+    return std::make_unique<StdFileOperator>();
+  }
+
  public:
-  FileObj() : file_operator_(std::make_unique<StdFileOperator>()){};
+  explicit FileObj(bool direct_io = false) : file_operator_(NewFileOperator(direct_io)){};
   ~FileObj() = default;
 
   FileObj(FileObj &&other) noexcept {
@@ -106,16 +168,16 @@ class FileObj {
 
   size_t Size() const { return file_operator_->Size(); }
   void SetSize(size_t size) { size_ = size; }
-  static FileObj CreateAndWrite(const std::string &path, const std::vector<uint8_t> &data) {
-    FileObj file;
+  static FileObj CreateAndWrite(const std::string &path, const std::vector<uint8_t> &data, bool direct_io = false) {
+    FileObj file(direct_io);
     if (!file.file_operator_->Create(path, data)) {
       throw std::runtime_error("Failed to create file");
     }
     file.file_operator_->Sync();
     return file;
   }
-  static FileObj Open(const std::string &path) {
-    FileObj file;
+  static FileObj Open(const std::string &path, bool direct_io = false) {
+    FileObj file(direct_io);
     if (!file.file_operator_->Open(path, false)) {
       throw std::runtime_error("Failed to open file");
     }
@@ -127,4 +189,9 @@ class FileObj {
     }
     return file_operator_->Read(offset, size);
   }
-};
\ No newline at end of file
+  int NativeHandle() const { return file_operator_->NativeHandle(); }
+};
+
+// fsync the file or directory at path, e.g. the directory of a file just created or renamed.
+// Throws std::runtime_error on failure
+void SyncPath(const std::string &path);
@@ -1,9 +1,64 @@
 #pragma once
 
+// defaults of the fields of Options and ColumnFamilyOptions, which set them per engine and per column family
+
 #define LSM_TOL_MEM_SIZE_LIMIT (64 * 1024 * 1024)  // 64MB
 #define LSM_PER_MEM_SIZE_LIMIT (4 * 1024 * 1024)   // 4MB
 #define LSM_BLOCK_SIZE (32 * 1024)                 // 32KB
+// bound of the memtables, block cache and SST index and filter memory together, 0 disables it
+#define LSM_MEMORY_BUDGET 0
+
+#define MEMTABLE_VECTOR_SORT_THREADS 4        // threads sorting a vector memtable for its flush
+#define MEMTABLE_VECTOR_SORT_MIN_CHUNK 16384  // entries each of these threads sorts at least
+
+// write stalls of a column family, see ColumnFamilyOptions and WriteController
+#define LSM_FROZEN_SLOWDOWN_TRIGGER 20               // frozen memtables
+#define LSM_FROZEN_STOP_TRIGGER 24
+#define LSM_L0_SLOWDOWN_TRIGGER 20                   // L0 SSTs
+#define LSM_L0_STOP_TRIGGER 36
+#define LSM_SOFT_PENDING_BYTES_LIMIT (64ULL << 30)   // bytes waiting for a flush or a compaction
+#define LSM_HARD_PENDING_BYTES_LIMIT (256ULL << 30)
+#define LSM_DELAYED_WRITE_RATE (16 * 1024 * 1024)    // bytes per second at the slowdown triggers
+#define LSM_MIN_WRITE_DELAY_MICROS 1000              // shorter delays are carried over to the next writes
+
+// write-ahead log, see WriteQueue
+#define LSM_MAX_WAL_FILE_SIZE (64 * 1024 * 1024)   // a new log file is started once the current one is this large
+#define LSM_MAX_WRITE_GROUP_BYTES (1024 * 1024)    // bytes of batches a leader writes to the log as one group
+
+// universal compaction, see UniversalCompactionPicker
+#define LSM_L0_COMPACTION_TRIGGER 4               // sorted runs which trigger a compaction
+#define UNIVERSAL_SIZE_RATIO 1                    // percent
+#define UNIVERSAL_MIN_MERGE_WIDTH 2
+#define UNIVERSAL_MAX_SIZE_AMPLIFICATION_PERCENT 200
+
+#define FIFO_MAX_TABLE_FILES_SIZE (1ULL << 30)  // 1GB of SSTs kept by the FIFO compaction
+
+// key-value separation, see ColumnFamilyOptions::enable_blob_files
+#define BLOB_MIN_SIZE 4096       // values of this many bytes or more are written to blob files
+#define BLOB_GC_AGE_CUTOFF 0.25  // share of the oldest blob files whose values a full compaction relocates
 
 #define BLOCK_CACHE_CAPACITY 1024
 #define BLOCK_CACHE_K 8
+#define BLOCK_CACHE_HIGH_PRI_RATIO 0.1  // share of the block cache reserved for the index partitions
+#define BLOCK_CACHE_LOW_PRI_RATIO 0.1   // share reserved for the blocks of scans not filling the cache
+#define BLOCK_CACHE_PIN_L0_INDEX false  // keep the index partitions of the open L0 SSTs in the block cache
+
+#define SECONDARY_CACHE_ADMISSION_ENTRIES 65536  // keys of evicted blocks remembered to admit their next eviction
+
+#define ROW_CACHE_CAPACITY (8 * 1024 * 1024)  // bytes of the row cache, shared by the column families using it
+#define ROW_CACHE_SHARDS 16                    // each shard has its own lock and LRU list
+
+#define TABLE_CACHE_CAPACITY 256  // max number of SSTs kept open
+#define SST_INDEX_PARTITION_SIZE 128  // data blocks per index partition, SSTs with fewer blocks keep a flat index
+
+#define SST_INITIAL_READAHEAD_SIZE (64 * 1024)    // first readahead window of a sequential scan
+#define SST_MAX_READAHEAD_SIZE (2 * 1024 * 1024)  // the window doubles on every readahead up to this size
+
+#define BLOOM_FILTER_BITS_PER_KEY 10  // about 1% false positive rate
+
+#define LSM_USE_DIRECT_IO false                        // read and write SSTs with O_DIRECT
+#define DIRECT_IO_ALIGNMENT 4096                       // alignment of the buffers and extents of direct I/O
+#define DIRECT_IO_BUFFER_POOL_SIZE (16 * 1024 * 1024)  // max bytes of free aligned buffers kept for reuse
 
+#define ASYNC_READ_QUEUE_DEPTH 64  // max block reads in flight on the io_uring
+#define ASYNC_READ_THREADS 4       // threads reading blocks when io_uring is not available
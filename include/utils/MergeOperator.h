@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+/** MergeOperator combines the operands of LSM::Merge() with the existing value of a key.
+ * It must be associative, Merge(Merge(a, b), c) == Merge(a, Merge(b, c)): operands are combined with each other
+ * before the existing value is known, e.g. by successive merges in the memtable.
+ * The name is not persisted, a column family must always be opened with the same operator */
+class MergeOperator {
+ public:
+  MergeOperator() = default;
+  virtual ~MergeOperator() = default;
+
+  virtual std::string Name() const = 0;
+  // existing_value is nullopt when the key does not exist or was deleted
+  virtual std::string Merge(const std::string &key, const std::optional<std::string> &existing_value,
+                            const std::string &operand) const = 0;
+};
+
+/** UInt64AddOperator adds 8-byte counters, see EncodeValue() */
+class UInt64AddOperator : public MergeOperator {
+ public:
+  std::string Name() const override { return "uint64add"; }
+  std::string Merge(const std::string &key, const std::optional<std::string> &existing_value,
+                    const std::string &operand) const override;
+
+  static std::string EncodeValue(uint64_t value);
+  // values of another size count as 0
+  static uint64_t DecodeValue(const std::string &value);
+};
+
+/** StringAppendOperator appends the operands to the value, separated by delimiter */
+class StringAppendOperator : public MergeOperator {
+ private:
+  std::string delimiter_;
+
+ public:
+  explicit StringAppendOperator(std::string delimiter) : delimiter_(std::move(delimiter)) {}
+
+  std::string Name() const override { return "stringappend"; }
+  std::string Merge(const std::string &key, const std::optional<std::string> &existing_value,
+                    const std::string &operand) const override;
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <utils/CompactionFilter.h>
+#include <utils/Macro.h>
+#include <utils/MergeOperator.h>
+#include <utils/PrefixExtractor.h>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/** ReadOptions controls a single read, e.g. LSM::Get() or an iterator */
+struct ReadOptions {
+  // verify the checksum of the blocks read from disk,
+  // blocks already in the block cache are not verified again, so the blocks read without it are not cached.
+  // The blocks prefetched by readahead are verified anyway
+  bool verify_checksums = true;
+  // iterators reading blocks sequentially prefetch the following blocks with one large read,
+  // the window grows up to max_readahead_size bytes, 0 disables readahead
+  size_t max_readahead_size = SST_MAX_READAHEAD_SIZE;
+  // false inserts the blocks read as low priority, so a large scan does not evict the blocks of point lookups
+  bool fill_cache = true;
+};
+
+/** WriteOptions controls a single write, e.g. LSM::Put() or LSM::Write() */
+struct WriteOptions {
+  // sync the write-ahead log before the write returns. Without it a crash of the process loses no write,
+  // a crash of the machine may lose the latest ones
+  bool sync = false;
+  // skip the write-ahead log, the write is lost by a crash until its memtable is flushed
+  bool disable_wal = false;
+};
+
+/** MemTableRepType chooses how a memtable holds its entries, see MemTableRep */
+enum class MemTableRepType {
+  kSkipList = 0,   // sorted on insert, for mixed reads, writes and scans
+  kHashTable = 1,  // O(1) Put() and Get(), sorted at the flush, for point lookups. Scans sort the active table
+  // appended without ordering work and sorted in parallel by the flush, for bulk loads which read after the load.
+  // Get() scans the tables until they are flushed, and so do Merge() and the writes checking a TTL or a blob
+  kVector = 2,
+};
+
+/** CompactionStyle decides when the SSTs of a column family are merged */
+enum class CompactionStyle {
+  kNone = 0,       // only by Compact(), and by the writers past a stop trigger
+  kUniversal = 1,  // after the flushes, by merging sorted runs of similar size, see UniversalCompactionPicker
+  // never, e.g. for time series: the oldest SSTs are deleted whole after the flushes and by Compact(),
+  // see FifoCompactionOptions
+  kFifo = 2,
+};
+
+/** UniversalCompactionOptions tune CompactionStyle::kUniversal */
+struct UniversalCompactionOptions {
+  // the newest runs are merged while the next run is at most size_ratio percent larger than the runs picked
+  unsigned size_ratio = UNIVERSAL_SIZE_RATIO;
+  size_t min_merge_width = UNIVERSAL_MIN_MERGE_WIDTH;
+  size_t max_merge_width = std::numeric_limits<size_t>::max();
+  // all the runs are merged once the runs newer than the oldest reach this percent of its size
+  unsigned max_size_amplification_percent = UNIVERSAL_MAX_SIZE_AMPLIFICATION_PERCENT;
+};
+
+/** FifoCompactionOptions tune CompactionStyle::kFifo. The SSTs are deleted from the oldest one, with all the keys
+ * they hold, so it suits keys written once and removed by age only */
+struct FifoCompactionOptions {
+  // the oldest SSTs are deleted while the SSTs add up to more bytes, 0 disables it
+  uint64_t max_table_files_size = FIFO_MAX_TABLE_FILES_SIZE;
+  // the SSTs flushed more than ttl seconds ago are deleted, 0 disables it.
+  // Unlike ColumnFamilyOptions::ttl, it costs no rewrite and no bytes per entry
+  uint64_t ttl = 0;
+};
+
+/** ColumnFamilyOptions configure one column family, every column family builds its own SSTs with them */
+struct ColumnFamilyOptions {
+  // SSTs get a prefix bloom filter when set, which lets ScanPrefix() skip SSTs
+  std::shared_ptr<const PrefixExtractor> prefix_extractor;
+  // bytes a memtable allocates before it is frozen and flushed
+  size_t write_buffer_size = LSM_PER_MEM_SIZE_LIMIT;
+  MemTableRepType memtable_rep = MemTableRepType::kSkipList;
+  size_t block_size = LSM_BLOCK_SIZE;
+  // data blocks per index partition, 0 keeps a flat index
+  size_t index_partition_size = SST_INDEX_PARTITION_SIZE;
+  // combines the operands of Merge(), required to use Merge(). Values are stored with their type when it is set,
+  // so it must not be turned on or off once data is written
+  std::shared_ptr<const MergeOperator> merge_operator;
+  // called for the entries rewritten by flushes and compactions, merge operands are not filtered
+  std::shared_ptr<const CompactionFilter> compaction_filter;
+  // entries expire ttl seconds after they are written, 0 disables it.
+  // Values are stored with their write time, expired entries are hidden from reads
+  // and removed by flushes and compactions. It must not be turned on or off once data is written
+  uint64_t ttl = 0;
+  // cache the results of Get() and MultiGet() in the row cache of the engine,
+  // column families with a TTL do not use it since cached values would outlive their expiration
+  bool row_cache = false;
+  // pin the index partitions of the open SSTs in the block cache, all the SSTs are in L0.
+  // The bloom filters are always held in memory by the open SSTs
+  bool pin_l0_index_blocks = BLOCK_CACHE_PIN_L0_INDEX;
+  // writes of the whole engine are delayed once the column family reaches a slowdown trigger, and wait while
+  // it is past a stop trigger until its memtables are flushed and its SSTs compacted. 0 disables a trigger.
+  // The pending bytes are those of the frozen memtables, plus those of L0 when it has more than one SST
+  size_t frozen_memtables_slowdown_trigger = LSM_FROZEN_SLOWDOWN_TRIGGER;
+  size_t frozen_memtables_stop_trigger = LSM_FROZEN_STOP_TRIGGER;
+  size_t level0_slowdown_writes_trigger = LSM_L0_SLOWDOWN_TRIGGER;
+  size_t level0_stop_writes_trigger = LSM_L0_STOP_TRIGGER;
+  uint64_t soft_pending_bytes_limit = LSM_SOFT_PENDING_BYTES_LIMIT;
+  uint64_t hard_pending_bytes_limit = LSM_HARD_PENDING_BYTES_LIMIT;
+  // the options of the default column family are those given to the engine
+  CompactionStyle compaction_style = CompactionStyle::kNone;
+  // every SST of L0 is a sorted run, a compaction is considered once there are this many of them
+  size_t level0_file_num_compaction_trigger = LSM_L0_COMPACTION_TRIGGER;
+  UniversalCompactionOptions universal;
+  FifoCompactionOptions fifo;
+  // flushes write the values of min_blob_size bytes or more to blob files, the SSTs keep a small reference
+  // instead and compactions move the references rather than the values. A full compaction relocates the values
+  // still referenced in the oldest blob_garbage_collection_age_cutoff of the blob files, and deletes the blob
+  // files no SST references anymore. Values are stored with their type when it is set,
+  // so it must not be turned on or off once data is written
+  bool enable_blob_files = false;
+  size_t min_blob_size = BLOB_MIN_SIZE;
+  double blob_garbage_collection_age_cutoff = BLOB_GC_AGE_CUTOFF;
+};
+
+/** Options configure an engine. The fields of ColumnFamilyOptions are the options of the default column family,
+ * the others are shared by all the column families. The defaults are those of Macro.h */
+struct Options : public ColumnFamilyOptions {
+  Options() = default;
+  explicit Options(const ColumnFamilyOptions &default_cf_options) : ColumnFamilyOptions(default_cf_options) {}
+
+  // the memtables of all the column families are flushed once they allocate this many bytes
+  size_t db_write_buffer_size = LSM_TOL_MEM_SIZE_LIMIT;
+  // bound of the memtables, block cache and SST index and filter memory together, 0 disables it.
+  // See WriteBufferManager
+  size_t memory_budget = LSM_MEMORY_BUDGET;
+  // blocks kept by the block cache of the engine, see BlockCache
+  size_t block_cache_capacity = BLOCK_CACHE_CAPACITY;
+  size_t block_cache_k = BLOCK_CACHE_K;
+  double block_cache_high_pri_ratio = BLOCK_CACHE_HIGH_PRI_RATIO;
+  double block_cache_low_pri_ratio = BLOCK_CACHE_LOW_PRI_RATIO;
+  // bytes of the row cache, see ColumnFamilyOptions::row_cache
+  size_t row_cache_capacity = ROW_CACHE_CAPACITY;
+  size_t row_cache_shards = ROW_CACHE_SHARDS;
+  // SSTs kept open by each column family
+  size_t table_cache_capacity = TABLE_CACHE_CAPACITY;
+  size_t async_read_queue_depth = ASYNC_READ_QUEUE_DEPTH;
+  size_t async_read_threads = ASYNC_READ_THREADS;
+  // bytes per second the writes are delayed to at the slowdown triggers, see WriteController
+  uint64_t delayed_write_rate = LSM_DELAYED_WRITE_RATE;
+  // read and write the SSTs with O_DIRECT
+  bool use_direct_io = LSM_USE_DIRECT_IO;
+  // the log files are deleted once the memtables holding their writes are flushed
+  uint64_t max_wal_file_size = LSM_MAX_WAL_FILE_SIZE;
+  // bytes of batches a leader writes to the log and syncs at once, see WriteQueue
+  size_t max_write_group_bytes = LSM_MAX_WRITE_GROUP_BYTES;
+};
+
+/** The options which can be changed while the engine runs, by the name of their field, e.g. "universal.size_ratio".
+ * Column families: write_buffer_size, the write stall triggers and limits, level0_file_num_compaction_trigger,
+ * the fields of universal and fifo, min_blob_size and blob_garbage_collection_age_cutoff.
+ * Engine: db_write_buffer_size, memory_budget, block_cache_capacity, row_cache_capacity and delayed_write_rate.
+ * They throw std::invalid_argument, leaving options unchanged, for another name or a value which does not parse */
+void SetColumnFamilyOptions(ColumnFamilyOptions *options, const std::unordered_map<std::string, std::string> &values);
+void SetDBOptions(Options *options, const std::unordered_map<std::string, std::string> &values);
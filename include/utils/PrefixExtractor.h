@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+/** PrefixExtractor maps a key to the prefix used by prefix scans and prefix bloom filters.
+ * The name is stored in every SST, a filter built with another extractor is never used */
+class PrefixExtractor {
+ public:
+  PrefixExtractor() = default;
+  virtual ~PrefixExtractor() = default;
+
+  virtual std::string Name() const = 0;
+  // whether key has a prefix, Transform() is only called on keys in the domain
+  virtual bool InDomain(const std::string &key) const = 0;
+  virtual std::string Transform(const std::string &key) const = 0;
+};
+
+/** FixedPrefixExtractor uses the first prefix_len bytes as the prefix, shorter keys have no prefix */
+class FixedPrefixExtractor : public PrefixExtractor {
+ private:
+  size_t prefix_len_;
+
+ public:
+  explicit FixedPrefixExtractor(size_t prefix_len) : prefix_len_(prefix_len) {}
+
+  std::string Name() const override { return "fixed:" + std::to_string(prefix_len_); }
+  bool InDomain(const std::string &key) const override { return key.size() >= prefix_len_; }
+  std::string Transform(const std::string &key) const override { return key.substr(0, prefix_len_); }
+};
@@ -1,5 +1,6 @@
 #include <block/Block.h>
 #include <block/BlockIterator.h>
+#include <utils/Crc32c.h>
 #include <cstring>
 #include <stdexcept>
 
@@ -19,7 +20,7 @@ std::vector<uint8_t> Block::Encode() {
   return result;
 }
 
-std::shared_ptr<Block> Block::Decode(const std::vector<uint8_t> &encoded, bool with_hash) {
+std::shared_ptr<Block> Block::Decode(const std::vector<uint8_t> &encoded, bool with_hash, bool verify_checksum) {
   std::shared_ptr<Block> block = std::make_shared<Block>();
 
   if (encoded.size() < sizeof(uint16_t)) {
@@ -28,14 +29,17 @@ std::shared_ptr<Block> Block::Decode(const std::vector<uint8_t> &encoded, bool w
 
   size_t num_elements_pos = encoded.size() - sizeof(uint16_t);
   if (with_hash) {
+    if (encoded.size() < sizeof(uint16_t) + sizeof(uint32_t)) {
+      throw std::runtime_error("Invalid block data, too small");
+    }
     num_elements_pos -= sizeof(uint32_t);
     auto hash_pos = encoded.size() - sizeof(uint32_t);
-    uint32_t hash_val = 0;
-    memcpy(&hash_val, encoded.data() + hash_pos, sizeof(uint32_t));
-    uint32_t encoded_hash_val =
-        std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(encoded.data()), hash_pos));
-    if (hash_val != encoded_hash_val) {
-      throw std::runtime_error("Invalid block data, hash mismatch");
+    if (verify_checksum) {
+      uint32_t hash_val = 0;
+      memcpy(&hash_val, encoded.data() + hash_pos, sizeof(uint32_t));
+      if (hash_val != Crc32c::Value(encoded.data(), hash_pos)) {
+        throw std::runtime_error("Invalid block data, checksum mismatch");
+      }
     }
   }
   uint16_t num_of_elements = 0;
@@ -130,6 +134,20 @@ std::optional<size_t> Block::FindEntryIdx(const std::string &key) const {
   return std::nullopt;
 }
 
+size_t Block::LowerBoundIdx(const std::string &key) const {
+  int left = -1;
+  int right = offsets_.size();
+  while (left + 1 != right) {
+    int mid = (left + right) / 2;
+    if (CompareKeyAt(GetOffsetAt(mid), key) < 0) {
+      left = mid;
+    } else {
+      right = mid;
+    }
+  }
+  return right;
+}
+
 std::optional<std::string> Block::FindValue(const std::string &key) const {
   auto idx = FindEntryIdx(key);
   if (!idx.has_value()) {
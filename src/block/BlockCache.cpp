@@ -1,12 +1,38 @@
 #include <block/BlockCache.h>
 
+#include <limits>
 #include <stdexcept>
 #include <utility>
+#include <vector>
+
+BlockCache::BlockCache(size_t capacity, size_t k, double high_pri_ratio, double low_pri_ratio)
+    : capacity_(capacity),
+      k_(k),
+      timestamp_(0),
+      max_bytes_(std::numeric_limits<size_t>::max()),
+      usage_bytes_(0),
+      total_requests_(0),
+      hit_requests_(0) {
+  if (high_pri_ratio < 0 || low_pri_ratio < 0 || high_pri_ratio + low_pri_ratio > 1) {
+    throw std::invalid_argument("BlockCache reserved ratios should be in [0, 1] and add up to at most 1");
+  }
+  reserved_ratios_[static_cast<size_t>(CachePriority::kLow)] = low_pri_ratio;
+  reserved_ratios_[static_cast<size_t>(CachePriority::kNormal)] = 0;
+  reserved_ratios_[static_cast<size_t>(CachePriority::kHigh)] = high_pri_ratio;
+  for (size_t p = 0; p < kNumPriorities; p++) {
+    reserved_[p] = static_cast<size_t>(static_cast<double>(capacity_) * reserved_ratios_[p]);
+  }
+}
 
 std::shared_ptr<Block> BlockCache::Get(int sst_id, int block_id) {
   std::lock_guard<std::mutex> lock(mutex_);
   ++total_requests_;
   auto key = std::make_pair(sst_id, block_id);
+  auto pinned = pinned_map_.find(key);
+  if (pinned != pinned_map_.end()) {
+    ++hit_requests_;
+    return pinned->second;
+  }
   auto it = cache_map_.find(key);
   if (it == cache_map_.end()) {
     return nullptr;
@@ -19,22 +45,152 @@ std::shared_ptr<Block> BlockCache::Get(int sst_id, int block_id) {
   return res;
 }
 
-void BlockCache::Put(int sst_id, int block_id, std::shared_ptr<Block> block) {
-  std::lock_guard<std::mutex> lock(mutex_);
+void BlockCache::Put(int sst_id, int block_id, std::shared_ptr<Block> block, CachePriority priority, bool pinned) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    InternalPut(sst_id, block_id, std::move(block), priority, pinned);
+  }
+  Demote();
+}
+
+void BlockCache::InternalPut(int sst_id, int block_id, std::shared_ptr<Block> block, CachePriority priority,
+                             bool pinned) {
   auto key = std::make_pair(sst_id, block_id);
+  if (pinned_map_.find(key) != pinned_map_.end()) {
+    return;
+  }
   auto it = cache_map_.find(key);
-  if (it != cache_map_.end()) {
+  if (pinned) {
+    if (it != cache_map_.end()) {
+      auto node = it->second;
+      auto p = static_cast<size_t>(node->GetPriority());
+      auto &list = node->GetHistory().size() >= k_ ? hot_lists_[p] : cold_lists_[p];
+      usage_bytes_ -= node->GetCharge();
+      list.erase(node);
+      cache_map_.erase(it);
+    }
+    usage_bytes_ += block->MemoryUsage();
+    pinned_map_[key] = std::move(block);
+    return;
+  }
+  if (it == cache_map_.end()) {
+    Insert(sst_id, block_id, std::move(block), priority);
     return;
   }
 
-  if (cache_map_.size() >= capacity_) {
-    Evict();
+  // raise the cached block to the new priority, it keeps its access history
+  auto node = it->second;
+  if (node->GetPriority() >= priority) {
+    return;
+  }
+  auto from = static_cast<size_t>(node->GetPriority());
+  auto to = static_cast<size_t>(priority);
+  node->SetPriority(priority);
+  if (node->GetHistory().size() >= k_) {
+    auto pos = hot_lists_[to].begin();
+    while (pos != hot_lists_[to].end() && pos->GetHistory().front() < node->GetHistory().front()) {
+      pos++;
+    }
+    hot_lists_[to].splice(pos, hot_lists_[from], node);
+  } else {
+    cold_lists_[to].splice(cold_lists_[to].end(), cold_lists_[from], node);
   }
+}
 
-  auto node = cold_list_.emplace(cold_list_.end(), sst_id, block_id, k_);
-  node->SetBlock(std::move(block));
-  cache_map_[key] = node;
-  RecordAccess(node);
+void BlockCache::Pin(int sst_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++pin_refs_[sst_id];
+}
+
+void BlockCache::Unpin(int sst_id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto refs = pin_refs_.find(sst_id);
+    if (refs != pin_refs_.end()) {
+      if (--refs->second > 0) {
+        return;
+      }
+      pin_refs_.erase(refs);
+    }
+    std::vector<std::pair<int, std::shared_ptr<Block>>> released;
+    for (auto it = pinned_map_.begin(); it != pinned_map_.end();) {
+      if (it->first.first == sst_id) {
+        usage_bytes_ -= it->second->MemoryUsage();
+        released.emplace_back(it->first.second, std::move(it->second));
+        it = pinned_map_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (auto &[block_id, block] : released) {
+      Insert(sst_id, block_id, std::move(block), CachePriority::kHigh);
+    }
+  }
+  Demote();
+}
+
+void BlockCache::SetMaxBytes(size_t max_bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_bytes_ = max_bytes;
+    while (!cache_map_.empty() && usage_bytes_ > max_bytes_) {
+      Evict(kNumPriorities);
+    }
+  }
+  Demote();
+}
+
+void BlockCache::SetCapacity(size_t capacity) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    for (size_t p = 0; p < kNumPriorities; p++) {
+      reserved_[p] = static_cast<size_t>(static_cast<double>(capacity_) * reserved_ratios_[p]);
+    }
+    while (cache_map_.size() > capacity_) {
+      Evict(kNumPriorities);
+    }
+  }
+  Demote();
+}
+
+size_t BlockCache::GetCapacity() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return capacity_;
+}
+
+size_t BlockCache::GetUsageBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return usage_bytes_;
+}
+
+void BlockCache::SetSecondaryCache(std::shared_ptr<SecondaryCache> secondary_cache) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  secondary_cache_ = std::move(secondary_cache);
+}
+
+std::shared_ptr<SecondaryCache> BlockCache::GetSecondaryCache() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return secondary_cache_;
+}
+
+void BlockCache::Demote() {
+  std::vector<CacheNode> demoted;
+  std::shared_ptr<SecondaryCache> secondary_cache;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (demoted_.empty()) {
+      return;
+    }
+    demoted.swap(demoted_);
+    secondary_cache = secondary_cache_;
+  }
+  if (secondary_cache == nullptr) {
+    return;
+  }
+  for (auto &node : demoted) {
+    secondary_cache->Insert(node.GetSSTId(), node.GetBlockId(), node.GetBlock());
+  }
 }
 
 double BlockCache::GetHitRate() const {
@@ -42,45 +198,92 @@ double BlockCache::GetHitRate() const {
   return total_requests_ == 0 ? 0 : static_cast<double>(hit_requests_) / total_requests_;
 }
 
-void BlockCache::Evict() {
-  if (!cold_list_.empty()) {
-    auto node = cold_list_.front();
-    cache_map_.erase(std::make_pair(node.GetSSTId(), node.GetBlockId()));
-    cold_list_.pop_front();
+size_t BlockCache::GetUsage(CachePriority priority) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return InternalUsage(static_cast<size_t>(priority));
+}
+
+size_t BlockCache::GetPinnedCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pinned_map_.size();
+}
+
+void BlockCache::Insert(int sst_id, int block_id, std::shared_ptr<Block> block, CachePriority priority) {
+  if (capacity_ == 0) {
     return;
   }
-  if (hot_list_.empty()) {
-    throw std::runtime_error("no cached_block to evict");
+  size_t charge = block->MemoryUsage();
+  while (!cache_map_.empty() && (cache_map_.size() >= capacity_ || usage_bytes_ + charge > max_bytes_)) {
+    Evict(static_cast<size_t>(priority));
   }
-  auto node = hot_list_.front();
+
+  auto &cold_list = cold_lists_[static_cast<size_t>(priority)];
+  auto node = cold_list.emplace(cold_list.end(), sst_id, block_id, k_, priority);
+  node->SetBlock(std::move(block));
+  usage_bytes_ += charge;
+  cache_map_[std::make_pair(sst_id, block_id)] = node;
+  RecordAccess(node);
+}
+
+size_t BlockCache::InternalUsage(size_t priority) const {
+  return cold_lists_[priority].size() + hot_lists_[priority].size();
+}
+
+void BlockCache::Evict(size_t incoming) {
+  // the lowest priority which would use more than its reserve gives up a block
+  for (size_t p = 0; p < kNumPriorities; p++) {
+    if (InternalUsage(p) > 0 && InternalUsage(p) + (p == incoming ? 1 : 0) > reserved_[p]) {
+      EvictFrom(p);
+      return;
+    }
+  }
+  for (size_t p = 0; p < kNumPriorities; p++) {
+    if (InternalUsage(p) > 0) {
+      EvictFrom(p);
+      return;
+    }
+  }
+  throw std::runtime_error("no cached_block to evict");
+}
+
+void BlockCache::EvictFrom(size_t priority) {
+  auto &list = cold_lists_[priority].empty() ? hot_lists_[priority] : cold_lists_[priority];
+  auto &node = list.front();
   cache_map_.erase(std::make_pair(node.GetSSTId(), node.GetBlockId()));
-  hot_list_.pop_front();
+  usage_bytes_ -= node.GetCharge();
+  // the blocks of scans not filling the cache are not worth the disk
+  if (secondary_cache_ != nullptr && priority != static_cast<size_t>(CachePriority::kLow)) {
+    demoted_.push_back(std::move(node));
+  }
+  list.pop_front();
 }
 
 void BlockCache::RecordAccess(std::list<CacheNode>::iterator it) {
+  auto &cold_list = cold_lists_[static_cast<size_t>(it->GetPriority())];
+  auto &hot_list = hot_lists_[static_cast<size_t>(it->GetPriority())];
   if (it->GetHistory().size() == k_ - 1) {
     it->AddTimeStamp(timestamp_++);
     auto cache_node = *it;
-    auto hot_list_it = hot_list_.begin();
-    while (hot_list_it != hot_list_.end() && hot_list_it->GetHistory().front() < cache_node.GetHistory().front()) {
+    auto hot_list_it = hot_list.begin();
+    while (hot_list_it != hot_list.end() && hot_list_it->GetHistory().front() < cache_node.GetHistory().front()) {
       hot_list_it++;
     }
-    auto new_it = hot_list_.insert(hot_list_it, cache_node);
-    cold_list_.erase(it);
+    auto new_it = hot_list.insert(hot_list_it, cache_node);
+    cold_list.erase(it);
     cache_map_[std::make_pair(cache_node.GetSSTId(), cache_node.GetBlockId())] = new_it;
   } else if (it->GetHistory().size() == k_) {
     it->AddTimeStamp(timestamp_++);
     auto cache_node = *it;
-    hot_list_.erase(it);
-    auto hot_list_it = hot_list_.begin();
-    while (hot_list_it != hot_list_.end() && hot_list_it->GetHistory().front() < cache_node.GetHistory().front()) {
+    hot_list.erase(it);
+    auto hot_list_it = hot_list.begin();
+    while (hot_list_it != hot_list.end() && hot_list_it->GetHistory().front() < cache_node.GetHistory().front()) {
       hot_list_it++;
     }
-    auto new_it = hot_list_.insert(hot_list_it, cache_node);
+    auto new_it = hot_list.insert(hot_list_it, cache_node);
     cache_map_[std::make_pair(cache_node.GetSSTId(), cache_node.GetBlockId())] = new_it;
   } else {
     it->AddTimeStamp(timestamp_++);
-    cold_list_.splice(cold_list_.end(), cold_list_, it);
+    cold_list.splice(cold_list.end(), cold_list, it);
     cache_map_[std::make_pair(it->GetSSTId(), it->GetBlockId())] = it;
   }
 }
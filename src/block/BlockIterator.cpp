@@ -35,6 +35,14 @@ BlockIterator &BlockIterator::operator++() {
   return *this;
 }
 
+BlockIterator &BlockIterator::operator--() {
+  if (block_) {
+    current_idx_ = current_idx_ == 0 ? block_->offsets_.size() : current_idx_ - 1;
+  }
+  UpdateCurrent();
+  return *this;
+}
+
 bool BlockIterator::operator==(const BlockIterator &other) const {
   if (block_ != other.block_) {
     return false;
@@ -59,6 +67,8 @@ BlockIterator::value_type &BlockIterator::operator*() const {
   return cached_value_.value();
 }
 
-bool BlockIterator::IsEnd() {
+bool BlockIterator::IsEnd() const {
   return current_idx_ >= block_->offsets_.size();
-}
\ No newline at end of file
+}
+
+bool BlockIterator::IsLast() const { return current_idx_ + 1 == block_->offsets_.size(); }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <block/BlockMeta.h>
+#include <utils/Crc32c.h>
 #include <cstring>
 #include <stdexcept>
 
@@ -41,8 +42,7 @@ void BlockMeta::EncodeMeta(const std::vector<BlockMeta> &meta_entries, std::vect
   // Write the hash
   const uint8_t *data_start = meta->data() + sizeof(uint32_t);
   const uint8_t *data_end = data;
-  uint32_t hash = std::hash<std::string_view>{}(
-      std::string_view(reinterpret_cast<const char *>(data_start), data_end - data_start));
+  uint32_t hash = Crc32c::Value(data_start, data_end - data_start);
   memcpy(data, &hash, sizeof(uint32_t));
 }
 
@@ -83,8 +83,7 @@ std::vector<BlockMeta> BlockMeta::DecodeMeta(const std::vector<uint8_t> &meta) {
 
   const uint8_t *data_start = meta.data() + sizeof(uint32_t);
   const uint8_t *data_end = data;
-  uint32_t hash = std::hash<std::string_view>{}(
-      std::string_view(reinterpret_cast<const char *>(data_start), data_end - data_start));
+  uint32_t hash = Crc32c::Value(data_start, data_end - data_start);
   if (hash != stored_hash) {
     throw std::runtime_error("Meta Hash mismatch");
   }
@@ -0,0 +1,206 @@
+#include <block/SecondaryCache.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utils/Crc32c.h>
+#include <zlib.h>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+// sst id, block id, raw size, compressed size and crc32c of the compressed data
+constexpr size_t HEADER_SIZE = 5 * sizeof(uint32_t);
+
+std::vector<uint8_t> Compress(const std::vector<uint8_t> &raw) {
+  uLongf size = compressBound(raw.size());
+  std::vector<uint8_t> res(size);
+  if (compress2(res.data(), &size, raw.data(), raw.size(), Z_BEST_SPEED) != Z_OK) {
+    throw std::runtime_error("Failed to compress block");
+  }
+  res.resize(size);
+  return res;
+}
+
+bool Uncompress(const uint8_t *data, size_t size, std::vector<uint8_t> *raw) {
+  uLongf raw_size = raw->size();
+  return uncompress(raw->data(), &raw_size, data, size) == Z_OK && raw_size == raw->size();
+}
+}  // namespace
+
+SecondaryCache::SecondaryCache(std::string path, size_t capacity, size_t admission_entries)
+    : path_(std::move(path)), capacity_(capacity), admission_capacity_(admission_entries) {
+  if (capacity_ <= HEADER_SIZE) {
+    throw std::invalid_argument("SecondaryCache capacity is too small");
+  }
+  fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    throw std::runtime_error("Failed to open secondary cache file " + path_);
+  }
+}
+
+SecondaryCache::~SecondaryCache() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+bool SecondaryCache::Insert(int sst_id, int block_id, const std::shared_ptr<Block> &block) {
+  auto key = std::make_pair(sst_id, block_id);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(key) != 0 || !Admit(key)) {
+      return false;
+    }
+  }
+
+  // compress without holding the lock
+  auto raw = block->Encode();
+  auto compressed = Compress(raw);
+  std::vector<uint8_t> record(HEADER_SIZE + compressed.size());
+  uint32_t header[5] = {static_cast<uint32_t>(sst_id), static_cast<uint32_t>(block_id),
+                        static_cast<uint32_t>(raw.size()), static_cast<uint32_t>(compressed.size()),
+                        Crc32c::Value(compressed.data(), compressed.size())};
+  memcpy(record.data(), header, HEADER_SIZE);
+  memcpy(record.data() + HEADER_SIZE, compressed.data(), compressed.size());
+  if (record.size() > capacity_) {
+    return false;
+  }
+
+  size_t offset;
+  {
+    // reserve the range, the record is written without holding the lock
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(key) != 0) {
+      return false;
+    }
+    offset = Allocate(record.size());
+    index_[key] = {offset, record.size(), false};
+    records_[offset] = key;
+  }
+  size_t done = 0;
+  while (done < record.size()) {
+    ssize_t n = ::pwrite(fd_, record.data() + done, record.size() - done, static_cast<off_t>(offset + done));
+    if (n <= 0) {
+      break;
+    }
+    done += static_cast<size_t>(n);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // the reservation may have been erased or overwritten meanwhile
+  auto it = index_.find(key);
+  if (it == index_.end() || it->second.offset_ != offset) {
+    return false;
+  }
+  if (done < record.size()) {
+    // the space stays unused until it is overwritten
+    records_.erase(offset);
+    index_.erase(it);
+    return false;
+  }
+  it->second.written_ = true;
+  return true;
+}
+
+std::shared_ptr<Block> SecondaryCache::Lookup(int sst_id, int block_id) {
+  auto key = std::make_pair(sst_id, block_id);
+  Handle handle;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++total_requests_;
+    auto it = index_.find(key);
+    if (it == index_.end() || !it->second.written_) {
+      return nullptr;
+    }
+    handle = it->second;
+  }
+
+  // the record may be overwritten while it is read, the header and the checksum tell
+  std::vector<uint8_t> record(handle.size_);
+  size_t done = 0;
+  while (done < record.size()) {
+    ssize_t n = ::pread(fd_, record.data() + done, record.size() - done, static_cast<off_t>(handle.offset_ + done));
+    if (n <= 0) {
+      return nullptr;
+    }
+    done += static_cast<size_t>(n);
+  }
+  uint32_t header[5];
+  memcpy(header, record.data(), HEADER_SIZE);
+  if (header[0] != static_cast<uint32_t>(sst_id) || header[1] != static_cast<uint32_t>(block_id) ||
+      HEADER_SIZE + header[3] != record.size() ||
+      Crc32c::Value(record.data() + HEADER_SIZE, header[3]) != header[4]) {
+    return nullptr;
+  }
+  std::vector<uint8_t> raw(header[2]);
+  if (!Uncompress(record.data() + HEADER_SIZE, header[3], &raw)) {
+    return nullptr;
+  }
+  auto block = Block::Decode(raw);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++hit_requests_;
+  return block;
+}
+
+void SecondaryCache::Erase(int sst_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = index_.begin(); it != index_.end();) {
+    if (it->first.first == sst_id) {
+      records_.erase(it->second.offset_);
+      it = index_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t SecondaryCache::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return index_.size();
+}
+
+double SecondaryCache::GetHitRate() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return total_requests_ == 0 ? 0 : static_cast<double>(hit_requests_) / total_requests_;
+}
+
+size_t SecondaryCache::Allocate(size_t size) {
+  if (write_offset_ + size > capacity_) {
+    write_offset_ = 0;
+  }
+  size_t begin = write_offset_;
+  size_t end = begin + size;
+  // the record starting before begin may reach into the range
+  auto it = records_.lower_bound(begin);
+  if (it != records_.begin()) {
+    auto prev = std::prev(it);
+    if (prev->first + index_[prev->second].size_ > begin) {
+      it = prev;
+    }
+  }
+  while (it != records_.end() && it->first < end) {
+    index_.erase(it->second);
+    it = records_.erase(it);
+  }
+  write_offset_ = end;
+  return begin;
+}
+
+bool SecondaryCache::Admit(const Key &key) {
+  auto it = admission_map_.find(key);
+  if (it != admission_map_.end()) {
+    admission_list_.erase(it->second);
+    admission_map_.erase(it);
+    return true;
+  }
+  if (admission_capacity_ == 0) {
+    return false;
+  }
+  admission_map_[key] = admission_list_.insert(admission_list_.end(), key);
+  if (admission_list_.size() > admission_capacity_) {
+    admission_map_.erase(admission_list_.front());
+    admission_list_.pop_front();
+  }
+  return false;
+}
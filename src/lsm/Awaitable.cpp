@@ -0,0 +1,147 @@
+#include <lsm/Awaitable.h>
+#include <lsm/LSMEngine.h>
+#include <limits>
+#include <utility>
+
+// **************** BlockReadAwaitable ****************
+BlockReadAwaitable::BlockReadAwaitable(AsyncBlockReader *reader, std::vector<BlockReadRequest> requests,
+                                       const ReadOptions &options)
+    : reader_(reader), requests_(std::move(requests)), options_(options) {}
+
+bool BlockReadAwaitable::await_suspend(std::coroutine_handle<> handle) {
+  // the blocks cached meanwhile are not read, the coroutine does not suspend if all of them are
+  std::vector<BlockReadRequest> requests;
+  for (const auto &request : requests_) {
+    if (request.sst_->GetCachedBlock(request.block_idx_) == nullptr) {
+      requests.push_back(request);
+    }
+  }
+  if (requests.empty()) {
+    return false;
+  }
+  // the last read to complete resumes the coroutine, on the reader's thread unless it completes inline.
+  // The coroutine may then run or be destroyed before Submit() returns, so only locals are used from here
+  auto state = std::make_shared<State>();
+  state->remaining_ = requests.size();
+  state_ = state;
+  ReadOptions options = options_;
+  AsyncBlockReader *reader = reader_;
+  for (const auto &request : requests) {
+    reader->Submit(request, options, [state, handle](std::shared_ptr<Block> block, std::exception_ptr error) {
+      if (error != nullptr) {
+        std::lock_guard<std::mutex> lock(state->mutex_);
+        if (state->error_ == nullptr) {
+          state->error_ = error;
+        }
+      }
+      if (--state->remaining_ == 0) {
+        handle.resume();
+      }
+    });
+  }
+  return true;
+}
+
+void BlockReadAwaitable::await_resume() {
+  if (state_ == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(state_->mutex_);
+  if (state_->error_ != nullptr) {
+    std::rethrow_exception(state_->error_);
+  }
+}
+
+// **************** GetAwaitable ****************
+GetAwaitable::GetAwaitable(LSMEngine *engine, ColumnFamily *cf, std::string key, const ReadOptions &options)
+    : engine_(engine), cf_(cf), key_(std::move(key)), options_(options) {}
+
+bool GetAwaitable::await_ready() {
+  lookup_.emplace(*cf_, key_);
+  auto &lookup = lookup_.value();
+  std::vector<BlockReadRequest> requests;
+  {
+    // the memtable is read under the same locks as the synchronous Get, no lock is held across the suspension,
+    // the SSTs of the moment the memtable is read are kept instead
+    std::shared_lock<std::shared_mutex> lock(engine_->write_mutex_);
+    std::shared_lock<std::shared_mutex> cf_lock(cf_->mutex_);
+    if (cf_->memtable_.GetVersions(key_, [&lookup](const std::string &value) { return lookup.Add(value); })) {
+      in_memtable_ = true;
+      return true;
+    }
+    lock.unlock();
+    ssts_ = engine_->GetSSTs(*cf_);
+    requests = engine_->CollectBlockReads(*cf_, {key_}, options_);
+  }
+  reads_ = BlockReadAwaitable(engine_->async_reader_.get(), std::move(requests), options_);
+  return reads_.await_ready();
+}
+
+std::optional<std::string> GetAwaitable::await_resume() {
+  if (in_memtable_) {
+    return lookup_->Finish();
+  }
+  reads_.await_resume();
+  // the blocks are cached now, unless they were evicted meanwhile and are read again
+  return LSMEngine::GetFromSST(ssts_, &lookup_.value(), options_);
+}
+
+// **************** AsyncLSMIterator ****************
+AsyncLSMIterator::AsyncLSMIterator(AsyncBlockReader *reader, MergeIterator iter, std::vector<SSTIterator *> sst_iters,
+                                   const ReadOptions &options)
+    : reader_(reader),
+      iter_(std::move(iter)),
+      sst_iters_(std::move(sst_iters)),
+      prefetched_(sst_iters_.size(), std::numeric_limits<size_t>::max()),
+      options_(options) {}
+
+bool NextAwaitable::await_ready() {
+  if (iter_->IsEnd()) {
+    return true;
+  }
+  std::vector<BlockReadRequest> requests;
+  for (size_t i = 0; i < iter_->sst_iters_.size(); i++) {
+    auto *sst_iter = iter_->sst_iters_[i];
+    auto block_idx = sst_iter->NextBlockToRead();
+    if (!block_idx.has_value()) {
+      continue;
+    }
+    BlockReadRequest request{sst_iter->GetSST(), block_idx.value()};
+    if (sst_iter->AtBlockEnd()) {
+      // the step may move into the block, wait for it
+      requests.push_back(request);
+    } else if (iter_->prefetched_[i] != block_idx.value()) {
+      // read it while the rest of the current block is consumed, a failed read is retried by the step
+      iter_->prefetched_[i] = block_idx.value();
+      iter_->reader_->Submit(request, iter_->options_, [](const std::shared_ptr<Block> &, std::exception_ptr) {});
+    }
+  }
+  reads_ = BlockReadAwaitable(iter_->reader_, std::move(requests), iter_->options_);
+  return reads_.await_ready();
+}
+
+void NextAwaitable::await_resume() {
+  reads_.await_resume();
+  ++iter_->iter_;
+}
+
+// **************** ScanAwaitable ****************
+ScanAwaitable::ScanAwaitable(LSMEngine *engine, ColumnFamily *cf, std::string key, const ReadOptions &options)
+    : engine_(engine), cf_(cf), key_(std::move(key)), options_(options) {}
+
+bool ScanAwaitable::await_ready() {
+  std::vector<BlockReadRequest> requests;
+  {
+    std::shared_lock<std::shared_mutex> cf_lock(cf_->mutex_);
+    requests = engine_->CollectSeekReads(*cf_, key_, options_);
+  }
+  reads_ = BlockReadAwaitable(engine_->async_reader_.get(), std::move(requests), options_);
+  return reads_.await_ready();
+}
+
+AsyncLSMIterator ScanAwaitable::await_resume() {
+  reads_.await_resume();
+  std::vector<SSTIterator *> sst_iters;
+  auto iter = engine_->NewHeapIterator(*cf_, key_, options_, nullptr, &sst_iters);
+  return AsyncLSMIterator(engine_->async_reader_.get(), MergeIterator(std::move(iter)), std::move(sst_iters), options_);
+}
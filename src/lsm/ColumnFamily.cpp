@@ -0,0 +1,373 @@
+#include <lsm/ColumnFamily.h>
+#include <utils/Macro.h>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+ColumnFamily::ColumnFamily(std::string name, std::string dir, const ColumnFamilyOptions &options,
+                           std::shared_ptr<TableCache> table_cache, uint32_t row_cache_id,
+                           WriteBufferManager *write_buffer_manager)
+    : name_(std::move(name)),
+      dir_(std::move(dir)),
+      options_(options),
+      memtable_(write_buffer_manager, options.write_buffer_size, options.memtable_rep),
+      l0_bytes_(0),
+      table_cache_(std::move(table_cache)),
+      row_cache_id_(row_cache_id),
+      compaction_bytes_written_(0) {
+  if (options_.ttl > 0) {
+    ttl_filter_ = std::make_unique<TTLCompactionFilter>(options_.ttl);
+  }
+  auto ids = ListSSTIds(dir_);
+  std::sort(ids.begin(), ids.end(), std::greater<>());
+  l0_sst_ids_.assign(ids.begin(), ids.end());
+  for (auto sst_id : ids) {
+    l0_bytes_ += std::filesystem::file_size(table_cache_->GetSSTPath(sst_id));
+  }
+  auto blob_files = std::make_shared<BlobFiles>();
+  for (auto file_number : ListBlobFileNumbers(dir_)) {
+    blob_files->emplace(file_number, std::make_shared<BlobFileReader>(GetBlobPath(file_number), file_number));
+  }
+  blob_files_ = std::move(blob_files);
+}
+
+std::vector<size_t> ColumnFamily::ListSSTIds(const std::string &dir) { return ListFileIds(dir, "sst_"); }
+
+std::vector<size_t> ColumnFamily::ListBlobFileNumbers(const std::string &dir) { return ListFileIds(dir, "blob_"); }
+
+std::vector<size_t> ColumnFamily::ListFileIds(const std::string &dir, const std::string &prefix) {
+  std::vector<size_t> ids;
+  if (!std::filesystem::exists(dir)) {
+    return ids;
+  }
+  for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+    if (!entry.is_regular_file()) {
+      continue;
+    }
+    std::string filename = entry.path().filename().string();
+
+    if (filename.substr(0, prefix.size()) != prefix) {
+      continue;
+    }
+
+    std::string id_str = filename.substr(prefix.size());
+    if (id_str.empty()) {
+      continue;
+    }
+    ids.push_back(std::stoull(id_str));
+  }
+  return ids;
+}
+
+std::shared_ptr<SSTBuilder> ColumnFamily::NewSSTBuilder() const {
+  auto builder = std::make_shared<SSTBuilder>(options_.block_size, options_.prefix_extractor);
+  builder->SetIndexPartitionSize(options_.index_partition_size);
+  builder->SetDirectIO(table_cache_->UsesDirectIO());
+  return builder;
+}
+
+std::string ColumnFamily::Encode(ValueType type, const std::string &value, uint64_t write_time) const {
+  std::string res;
+  if (HasValueType()) {
+    res.push_back(static_cast<char>(type));
+  }
+  res += value;
+  if (ttl_filter_ != nullptr) {
+    return TTLCompactionFilter::AppendWriteTime(res, write_time);
+  }
+  return res;
+}
+
+ColumnFamily::ValueType ColumnFamily::Decode(const std::string &stored, std::string *value,
+                                             uint64_t *write_time) const {
+  if (stored.empty()) {
+    return ValueType::kDeletion;
+  }
+  size_t begin = 0;
+  size_t end = stored.size();
+  auto type = ValueType::kValue;
+  if (HasValueType()) {
+    type = static_cast<ValueType>(stored[0]);
+    begin = 1;
+  }
+  *write_time = 0;
+  if (ttl_filter_ != nullptr) {
+    *write_time = TTLCompactionFilter::GetWriteTime(stored);
+    end -= sizeof(uint64_t);
+  }
+  if (begin > end) {
+    throw std::runtime_error("Corrupted value");
+  }
+  value->assign(stored, begin, end - begin);
+  return type;
+}
+
+std::string ColumnFamily::EncodeValue(const std::string &value) const {
+  return Encode(ValueType::kValue, value, ttl_filter_ != nullptr ? TTLCompactionFilter::Now() : 0);
+}
+
+std::string ColumnFamily::EncodeMerge(const std::string &key, const std::optional<std::string> &existing,
+                                      const std::string &operand) const {
+  if (options_.merge_operator == nullptr) {
+    throw std::invalid_argument("Column family " + name_ + " has no merge operator");
+  }
+  uint64_t now = ttl_filter_ != nullptr ? TTLCompactionFilter::Now() : 0;
+  if (!existing.has_value()) {
+    return Encode(ValueType::kMerge, operand, now);
+  }
+
+  std::string value;
+  uint64_t write_time;
+  if (Decode(existing.value(), &value, &write_time) == ValueType::kMerge &&
+      (ttl_filter_ == nullptr || !ttl_filter_->IsExpired(existing.value(), now))) {
+    // the operator is associative, the combined operand stays unresolved
+    return Encode(ValueType::kMerge, options_.merge_operator->Merge(key, value, operand), now);
+  }
+  Lookup lookup(*this, key);
+  lookup.Add(existing.value());
+  return Encode(ValueType::kValue, options_.merge_operator->Merge(key, lookup.Finish(), operand), now);
+}
+
+std::optional<std::string> ColumnFamily::FilterValue(const std::string &key, const std::string &stored) const {
+  std::string new_value;
+  if (ttl_filter_ != nullptr && ttl_filter_->Filter(key, stored, &new_value) == CompactionFilter::Decision::kRemove) {
+    return std::nullopt;
+  }
+  if (options_.compaction_filter == nullptr) {
+    return stored;
+  }
+
+  // the user filter sees the user value, a changed value keeps the original write time
+  std::string value;
+  uint64_t write_time;
+  auto type = Decode(stored, &value, &write_time);
+  if (type == ValueType::kBlobIndex) {
+    value = ReadBlob(value, *GetBlobFiles());
+  } else if (type != ValueType::kValue) {
+    return stored;
+  }
+  switch (options_.compaction_filter->Filter(key, value, &new_value)) {
+    case CompactionFilter::Decision::kKeep:
+      return stored;
+    case CompactionFilter::Decision::kRemove:
+      return std::nullopt;
+    case CompactionFilter::Decision::kChangeValue:
+      if (new_value.empty()) {
+        return std::nullopt;
+      }
+      return Encode(ValueType::kValue, new_value, write_time);
+  }
+  return stored;
+}
+
+std::optional<std::string> ColumnFamily::CompactVersions(const std::string &key,
+                                                         const std::vector<std::string> &versions,
+                                                         bool bottommost) const {
+  // an empty stored value is a deletion
+  std::optional<std::string> removed;
+  if (!bottommost) {
+    removed = std::string();
+  }
+  std::string newest;
+  uint64_t write_time;
+  auto type = Decode(versions.front(), &newest, &write_time);
+  if (type == ValueType::kDeletion) {
+    return removed;
+  }
+  if (type != ValueType::kMerge) {
+    // the newest version is the value, a blob index is kept rather than read
+    auto res = FilterValue(key, versions.front());
+    return res.has_value() ? res : removed;
+  }
+
+  Lookup lookup(*this, key);
+  bool resolved = false;
+  for (const auto &version : versions) {
+    if (lookup.Add(version)) {
+      resolved = true;
+      break;
+    }
+  }
+  // the resolved value lives as long as the newest version
+  if (!resolved && !bottommost) {
+    return Encode(ValueType::kMerge, lookup.CombineOperands(), write_time);
+  }
+  auto value = lookup.Finish();
+  if (!value.has_value()) {
+    return removed;
+  }
+  auto res = FilterValue(key, Encode(ValueType::kValue, value.value(), write_time));
+  return res.has_value() ? res : removed;
+}
+
+std::function<std::optional<std::string>(const std::string &, const std::vector<std::string> &)>
+ColumnFamily::ValueReader() const {
+  if (ttl_filter_ == nullptr && !HasValueType()) {
+    return nullptr;
+  }
+  std::shared_ptr<const BlobFiles> blob_files;
+  if (options_.enable_blob_files) {
+    blob_files = GetBlobFiles();
+  }
+  return [this, blob_files](const std::string &key, const std::vector<std::string> &versions) {
+    Lookup lookup(*this, key, blob_files);
+    for (const auto &version : versions) {
+      if (lookup.Add(version)) {
+        break;
+      }
+    }
+    return lookup.Finish();
+  };
+}
+
+std::string ColumnFamily::GetBlobPath(uint64_t file_number) const {
+  return (std::filesystem::path(dir_) / ("blob_" + std::to_string(file_number))).string();
+}
+
+std::shared_ptr<const ColumnFamily::BlobFiles> ColumnFamily::GetBlobFiles() const {
+  std::lock_guard<std::mutex> lock(blob_mutex_);
+  return blob_files_;
+}
+
+void ColumnFamily::AddBlobFile(uint64_t file_number) {
+  auto reader = std::make_shared<BlobFileReader>(GetBlobPath(file_number), file_number);
+  std::lock_guard<std::mutex> lock(blob_mutex_);
+  auto blob_files = std::make_shared<BlobFiles>(*blob_files_);
+  blob_files->emplace(file_number, std::move(reader));
+  blob_files_ = std::move(blob_files);
+}
+
+void ColumnFamily::RemoveBlobFiles(const std::vector<uint64_t> &file_numbers) {
+  if (file_numbers.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(blob_mutex_);
+    auto blob_files = std::make_shared<BlobFiles>(*blob_files_);
+    for (auto file_number : file_numbers) {
+      blob_files->erase(file_number);
+    }
+    blob_files_ = std::move(blob_files);
+  }
+  // the iterators still holding a reader keep the file open
+  for (auto file_number : file_numbers) {
+    std::filesystem::remove(GetBlobPath(file_number));
+  }
+}
+
+std::string ColumnFamily::ReadBlob(const std::string &encoded_index, const BlobFiles &blob_files) const {
+  auto index = BlobIndex::Decode(encoded_index);
+  auto it = blob_files.find(index.file_number_);
+  if (it == blob_files.end()) {
+    throw std::runtime_error("Missing blob file " + std::to_string(index.file_number_) + " of column family " +
+                             name_);
+  }
+  return it->second->Read(index);
+}
+
+std::string ColumnFamily::SeparateValue(const std::string &stored, BlobFileBuilder *builder,
+                                        uint64_t relocate_before, std::set<uint64_t> *referenced) const {
+  std::string value;
+  uint64_t write_time;
+  auto type = Decode(stored, &value, &write_time);
+  if (type == ValueType::kBlobIndex) {
+    auto index = BlobIndex::Decode(value);
+    if (index.file_number_ >= relocate_before) {
+      if (referenced != nullptr) {
+        referenced->insert(index.file_number_);
+      }
+      return stored;
+    }
+    value = ReadBlob(value, *GetBlobFiles());
+  } else if (type != ValueType::kValue || value.size() < options_.min_blob_size) {
+    return stored;
+  }
+  auto index = builder->Add(value);
+  if (referenced != nullptr) {
+    referenced->insert(index.file_number_);
+  }
+  return Encode(ValueType::kBlobIndex, index.Encode(), write_time);
+}
+
+size_t ColumnFamily::PendingBytes() {
+  size_t res = memtable_.GetFrozenSize();
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  // a single SST is already compacted, the SSTs of a FIFO column family are never merged
+  if (l0_sst_ids_.size() > 1 && options_.compaction_style != CompactionStyle::kFifo) {
+    res += l0_bytes_;
+  }
+  return res;
+}
+
+WriteStall ColumnFamily::GetWriteStall(double *severity) {
+  size_t l0_count;
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    l0_count = l0_sst_ids_.size();
+  }
+  WriteStall res = WriteStall::kNone;
+  *severity = 0;
+  auto check = [&res, severity](uint64_t value, uint64_t slowdown, uint64_t stop) {
+    if (stop > 0 && value >= stop) {
+      res = WriteStall::kStopped;
+    } else if (slowdown > 0 && value >= slowdown) {
+      if (res == WriteStall::kNone) {
+        res = WriteStall::kDelayed;
+      }
+      if (stop > slowdown) {
+        *severity = std::max(*severity, static_cast<double>(value - slowdown) / static_cast<double>(stop - slowdown));
+      }
+    }
+  };
+  check(memtable_.GetFrozenCount(), options_.frozen_memtables_slowdown_trigger,
+        options_.frozen_memtables_stop_trigger);
+  if (options_.compaction_style != CompactionStyle::kFifo) {
+    check(l0_count, options_.level0_slowdown_writes_trigger, options_.level0_stop_writes_trigger);
+  }
+  check(PendingBytes(), options_.soft_pending_bytes_limit, options_.hard_pending_bytes_limit);
+  return res;
+}
+
+// **************** ColumnFamily::Lookup ****************
+bool ColumnFamily::Lookup::Add(const std::string &stored) {
+  std::string value;
+  uint64_t write_time;
+  auto type = cf_.Decode(stored, &value, &write_time);
+  if (type == ValueType::kDeletion ||
+      (cf_.ttl_filter_ != nullptr && cf_.ttl_filter_->IsExpired(stored, TTLCompactionFilter::Now()))) {
+    // an expired entry hides the older versions like a deletion
+    return true;
+  }
+  if (type == ValueType::kValue) {
+    base_ = std::move(value);
+    return true;
+  }
+  if (type == ValueType::kBlobIndex) {
+    if (blob_files_ == nullptr) {
+      blob_files_ = cf_.GetBlobFiles();
+    }
+    base_ = cf_.ReadBlob(value, *blob_files_);
+    return true;
+  }
+  operands_.push_back(std::move(value));
+  return false;
+}
+
+std::string ColumnFamily::Lookup::CombineOperands() const {
+  auto res = operands_.back();
+  for (auto it = std::next(operands_.rbegin()); it != operands_.rend(); ++it) {
+    res = cf_.options_.merge_operator->Merge(key_, res, *it);
+  }
+  return res;
+}
+
+std::optional<std::string> ColumnFamily::Lookup::Finish() const {
+  auto res = base_;
+  for (auto it = operands_.rbegin(); it != operands_.rend(); ++it) {
+    res = cf_.options_.merge_operator->Merge(key_, res, *it);
+  }
+  return res;
+}
@@ -0,0 +1,39 @@
+#include <lsm/CompactionPicker.h>
+#include <algorithm>
+
+UniversalCompactionPicker::UniversalCompactionPicker(const UniversalCompactionOptions &options, size_t trigger)
+    : options_(options), trigger_(std::max<size_t>(trigger, 2)) {
+  options_.min_merge_width = std::max<size_t>(options_.min_merge_width, 2);
+  options_.max_merge_width = std::max(options_.max_merge_width, options_.min_merge_width);
+}
+
+std::optional<CompactionPick> UniversalCompactionPicker::Pick(const std::vector<SortedRun> &runs) const {
+  if (runs.size() < trigger_) {
+    return std::nullopt;
+  }
+
+  size_t newer_size = 0;
+  for (size_t i = 0; i + 1 < runs.size(); i++) {
+    newer_size += runs[i].size_;
+  }
+  if (newer_size * 100 >= static_cast<size_t>(options_.max_size_amplification_percent) * runs.back().size_) {
+    return CompactionPick{runs.size(), CompactionReason::kSizeAmplification};
+  }
+
+  for (size_t start = 0; start < runs.size(); start++) {
+    size_t candidate_size = runs[start].size_;
+    size_t end = start + 1;
+    while (end < runs.size() && end < options_.max_merge_width &&
+           runs[end].size_ * 100 <= candidate_size * (100 + options_.size_ratio)) {
+      candidate_size += runs[end].size_;
+      end++;
+    }
+    if (end - start >= options_.min_merge_width) {
+      // the runs newer than start are merged along
+      return CompactionPick{end, CompactionReason::kSizeRatio};
+    }
+  }
+
+  size_t num_runs = std::max(runs.size() - trigger_ + 1, options_.min_merge_width);
+  return CompactionPick{std::min(num_runs, runs.size()), CompactionReason::kRunCount};
+}
@@ -1,177 +1,1319 @@
 #include <lsm/LSMEngine.h>
 #include <utils/Macro.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <thread>
 
-LSMEngine::LSMEngine(std::string data_dir) : data_dir_(std::move(data_dir)) {
-  block_cache_ = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+namespace {
+Options DefaultOptions(std::shared_ptr<const PrefixExtractor> prefix_extractor) {
+  Options options;
+  options.prefix_extractor = std::move(prefix_extractor);
+  return options;
+}
+}  // namespace
+
+LSMEngine::LSMEngine(std::string data_dir, std::shared_ptr<const PrefixExtractor> prefix_extractor)
+    : LSMEngine(std::move(data_dir), DefaultOptions(std::move(prefix_extractor))) {}
+
+LSMEngine::LSMEngine(std::string data_dir, const ColumnFamilyOptions &default_options)
+    : LSMEngine(std::move(data_dir), Options(default_options)) {}
+
+LSMEngine::LSMEngine(std::string data_dir, const Options &options)
+    : data_dir_(std::move(data_dir)),
+      options_(options),
+      next_sst_id_(0),
+      next_row_cache_id_(0),
+      next_log_number_(0),
+      log_last_sequence_(0),
+      first_log_number_(0),
+      applied_sequence_(0) {
+  block_cache_ = std::make_shared<BlockCache>(options_.block_cache_capacity, options_.block_cache_k,
+                                              options_.block_cache_high_pri_ratio, options_.block_cache_low_pri_ratio);
+  async_reader_ = std::make_shared<AsyncBlockReader>(options_.async_read_queue_depth, options_.async_read_threads);
+  row_cache_ = std::make_unique<RowCache>(options_.row_cache_capacity, options_.row_cache_shards);
+  write_buffer_manager_ =
+      std::make_unique<WriteBufferManager>(options_.db_write_buffer_size, options_.memory_budget, block_cache_);
+  write_controller_ = std::make_unique<WriteController>(options_.delayed_write_rate);
 
   if (!std::filesystem::exists(data_dir_)) {
     std::filesystem::create_directories(data_dir_);
-  } else {
-    for (const auto &entry : std::filesystem::directory_iterator(data_dir_)) {
-      if (!entry.is_regular_file()) {
-        continue;
+  }
+  wal_dir_ = (std::filesystem::path(data_dir_) / "wal").string();
+  std::filesystem::create_directories(wal_dir_);
+  // new SSTs and blob files get ids above all the files on disk, including those of column families not opened yet
+  std::vector<std::string> dirs{data_dir_};
+  for (const auto &entry : std::filesystem::directory_iterator(data_dir_)) {
+    if (entry.is_directory() && entry.path().filename().string().rfind("cf_", 0) == 0) {
+      dirs.push_back(entry.path().string());
+    }
+  }
+  for (const auto &dir : dirs) {
+    for (auto sst_id : ColumnFamily::ListSSTIds(dir)) {
+      next_sst_id_ = std::max<SST_ID>(next_sst_id_, sst_id + 1);
+    }
+    for (auto sst_id : ColumnFamily::ListFileIds(dir, "tmp_sst_")) {
+      next_sst_id_ = std::max<SST_ID>(next_sst_id_, sst_id + 1);
+    }
+    for (auto file_number : ColumnFamily::ListBlobFileNumbers(dir)) {
+      next_sst_id_ = std::max<SST_ID>(next_sst_id_, file_number + 1);
+    }
+  }
+
+  uint64_t last_sequence = RecoverLogs();
+  applied_sequence_ = last_sequence;
+  log_last_sequence_ = last_sequence;
+  first_log_number_ = next_log_number_++;
+  log_writer_ = std::make_unique<LogWriter>(LogPath(first_log_number_), first_log_number_);
+  write_queue_ = std::make_unique<WriteQueue>(
+      [this](const std::vector<WriteQueue::Writer *> &group) { WriteLog(group); },
+      [this](const std::vector<WriteQueue::Writer *> &group) { ApplyGroup(group); }, last_sequence,
+      options_.max_write_group_bytes);
+
+  // replays the writes of the default column family the SSTs miss
+  default_column_family_ = CreateColumnFamily("default", options_);
+  DeleteObsoleteLogs();
+}
+
+LSMEngine::~LSMEngine() { FlushAll(); }
+
+std::string LSMEngine::ColumnFamilyDir(const std::string &name) const {
+  if (name == "default") {
+    return data_dir_;
+  }
+  return (std::filesystem::path(data_dir_) / ("cf_" + name)).string();
+}
+
+std::string LSMEngine::RowCacheKey(const ColumnFamily &cf, const std::string &key) {
+  uint32_t id = cf.row_cache_id_;
+  std::string res(reinterpret_cast<const char *>(&id), sizeof(uint32_t));
+  res += key;
+  return res;
+}
+
+void LSMEngine::InvalidateRow(ColumnFamily &cf, const std::string &key) {
+  if (cf.UsesRowCache()) {
+    row_cache_->Erase(RowCacheKey(cf, key));
+  }
+}
+
+std::string LSMEngine::LogPath(uint64_t number) const {
+  return (std::filesystem::path(wal_dir_) / ("log_" + std::to_string(number))).string();
+}
+
+std::string LSMEngine::FlushedSequencePath(const std::string &name) const {
+  return (std::filesystem::path(wal_dir_) / ("flushed_" + name)).string();
+}
+
+uint64_t LSMEngine::ReadFlushedSequence(const std::string &name, SST_ID *sst_id) const {
+  std::ifstream file(FlushedSequencePath(name), std::ios::binary);
+  uint64_t sequence = 0;
+  uint64_t flushed_sst_id = NO_SST;
+  if (!file.is_open() || !file.read(reinterpret_cast<char *>(&sequence), sizeof(uint64_t))) {
+    sequence = 0;
+  } else if (!file.read(reinterpret_cast<char *>(&flushed_sst_id), sizeof(uint64_t))) {
+    flushed_sst_id = NO_SST;
+  }
+  if (sst_id != nullptr) {
+    *sst_id = flushed_sst_id;
+  }
+  return sequence;
+}
+
+void LSMEngine::WriteFlushedSequence(const std::string &name, uint64_t sequence, SST_ID sst_id) {
+  WriteWalFile("flushed_" + name, {sequence, sst_id});
+}
+
+std::string LSMEngine::CompactionPath(const std::string &name) const {
+  return (std::filesystem::path(wal_dir_) / ("compaction_" + name)).string();
+}
+
+bool LSMEngine::ReadCompaction(const std::string &name, SST_ID *output_id, std::vector<SST_ID> *input_ids) const {
+  std::ifstream file(CompactionPath(name), std::ios::binary);
+  uint64_t id;
+  if (!file.is_open() || !file.read(reinterpret_cast<char *>(&id), sizeof(uint64_t))) {
+    return false;
+  }
+  *output_id = id;
+  input_ids->clear();
+  while (file.read(reinterpret_cast<char *>(&id), sizeof(uint64_t))) {
+    input_ids->push_back(id);
+  }
+  return true;
+}
+
+void LSMEngine::WriteCompaction(const std::string &name, SST_ID output_id, const std::vector<SST_ID> &input_ids) {
+  std::vector<uint64_t> data{output_id};
+  data.insert(data.end(), input_ids.begin(), input_ids.end());
+  WriteWalFile("compaction_" + name, data);
+}
+
+void LSMEngine::RemoveCompaction(const std::string &name) {
+  std::filesystem::remove(CompactionPath(name));
+  SyncPath(wal_dir_);
+}
+
+void LSMEngine::WriteWalFile(const std::string &filename, const std::vector<uint64_t> &data) {
+  // replaced by a rename, so a crash leaves either the old or the new content
+  auto path = (std::filesystem::path(wal_dir_) / filename).string();
+  auto tmp_path = (std::filesystem::path(wal_dir_) / ("tmp_" + filename)).string();
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(data.data()),
+               static_cast<std::streamsize>(data.size() * sizeof(uint64_t)));
+    if (!file.flush()) {
+      throw std::runtime_error("Failed to write " + tmp_path);
+    }
+  }
+  SyncPath(tmp_path);
+  std::filesystem::rename(tmp_path, path);
+  SyncPath(wal_dir_);
+}
+
+std::string LSMEngine::TmpSSTPath(const std::string &sst_path) {
+  std::filesystem::path path(sst_path);
+  return (path.parent_path() / ("tmp_" + path.filename().string())).string();
+}
+
+void LSMEngine::RecoverTmpSSTs(const std::string &name, const TableCache &table_cache) {
+  SST_ID flushed_sst_id = NO_SST;
+  ReadFlushedSequence(name, &flushed_sst_id);
+  SST_ID compacted_sst_id = NO_SST;
+  std::vector<SST_ID> compaction_inputs;
+  bool compacted = ReadCompaction(name, &compacted_sst_id, &compaction_inputs);
+  for (auto sst_id : ColumnFamily::ListFileIds(table_cache.GetDataDir(), "tmp_sst_")) {
+    auto sst_path = table_cache.GetSSTPath(sst_id);
+    if (sst_id == flushed_sst_id || (compacted && sst_id == compacted_sst_id)) {
+      // the log entries it holds are no longer replayed, or the compaction inputs it replaces are deleted below
+      std::filesystem::rename(TmpSSTPath(sst_path), sst_path);
+    } else {
+      std::filesystem::remove(TmpSSTPath(sst_path));
+    }
+  }
+  // the output of a recorded compaction is complete, its inputs would apply their merge operands twice
+  for (auto sst_id : compaction_inputs) {
+    std::filesystem::remove(table_cache.GetSSTPath(sst_id));
+  }
+  SyncPath(table_cache.GetDataDir());
+  if (compacted) {
+    RemoveCompaction(name);
+  }
+}
+
+uint64_t LSMEngine::RecoverLogs() {
+  // the logs may have been deleted since the last flush
+  uint64_t last_sequence = 0;
+  for (const auto &entry : std::filesystem::directory_iterator(wal_dir_)) {
+    auto filename = entry.path().filename().string();
+    if (filename.rfind("flushed_", 0) == 0) {
+      last_sequence = std::max(last_sequence, ReadFlushedSequence(filename.substr(std::strlen("flushed_"))));
+    }
+  }
+
+  auto log_numbers = ColumnFamily::ListFileIds(wal_dir_, "log_");
+  std::sort(log_numbers.begin(), log_numbers.end());
+  std::map<std::string, uint64_t> flushed_sequences;
+  for (auto log_number : log_numbers) {
+    LogReader reader(LogPath(log_number));
+    std::string payload;
+    uint64_t log_last_sequence = 0;
+    while (reader.ReadRecord(&payload)) {
+      auto record = LogRecord::Decode(payload);
+      auto sequence = record.sequence_;
+      for (auto &entry : record.entries_) {
+        auto it = flushed_sequences.find(entry.column_family_);
+        if (it == flushed_sequences.end()) {
+          it = flushed_sequences.emplace(entry.column_family_, ReadFlushedSequence(entry.column_family_)).first;
+        }
+        // the SSTs hold the writes up to the flushed sequence, a merge replayed over them would apply twice
+        if (sequence > it->second) {
+          pending_recovery_[entry.column_family_].emplace_back(sequence, std::move(entry));
+        }
+        log_last_sequence = std::max(log_last_sequence, sequence++);
       }
-      std::string filename = entry.path().filename().string();
+    }
+    old_logs_[log_number] = log_last_sequence;
+    last_sequence = std::max(last_sequence, log_last_sequence);
+    next_log_number_ = std::max<uint64_t>(next_log_number_, log_number + 1);
+  }
+  return last_sequence;
+}
 
-      if (filename.substr(0, 4) != "sst_") {
-        continue;
+void LSMEngine::WriteLog(const std::vector<WriteQueue::Writer *> &group) {
+  std::vector<std::string> payloads;
+  bool sync = false;
+  uint64_t last_sequence = 0;
+  for (auto *writer : group) {
+    if (writer->options_.disable_wal || writer->batch_->Count() == 0) {
+      continue;
+    }
+    LogRecord record;
+    record.sequence_ = writer->sequence_;
+    for (const auto &entry : writer->batch_->GetEntries()) {
+      auto *cf = entry.column_family_ == nullptr ? default_column_family_ : entry.column_family_;
+      record.entries_.push_back({entry.type_, cf->GetName(), entry.key_, entry.value_});
+    }
+    payloads.push_back(record.Encode());
+    sync = sync || writer->options_.sync;
+    last_sequence = writer->sequence_ + writer->batch_->Count() - 1;
+  }
+  if (payloads.empty()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(wal_mutex_);
+  if (log_writer_->GetSize() >= options_.max_wal_file_size) {
+    old_logs_[log_writer_->GetNumber()] = log_last_sequence_;
+    uint64_t log_number = next_log_number_++;
+    log_writer_ = std::make_unique<LogWriter>(LogPath(log_number), log_number);
+  }
+  // one write and at most one sync for the whole group
+  log_writer_->Append(payloads);
+  log_last_sequence_ = last_sequence;
+  if (sync) {
+    log_writer_->Sync();
+  }
+}
+
+void LSMEngine::ApplyGroup(const std::vector<WriteQueue::Writer *> &group) {
+  std::unique_lock<std::shared_mutex> lock(write_mutex_);
+  for (auto *writer : group) {
+    uint64_t sequence = writer->sequence_;
+    for (const auto &entry : writer->batch_->GetEntries()) {
+      auto *cf = entry.column_family_ == nullptr ? default_column_family_ : entry.column_family_;
+      ApplyEntry(cf, entry.type_, entry.key_, entry.value_, sequence++);
+    }
+  }
+  applied_sequence_ = group.back()->sequence_ + group.back()->batch_->Count() - 1;
+}
+
+void LSMEngine::ApplyEntry(ColumnFamily *cf, WriteBatch::EntryType type, const std::string &key,
+                           const std::string &value, uint64_t sequence) {
+  switch (type) {
+    case WriteBatch::EntryType::kPut:
+      cf->memtable_.Put(key, cf->EncodeValue(value), sequence);
+      break;
+    case WriteBatch::EntryType::kRemove:
+      cf->memtable_.Remove(key, sequence);
+      break;
+    case WriteBatch::EntryType::kMerge:
+      cf->memtable_.Merge(
+          key,
+          [cf, &key, &value](const std::optional<std::string> &existing) {
+            return cf->EncodeMerge(key, existing, value);
+          },
+          sequence);
+      break;
+  }
+  InvalidateRow(*cf, key);
+}
+
+void LSMEngine::DeleteObsoleteLogs() {
+  // read before the memtables: every write up to it is either in a memtable or flushed
+  uint64_t applied_sequence = applied_sequence_;
+  std::lock_guard<std::mutex> lock(wal_mutex_);
+  uint64_t oldest_sequence = std::numeric_limits<uint64_t>::max();
+  for (auto &[name, cf] : column_families_) {
+    auto sequence = cf->memtable_.GetOldestSequence();
+    if (sequence != 0) {
+      oldest_sequence = std::min(oldest_sequence, sequence);
+    }
+  }
+  for (auto it = old_logs_.begin(); it != old_logs_.end();) {
+    // the column families not opened yet replay from the logs of the previous run
+    bool recovering = it->first < first_log_number_ && !pending_recovery_.empty();
+    if (recovering || it->second > applied_sequence || it->second >= oldest_sequence) {
+      ++it;
+      continue;
+    }
+    std::filesystem::remove(LogPath(it->first));
+    it = old_logs_.erase(it);
+  }
+}
+
+ColumnFamily *LSMEngine::CreateColumnFamily(const std::string &name, const ColumnFamilyOptions &options) {
+  if (name.empty() || name.find('/') != std::string::npos) {
+    throw std::invalid_argument("Invalid column family name: " + name);
+  }
+  std::unique_lock<std::shared_mutex> lock(column_families_mutex_);
+  if (column_families_.count(name) != 0) {
+    throw std::invalid_argument("Column family already exists: " + name);
+  }
+
+  auto dir = ColumnFamilyDir(name);
+  std::filesystem::create_directories(dir);
+  auto table_cache = std::make_shared<TableCache>(dir, options_.table_cache_capacity, block_cache_,
+                                                  options_.use_direct_io, options.pin_l0_index_blocks);
+  RecoverTmpSSTs(name, *table_cache);
+  auto cf = std::make_unique<ColumnFamily>(name, dir, options, std::move(table_cache), next_row_cache_id_++,
+                                           write_buffer_manager_.get());
+  std::lock_guard<std::mutex> wal_lock(wal_mutex_);
+  auto pending = pending_recovery_.find(name);
+  if (pending != pending_recovery_.end()) {
+    // no writer sees the column family before it is in the map
+    for (const auto &[sequence, entry] : pending->second) {
+      ApplyEntry(cf.get(), entry.type_, entry.key_, entry.value_, sequence);
+    }
+    pending_recovery_.erase(pending);
+  }
+  auto *res = cf.get();
+  column_families_[name] = std::move(cf);
+  return res;
+}
+
+ColumnFamily *LSMEngine::GetColumnFamily(const std::string &name) {
+  std::shared_lock<std::shared_mutex> lock(column_families_mutex_);
+  auto it = column_families_.find(name);
+  return it == column_families_.end() ? nullptr : it->second.get();
+}
+
+void LSMEngine::DropColumnFamily(const std::string &name) {
+  if (name == "default") {
+    throw std::invalid_argument("The default column family cannot be dropped");
+  }
+  std::unique_lock<std::shared_mutex> lock(column_families_mutex_);
+  auto it = column_families_.find(name);
+  if (it == column_families_.end()) {
+    throw std::invalid_argument("Column family does not exist: " + name);
+  }
+  auto &cf = *it->second;
+  auto secondary_cache = block_cache_->GetSecondaryCache();
+  {
+    std::unique_lock<std::shared_mutex> cf_lock(cf.mutex_);
+    for (auto sst_id : cf.l0_sst_ids_) {
+      cf.table_cache_->Erase(sst_id);
+      // the records would hold the secondary cache file until they are overwritten
+      if (secondary_cache != nullptr) {
+        secondary_cache->Erase(static_cast<int>(sst_id));
+      }
+    }
+  }
+  std::lock_guard<std::mutex> wal_lock(wal_mutex_);
+  // the writes still in the log are not replayed into a column family created again with the name
+  WriteFlushedSequence(name, write_queue_->GetLastSequence());
+  std::filesystem::remove(CompactionPath(name));
+  // SST ids are never reused, so the blocks left in the block cache are simply never hit again
+  std::filesystem::remove_all(cf.dir_);
+  column_families_.erase(it);
+}
+
+void LSMEngine::SetOptions(ColumnFamily *cf, const std::unordered_map<std::string, std::string> &values) {
+  // the writers read the stall triggers under the column family map lock,
+  // the flushes and compactions read the other options under the flush mutex
+  std::unique_lock<std::shared_mutex> lock(column_families_mutex_);
+  std::lock_guard<std::mutex> compaction_lock(cf->compaction_mutex_);
+  std::lock_guard<std::mutex> flush_lock(cf->flush_mutex_);
+  SetColumnFamilyOptions(&cf->options_, values);
+  cf->memtable_.SetTableSizeLimit(cf->options_.write_buffer_size);
+  UpdateWriteStall();
+}
+
+void LSMEngine::SetDBOptions(const std::unordered_map<std::string, std::string> &values) {
+  std::lock_guard<std::mutex> lock(options_mutex_);
+  ::SetDBOptions(&options_, values);
+  write_buffer_manager_->SetBufferSize(options_.db_write_buffer_size);
+  write_buffer_manager_->SetMemoryBudget(options_.memory_budget);
+  block_cache_->SetCapacity(options_.block_cache_capacity);
+  row_cache_->SetCapacity(options_.row_cache_capacity);
+  write_controller_->SetDelayedWriteRate(options_.delayed_write_rate);
+}
+
+Options LSMEngine::GetDBOptions() {
+  Options res;
+  {
+    std::lock_guard<std::mutex> lock(options_mutex_);
+    res = options_;
+  }
+  // the column family options are those of the default column family, as changed by SetOptions()
+  std::lock_guard<std::mutex> flush_lock(default_column_family_->flush_mutex_);
+  static_cast<ColumnFamilyOptions &>(res) = default_column_family_->options_;
+  return res;
+}
+
+void LSMEngine::Write(const WriteBatch &batch, const WriteOptions &options) {
+  // reject the batch before logging any of it
+  for (const auto &entry : batch.GetEntries()) {
+    auto *cf = entry.column_family_ == nullptr ? default_column_family_ : entry.column_family_;
+    if (entry.type_ == WriteBatch::EntryType::kMerge && cf->options_.merge_operator == nullptr) {
+      throw std::invalid_argument("Column family " + cf->GetName() + " has no merge operator");
+    }
+  }
+
+  MaybeStallWrite(batch.GetDataSize());
+  write_queue_->Write(batch, options);
+  MaybeFlush();
+}
+
+void LSMEngine::Put(const std::string &key, const std::string &value, const WriteOptions &options) {
+  Put(default_column_family_, key, value, options);
+}
+
+void LSMEngine::Put(ColumnFamily *cf, const std::string &key, const std::string &value, const WriteOptions &options) {
+  WriteBatch batch;
+  batch.Put(cf, key, value);
+  Write(batch, options);
+}
+
+void LSMEngine::Merge(const std::string &key, const std::string &operand, const WriteOptions &options) {
+  Merge(default_column_family_, key, operand, options);
+}
+
+void LSMEngine::Merge(ColumnFamily *cf, const std::string &key, const std::string &operand,
+                      const WriteOptions &options) {
+  WriteBatch batch;
+  batch.Merge(cf, key, operand);
+  Write(batch, options);
+}
+
+void LSMEngine::MaybeFlush() {
+  std::shared_lock<std::shared_mutex> lock(column_families_mutex_);
+  size_t table_memory = 0;
+  if (write_buffer_manager_->GetMemoryBudget() > 0) {
+    for (auto &[name, cf] : column_families_) {
+      table_memory += cf->table_cache_->GetMemoryUsage();
+    }
+  }
+  if (write_buffer_manager_->ShouldFlush(table_memory)) {
+    size_t largest_size = 0;
+    ColumnFamily *largest = nullptr;
+    for (auto &[name, cf] : column_families_) {
+      size_t size = cf->memtable_.GetAllocatedBytes();
+      if (size > largest_size) {
+        largest_size = size;
+        largest = cf.get();
+      }
+    }
+    if (largest != nullptr) {
+      Flush(largest);
+    }
+  }
+  UpdateWriteStall();
+}
+
+void LSMEngine::UpdateWriteStall() {
+  WriteStall state = WriteStall::kNone;
+  double severity = 0;
+  for (auto &[name, cf] : column_families_) {
+    double cf_severity;
+    auto cf_state = cf->GetWriteStall(&cf_severity);
+    state = std::max(state, cf_state);
+    if (cf_state == WriteStall::kDelayed) {
+      severity = std::max(severity, cf_severity);
+    }
+  }
+  write_controller_->SetState(state, severity);
+}
+
+void LSMEngine::MaybeStallWrite(size_t bytes) {
+  if (write_controller_->GetState() == WriteStall::kNone) {
+    return;
+  }
+  {
+    // flushes and compactions called directly may have drained the backlog since the last write
+    std::shared_lock<std::shared_mutex> lock(column_families_mutex_);
+    UpdateWriteStall();
+  }
+  if (write_controller_->GetState() == WriteStall::kStopped) {
+    auto start = std::chrono::steady_clock::now();
+    DrainBacklog();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    write_controller_->RecordStop(elapsed.count());
+  }
+  auto delay = write_controller_->GetDelay(bytes);
+  if (delay > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(delay));
+    write_controller_->RecordDelay(delay);
+  }
+}
+
+void LSMEngine::DrainBacklog() {
+  std::shared_lock<std::shared_mutex> lock(column_families_mutex_);
+  for (auto &[name, cf] : column_families_) {
+    double severity;
+    while (cf->GetWriteStall(&severity) == WriteStall::kStopped) {
+      size_t frozen_count = cf->memtable_.GetFrozenCount();
+      size_t l0_count;
+      {
+        std::shared_lock<std::shared_mutex> cf_lock(cf->mutex_);
+        l0_count = cf->l0_sst_ids_.size();
+      }
+      auto stop = cf->options_.frozen_memtables_stop_trigger;
+      bool compactable = l0_count > 1 && cf->options_.compaction_style != CompactionStyle::kFifo;
+      // the frozen memtables are flushed first when there are too many of them, L0 is compacted otherwise
+      if (frozen_count > 0 && ((stop > 0 && frozen_count >= stop) || !compactable)) {
+        Flush(cf.get());
+      } else if (compactable) {
+        Compact(cf.get());
+      } else {
+        break;
       }
+    }
+  }
+  UpdateWriteStall();
+}
+
+std::optional<std::string> LSMEngine::Get(const std::string &key, const ReadOptions &options) {
+  return Get(default_column_family_, key, options);
+}
+
+std::optional<std::string> LSMEngine::Get(ColumnFamily *cf, const std::string &key, const ReadOptions &options) {
+  if (!cf->UsesRowCache()) {
+    return GetUncached(*cf, key, options);
+  }
+  auto cache_key = RowCacheKey(*cf, key);
+  auto cached = row_cache_->Get(cache_key);
+  if (cached.has_value()) {
+    return cached.value();
+  }
+  auto generation = row_cache_->GetGeneration(cache_key);
+  auto res = GetUncached(*cf, key, options);
+  row_cache_->Insert(cache_key, res, generation);
+  return res;
+}
+
+std::optional<std::string> LSMEngine::GetUncached(ColumnFamily &cf, const std::string &key,
+                                                  const ReadOptions &options) {
+  // search in memtable, the SSTs are taken under the same cf.mutex_ so that a flush in between is seen whole.
+  // They are read after it is released, a flush installing its SST does not wait for the lookup
+  ColumnFamily::Lookup lookup(cf, key);
+  std::vector<std::shared_ptr<SST>> ssts;
+  {
+    std::shared_lock<std::shared_mutex> lock(write_mutex_);
+    std::shared_lock<std::shared_mutex> cf_lock(cf.mutex_);
+    if (cf.memtable_.GetVersions(key, [&lookup](const std::string &value) { return lookup.Add(value); })) {
+      return lookup.Finish();
+    }
+    lock.unlock();
+    ssts = GetSSTs(cf);
+  }
+
+  // a point lookup reads its blocks one SST after another and stops at the first complete value,
+  // so it is not worth prefetching
+  return GetFromSST(ssts, &lookup, options);
+}
 
-      std::string id_str = filename.substr(4);
-      if (id_str.empty()) {
+std::vector<std::optional<std::string>> LSMEngine::MultiGet(const std::vector<std::string> &keys,
+                                                            const ReadOptions &options) {
+  return MultiGet(default_column_family_, keys, options);
+}
+
+std::vector<std::optional<std::string>> LSMEngine::MultiGet(ColumnFamily *cf, const std::vector<std::string> &keys,
+                                                            const ReadOptions &options) {
+  std::vector<std::optional<std::string>> res(keys.size());
+  std::vector<size_t> lookup_keys;  // the keys not in the row cache
+  std::vector<std::string> cache_keys;
+  std::vector<uint64_t> generations;
+  if (cf->UsesRowCache()) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      auto cache_key = RowCacheKey(*cf, keys[i]);
+      auto cached = row_cache_->Get(cache_key);
+      if (cached.has_value()) {
+        res[i] = cached.value();
         continue;
       }
-      SST_ID sst_id = std::stoull(id_str);
+      lookup_keys.push_back(i);
+      generations.push_back(row_cache_->GetGeneration(cache_key));
+      cache_keys.push_back(std::move(cache_key));
+    }
+  } else {
+    for (size_t i = 0; i < keys.size(); i++) {
+      lookup_keys.push_back(i);
+    }
+  }
 
-      std::unique_lock<std::shared_mutex> lock(mutex_);
-      std::string sst_path = GetSSTPath(sst_id);
-      auto sst = SST::Open(sst_id, FileObj::Open(sst_path), block_cache_);
-      ssts_[sst_id] = sst;
+  std::vector<ColumnFamily::Lookup> lookups;
+  lookups.reserve(keys.size());
+  std::vector<size_t> sst_lookups;  // the keys not resolved by the memtable
+  std::vector<std::shared_ptr<SST>> ssts;
+  std::vector<BlockReadRequest> requests;
+  {
+    // the SSTs and their blocks are taken with the memtable and read after the locks are released, see GetUncached()
+    std::shared_lock<std::shared_mutex> lock(write_mutex_);
+    std::shared_lock<std::shared_mutex> cf_lock(cf->mutex_);
+    for (auto i : lookup_keys) {
+      auto &lookup = lookups.emplace_back(*cf, keys[i]);
+      if (cf->memtable_.GetVersions(keys[i], [&lookup](const std::string &value) { return lookup.Add(value); })) {
+        res[i] = lookup.Finish();
+      } else {
+        sst_lookups.push_back(lookups.size() - 1);
+      }
+    }
+    lock.unlock();
 
-      l0_sst_ids_.push_back(sst_id);
+    // sst_lookups are indexes of lookups, lookup_keys maps them to the indexes of keys
+    std::vector<std::string> sst_keys;
+    sst_keys.reserve(sst_lookups.size());
+    for (auto i : sst_lookups) {
+      sst_keys.push_back(lookups[i].GetKey());
     }
+    ssts = GetSSTs(*cf);
+    requests = CollectBlockReads(*cf, sst_keys, options);
+  }
+  PrefetchBlocks(requests, options);
+  for (auto i : sst_lookups) {
+    res[lookup_keys[i]] = GetFromSST(ssts, &lookups[i], options);
+  }
+
+  for (size_t i = 0; i < cache_keys.size(); i++) {
+    row_cache_->Insert(cache_keys[i], res[lookup_keys[i]], generations[i]);
   }
-  l0_sst_ids_.sort();
-  l0_sst_ids_.reverse();
+  return res;
 }
 
-LSMEngine::~LSMEngine() { FlushAll(); }
+std::optional<std::string> LSMEngine::GetFromSST(const std::vector<std::shared_ptr<SST>> &ssts,
+                                                 ColumnFamily::Lookup *lookup, const ReadOptions &options) {
+  for (const auto &sst : ssts) {
+    auto sst_it = sst->Get(lookup->GetKey(), options);
+    if (sst_it.IsValid() && lookup->Add(sst_it.GetValue())) {
+      break;
+    }
+  }
 
-void LSMEngine::Put(const std::string &key, const std::string &value) {
-  memtable_.Put(key, value);
+  return lookup->Finish();
+}
 
-  if (memtable_.GetCurSize() >= LSM_TOL_MEM_SIZE_LIMIT) {
-    Flush();
+std::vector<std::shared_ptr<SST>> LSMEngine::GetSSTs(ColumnFamily &cf) {
+  std::vector<std::shared_ptr<SST>> ssts;
+  for (auto sst_id : cf.l0_sst_ids_) {
+    ssts.push_back(cf.table_cache_->FindTable(sst_id));
   }
+  return ssts;
 }
 
-std::optional<std::string> LSMEngine::Get(const std::string &key) {
-  // search in memtable
-  auto it = memtable_.Get(key);
-  if (it.has_value()) {
-    if (it.value().empty()) {
-      return std::nullopt;
+std::vector<BlockReadRequest> LSMEngine::CollectBlockReads(ColumnFamily &cf, const std::vector<std::string> &keys,
+                                                          const ReadOptions &options) {
+  std::vector<BlockReadRequest> requests;
+  std::set<std::pair<SST_ID, size_t>> requested;
+  for (auto sst_id : cf.l0_sst_ids_) {
+    auto sst = cf.table_cache_->FindTable(sst_id);
+    for (const auto &key : keys) {
+      if (key < sst->GetFirstKey() || key > sst->GetLastKey() || !sst->KeyMayMatch(key)) {
+        continue;
+      }
+      size_t block_idx = sst->FindBlockIndex(key, options);
+      if (requested.emplace(sst_id, block_idx).second && sst->GetCachedBlock(block_idx) == nullptr) {
+        requests.push_back({sst, block_idx});
+      }
+    }
+  }
+  return requests;
+}
+
+std::vector<BlockReadRequest> LSMEngine::CollectSeekReads(ColumnFamily &cf, const std::string &key,
+                                                         const ReadOptions &options) {
+  std::vector<BlockReadRequest> requests;
+  for (auto sst_id : cf.l0_sst_ids_) {
+    auto sst = cf.table_cache_->FindTable(sst_id);
+    if (sst->NumBlocks() == 0 || key > sst->GetLastKey()) {
+      continue;
+    }
+    size_t block_idx = key <= sst->GetFirstKey() ? 0 : sst->FindBlockIndex(key, options);
+    if (sst->GetCachedBlock(block_idx) == nullptr) {
+      requests.push_back({sst, block_idx});
+    }
+  }
+  return requests;
+}
+
+void LSMEngine::PrefetchBlocks(const std::vector<BlockReadRequest> &requests, const ReadOptions &options) {
+  // a single block is read by the lookup itself
+  if (requests.size() > 1) {
+    async_reader_->ReadBlocks(requests, options);
+  }
+}
+
+GetAwaitable LSMEngine::GetAsync(const std::string &key, const ReadOptions &options) {
+  return GetAsync(default_column_family_, key, options);
+}
+
+GetAwaitable LSMEngine::GetAsync(ColumnFamily *cf, const std::string &key, const ReadOptions &options) {
+  return GetAwaitable(this, cf, key, options);
+}
+
+ScanAwaitable LSMEngine::ScanAsync(const std::string &key, const ReadOptions &options) {
+  return ScanAsync(default_column_family_, key, options);
+}
+
+ScanAwaitable LSMEngine::ScanAsync(ColumnFamily *cf, const std::string &key, const ReadOptions &options) {
+  return ScanAwaitable(this, cf, key, options);
+}
+
+void LSMEngine::Remove(const std::string &key, const WriteOptions &options) {
+  Remove(default_column_family_, key, options);
+}
+
+void LSMEngine::Remove(ColumnFamily *cf, const std::string &key, const WriteOptions &options) {
+  WriteBatch batch;
+  batch.Remove(cf, key);
+  Write(batch, options);
+}
+
+void LSMEngine::Flush() { Flush(default_column_family_); }
+
+void LSMEngine::Flush(ColumnFamily *cf) {
+  if (FlushMemtable(cf)) {
+    MaybeCompact(cf);
+  }
+}
+
+bool LSMEngine::FlushMemtable(ColumnFamily *cf) {
+  std::lock_guard<std::mutex> flush_lock(cf->flush_mutex_);
+  if (cf->memtable_.GetTotalSize() == 0) {
+    return false;
+  }
+
+  SST_ID new_sst_id = next_sst_id_++;
+  auto sst_path = cf->table_cache_->GetSSTPath(new_sst_id);
+  auto tmp_sst_path = TmpSSTPath(sst_path);
+  auto blob_builder = NewBlobFileBuilder(cf);
+  std::function<std::optional<std::string>(const std::string &, const std::string &)> filter;
+  if (cf->HasFilter() || blob_builder != nullptr) {
+    filter = [cf, blob = blob_builder.get()](const std::string &key,
+                                             const std::string &value) -> std::optional<std::string> {
+      auto res = cf->HasFilter() ? cf->FilterValue(key, value) : value;
+      if (res.has_value() && blob != nullptr) {
+        return cf->SeparateValue(res.value(), blob);
+      }
+      return res;
+    };
+  }
+  auto new_sst = cf->memtable_.FlushLast(cf->NewSSTBuilder(), tmp_sst_path, new_sst_id, block_cache_, filter);
+  if (new_sst == nullptr) {
+    return false;
+  }
+  if (blob_builder != nullptr && blob_builder->Finish()) {
+    cf->AddBlobFile(blob_builder->GetFileNumber());
+  }
+  // the SST is listed on reopen only once its writes are no longer replayed from the log, a merge replayed over
+  // it would apply twice. A crash before the flushed sequence is written leaves the temporary SST, which
+  // recovery deletes, and after it one which recovery renames, see RecoverTmpSSTs()
+  SyncPath(tmp_sst_path);
+  // the names of the SST and of the new blob file, before the log entries they hold are no longer replayed
+  SyncPath(cf->dir_);
+  auto flushed_sequence = cf->memtable_.GetFlushingSequence();
+  if (flushed_sequence > 0) {
+    WriteFlushedSequence(cf->GetName(), flushed_sequence, new_sst_id);
+  }
+  std::filesystem::rename(tmp_sst_path, sst_path);
+  SyncPath(cf->dir_);
+
+  {
+    std::unique_lock<std::shared_mutex> lock(cf->mutex_);
+    cf->l0_sst_ids_.push_front(new_sst_id);
+    cf->l0_bytes_ += new_sst->GetSSTSize();
+    cf->table_cache_->Insert(new_sst);
+    cf->memtable_.ReleaseLast();
+  }
+  if (cf->HasFilter()) {
+    // the filters may have changed values, the rows cached before are left to the LRU
+    cf->row_cache_id_ = next_row_cache_id_++;
+  }
+  DeleteObsoleteLogs();
+  return true;
+}
+
+void LSMEngine::MaybeCompact(ColumnFamily *cf) {
+  switch (cf->options_.compaction_style) {
+    case CompactionStyle::kNone:
+      return;
+    case CompactionStyle::kUniversal: {
+      std::lock_guard<std::mutex> compaction_lock(cf->compaction_mutex_);
+      std::unique_lock<std::mutex> flush_lock(cf->flush_mutex_);
+      CompactUniversal(cf, &flush_lock);
+      return;
+    }
+    case CompactionStyle::kFifo: {
+      std::lock_guard<std::mutex> compaction_lock(cf->compaction_mutex_);
+      std::lock_guard<std::mutex> flush_lock(cf->flush_mutex_);
+      CompactFifo(cf);
+      return;
     }
-    return it.value();
   }
+}
 
-  // search in L0 SST
-  std::shared_lock<std::shared_mutex> lock(mutex_);
-  for (auto sst_id : l0_sst_ids_) {
-    auto sst = ssts_[sst_id];
-    auto sst_it = sst->Get(key);
-    if (sst_it != sst->End()) {
-      if (sst_it.GetValue().empty()) {
-        return std::nullopt;
+void LSMEngine::CompactUniversal(ColumnFamily *cf, std::unique_lock<std::mutex> *flush_lock) {
+  UniversalCompactionPicker picker(cf->options_.universal, cf->options_.level0_file_num_compaction_trigger);
+  // a merge may leave enough runs of similar size for the next one
+  while (true) {
+    std::vector<SortedRun> runs;
+    {
+      std::shared_lock<std::shared_mutex> lock(cf->mutex_);
+      for (auto sst_id : cf->l0_sst_ids_) {
+        runs.push_back({sst_id, cf->table_cache_->FindTable(sst_id)->GetSSTSize()});
       }
-      return sst_it.GetValue();
     }
+    auto pick = picker.Pick(runs);
+    if (!pick.has_value()) {
+      return;
+    }
+    std::vector<SST_ID> input_ids;
+    for (size_t i = 0; i < pick->num_runs_; i++) {
+      input_ids.push_back(runs[i].sst_id_);
+    }
+    CompactRuns(cf, flush_lock, input_ids, pick->num_runs_ == runs.size());
   }
+}
 
-  return std::nullopt;
+void LSMEngine::CompactFifo(ColumnFamily *cf) {
+  const auto &options = cf->options_.fifo;
+  auto now = std::filesystem::file_time_type::clock::now();
+  std::vector<SST_ID> removed;
+  {
+    // the SSTs are never rewritten, so the time of its file is when an SST was flushed
+    std::unique_lock<std::shared_mutex> lock(cf->mutex_);
+    while (!cf->l0_sst_ids_.empty()) {
+      auto sst_id = cf->l0_sst_ids_.back();
+      auto path = cf->table_cache_->GetSSTPath(sst_id);
+      bool too_large = options.max_table_files_size > 0 && cf->l0_bytes_ > options.max_table_files_size;
+      bool expired = options.ttl > 0 && now - std::filesystem::last_write_time(path) >
+                                            std::chrono::seconds(static_cast<int64_t>(options.ttl));
+      if (!too_large && !expired) {
+        break;
+      }
+      cf->l0_bytes_ -= std::filesystem::file_size(path);
+      cf->table_cache_->Erase(sst_id);
+      cf->l0_sst_ids_.pop_back();
+      removed.push_back(sst_id);
+    }
+  }
+  if (removed.empty()) {
+    return;
+  }
+  // the rows cached from the deleted SSTs must not be returned anymore
+  cf->row_cache_id_ = next_row_cache_id_++;
+  RemoveSSTFiles(cf, removed);
+
+  // the SSTs are never merged, so a blob file is only referenced by the SST flushed along, whose id is lower
+  std::vector<uint64_t> obsolete_blob_files;
+  {
+    std::shared_lock<std::shared_mutex> lock(cf->mutex_);
+    for (const auto &[file_number, reader] : *cf->GetBlobFiles()) {
+      if (cf->l0_sst_ids_.empty() || file_number < cf->l0_sst_ids_.back()) {
+        obsolete_blob_files.push_back(file_number);
+      }
+    }
+  }
+  cf->RemoveBlobFiles(obsolete_blob_files);
 }
 
-void LSMEngine::Remove(const std::string &key) { memtable_.Remove(key); }
+void LSMEngine::Compact() { Compact(default_column_family_); }
 
-void LSMEngine::Flush() {
-  if (memtable_.GetTotalSize() == 0) {
+void LSMEngine::Compact(ColumnFamily *cf) {
+  std::lock_guard<std::mutex> compaction_lock(cf->compaction_mutex_);
+  std::unique_lock<std::mutex> flush_lock(cf->flush_mutex_);
+  std::vector<SST_ID> input_ids;
+  {
+    std::shared_lock<std::shared_mutex> lock(cf->mutex_);
+    input_ids.assign(cf->l0_sst_ids_.begin(), cf->l0_sst_ids_.end());
+  }
+  if (input_ids.empty()) {
     return;
   }
+  if (cf->options_.compaction_style == CompactionStyle::kFifo) {
+    CompactFifo(cf);
+    return;
+  }
+  CompactRuns(cf, &flush_lock, input_ids, true);
+}
+
+void LSMEngine::CompactRuns(ColumnFamily *cf, std::unique_lock<std::mutex> *flush_lock,
+                            const std::vector<SST_ID> &input_ids, bool bottommost) {
+  // a bottommost merge sees every version of a key, so it drops the deleted and overwritten entries for good.
+  // The inputs are read once and removed, their blocks must not evict the ones of the readers
+  ReadOptions read_options;
+  read_options.fill_cache = false;
+  // the output id is taken with the inputs, so that the SSTs flushed during the merge get higher ones
+  SST_ID new_sst_id = next_sst_id_++;
+  auto builder = cf->NewSSTBuilder();
+  auto blob_builder = NewBlobFileBuilder(cf);
+  // the garbage collection of the blob files: a bottommost merge sees every reference, it moves the values of
+  // the oldest blob files to the new one so that they no longer pin the overwritten and deleted values
+  std::vector<uint64_t> old_blob_files;
+  uint64_t relocate_before = 0;
+  std::set<uint64_t> referenced;
+  if (blob_builder != nullptr && bottommost) {
+    for (const auto &[file_number, blob_reader] : *cf->GetBlobFiles()) {
+      old_blob_files.push_back(file_number);
+    }
+    auto cutoff = static_cast<size_t>(static_cast<double>(old_blob_files.size()) *
+                                      cf->options_.blob_garbage_collection_age_cutoff);
+    if (cutoff >= old_blob_files.size()) {
+      relocate_before = std::numeric_limits<uint64_t>::max();
+    } else if (cutoff > 0) {
+      relocate_before = old_blob_files[cutoff];
+    }
+  }
+  // the flushes go on during the merge, compaction_mutex_ keeps the options it reads
+  flush_lock->unlock();
+  std::vector<std::unique_ptr<BaseIterator>> iters;
+  for (auto sst_id : input_ids) {
+    iters.push_back(std::make_unique<SSTIterator>(cf->table_cache_->FindTable(sst_id), read_options));
+  }
+  HeapIterator::ValueReader reader;
+  if (!bottommost || cf->HasFilter() || cf->options_.merge_operator != nullptr) {
+    reader = [cf, bottommost](const std::string &key, const std::vector<std::string> &versions) {
+      return cf->CompactVersions(key, versions, bottommost);
+    };
+  }
+  HeapIterator iter(std::move(iters), reader);
+  bool has_entries = false;
+  for (; !iter.IsEnd(); ++iter) {
+    if (blob_builder != nullptr) {
+      builder->Add(iter->first, cf->SeparateValue(iter->second, blob_builder.get(), relocate_before, &referenced));
+    } else {
+      builder->Add(iter->first, iter->second);
+    }
+    has_entries = true;
+  }
+  if (blob_builder != nullptr && blob_builder->Finish()) {
+    cf->AddBlobFile(blob_builder->GetFileNumber());
+    cf->compaction_bytes_written_ += blob_builder->GetFileSize();
+  }
+  // the output is built under a temporary name and the compaction recorded before it is renamed, like the SST of
+  // a flush. A crash before the record leaves the inputs, which recovery keeps, and after it both sides, of
+  // which recovery keeps the output, see RecoverTmpSSTs()
+  std::shared_ptr<SST> new_sst;
+  auto sst_path = cf->table_cache_->GetSSTPath(new_sst_id);
+  auto tmp_sst_path = TmpSSTPath(sst_path);
+  if (has_entries) {
+    new_sst = builder->Build(new_sst_id, tmp_sst_path, block_cache_);
+    cf->compaction_bytes_written_ += new_sst->GetSSTSize();
+    SyncPath(tmp_sst_path);
+  }
+  // the names of the output and of the new blob file
+  SyncPath(cf->dir_);
+  WriteCompaction(cf->GetName(), has_entries ? new_sst_id : NO_SST, input_ids);
+  if (has_entries) {
+    std::filesystem::rename(tmp_sst_path, sst_path);
+    SyncPath(cf->dir_);
+  }
 
-  size_t new_sst_id = l0_sst_ids_.empty() ? 0 : l0_sst_ids_.front() + 1;
+  flush_lock->lock();
+  {
+    // the inputs are consecutive runs, the output takes their place, the SSTs flushed meanwhile are newer
+    std::unique_lock<std::shared_mutex> lock(cf->mutex_);
+    auto pos = std::find(cf->l0_sst_ids_.begin(), cf->l0_sst_ids_.end(), input_ids.front());
+    for (auto sst_id : input_ids) {
+      cf->l0_bytes_ -= cf->table_cache_->FindTable(sst_id)->GetSSTSize();
+      cf->table_cache_->Erase(sst_id);
+    }
+    pos = cf->l0_sst_ids_.erase(pos, std::next(pos, static_cast<std::ptrdiff_t>(input_ids.size())));
+    if (new_sst != nullptr) {
+      cf->l0_sst_ids_.insert(pos, new_sst_id);
+      cf->l0_bytes_ += new_sst->GetSSTSize();
+      cf->table_cache_->Insert(new_sst);
+    }
+  }
+  if (cf->HasFilter()) {
+    cf->row_cache_id_ = next_row_cache_id_++;
+  }
+  RemoveSSTFiles(cf, input_ids);
+  SyncPath(cf->dir_);
+  RemoveCompaction(cf->GetName());
 
-  std::shared_ptr<SSTBuilder> builder = std::make_shared<SSTBuilder>(LSM_BLOCK_SIZE);
+  std::vector<uint64_t> obsolete_blob_files;
+  for (auto file_number : old_blob_files) {
+    if (referenced.count(file_number) == 0) {
+      obsolete_blob_files.push_back(file_number);
+    }
+  }
+  cf->RemoveBlobFiles(obsolete_blob_files);
+}
 
-  auto sst_path = GetSSTPath(new_sst_id);
-  auto new_sst = memtable_.FlushLast(builder, sst_path, new_sst_id, block_cache_);
+std::unique_ptr<BlobFileBuilder> LSMEngine::NewBlobFileBuilder(ColumnFamily *cf) {
+  if (!cf->options_.enable_blob_files) {
+    return nullptr;
+  }
+  SST_ID file_number = next_sst_id_++;
+  return std::make_unique<BlobFileBuilder>(cf->GetBlobPath(file_number), file_number);
+}
 
-  std::unique_lock<std::shared_mutex> lock(mutex_);
-  l0_sst_ids_.push_front(new_sst_id);
-  ssts_[new_sst_id] = new_sst;
+void LSMEngine::RemoveSSTFiles(ColumnFamily *cf, const std::vector<SST_ID> &sst_ids) {
+  // readers still holding one of the SSTs keep its file open
+  auto secondary_cache = block_cache_->GetSecondaryCache();
+  for (auto sst_id : sst_ids) {
+    std::filesystem::remove(cf->table_cache_->GetSSTPath(sst_id));
+    if (secondary_cache != nullptr) {
+      secondary_cache->Erase(static_cast<int>(sst_id));
+    }
+  }
 }
 
 void LSMEngine::FlushAll() {
-  while (memtable_.GetTotalSize() > 0) {
-    Flush();
+  std::shared_lock<std::shared_mutex> lock(column_families_mutex_);
+  for (auto &[name, cf] : column_families_) {
+    while (cf->memtable_.GetTotalSize() > 0) {
+      Flush(cf.get());
+    }
   }
 }
 
-std::string LSMEngine::GetSSTPath(SST_ID sst_id) {
-  std::stringstream ss;
-  ss << data_dir_ << "/sst_" << std::setfill('0') << std::setw(4) << sst_id;
-  return ss.str();
-}
+std::string LSMEngine::GetSSTPath(SST_ID sst_id) { return default_column_family_->table_cache_->GetSSTPath(sst_id); }
+
+HeapIterator LSMEngine::NewHeapIterator(ColumnFamily &cf, const std::optional<std::string> &key,
+                                        const ReadOptions &options, const std::function<bool(const SST &)> &sst_filter,
+                                        std::vector<SSTIterator *> *sst_iters) {
+  // the memtables and the SSTs are taken under one lock, see ColumnFamily::mutex_
+  std::shared_lock<std::shared_mutex> lock(cf.mutex_);
+  auto iters = cf.memtable_.NewIterators();
+  if (key.has_value()) {
+    for (auto &iter : iters) {
+      iter->Seek(key.value());
+    }
+  }
 
-MergeIterator LSMEngine::Begin() {
-  std::vector<SearchItem> items;
-  std::shared_lock<std::shared_mutex> lock(mutex_);
-  for (auto sst_id : l0_sst_ids_) {
-    auto sst = ssts_[sst_id];
-    auto sst_it = sst->Begin();
-    while (!sst_it.IsEnd()) {
-      items.emplace_back(sst_it.GetKey(), sst_it.GetValue(), sst_id);
-      ++sst_it;
+  for (auto sst_id : cf.l0_sst_ids_) {
+    auto sst = cf.table_cache_->FindTable(sst_id);
+    if (sst_filter != nullptr && !sst_filter(*sst)) {
+      continue;
+    }
+    auto iter = key.has_value() ? std::make_unique<SSTIterator>(sst, key.value(), options)
+                                : std::make_unique<SSTIterator>(sst, options);
+    if (sst_iters != nullptr) {
+      sst_iters->push_back(iter.get());
     }
+    iters.push_back(std::move(iter));
   }
-  HeapIterator sst_iter(items);
-  auto mem_table_iter = memtable_.Begin();
-  return MergeIterator(mem_table_iter, sst_iter);
+  return HeapIterator(std::move(iters), cf.ValueReader());
+}
+
+MergeIterator LSMEngine::Begin(const ReadOptions &options) { return Begin(default_column_family_, options); }
+
+MergeIterator LSMEngine::Begin(ColumnFamily *cf, const ReadOptions &options) {
+  return MergeIterator(NewHeapIterator(*cf, std::nullopt, options));
 }
 
 MergeIterator LSMEngine::End() { return MergeIterator{}; }
 
+MergeIterator LSMEngine::Seek(const std::string &key, const ReadOptions &options) {
+  return Seek(default_column_family_, key, options);
+}
+
+MergeIterator LSMEngine::Seek(ColumnFamily *cf, const std::string &key, const ReadOptions &options) {
+  return MergeIterator(NewHeapIterator(*cf, key, options));
+}
+
+MergeIterator LSMEngine::SeekToLast(const ReadOptions &options) { return SeekToLast(default_column_family_, options); }
+
+MergeIterator LSMEngine::SeekToLast(ColumnFamily *cf, const ReadOptions &options) {
+  auto iter = NewHeapIterator(*cf, std::nullopt, options);
+  iter.SeekToLast();
+  return MergeIterator(std::move(iter));
+}
+
+MergeIterator LSMEngine::SeekForPrev(const std::string &key, const ReadOptions &options) {
+  return SeekForPrev(default_column_family_, key, options);
+}
+
+MergeIterator LSMEngine::SeekForPrev(ColumnFamily *cf, const std::string &key, const ReadOptions &options) {
+  auto iter = NewHeapIterator(*cf, std::nullopt, options);
+  iter.SeekForPrev(key);
+  return MergeIterator(std::move(iter));
+}
+
+MergeIterator LSMEngine::ScanPrefix(const std::string &prefix, const ReadOptions &options) {
+  return ScanPrefix(default_column_family_, prefix, options);
+}
+
+MergeIterator LSMEngine::ScanPrefix(ColumnFamily *cf, const std::string &prefix, const ReadOptions &options) {
+  // SSTs whose prefix bloom filter rejects the prefix are skipped without reading any block
+  auto may_match = [cf, &prefix](const SST &sst) {
+    return sst.PrefixMayMatch(prefix, cf->options_.prefix_extractor.get());
+  };
+  auto predicate = [prefix](const std::string &key) {
+    int cmp = key.compare(0, prefix.size(), prefix);
+    if (cmp < 0) {
+      return 1;
+    }
+    return cmp > 0 ? -1 : 0;
+  };
+  return MergeIterator(NewHeapIterator(*cf, prefix, options, may_match), predicate);
+}
+
 std::optional<std::pair<MergeIterator, MergeIterator>> LSMEngine::LSMItersMonotonyPredicate(
     const std::function<int(const std::string &)> &predicate) {
-  auto mem_result = memtable_.ItersMonotonyPredicate(predicate);
-  std::vector<SearchItem> items;
-  for (auto &[sst_idx, sst] : ssts_) {
-    auto result = SSTItersMonotonyPredicate(sst, predicate);
-    if (!result.has_value()) {
-      continue;
+  auto &cf = *default_column_family_;
+  // only find the first satisfied key of each source, the entries are read lazily by the merge iterator
+  std::optional<std::string> first_key;
+  auto update_first_key = [&first_key](const std::string &key) {
+    if (!first_key.has_value() || key < first_key.value()) {
+      first_key = key;
     }
-    auto &[begin, end] = result.value();
-    while (begin != end) {
-      items.emplace_back(begin.GetKey(), begin.GetValue(), -sst_idx);
-      ++begin;
+  };
+
+  auto mem_result = cf.memtable_.ItersMonotonyPredicate(predicate);
+  if (mem_result.has_value() && !mem_result->first.IsEnd()) {
+    update_first_key(mem_result->first->first);
+  }
+  {
+    std::shared_lock<std::shared_mutex> lock(cf.mutex_);
+    for (auto sst_id : cf.l0_sst_ids_) {
+      auto sst = cf.table_cache_->FindTable(sst_id);
+      auto result = SSTItersMonotonyPredicate(sst, predicate);
+      if (result.has_value() && result->first.IsValid()) {
+        update_first_key(result->first.GetKey());
+      }
     }
   }
 
-  if (!mem_result.has_value() && items.empty()) {
+  if (!first_key.has_value()) {
     return std::nullopt;
   }
-
-  HeapIterator l0_iter(items);
-  if (mem_result.has_value()) {
-    auto [mem_start, mem_end] = mem_result.value();
-    auto start = MergeIterator(mem_start, l0_iter);
-    auto end = MergeIterator{};
-    return std::make_pair(start, end);
+  auto start = MergeIterator(NewHeapIterator(cf, first_key, ReadOptions()), predicate);
+  if (start.IsEnd()) {
+    return std::nullopt;
   }
-  auto start = MergeIterator(HeapIterator{}, l0_iter);
-  auto end = MergeIterator{};
-  return std::make_pair(start, end);
+  return std::make_pair(start, MergeIterator{});
 }
 
-LSM::LSM(std::string data_dir) : engine_(std::move(data_dir)) {}
+LSM::LSM(std::string data_dir, std::shared_ptr<const PrefixExtractor> prefix_extractor)
+    : engine_(std::move(data_dir), std::move(prefix_extractor)) {}
+
+LSM::LSM(std::string data_dir, const Options &options) : engine_(std::move(data_dir), options) {}
+
+LSM::LSM(std::string data_dir, const ColumnFamilyOptions &default_options)
+    : engine_(std::move(data_dir), default_options) {}
 
 LSM::~LSM() { engine_.FlushAll(); }
 
-std::optional<std::string> LSM::Get(const std::string &key) { return engine_.Get(key); }
+ColumnFamily *LSM::CreateColumnFamily(const std::string &name, const ColumnFamilyOptions &options) {
+  return engine_.CreateColumnFamily(name, options);
+}
+
+ColumnFamily *LSM::GetColumnFamily(const std::string &name) { return engine_.GetColumnFamily(name); }
+
+ColumnFamily *LSM::DefaultColumnFamily() { return engine_.DefaultColumnFamily(); }
+
+void LSM::DropColumnFamily(const std::string &name) { engine_.DropColumnFamily(name); }
+
+void LSM::Write(const WriteBatch &batch, const WriteOptions &options) { engine_.Write(batch, options); }
+
+std::optional<std::string> LSM::Get(const std::string &key, const ReadOptions &options) {
+  return engine_.Get(key, options);
+}
+
+std::optional<std::string> LSM::Get(ColumnFamily *cf, const std::string &key, const ReadOptions &options) {
+  return engine_.Get(cf, key, options);
+}
+
+std::vector<std::optional<std::string>> LSM::MultiGet(const std::vector<std::string> &keys,
+                                                      const ReadOptions &options) {
+  return engine_.MultiGet(keys, options);
+}
+
+std::vector<std::optional<std::string>> LSM::MultiGet(ColumnFamily *cf, const std::vector<std::string> &keys,
+                                                      const ReadOptions &options) {
+  return engine_.MultiGet(cf, keys, options);
+}
+
+GetAwaitable LSM::GetAsync(const std::string &key, const ReadOptions &options) {
+  return engine_.GetAsync(key, options);
+}
+
+GetAwaitable LSM::GetAsync(ColumnFamily *cf, const std::string &key, const ReadOptions &options) {
+  return engine_.GetAsync(cf, key, options);
+}
+
+ScanAwaitable LSM::ScanAsync(const std::string &key, const ReadOptions &options) {
+  return engine_.ScanAsync(key, options);
+}
+
+ScanAwaitable LSM::ScanAsync(ColumnFamily *cf, const std::string &key, const ReadOptions &options) {
+  return engine_.ScanAsync(cf, key, options);
+}
+
+void LSM::Put(const std::string &key, const std::string &value, const WriteOptions &options) {
+  engine_.Put(key, value, options);
+}
+
+void LSM::Put(ColumnFamily *cf, const std::string &key, const std::string &value, const WriteOptions &options) {
+  engine_.Put(cf, key, value, options);
+}
+
+void LSM::Remove(const std::string &key, const WriteOptions &options) { engine_.Remove(key, options); }
 
-void LSM::Put(const std::string &key, const std::string &value) { engine_.Put(key, value); }
+void LSM::Merge(const std::string &key, const std::string &operand, const WriteOptions &options) {
+  engine_.Merge(key, operand, options);
+}
+
+void LSM::Merge(ColumnFamily *cf, const std::string &key, const std::string &operand, const WriteOptions &options) {
+  engine_.Merge(cf, key, operand, options);
+}
 
-void LSM::Remove(const std::string &key) { engine_.Remove(key); }
+void LSM::Remove(ColumnFamily *cf, const std::string &key, const WriteOptions &options) {
+  engine_.Remove(cf, key, options);
+}
 
 void LSM::Flush() { engine_.Flush(); }
 
+void LSM::Flush(ColumnFamily *cf) { engine_.Flush(cf); }
+
 void LSM::FlushAll() { engine_.FlushAll(); }
 
-LSM::LSMIterator LSM::Begin() { return engine_.Begin(); }
+void LSM::Compact() { engine_.Compact(); }
+
+void LSM::Compact(ColumnFamily *cf) { engine_.Compact(cf); }
+
+const RowCache &LSM::GetRowCache() const { return engine_.GetRowCache(); }
+
+WriteBufferManager &LSM::GetWriteBufferManager() { return engine_.GetWriteBufferManager(); }
+
+WriteController &LSM::GetWriteController() { return engine_.GetWriteController(); }
+
+WriteQueue &LSM::GetWriteQueue() { return engine_.GetWriteQueue(); }
+
+void LSM::SetOptions(ColumnFamily *cf, const std::unordered_map<std::string, std::string> &values) {
+  engine_.SetOptions(cf, values);
+}
+
+void LSM::SetDBOptions(const std::unordered_map<std::string, std::string> &values) { engine_.SetDBOptions(values); }
+
+Options LSM::GetDBOptions() { return engine_.GetDBOptions(); }
+
+void LSM::SetSecondaryCache(std::shared_ptr<SecondaryCache> secondary_cache) {
+  engine_.SetSecondaryCache(std::move(secondary_cache));
+}
+
+LSM::LSMIterator LSM::Begin(const ReadOptions &options) { return engine_.Begin(options); }
+
+LSM::LSMIterator LSM::Begin(ColumnFamily *cf, const ReadOptions &options) { return engine_.Begin(cf, options); }
 
 LSM::LSMIterator LSM::End() { return engine_.End(); }
 
+LSM::LSMIterator LSM::Seek(const std::string &key, const ReadOptions &options) { return engine_.Seek(key, options); }
+
+LSM::LSMIterator LSM::Seek(ColumnFamily *cf, const std::string &key, const ReadOptions &options) {
+  return engine_.Seek(cf, key, options);
+}
+
+LSM::LSMIterator LSM::SeekToLast(const ReadOptions &options) { return engine_.SeekToLast(options); }
+
+LSM::LSMIterator LSM::SeekToLast(ColumnFamily *cf, const ReadOptions &options) {
+  return engine_.SeekToLast(cf, options);
+}
+
+LSM::LSMIterator LSM::SeekForPrev(const std::string &key, const ReadOptions &options) {
+  return engine_.SeekForPrev(key, options);
+}
+
+LSM::LSMIterator LSM::SeekForPrev(ColumnFamily *cf, const std::string &key, const ReadOptions &options) {
+  return engine_.SeekForPrev(cf, key, options);
+}
+
+LSM::LSMIterator LSM::ScanPrefix(const std::string &prefix, const ReadOptions &options) {
+  return engine_.ScanPrefix(prefix, options);
+}
+
+LSM::LSMIterator LSM::ScanPrefix(ColumnFamily *cf, const std::string &prefix, const ReadOptions &options) {
+  return engine_.ScanPrefix(cf, prefix, options);
+}
+
 std::optional<std::pair<MergeIterator, MergeIterator>> LSM::LSMItersMonotonyPredicate(
     const std::function<int(const std::string &)> &predicate) {
   return engine_.LSMItersMonotonyPredicate(predicate);
-}
\ No newline at end of file
+}
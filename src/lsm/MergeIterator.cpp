@@ -1,61 +1,47 @@
 #include <lsm/MergeIterator.h>
+#include <utility>
 
-MergeIterator::MergeIterator(const HeapIterator &mem_table_iter, const HeapIterator &sst_iter)
-    : mem_table_iter_(mem_table_iter), sst_iter_(sst_iter) {
-  SkipSSTIter();
-  choose_mem_table_ = ChooseIter();
-}
+MergeIterator::MergeIterator(HeapIterator iter, std::function<int(const std::string &)> predicate)
+    : iter_(std::move(iter)), predicate_(std::move(predicate)) {}
 
-bool MergeIterator::ChooseIter() {
-  if (mem_table_iter_.IsEnd()) {
-    return false;
-  }
-  if (sst_iter_.IsEnd()) {
+bool MergeIterator::IsEnd() const {
+  if (iter_.IsEnd()) {
     return true;
   }
-  return mem_table_iter_->first < sst_iter_->first;
+  return predicate_ != nullptr && predicate_(iter_->first) != 0;
 }
 
-void MergeIterator::SkipSSTIter() {
-  while (!mem_table_iter_.IsEnd() && !sst_iter_.IsEnd() && sst_iter_->first == mem_table_iter_->first) {
-    ++sst_iter_;
-  }
-}
+void MergeIterator::SeekToFirst() { iter_.SeekToFirst(); }
 
-bool MergeIterator::IsEnd() const { return mem_table_iter_.IsEnd() && sst_iter_.IsEnd(); }
+void MergeIterator::SeekToLast() { iter_.SeekToLast(); }
 
-MergeIterator::value_type MergeIterator::operator*() const { return choose_mem_table_ ? *mem_table_iter_ : *sst_iter_; }
+void MergeIterator::Seek(const std::string &key) { iter_.Seek(key); }
+
+void MergeIterator::SeekForPrev(const std::string &key) { iter_.SeekForPrev(key); }
+
+MergeIterator::value_type MergeIterator::operator*() const { return *iter_; }
 
 MergeIterator &MergeIterator::operator++() {
-  if (choose_mem_table_) {
-    ++mem_table_iter_;
-  } else {
-    ++sst_iter_;
+  if (!IsEnd()) {
+    ++iter_;
+  }
+  return *this;
+}
+
+MergeIterator &MergeIterator::operator--() {
+  if (!IsEnd()) {
+    --iter_;
   }
-  SkipSSTIter();
-  choose_mem_table_ = ChooseIter();
   return *this;
 }
 
 bool MergeIterator::operator==(const MergeIterator &other) const {
-  if (this->IsEnd() && other.IsEnd()) {
-    return true;
+  if (this->IsEnd() || other.IsEnd()) {
+    return this->IsEnd() && other.IsEnd();
   }
-  return this->mem_table_iter_ == other.mem_table_iter_ && this->sst_iter_ == other.sst_iter_ &&
-         this->choose_mem_table_ == other.choose_mem_table_;
+  return this->iter_ == other.iter_;
 }
 
 bool MergeIterator::operator!=(const MergeIterator &other) const { return !(*this == other); }
 
-MergeIterator::value_type *MergeIterator::operator->() const {
-  UpdateCurrent();
-  return current_value_.get();
-}
-
-void MergeIterator::UpdateCurrent() const {
-  if (choose_mem_table_) {
-    current_value_ = std::make_shared<value_type>(*mem_table_iter_);
-  } else {
-    current_value_ = std::make_shared<value_type>(*sst_iter_);
-  }
-}
\ No newline at end of file
+MergeIterator::value_type *MergeIterator::operator->() const { return iter_.operator->(); }
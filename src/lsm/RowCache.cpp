@@ -0,0 +1,114 @@
+#include <lsm/RowCache.h>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+// bytes charged for an entry besides the key and value, roughly the list node and hash map slot
+constexpr size_t ROW_CACHE_ENTRY_OVERHEAD = 64;
+}  // namespace
+
+RowCache::RowCache(size_t capacity, size_t num_shards)
+    : capacity_(capacity), shard_capacity_(0), total_requests_(0), hit_requests_(0) {
+  if (num_shards == 0) {
+    throw std::invalid_argument("RowCache shards should be positive");
+  }
+  shard_capacity_ = capacity / num_shards;
+  shards_.reserve(num_shards);
+  for (size_t i = 0; i < num_shards; i++) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+}
+
+RowCache::Shard &RowCache::GetShard(const std::string &key) const {
+  return *shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
+
+void RowCache::EraseEntry(Shard &shard, std::list<Entry>::iterator it) {
+  shard.usage_ -= it->charge_;
+  shard.map_.erase(it->key_);
+  shard.lru_list_.erase(it);
+}
+
+std::optional<std::optional<std::string>> RowCache::Get(const std::string &key) {
+  auto &shard = GetShard(key);
+  std::optional<std::optional<std::string>> res;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    auto it = shard.map_.find(key);
+    if (it != shard.map_.end()) {
+      shard.lru_list_.splice(shard.lru_list_.begin(), shard.lru_list_, it->second);
+      res = it->second->value_;
+    }
+  }
+
+  ++total_requests_;
+  if (res.has_value()) {
+    ++hit_requests_;
+  }
+  return res;
+}
+
+uint64_t RowCache::GetGeneration(const std::string &key) const {
+  auto &shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mutex_);
+  return shard.generation_;
+}
+
+void RowCache::Insert(const std::string &key, const std::optional<std::string> &value, uint64_t generation) {
+  size_t charge = key.size() + value.value_or("").size() + ROW_CACHE_ENTRY_OVERHEAD;
+  size_t shard_capacity = shard_capacity_;
+  if (charge > shard_capacity) {
+    return;
+  }
+
+  auto &shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mutex_);
+  if (shard.generation_ != generation) {
+    return;  // a write may have changed the result
+  }
+  auto it = shard.map_.find(key);
+  if (it != shard.map_.end()) {
+    EraseEntry(shard, it->second);
+  }
+  while (shard.usage_ + charge > shard_capacity) {
+    EraseEntry(shard, std::prev(shard.lru_list_.end()));
+  }
+  shard.lru_list_.push_front({key, value, charge});
+  shard.map_[key] = shard.lru_list_.begin();
+  shard.usage_ += charge;
+}
+
+void RowCache::Erase(const std::string &key) {
+  auto &shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mutex_);
+  ++shard.generation_;
+  auto it = shard.map_.find(key);
+  if (it != shard.map_.end()) {
+    EraseEntry(shard, it->second);
+  }
+}
+
+void RowCache::SetCapacity(size_t capacity) {
+  capacity_ = capacity;
+  shard_capacity_ = capacity / shards_.size();
+  for (const auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex_);
+    while (shard->usage_ > shard_capacity_) {
+      EraseEntry(*shard, std::prev(shard->lru_list_.end()));
+    }
+  }
+}
+
+size_t RowCache::GetUsage() const {
+  size_t usage = 0;
+  for (const auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex_);
+    usage += shard->usage_;
+  }
+  return usage;
+}
+
+double RowCache::GetHitRate() const {
+  size_t total = total_requests_;
+  return total == 0 ? 0 : static_cast<double>(hit_requests_) / total;
+}
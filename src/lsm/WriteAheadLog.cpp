@@ -0,0 +1,144 @@
+#include <fcntl.h>
+#include <lsm/WriteAheadLog.h>
+#include <unistd.h>
+#include <utils/Crc32c.h>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr size_t HEADER_SIZE = 2 * sizeof(uint32_t);
+
+template <typename T>
+void PutFixed(std::string *dst, T value) {
+  dst->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void PutString(std::string *dst, const std::string &value) {
+  PutFixed(dst, static_cast<uint32_t>(value.size()));
+  dst->append(value);
+}
+
+template <typename T>
+T GetFixed(const std::string &src, size_t *offset) {
+  if (src.size() - *offset < sizeof(T)) {
+    throw std::runtime_error("Corrupted log record");
+  }
+  T value;
+  memcpy(&value, src.data() + *offset, sizeof(T));
+  *offset += sizeof(T);
+  return value;
+}
+
+std::string GetString(const std::string &src, size_t *offset) {
+  auto size = GetFixed<uint32_t>(src, offset);
+  if (src.size() - *offset < size) {
+    throw std::runtime_error("Corrupted log record");
+  }
+  std::string value = src.substr(*offset, size);
+  *offset += size;
+  return value;
+}
+}  // namespace
+
+// **************** LogRecord ****************
+std::string LogRecord::Encode() const {
+  std::string res;
+  PutFixed(&res, sequence_);
+  PutFixed(&res, static_cast<uint32_t>(entries_.size()));
+  for (const auto &entry : entries_) {
+    PutFixed(&res, static_cast<uint8_t>(entry.type_));
+    PutString(&res, entry.column_family_);
+    PutString(&res, entry.key_);
+    PutString(&res, entry.value_);
+  }
+  return res;
+}
+
+LogRecord LogRecord::Decode(const std::string &payload) {
+  LogRecord res;
+  size_t offset = 0;
+  res.sequence_ = GetFixed<uint64_t>(payload, &offset);
+  auto count = GetFixed<uint32_t>(payload, &offset);
+  for (uint32_t i = 0; i < count; i++) {
+    auto type = GetFixed<uint8_t>(payload, &offset);
+    if (type > static_cast<uint8_t>(WriteBatch::EntryType::kMerge)) {
+      throw std::runtime_error("Corrupted log record");
+    }
+    Entry entry{static_cast<WriteBatch::EntryType>(type), "", "", ""};
+    entry.column_family_ = GetString(payload, &offset);
+    entry.key_ = GetString(payload, &offset);
+    entry.value_ = GetString(payload, &offset);
+    res.entries_.push_back(std::move(entry));
+  }
+  if (offset != payload.size()) {
+    throw std::runtime_error("Corrupted log record");
+  }
+  return res;
+}
+
+// **************** LogWriter ****************
+LogWriter::LogWriter(std::string path, uint64_t number) : path_(std::move(path)), number_(number), size_(0) {
+  fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+  if (fd_ < 0) {
+    throw std::runtime_error("Failed to create log file " + path_);
+  }
+}
+
+LogWriter::~LogWriter() { ::close(fd_); }
+
+void LogWriter::Append(const std::vector<std::string> &payloads) {
+  std::string data;
+  for (const auto &payload : payloads) {
+    PutFixed(&data, Crc32c::Value(reinterpret_cast<const uint8_t *>(payload.data()), payload.size()));
+    PutFixed(&data, static_cast<uint32_t>(payload.size()));
+    data += payload;
+  }
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t n = ::write(fd_, data.data() + done, data.size() - done);
+    if (n <= 0) {
+      throw std::runtime_error("Failed to write log file " + path_);
+    }
+    done += static_cast<size_t>(n);
+  }
+  size_ += data.size();
+}
+
+void LogWriter::Sync() {
+  if (::fdatasync(fd_) != 0) {
+    throw std::runtime_error("Failed to sync log file " + path_);
+  }
+}
+
+// **************** LogReader ****************
+LogReader::LogReader(const std::string &path) : offset_(0) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("Failed to open log file " + path);
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  data_ = buffer.str();
+}
+
+bool LogReader::ReadRecord(std::string *payload) {
+  if (data_.size() - offset_ < HEADER_SIZE) {
+    return false;
+  }
+  uint32_t crc;
+  uint32_t size;
+  memcpy(&crc, data_.data() + offset_, sizeof(uint32_t));
+  memcpy(&size, data_.data() + offset_ + sizeof(uint32_t), sizeof(uint32_t));
+  if (data_.size() - offset_ - HEADER_SIZE < size ||
+      Crc32c::Value(reinterpret_cast<const uint8_t *>(data_.data()) + offset_ + HEADER_SIZE, size) != crc) {
+    // the tail of a write the crash interrupted, nothing after it is trusted
+    offset_ = data_.size();
+    return false;
+  }
+  *payload = data_.substr(offset_ + HEADER_SIZE, size);
+  offset_ += HEADER_SIZE + size;
+  return true;
+}
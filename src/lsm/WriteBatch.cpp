@@ -0,0 +1,16 @@
+#include <lsm/WriteBatch.h>
+
+void WriteBatch::Put(ColumnFamily *column_family, const std::string &key, const std::string &value) {
+  entries_.push_back({EntryType::kPut, column_family, key, value});
+  data_size_ += key.size() + value.size();
+}
+
+void WriteBatch::Remove(ColumnFamily *column_family, const std::string &key) {
+  entries_.push_back({EntryType::kRemove, column_family, key, ""});
+  data_size_ += key.size();
+}
+
+void WriteBatch::Merge(ColumnFamily *column_family, const std::string &key, const std::string &operand) {
+  entries_.push_back({EntryType::kMerge, column_family, key, operand});
+  data_size_ += key.size() + operand.size();
+}
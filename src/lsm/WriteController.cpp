@@ -0,0 +1,69 @@
+#include <lsm/WriteController.h>
+#include <algorithm>
+
+WriteController::WriteController(uint64_t delayed_write_rate)
+    : delayed_write_rate_(std::max<uint64_t>(delayed_write_rate, 1)),
+      state_(WriteStall::kNone),
+      severity_(0),
+      next_write_time_(Clock::now()) {}
+
+void WriteController::SetState(WriteStall state, double severity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (state == WriteStall::kDelayed && state_ != WriteStall::kDelayed) {
+    // the writes before the slowdown are not charged to the rate
+    next_write_time_ = Clock::now();
+  }
+  state_ = state;
+  severity_ = std::clamp(severity, 0.0, 1.0);
+}
+
+uint64_t WriteController::GetDelayedWriteRate() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return delayed_write_rate_;
+}
+
+void WriteController::SetDelayedWriteRate(uint64_t delayed_write_rate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  delayed_write_rate_ = std::max<uint64_t>(delayed_write_rate, 1);
+}
+
+WriteStall WriteController::GetState() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return state_;
+}
+
+uint64_t WriteController::GetCurrentRate() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::max<uint64_t>(static_cast<uint64_t>(delayed_write_rate_ * (1 - 0.9 * severity_)), 1);
+}
+
+uint64_t WriteController::GetDelay(size_t bytes) {
+  auto rate = GetCurrentRate();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (state_ != WriteStall::kDelayed) {
+    return 0;
+  }
+  auto now = Clock::now();
+  // an idle writer does not build up credit
+  next_write_time_ = std::max(next_write_time_, now);
+  next_write_time_ += std::chrono::microseconds(static_cast<uint64_t>(bytes * 1000000.0 / rate));
+  auto wait = std::chrono::duration_cast<std::chrono::microseconds>(next_write_time_ - now).count();
+  return wait < LSM_MIN_WRITE_DELAY_MICROS ? 0 : static_cast<uint64_t>(wait);
+}
+
+void WriteController::RecordDelay(uint64_t micros) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.delayed_writes;
+  stats_.delay_micros += micros;
+}
+
+void WriteController::RecordStop(uint64_t micros) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.stopped_writes;
+  stats_.stop_micros += micros;
+}
+
+WriteStallStats WriteController::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
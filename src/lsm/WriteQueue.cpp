@@ -0,0 +1,91 @@
+#include <lsm/WriteQueue.h>
+#include <utility>
+
+WriteQueue::WriteQueue(Stage log_stage, Stage memtable_stage, uint64_t last_sequence, size_t max_group_bytes)
+    : log_stage_(std::move(log_stage)),
+      memtable_stage_(std::move(memtable_stage)),
+      max_group_bytes_(max_group_bytes),
+      logging_(false),
+      next_group_(0),
+      applying_group_(0),
+      last_sequence_(last_sequence) {}
+
+void WriteQueue::Write(const WriteBatch &batch, const WriteOptions &options) {
+  Writer writer{&batch, options, 0, false, nullptr};
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_.push_back(&writer);
+  // a writer taken into a group is no longer queued, it waits for done_
+  cv_.wait(lock, [this, &writer] {
+    return writer.done_ || (!logging_ && !queue_.empty() && queue_.front() == &writer);
+  });
+  if (writer.done_) {
+    // a leader wrote the batch with its group
+    if (writer.error_ != nullptr) {
+      std::rethrow_exception(writer.error_);
+    }
+    return;
+  }
+
+  // leader: take the writers queued behind, the group is at least the leader
+  logging_ = true;
+  std::vector<Writer *> group;
+  size_t group_bytes = 0;
+  while (!queue_.empty() &&
+         (group.empty() || group_bytes + queue_.front()->batch_->GetDataSize() <= max_group_bytes_)) {
+    auto *member = queue_.front();
+    queue_.pop_front();
+    member->sequence_ = last_sequence_ + 1;
+    last_sequence_ += member->batch_->Count();
+    group_bytes += member->batch_->GetDataSize();
+    group.push_back(member);
+  }
+  uint64_t ticket = next_group_++;
+  stats_.writes += group.size();
+  stats_.groups++;
+  lock.unlock();
+
+  std::exception_ptr error;
+  try {
+    log_stage_(group);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  lock.lock();
+  // the next leader writes its group to the log while this group is inserted
+  logging_ = false;
+  cv_.notify_all();
+  cv_.wait(lock, [this, ticket] { return applying_group_ == ticket; });
+  lock.unlock();
+
+  // a group which is not in the log is not applied either
+  if (error == nullptr) {
+    try {
+      memtable_stage_(group);
+    } catch (...) {
+      error = std::current_exception();
+    }
+  }
+
+  lock.lock();
+  applying_group_++;
+  for (auto *member : group) {
+    member->error_ = error;
+    member->done_ = true;
+  }
+  cv_.notify_all();
+  lock.unlock();
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+uint64_t WriteQueue::GetLastSequence() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_sequence_;
+}
+
+WriteQueueStats WriteQueue::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
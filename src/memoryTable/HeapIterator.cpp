@@ -1,4 +1,6 @@
 #include <memoryTable/HeapIterator.h>
+#include <algorithm>
+#include <map>
 
 bool operator<(const SearchItem &lhs, const SearchItem &rhs) {
   if (lhs.key_ == rhs.key_) {
@@ -16,48 +18,256 @@ bool operator>(const SearchItem &lhs, const SearchItem &rhs) {
 
 bool operator==(const SearchItem &lhs, const SearchItem &rhs) { return lhs.key_ == rhs.key_ && lhs.idx_ == rhs.idx_; }
 
+// **************** VectorIterator ****************
+VectorIterator::VectorIterator(std::shared_ptr<const std::vector<ValueType>> items)
+    : items_(std::move(items)), pos_(0) {}
+
+bool VectorIterator::IsValid() const { return pos_ < items_->size(); }
+
+std::string VectorIterator::GetKey() const { return (*items_)[pos_].first; }
+
+std::string VectorIterator::GetValue() const { return (*items_)[pos_].second; }
+
+void VectorIterator::Next() {
+  if (pos_ < items_->size()) {
+    ++pos_;
+  }
+}
+
+void VectorIterator::Prev() { pos_ = pos_ == 0 ? items_->size() : pos_ - 1; }
+
+void VectorIterator::SeekToFirst() { pos_ = 0; }
+
+void VectorIterator::SeekToLast() { pos_ = items_->empty() ? 0 : items_->size() - 1; }
+
+void VectorIterator::Seek(const std::string &key) {
+  auto it = std::lower_bound(items_->begin(), items_->end(), key,
+                             [](const ValueType &item, const std::string &target) { return item.first < target; });
+  pos_ = it - items_->begin();
+}
+
+void VectorIterator::SeekForPrev(const std::string &key) {
+  auto it = std::upper_bound(items_->begin(), items_->end(), key,
+                             [](const std::string &target, const ValueType &item) { return target < item.first; });
+  pos_ = it == items_->begin() ? items_->size() : it - items_->begin() - 1;
+}
+
+std::unique_ptr<BaseIterator> VectorIterator::Clone() const { return std::make_unique<VectorIterator>(*this); }
+
+// **************** HeapIterator ****************
 HeapIterator::HeapIterator(const std::vector<SearchItem> &items) {
+  // group the items by source, each source becomes a sorted child
+  std::map<int, std::vector<ValueType>> sources;
   for (const auto &item : items) {
-    heap_.push(item);
+    sources[item.idx_].emplace_back(item.key_, item.value_);
+  }
+  for (auto &[idx, source] : sources) {
+    std::stable_sort(source.begin(), source.end(),
+                     [](const ValueType &lhs, const ValueType &rhs) { return lhs.first < rhs.first; });
+    // a source may hold the same key more than once, only the first one is visible
+    source.erase(std::unique(source.begin(), source.end(),
+                             [](const ValueType &lhs, const ValueType &rhs) { return lhs.first == rhs.first; }),
+                 source.end());
+    children_.push_back(
+        std::make_unique<VectorIterator>(std::make_shared<const std::vector<ValueType>>(std::move(source))));
+  }
+  RebuildHeap();
+}
+
+HeapIterator::HeapIterator(std::vector<std::unique_ptr<BaseIterator>> children, ValueReader value_reader)
+    : children_(std::move(children)), value_reader_(std::move(value_reader)) {
+  RebuildHeap();
+}
+
+HeapIterator::HeapIterator(const HeapIterator &other)
+    : heap_(other.heap_), forward_(other.forward_), current_(other.current_), value_reader_(other.value_reader_) {
+  children_.reserve(other.children_.size());
+  for (const auto &child : other.children_) {
+    children_.push_back(child->Clone());
+  }
+}
+
+HeapIterator &HeapIterator::operator=(const HeapIterator &other) {
+  if (this != &other) {
+    HeapIterator tmp(other);
+    *this = std::move(tmp);
   }
+  return *this;
+}
 
-  while (!heap_.empty() && heap_.top().value_.empty()) {
-    auto deleted = heap_.top();
-    while (!heap_.empty() && heap_.top().key_ == deleted.key_) {
-      heap_.pop();
+bool HeapIterator::HeapLess(const SearchItem &lhs, const SearchItem &rhs) const {
+  // the std heap functions keep the greatest item on top
+  if (lhs.key_ == rhs.key_) {
+    return lhs.idx_ > rhs.idx_;
+  }
+  return forward_ ? lhs.key_ > rhs.key_ : lhs.key_ < rhs.key_;
+}
+
+void HeapIterator::HeapPush(SearchItem item) {
+  heap_.push_back(std::move(item));
+  std::push_heap(heap_.begin(), heap_.end(),
+                 [this](const SearchItem &lhs, const SearchItem &rhs) { return HeapLess(lhs, rhs); });
+}
+
+void HeapIterator::HeapPop() {
+  std::pop_heap(heap_.begin(), heap_.end(),
+                [this](const SearchItem &lhs, const SearchItem &rhs) { return HeapLess(lhs, rhs); });
+  heap_.pop_back();
+}
+
+void HeapIterator::RebuildHeap() {
+  heap_.clear();
+  for (size_t i = 0; i < children_.size(); i++) {
+    if (children_[i]->IsValid()) {
+      HeapPush(SearchItem(children_[i]->GetKey(), children_[i]->GetValue(), i));
     }
   }
+  SkipDeleted();
   UpdateCurrent();
 }
 
+void HeapIterator::PopCurrentKey() {
+  auto key = heap_.front().key_;
+  while (!heap_.empty() && heap_.front().key_ == key) {
+    int idx = heap_.front().idx_;
+    HeapPop();
+    auto &child = children_[idx];
+    if (forward_) {
+      child->Next();
+    } else {
+      child->Prev();
+    }
+    if (child->IsValid()) {
+      HeapPush(SearchItem(child->GetKey(), child->GetValue(), idx));
+    }
+  }
+}
+
+void HeapIterator::SwitchDirection(bool forward) {
+  auto key = heap_.front().key_;
+  forward_ = forward;
+  for (auto &child : children_) {
+    if (forward_) {
+      child->Seek(key);
+      if (child->IsValid() && child->GetKey() == key) {
+        child->Next();
+      }
+    } else {
+      child->SeekForPrev(key);
+      if (child->IsValid() && child->GetKey() == key) {
+        child->Prev();
+      }
+    }
+  }
+  RebuildHeap();
+}
+
+void HeapIterator::SkipDeleted() {
+  while (!heap_.empty()) {
+    if (value_reader_ == nullptr) {
+      if (!heap_.front().value_.empty()) {
+        return;
+      }
+    } else {
+      auto value = value_reader_(heap_.front().key_, CurrentVersions());
+      if (value.has_value()) {
+        // decoded once, UpdateCurrent() picks it up
+        current_ = std::make_shared<ValueType>(heap_.front().key_, std::move(value.value()));
+        return;
+      }
+    }
+    PopCurrentKey();
+  }
+}
+
+std::vector<std::string> HeapIterator::CurrentVersions() const {
+  // every child positioned at the current key is in the heap, the one with the smallest index is the newest
+  std::vector<const SearchItem *> items;
+  for (const auto &item : heap_) {
+    if (item.key_ == heap_.front().key_) {
+      items.push_back(&item);
+    }
+  }
+  std::sort(items.begin(), items.end(),
+            [](const SearchItem *lhs, const SearchItem *rhs) { return lhs->idx_ < rhs->idx_; });
+  std::vector<std::string> versions;
+  versions.reserve(items.size());
+  for (const auto *item : items) {
+    versions.push_back(item->value_);
+  }
+  return versions;
+}
+
 void HeapIterator::UpdateCurrent() {
   if (heap_.empty()) {
     current_.reset();
     return;
   }
-  current_ = std::make_shared<ValueType>(heap_.top().key_, heap_.top().value_);
+  if (value_reader_ != nullptr) {
+    return;  // set by SkipDeleted()
+  }
+  current_ = std::make_shared<ValueType>(heap_.front().key_, heap_.front().value_);
+}
+
+void HeapIterator::SeekToFirst() {
+  forward_ = true;
+  for (auto &child : children_) {
+    child->SeekToFirst();
+  }
+  RebuildHeap();
+}
+
+void HeapIterator::SeekToLast() {
+  forward_ = false;
+  for (auto &child : children_) {
+    child->SeekToLast();
+  }
+  RebuildHeap();
+}
+
+void HeapIterator::Seek(const std::string &key) {
+  forward_ = true;
+  for (auto &child : children_) {
+    child->Seek(key);
+  }
+  RebuildHeap();
+}
+
+void HeapIterator::SeekForPrev(const std::string &key) {
+  forward_ = false;
+  for (auto &child : children_) {
+    child->SeekForPrev(key);
+  }
+  RebuildHeap();
 }
 
 HeapIterator &HeapIterator::operator++() {
   if (heap_.empty()) {
     return *this;
   }
+  if (!forward_) {
+    SwitchDirection(true);
+    return *this;
+  }
 
-  auto top = heap_.top();
-  heap_.pop();
+  // skip all the older versions of the current key
+  PopCurrentKey();
+  SkipDeleted();
+  UpdateCurrent();
+  return *this;
+}
 
-  // delete all the items with the same key
-  while (!heap_.empty() && heap_.top().key_ == top.key_) {
-    heap_.pop();
+HeapIterator &HeapIterator::operator--() {
+  if (heap_.empty()) {
+    return *this;
   }
-
-  while (!heap_.empty() && heap_.top().value_.empty()) {
-    auto deleted = heap_.top();
-    while (!heap_.empty() && heap_.top().key_ == deleted.key_) {
-      heap_.pop();
-    }
+  if (forward_) {
+    SwitchDirection(false);
+    return *this;
   }
 
+  PopCurrentKey();
+  SkipDeleted();
   UpdateCurrent();
   return *this;
 }
@@ -78,4 +288,4 @@ HeapIterator::ValueType *HeapIterator::operator->() const { return current_.get(
 
 HeapIterator::ValueType &HeapIterator::operator*() const { return *current_; }
 
-bool HeapIterator::IsEnd() const { return heap_.empty(); }
\ No newline at end of file
+bool HeapIterator::IsEnd() const { return heap_.empty(); }
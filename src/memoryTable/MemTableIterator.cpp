@@ -0,0 +1,73 @@
+#include <memoryTable/MemTableIterator.h>
+#include <mutex>
+#include <utility>
+
+namespace {
+// take the shared lock only when iterating the active table
+std::shared_lock<std::shared_mutex> LockTable(const std::shared_ptr<std::shared_mutex> &mutex) {
+  if (mutex == nullptr) {
+    return {};
+  }
+  return std::shared_lock<std::shared_mutex>(*mutex);
+}
+}  // namespace
+
+MemTableIterator::MemTableIterator(std::shared_ptr<StringSkipList> table, std::shared_ptr<std::shared_mutex> mutex)
+    : table_(std::move(table)), iter_(nullptr), mutex_(std::move(mutex)) {
+  SeekToFirst();
+}
+
+bool MemTableIterator::InternalIsValid() const {
+  return iter_.IsValid() && iter_ != table_->End() && iter_ != table_->REnd();
+}
+
+bool MemTableIterator::IsValid() const {
+  auto lock = LockTable(mutex_);
+  return InternalIsValid();
+}
+
+std::string MemTableIterator::GetKey() const {
+  auto lock = LockTable(mutex_);
+  return iter_.GetKey();
+}
+
+std::string MemTableIterator::GetValue() const {
+  auto lock = LockTable(mutex_);
+  return iter_.GetValue();
+}
+
+void MemTableIterator::Next() {
+  auto lock = LockTable(mutex_);
+  if (InternalIsValid()) {
+    ++iter_;
+  }
+}
+
+void MemTableIterator::Prev() {
+  auto lock = LockTable(mutex_);
+  if (InternalIsValid()) {
+    --iter_;
+  }
+}
+
+void MemTableIterator::SeekToFirst() {
+  auto lock = LockTable(mutex_);
+  iter_ = table_->Begin();
+}
+
+void MemTableIterator::SeekToLast() {
+  auto lock = LockTable(mutex_);
+  iter_ = table_->RBegin();
+}
+
+void MemTableIterator::Seek(const std::string &key) {
+  auto lock = LockTable(mutex_);
+  iter_ = table_->Seek(key);
+}
+
+void MemTableIterator::SeekForPrev(const std::string &key) {
+  auto lock = LockTable(mutex_);
+  iter_ = table_->SeekForPrev(key);
+}
+
+std::unique_ptr<BaseIterator> MemTableIterator::Clone() const { return std::make_unique<MemTableIterator>(*this); }
@@ -0,0 +1,280 @@
+#include <memoryTable/HeapIterator.h>
+#include <memoryTable/MemTableRep.h>
+#include <utils/Macro.h>
+#include <algorithm>
+#include <thread>
+
+namespace {
+// the bytes a hash table node holds besides the key and value: the pair of strings, the next pointer,
+// the cached hash and the allocator rounding
+constexpr size_t HASH_NODE_BYTES = sizeof(std::pair<const std::string, std::string>) + 3 * sizeof(void *);
+
+std::vector<MemTableRep::Entry> SortedScanPrefix(const std::vector<MemTableRep::Entry> &entries,
+                                                 const std::string &prefix) {
+  std::vector<MemTableRep::Entry> res;
+  auto it = std::lower_bound(entries.begin(), entries.end(), prefix,
+                             [](const MemTableRep::Entry &entry, const std::string &key) { return entry.first < key; });
+  for (; it != entries.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+    res.push_back(*it);
+  }
+  return res;
+}
+
+std::vector<MemTableRep::Entry> SortedScanMonotony(const std::vector<MemTableRep::Entry> &entries,
+                                                   const std::function<int(const std::string &)> &predicate) {
+  auto begin = std::partition_point(entries.begin(), entries.end(),
+                                    [&predicate](const MemTableRep::Entry &entry) { return predicate(entry.first) > 0; });
+  auto end = std::partition_point(begin, entries.end(),
+                                  [&predicate](const MemTableRep::Entry &entry) { return predicate(entry.first) == 0; });
+  return {begin, end};
+}
+
+bool EntryLess(const MemTableRep::Entry &lhs, const MemTableRep::Entry &rhs) { return lhs.first < rhs.first; }
+
+// run the tasks, all but the first on their own thread
+void RunParallel(const std::vector<std::function<void()>> &tasks) {
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < tasks.size(); i++) {
+    threads.emplace_back(tasks[i]);
+  }
+  if (!tasks.empty()) {
+    tasks[0]();
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+// the indexes of the newest version of each key of entries, which are in write order, in key order.
+// The indexes are sorted by chunks in parallel then merged pairwise, both stable so that the versions of a key
+// stay in write order. entries is only read
+std::vector<size_t> SortedOrder(const std::vector<MemTableRep::Entry> &entries) {
+  size_t size = entries.size();
+  std::vector<size_t> order(size);
+  for (size_t i = 0; i < size; i++) {
+    order[i] = i;
+  }
+  auto less = [&entries](size_t lhs, size_t rhs) { return entries[lhs].first < entries[rhs].first; };
+  size_t chunks = std::clamp<size_t>(size / MEMTABLE_VECTOR_SORT_MIN_CHUNK, 1, MEMTABLE_VECTOR_SORT_THREADS);
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i <= chunks; i++) {
+    bounds.push_back(size * i / chunks);
+  }
+  auto begin = order.begin();
+  std::vector<std::function<void()>> tasks;
+  for (size_t i = 0; i < chunks; i++) {
+    tasks.emplace_back(
+        [begin, &bounds, &less, i] { std::stable_sort(begin + bounds[i], begin + bounds[i + 1], less); });
+  }
+  RunParallel(tasks);
+  for (size_t width = 1; width < chunks; width *= 2) {
+    tasks.clear();
+    for (size_t i = 0; i + width < chunks; i += 2 * width) {
+      size_t last = std::min(i + 2 * width, chunks);
+      tasks.emplace_back([begin, &bounds, &less, i, width, last] {
+        std::inplace_merge(begin + bounds[i], begin + bounds[i + width], begin + bounds[last], less);
+      });
+    }
+    RunParallel(tasks);
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < size; i++) {
+    if (i + 1 < size && entries[order[i]].first == entries[order[i + 1]].first) {
+      continue;
+    }
+    order[kept++] = order[i];
+  }
+  order.resize(kept);
+  return order;
+}
+}  // namespace
+
+std::shared_ptr<MemTableRep> NewMemTableRep(MemTableRepType type) {
+  switch (type) {
+    case MemTableRepType::kHashTable:
+      return std::make_shared<HashTableRep>();
+    case MemTableRepType::kVector:
+      return std::make_shared<VectorRep>();
+    case MemTableRepType::kSkipList:
+      break;
+  }
+  return std::make_shared<SkipListRep>();
+}
+
+// **************** SkipListRep ****************
+SkipListRep::SkipListRep() {
+  KeyComparator<std::string> key_comparator;
+  list_ = std::make_shared<StringSkipList>(key_comparator);
+}
+
+void SkipListRep::Put(const std::string &key, const std::string &value) { list_->Put(key, value); }
+
+std::optional<std::string> SkipListRep::Get(const std::string &key) { return list_->Get(key); }
+
+size_t SkipListRep::UsedBytes() const { return list_->UsedBytes(); }
+
+size_t SkipListRep::AllocatedBytes() const { return list_->AllocatedBytes(); }
+
+void SkipListRep::Clear() { list_->Clear(); }
+
+std::unique_ptr<BaseIterator> SkipListRep::NewIterator(const std::shared_ptr<std::shared_mutex> &mutex) {
+  return std::make_unique<MemTableIterator>(list_, mutex);
+}
+
+std::vector<MemTableRep::Entry> SkipListRep::ScanPrefix(const std::string &prefix) {
+  std::vector<Entry> res;
+  for (auto iter = list_->BeginPreffix(prefix); iter != list_->EndPreffix(prefix); ++iter) {
+    res.emplace_back(iter.GetKey(), iter.GetValue());
+  }
+  return res;
+}
+
+std::vector<MemTableRep::Entry> SkipListRep::ScanMonotony(const std::function<int(const std::string &)> &predicate) {
+  std::vector<Entry> res;
+  auto range = list_->ItersMonotonyPredicate(predicate);
+  if (range.has_value()) {
+    for (auto iter = range->first; iter != range->second; ++iter) {
+      res.emplace_back(iter.GetKey(), iter.GetValue());
+    }
+  }
+  return res;
+}
+
+// **************** HashTableRep ****************
+HashTableRep::HashTableRep() : used_bytes_(0) {}
+
+void HashTableRep::Put(const std::string &key, const std::string &value) {
+  auto [it, inserted] = table_.try_emplace(key, value);
+  if (inserted) {
+    used_bytes_ += key.size() + value.size();
+  } else {
+    used_bytes_ = used_bytes_ - it->second.size() + value.size();
+    it->second = value;
+  }
+}
+
+std::optional<std::string> HashTableRep::Get(const std::string &key) {
+  auto it = table_.find(key);
+  if (it == table_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+size_t HashTableRep::AllocatedBytes() const {
+  return used_bytes_ + table_.size() * HASH_NODE_BYTES + table_.bucket_count() * sizeof(void *);
+}
+
+void HashTableRep::Clear() {
+  table_.clear();
+  used_bytes_ = 0;
+}
+
+std::shared_ptr<const std::vector<MemTableRep::Entry>> HashTableRep::Sorted() const {
+  std::vector<Entry> entries(table_.begin(), table_.end());
+  std::sort(entries.begin(), entries.end(), [](const Entry &lhs, const Entry &rhs) { return lhs.first < rhs.first; });
+  return std::make_shared<const std::vector<Entry>>(std::move(entries));
+}
+
+std::unique_ptr<BaseIterator> HashTableRep::NewIterator(const std::shared_ptr<std::shared_mutex> &mutex) {
+  std::shared_lock<std::shared_mutex> lock;
+  if (mutex != nullptr) {
+    lock = std::shared_lock<std::shared_mutex>(*mutex);
+  }
+  return std::make_unique<VectorIterator>(Sorted());
+}
+
+std::vector<MemTableRep::Entry> HashTableRep::ScanPrefix(const std::string &prefix) {
+  return SortedScanPrefix(*Sorted(), prefix);
+}
+
+std::vector<MemTableRep::Entry> HashTableRep::ScanMonotony(const std::function<int(const std::string &)> &predicate) {
+  return SortedScanMonotony(*Sorted(), predicate);
+}
+
+// **************** VectorRep ****************
+VectorRep::VectorRep() : used_bytes_(0), allocated_bytes_(0), sorted_all_(false) {}
+
+void VectorRep::Put(const std::string &key, const std::string &value) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  entries_.emplace_back(key, value);
+  used_bytes_ += key.size() + value.size();
+  allocated_bytes_ = used_bytes_ + entries_.capacity() * sizeof(Entry);
+}
+
+std::optional<std::string> VectorRep::Get(const std::string &key) {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  if (sorted_all_) {
+    auto it = std::lower_bound(sorted_->begin(), sorted_->end(), Entry(key, ""), EntryLess);
+    if (it == sorted_->end() || it->first != key) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+  for (auto it = entries_.rbegin(); it != entries_.rend(); ++it) {
+    if (it->first == key) {
+      return it->second;
+    }
+  }
+  return std::nullopt;
+}
+
+void VectorRep::Clear() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  entries_.clear();
+  used_bytes_ = 0;
+  allocated_bytes_ = entries_.capacity() * sizeof(Entry);
+  sorted_all_ = false;
+  sorted_ = nullptr;
+}
+
+std::shared_ptr<const std::vector<MemTableRep::Entry>> VectorRep::Sorted() {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  if (sorted_all_) {
+    return sorted_;
+  }
+  auto sorted = std::make_shared<std::vector<Entry>>();
+  for (auto i : SortedOrder(entries_)) {
+    sorted->push_back(entries_[i]);
+  }
+  return sorted;
+}
+
+void VectorRep::PrepareFlush() {
+  std::vector<size_t> order;
+  {
+    // the entries no longer change, the readers go on while they are sorted
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (sorted_all_) {
+      return;
+    }
+    order = SortedOrder(entries_);
+  }
+  auto sorted = std::make_shared<std::vector<Entry>>();
+  sorted->reserve(order.size());
+  // the readers only wait for the entries to be moved
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  for (auto i : order) {
+    sorted->push_back(std::move(entries_[i]));
+  }
+  entries_ = std::vector<Entry>();
+  sorted_ = std::move(sorted);
+  sorted_all_ = true;
+}
+
+std::unique_ptr<BaseIterator> VectorRep::NewIterator(const std::shared_ptr<std::shared_mutex> &mutex) {
+  std::shared_lock<std::shared_mutex> lock;
+  if (mutex != nullptr) {
+    lock = std::shared_lock<std::shared_mutex>(*mutex);
+  }
+  return std::make_unique<VectorIterator>(Sorted());
+}
+
+std::vector<MemTableRep::Entry> VectorRep::ScanPrefix(const std::string &prefix) {
+  return SortedScanPrefix(*Sorted(), prefix);
+}
+
+std::vector<MemTableRep::Entry> VectorRep::ScanMonotony(const std::function<int(const std::string &)> &predicate) {
+  return SortedScanMonotony(*Sorted(), predicate);
+}
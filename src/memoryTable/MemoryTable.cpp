@@ -6,32 +6,70 @@
 #include <optional>
 #include <utility>
 
-MemoryTable::MemoryTable() {
-  KeyComparator<std::string> key_comparator;
-  current_table_ = std::make_shared<StringSkipList>(key_comparator);
-  frozen_bytes_ = 0;
+MemoryTable::MemoryTable(WriteBufferManager *write_buffer_manager, size_t table_size_limit,
+                         MemTableRepType rep_type)
+    : rep_type_(rep_type),
+      frozen_bytes_(0),
+      frozen_allocated_bytes_(0),
+      write_buffer_manager_(write_buffer_manager),
+      table_size_limit_(table_size_limit),
+      current_table_mutex_(std::make_shared<std::shared_mutex>()),
+      current_sequences_(0, 0) {
+  current_table_ = NewMemTableRep(rep_type_);
+  if (write_buffer_manager_ != nullptr) {
+    write_buffer_manager_->ReserveMem(current_table_->AllocatedBytes());
+  }
+}
+
+MemoryTable::~MemoryTable() {
+  if (write_buffer_manager_ != nullptr) {
+    write_buffer_manager_->FreeMem(current_table_->AllocatedBytes() + frozen_allocated_bytes_);
+  }
 }
 
 void MemoryTable::InternalPut(const std::string &key, const std::string &value) { current_table_->Put(key, value); }
 
-void MemoryTable::Put(const std::string &key, const std::string &value) {
-  std::unique_lock<std::shared_mutex> lock(current_table_mutex_);
-  InternalPut(key, value);
-  if (current_table_->UsedBytes() > LSM_PER_MEM_SIZE_LIMIT) {
+void MemoryTable::AfterWrite(size_t before) {
+  size_t after = current_table_->AllocatedBytes();
+  if (write_buffer_manager_ != nullptr) {
+    if (after > before) {
+      write_buffer_manager_->ReserveMem(after - before);
+    } else {
+      write_buffer_manager_->FreeMem(before - after);
+    }
+  }
+  // the limit applies to the memory of the table, several times the bytes of its entries for small ones
+  if (after > table_size_limit_) {
     std::unique_lock<std::shared_mutex> lock(frozen_tables_mutex_);
     InternalFrozenCurrentTable();
   }
 }
 
+void MemoryTable::UpdateSequence(uint64_t sequence) {
+  if (sequence == 0) {
+    return;
+  }
+  if (current_sequences_.first == 0) {
+    current_sequences_.first = sequence;
+  }
+  current_sequences_.second = sequence;
+}
+
+void MemoryTable::Put(const std::string &key, const std::string &value, uint64_t sequence) {
+  std::unique_lock<std::shared_mutex> lock(*current_table_mutex_);
+  size_t before = current_table_->AllocatedBytes();
+  InternalPut(key, value);
+  UpdateSequence(sequence);
+  AfterWrite(before);
+}
+
 void MemoryTable::PutBatch(const std::vector<std::pair<std::string, std::string>> &batch) {
-  std::unique_lock<std::shared_mutex> lock(current_table_mutex_);
+  std::unique_lock<std::shared_mutex> lock(*current_table_mutex_);
+  size_t before = current_table_->AllocatedBytes();
   for (const auto &item : batch) {
     InternalPut(item.first, item.second);
   }
-  if (current_table_->UsedBytes() > LSM_PER_MEM_SIZE_LIMIT) {
-    std::unique_lock<std::shared_mutex> lock(frozen_tables_mutex_);
-    InternalFrozenCurrentTable();
-  }
+  AfterWrite(before);
 }
 
 std::optional<std::string> MemoryTable::CurGet(const std::string &key) {
@@ -54,7 +92,7 @@ std::optional<std::string> MemoryTable::FrozenGet(const std::string &key) {
 }
 
 std::optional<std::string> MemoryTable::Get(const std::string &key) {
-  std::shared_lock<std::shared_mutex> lock(current_table_mutex_);
+  std::shared_lock<std::shared_mutex> lock(*current_table_mutex_);
   auto result = CurGet(key);
   if (result.has_value()) {
     return result.value();
@@ -64,67 +102,115 @@ std::optional<std::string> MemoryTable::Get(const std::string &key) {
   return FrozenGet(key);
 }
 
+bool MemoryTable::GetVersions(const std::string &key, const std::function<bool(const std::string &)> &visit) {
+  // both locks are held together, a table frozen between the two reads would be visited twice
+  std::shared_lock<std::shared_mutex> lock(*current_table_mutex_);
+  std::shared_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
+  auto current = CurGet(key);
+  if (current.has_value() && visit(current.value())) {
+    return true;
+  }
+  for (const auto &table : frozen_tables_) {
+    auto result = table->Get(key);
+    if (result.has_value() && visit(result.value())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void MemoryTable::Merge(const std::string &key,
+                        const std::function<std::string(const std::optional<std::string> &)> &combine,
+                        uint64_t sequence) {
+  std::unique_lock<std::shared_mutex> lock(*current_table_mutex_);
+  size_t before = current_table_->AllocatedBytes();
+  InternalPut(key, combine(CurGet(key)));
+  UpdateSequence(sequence);
+  AfterWrite(before);
+}
+
 void MemoryTable::InternalRemove(const std::string &key) { current_table_->Put(key, ""); }
 
-void MemoryTable::Remove(const std::string &key) {
-  std::unique_lock<std::shared_mutex> lock(current_table_mutex_);
+void MemoryTable::Remove(const std::string &key, uint64_t sequence) {
+  std::unique_lock<std::shared_mutex> lock(*current_table_mutex_);
+  size_t before = current_table_->AllocatedBytes();
   InternalRemove(key);
+  UpdateSequence(sequence);
+  AfterWrite(before);
 }
 
 void MemoryTable::RemoveBatch(const std::vector<std::string> &keys) {
-  std::unique_lock<std::shared_mutex> lock(current_table_mutex_);
+  std::unique_lock<std::shared_mutex> lock(*current_table_mutex_);
+  size_t before = current_table_->AllocatedBytes();
   for (const auto &key : keys) {
     InternalRemove(key);
   }
+  AfterWrite(before);
 }
 
 void MemoryTable::Clear() {
-  std::unique_lock<std::shared_mutex> lock(current_table_mutex_);
+  std::unique_lock<std::shared_mutex> lock(*current_table_mutex_);
   std::unique_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
+  size_t before = current_table_->AllocatedBytes() + frozen_allocated_bytes_;
   current_table_->Clear();
   frozen_tables_.clear();
+  current_sequences_ = {0, 0};
+  frozen_sequences_.clear();
+  frozen_bytes_ = 0;
+  frozen_allocated_bytes_ = 0;
+  if (write_buffer_manager_ != nullptr) {
+    write_buffer_manager_->FreeMem(before - current_table_->AllocatedBytes());
+  }
 }
 
 void MemoryTable::InternalFrozenCurrentTable() {
   frozen_tables_.push_front(current_table_);
+  frozen_sequences_.push_front(current_sequences_);
+  current_sequences_ = {0, 0};
   frozen_bytes_ += current_table_->UsedBytes();
-  KeyComparator<std::string> key_comparator;
-  current_table_ = std::make_shared<StringSkipList>(key_comparator);
+  frozen_allocated_bytes_ += current_table_->AllocatedBytes();
+  current_table_ = NewMemTableRep(rep_type_);
+  if (write_buffer_manager_ != nullptr) {
+    write_buffer_manager_->ReserveMem(current_table_->AllocatedBytes());
+  }
 }
 
 void MemoryTable::FrozenCurrentTable() {
-  std::unique_lock<std::shared_mutex> lock(current_table_mutex_);
+  std::unique_lock<std::shared_mutex> lock(*current_table_mutex_);
   std::unique_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
   InternalFrozenCurrentTable();
 }
 
-HeapIterator MemoryTable::Begin() {
-  std::shared_lock<std::shared_mutex> lock(current_table_mutex_);
-  std::shared_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
-  std::vector<SearchItem> items;
-  for (auto iter = current_table_->Begin(); iter != current_table_->End(); ++iter) {
-    items.emplace_back(iter.GetKey(), iter.GetValue(), 0);
-  }
+HeapIterator MemoryTable::Begin() { return HeapIterator(NewIterators()); }
 
-  int table_idx = 1;
-  for (const auto &table : frozen_tables_) {
-    for (auto iter = table->Begin(); iter != table->End(); ++iter) {
-      items.emplace_back(iter.GetKey(), iter.GetValue(), table_idx);
-    }
-    table_idx++;
+std::vector<std::unique_ptr<BaseIterator>> MemoryTable::NewIterators() {
+  std::shared_ptr<MemTableRep> current_table;
+  std::list<std::shared_ptr<MemTableRep>> frozen_tables;
+  {
+    std::shared_lock<std::shared_mutex> lock(*current_table_mutex_);
+    std::shared_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
+    current_table = current_table_;
+    frozen_tables = frozen_tables_;
   }
 
-  return HeapIterator(items);
+  std::vector<std::unique_ptr<BaseIterator>> iters;
+  iters.reserve(frozen_tables.size() + 1);
+  // the active table is still written, its iterator takes the table lock when it reads it
+  iters.push_back(current_table->NewIterator(current_table_mutex_));
+  for (const auto &table : frozen_tables) {
+    iters.push_back(table->NewIterator(nullptr));
+  }
+  return iters;
 }
 
 HeapIterator MemoryTable::End() {
-  std::shared_lock<std::shared_mutex> lock(current_table_mutex_);
+  std::shared_lock<std::shared_mutex> lock(*current_table_mutex_);
   std::shared_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
   return HeapIterator();
 }
 
 size_t MemoryTable::GetCurSize() {
-  std::shared_lock<std::shared_mutex> lock(current_table_mutex_);
+  std::shared_lock<std::shared_mutex> lock(*current_table_mutex_);
   return current_table_->UsedBytes();
 }
 
@@ -133,46 +219,94 @@ size_t MemoryTable::GetFrozenSize() {
   return frozen_bytes_;
 }
 
+size_t MemoryTable::GetFrozenCount() {
+  std::shared_lock<std::shared_mutex> lock(frozen_tables_mutex_);
+  return frozen_tables_.size();
+}
+
 size_t MemoryTable::GetTotalSize() {
-  std::shared_lock<std::shared_mutex> lock(current_table_mutex_);
+  std::shared_lock<std::shared_mutex> lock(*current_table_mutex_);
   std::shared_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
   return current_table_->UsedBytes() + frozen_bytes_;
 }
 
-std::shared_ptr<SST> MemoryTable::FlushLast(const std::shared_ptr<SSTBuilder> &builder, const std::string &sst_path,
-                                            size_t sst_id, std::shared_ptr<BlockCache> block_cache) {
-  std::unique_lock<std::shared_mutex> lock(current_table_mutex_);
-  std::unique_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
-  if (frozen_tables_.empty()) {
-    if (current_table_->UsedBytes() == 0) {
-      return nullptr;
+size_t MemoryTable::GetAllocatedBytes() {
+  std::shared_lock<std::shared_mutex> lock(*current_table_mutex_);
+  std::shared_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
+  return current_table_->AllocatedBytes() + frozen_allocated_bytes_;
+}
+
+std::shared_ptr<SST> MemoryTable::FlushLast(
+    const std::shared_ptr<SSTBuilder> &builder, const std::string &sst_path, size_t sst_id,
+    std::shared_ptr<BlockCache> block_cache,
+    const std::function<std::optional<std::string>(const std::string &, const std::string &)> &filter) {
+  std::shared_ptr<MemTableRep> table;
+  {
+    std::unique_lock<std::shared_mutex> lock(*current_table_mutex_);
+    std::unique_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
+    if (frozen_tables_.empty()) {
+      if (current_table_->UsedBytes() == 0) {
+        return nullptr;
+      }
+      InternalFrozenCurrentTable();
     }
-    InternalFrozenCurrentTable();
+    table = frozen_tables_.back();
   }
 
-  auto table = frozen_tables_.back();
-  frozen_tables_.pop_back();
-  frozen_bytes_ -= table->UsedBytes();
-
-  auto flush_data = table->Dump();
-  for (const auto &item : flush_data) {
-    builder->Add(item.first, item.second);
+  // frozen tables are immutable, they are sorted and streamed to the builder without blocking the readers and
+  // writers of the memtable
+  table->PrepareFlush();
+  auto iter = table->NewIterator(nullptr);
+  for (iter->SeekToFirst(); iter->IsValid(); iter->Next()) {
+    auto key = iter->GetKey();
+    auto value = iter->GetValue();
+    if (filter == nullptr || value.empty()) {
+      builder->Add(key, value);
+    } else {
+      builder->Add(key, filter(key, value).value_or(""));
+    }
   }
   auto sst = builder->Build(sst_id, sst_path, std::move(block_cache));
   return sst;
 }
 
+void MemoryTable::ReleaseLast() {
+  std::unique_lock<std::shared_mutex> lock(frozen_tables_mutex_);
+  if (frozen_tables_.empty()) {
+    return;
+  }
+  frozen_bytes_ -= frozen_tables_.back()->UsedBytes();
+  frozen_allocated_bytes_ -= frozen_tables_.back()->AllocatedBytes();
+  if (write_buffer_manager_ != nullptr) {
+    write_buffer_manager_->FreeMem(frozen_tables_.back()->AllocatedBytes());
+  }
+  frozen_tables_.pop_back();
+  frozen_sequences_.pop_back();
+}
+
+uint64_t MemoryTable::GetFlushingSequence() {
+  std::shared_lock<std::shared_mutex> lock(frozen_tables_mutex_);
+  return frozen_sequences_.empty() ? 0 : frozen_sequences_.back().second;
+}
+
+uint64_t MemoryTable::GetOldestSequence() {
+  std::shared_lock<std::shared_mutex> lock(*current_table_mutex_);
+  std::shared_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
+  for (auto it = frozen_sequences_.rbegin(); it != frozen_sequences_.rend(); ++it) {
+    if (it->first != 0) {
+      return it->first;
+    }
+  }
+  return current_sequences_.first;
+}
+
 std::optional<std::pair<HeapIterator, HeapIterator>> MemoryTable::ItersMonotonyPredicate(
     const std::function<int(const std::string &)> &predicate) {
   std::vector<SearchItem> item_vec;
   {
-    std::shared_lock<std::shared_mutex> lock(current_table_mutex_);
-    auto cur_result = current_table_->ItersMonotonyPredicate(predicate);
-    if (cur_result.has_value()) {
-      auto [begin, end] = cur_result.value();
-      for (auto iter = begin; iter != end; ++iter) {
-        item_vec.emplace_back(iter.GetKey(), iter.GetValue(), 0);
-      }
+    std::shared_lock<std::shared_mutex> lock(*current_table_mutex_);
+    for (auto &[key, value] : current_table_->ScanMonotony(predicate)) {
+      item_vec.emplace_back(std::move(key), std::move(value), 0);
     }
   }
 
@@ -180,12 +314,8 @@ std::optional<std::pair<HeapIterator, HeapIterator>> MemoryTable::ItersMonotonyP
     std::shared_lock<std::shared_mutex> lock(frozen_tables_mutex_);
     int table_idx = 1;
     for (const auto &table : frozen_tables_) {
-      auto cur_result = table->ItersMonotonyPredicate(predicate);
-      if (cur_result.has_value()) {
-        auto [begin, end] = cur_result.value();
-        for (auto iter = begin; iter != end; ++iter) {
-          item_vec.emplace_back(iter.GetKey(), iter.GetValue(), table_idx);
-        }
+      for (auto &[key, value] : table->ScanMonotony(predicate)) {
+        item_vec.emplace_back(std::move(key), std::move(value), table_idx);
       }
       table_idx++;
     }
@@ -197,17 +327,17 @@ std::optional<std::pair<HeapIterator, HeapIterator>> MemoryTable::ItersMonotonyP
 }
 
 HeapIterator MemoryTable::ItersPreffix(const std::string &preffix) {
-  std::shared_lock<std::shared_mutex> lock(current_table_mutex_);
+  std::shared_lock<std::shared_mutex> lock(*current_table_mutex_);
   std::shared_lock<std::shared_mutex> lock2(frozen_tables_mutex_);
   std::vector<SearchItem> items;
-  for (auto iter = current_table_->BeginPreffix(preffix); iter != current_table_->EndPreffix(preffix); ++iter) {
-    items.emplace_back(iter.GetKey(), iter.GetValue(), 0);
+  for (auto &[key, value] : current_table_->ScanPrefix(preffix)) {
+    items.emplace_back(std::move(key), std::move(value), 0);
   }
 
   int table_idx = 1;
   for (const auto &table : frozen_tables_) {
-    for (auto iter = table->BeginPreffix(preffix); iter != table->EndPreffix(preffix); ++iter) {
-      items.emplace_back(iter.GetKey(), iter.GetValue(), table_idx);
+    for (auto &[key, value] : table->ScanPrefix(preffix)) {
+      items.emplace_back(std::move(key), std::move(value), table_idx);
     }
     table_idx++;
   }
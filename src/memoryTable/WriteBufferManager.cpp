@@ -0,0 +1,44 @@
+#include <memoryTable/WriteBufferManager.h>
+#include <limits>
+#include <utility>
+
+WriteBufferManager::WriteBufferManager(size_t buffer_size, size_t memory_budget,
+                                       std::shared_ptr<BlockCache> block_cache)
+    : buffer_size_(buffer_size),
+      memory_budget_(memory_budget),
+      block_cache_(std::move(block_cache)),
+      memory_used_(0),
+      cache_limit_(std::numeric_limits<size_t>::max()) {}
+
+void WriteBufferManager::SetMemoryBudget(size_t memory_budget) {
+  memory_budget_ = memory_budget;
+  if (memory_budget == 0 && block_cache_ != nullptr) {
+    cache_limit_ = std::numeric_limits<size_t>::max();
+    block_cache_->SetMaxBytes(cache_limit_);
+  }
+}
+
+bool WriteBufferManager::ShouldFlush(size_t table_memory) {
+  size_t used = memory_used_;
+  if (used >= buffer_size_) {
+    return true;
+  }
+  size_t budget = memory_budget_;
+  if (budget == 0) {
+    return false;
+  }
+
+  size_t fixed = used + table_memory;
+  if (block_cache_ != nullptr) {
+    size_t limit = fixed >= budget ? 0 : budget - fixed;
+    size_t last = cache_limit_;
+    // resize in steps, the block cache takes its lock to apply the limit
+    size_t diff = limit > last ? limit - last : last - limit;
+    if (diff >= budget / 64) {
+      cache_limit_ = limit;
+      block_cache_->SetMaxBytes(limit);
+    }
+  }
+  // flushing tiny memtables does not help when the SSTs take the budget
+  return fixed >= budget && used >= budget / 8;
+}
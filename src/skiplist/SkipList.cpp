@@ -4,7 +4,7 @@
 // **************** SkipList ****************
 SKIPLIST_TEMPLATE_ARGUMENTS
 SKIPLIST_TYPE::SkipList(const KeyComparator &comparator, int maxLevel)
-    : max_level_(maxLevel), level_(0), used_bytes_(0), comp_(std::move(comparator)) {
+    : max_level_(maxLevel), level_(0), used_bytes_(0), allocated_bytes_(0), comp_(std::move(comparator)) {
   head_ = std::make_shared<SkipListNode<K, V>>(max_level_ + 1);
   tail_ = std::make_shared<SkipListNode<K, V>>(max_level_ + 1);
   tail_key_ = comp_.MaxValue();
@@ -14,6 +14,8 @@ SKIPLIST_TYPE::SkipList(const KeyComparator &comparator, int maxLevel)
     tail_->SetBackward(i, head_);
   }
   last_.resize(max_level_ + 1, head_);
+  allocated_bytes_ =
+      NodeBytes(max_level_ + 1, head_->key_, head_->value_) + NodeBytes(max_level_ + 1, tail_->key_, tail_->value_);
 
   std::random_device rd;
   gen_ = std::mt19937(rd());
@@ -39,6 +41,28 @@ std::optional<V> SKIPLIST_TYPE::Get(const K &key) {
   return std::nullopt;
 }
 
+SKIPLIST_TEMPLATE_ARGUMENTS
+SKIPLIST_ITERATOR_TYPE SKIPLIST_TYPE::Seek(const K &key) {
+  auto p = head_;
+  for (int i = level_; i >= 0; i--) {
+    while (comp_(p->forward_[i]->key_, key) < 0) {
+      p = p->forward_[i];
+    }
+  }
+  return Iterator(p->forward_[0]);
+}
+
+SKIPLIST_TEMPLATE_ARGUMENTS
+SKIPLIST_ITERATOR_TYPE SKIPLIST_TYPE::SeekForPrev(const K &key) {
+  auto p = head_;
+  for (int i = level_; i >= 0; i--) {
+    while (p->forward_[i] != tail_ && comp_(p->forward_[i]->key_, key) <= 0) {
+      p = p->forward_[i];
+    }
+  }
+  return Iterator(p);
+}
+
 SKIPLIST_TEMPLATE_ARGUMENTS
 std::optional<std::shared_ptr<SkipListNode<K, V>>> SKIPLIST_TYPE::InternalSearch(const K &key) {
   if (comp_(key, tail_key_) >= 0) {
@@ -75,7 +99,11 @@ bool SKIPLIST_TYPE::Put(const K &key, const V &value) {
   }
   if (comp_((*p)->key_, key) == 0) {
     // if exists, update value and return
+    int level = static_cast<int>((*p)->forward_.size());
+    used_bytes_ += GetSize(value) - GetSize((*p)->value_);
+    allocated_bytes_ -= NodeBytes(level, key, (*p)->value_);
     (*p)->value_ = value;
+    allocated_bytes_ += NodeBytes(level, key, (*p)->value_);
     return true;
   }
   // insert new node
@@ -88,6 +116,7 @@ bool SKIPLIST_TYPE::Put(const K &key, const V &value) {
   new_node->key_ = key;
   new_node->value_ = value;
   used_bytes_ += GetSize(key) + GetSize(value);
+  allocated_bytes_ += NodeBytes(new_level + 1, new_node->key_, new_node->value_);
 
   // randomly update the pointers in each level
   int random_bits = dist_level_(gen_);
@@ -137,6 +166,7 @@ bool SKIPLIST_TYPE::Remove(const K &key) {
     level_--;
   }
   used_bytes_ -= GetSize(key) + GetSize((*p)->value_);
+  allocated_bytes_ -= NodeBytes(static_cast<int>((*p)->forward_.size()), (*p)->key_, (*p)->value_);
   return true;
 }
 
@@ -159,6 +189,21 @@ void SKIPLIST_TYPE::Clear() {
   }
   level_ = 0;
   used_bytes_ = 0;
+  allocated_bytes_ =
+      NodeBytes(max_level_ + 1, head_->key_, head_->value_) + NodeBytes(max_level_ + 1, tail_->key_, tail_->value_);
+}
+
+SKIPLIST_TEMPLATE_ARGUMENTS
+size_t SKIPLIST_TYPE::NodeBytes(int level, const K &key, const V &value) {
+  // make_shared puts the reference counts next to the node, the allocator rounds every block to 16 bytes
+  constexpr size_t kControlBlockBytes = 16;
+  auto round = [](size_t bytes) { return (bytes + 15) / 16 * 16; };
+  size_t bytes = round(sizeof(SkipListNode<K, V>) + kControlBlockBytes) +
+                 round(level * sizeof(std::shared_ptr<SkipListNode<K, V>>)) +
+                 round(level * sizeof(std::weak_ptr<SkipListNode<K, V>>));
+  size_t key_bytes = GetAllocatedSize(key);
+  size_t value_bytes = GetAllocatedSize(value);
+  return bytes + (key_bytes == 0 ? 0 : round(key_bytes)) + (value_bytes == 0 ? 0 : round(value_bytes));
 }
 
 SKIPLIST_TEMPLATE_ARGUMENTS
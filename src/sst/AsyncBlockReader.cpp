@@ -0,0 +1,391 @@
+#include <linux/io_uring.h>
+#include <sst/AsyncBlockReader.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utils/AlignedBufferPool.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace {
+// the reader whose completion thread or worker is running, a coroutine resumed there must not wait for the reader
+thread_local const AsyncBlockReader *current_reader = nullptr;
+}  // namespace
+
+// the reads always cover whole aligned extents, so they work on O_DIRECT files as well
+struct AsyncBlockReader::Request {
+  std::shared_ptr<SST> sst_;
+  size_t block_idx_;
+  ReadOptions options_;
+  Callback callback_;
+  int fd_;
+  size_t aligned_offset_;  // file offset of the read
+  size_t skip_;            // position of the block in buffer_
+  size_t size_;            // size of the block
+  AlignedBuffer buffer_;
+  iovec iov_;
+
+  Request(const BlockReadRequest &request, const ReadOptions &options, const Callback &callback)
+      : sst_(request.sst_),
+        block_idx_(request.block_idx_),
+        options_(options),
+        callback_(callback),
+        fd_(sst_->GetFileHandle()),
+        buffer_(Init(&aligned_offset_, &skip_, &size_)) {
+    iov_.iov_base = buffer_.Data();
+    iov_.iov_len = buffer_.Capacity();
+  }
+
+  AlignedBuffer Init(size_t *aligned_offset, size_t *skip, size_t *size) {
+    size_t offset;
+    sst_->GetBlockHandle(block_idx_, &offset, size, options_);
+    auto &pool = AlignedBufferPool::Default();
+    size_t alignment = pool.GetAlignment();
+    *aligned_offset = offset / alignment * alignment;
+    *skip = offset - *aligned_offset;
+    return pool.Acquire(*skip + *size);
+  }
+};
+
+// a minimal io_uring set up with raw syscalls, only the features needed by the reader are used
+struct AsyncBlockReader::IoUring {
+  int fd_ = -1;
+  void *sq_ring_ = MAP_FAILED;
+  size_t sq_ring_size_ = 0;
+  void *cq_ring_ = MAP_FAILED;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe *sqes_ = static_cast<io_uring_sqe *>(MAP_FAILED);
+  size_t sqes_size_ = 0;
+
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  io_uring_cqe *cqes_;
+
+  ~IoUring() {
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  // nullptr if io_uring is not available
+  static std::unique_ptr<IoUring> Create(unsigned entries) {
+    auto ring = std::make_unique<IoUring>();
+    io_uring_params params{};
+    ring->fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring->fd_ < 0) {
+      return nullptr;
+    }
+
+    ring->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      ring->sq_ring_size_ = ring->cq_ring_size_ = std::max(ring->sq_ring_size_, ring->cq_ring_size_);
+    }
+    ring->sq_ring_ = mmap(nullptr, ring->sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring->fd_, IORING_OFF_SQ_RING);
+    if (ring->sq_ring_ == MAP_FAILED) {
+      return nullptr;
+    }
+    if (single_mmap) {
+      ring->cq_ring_ = ring->sq_ring_;
+    } else {
+      ring->cq_ring_ = mmap(nullptr, ring->cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring->fd_, IORING_OFF_CQ_RING);
+      if (ring->cq_ring_ == MAP_FAILED) {
+        return nullptr;
+      }
+    }
+    ring->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sqes_ = static_cast<io_uring_sqe *>(mmap(nullptr, ring->sqes_size_, PROT_READ | PROT_WRITE,
+                                                   MAP_SHARED | MAP_POPULATE, ring->fd_, IORING_OFF_SQES));
+    if (ring->sqes_ == MAP_FAILED) {
+      return nullptr;
+    }
+
+    auto *sq = static_cast<uint8_t *>(ring->sq_ring_);
+    auto *cq = static_cast<uint8_t *>(ring->cq_ring_);
+    ring->sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    ring->sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    ring->sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    ring->cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    ring->cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    ring->cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    ring->cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    return ring;
+  }
+
+  // the caller serializes the submissions, every submitted entry is consumed by the kernel before returning
+  void Submit(uint8_t opcode, int fd, const iovec *iov, uint64_t offset, uint64_t user_data) {
+    unsigned tail = *sq_tail_;
+    unsigned idx = tail & *sq_mask_;
+    io_uring_sqe *sqe = &sqes_[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(iov);
+    sqe->len = iov == nullptr ? 0 : 1;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array_[idx] = idx;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+    // the kernel refuses new entries while the completion queue is full (EBUSY) or it is short of memory (EAGAIN),
+    // back off so the completion thread can drain the ring instead of spinning on the syscall
+    auto backoff = std::chrono::microseconds(1);
+    while (true) {
+      long ret = syscall(__NR_io_uring_enter, fd_, 1, 0, 0, nullptr, 0);
+      if (ret >= 1) {
+        return;
+      }
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret < 0 && errno != EAGAIN && errno != EBUSY) {
+        throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+      }
+      std::this_thread::sleep_for(backoff);
+      backoff = std::min(backoff * 2, std::chrono::microseconds(1000));
+    }
+  }
+
+  // wait for the next completion
+  io_uring_cqe WaitCompletion() {
+    while (true) {
+      unsigned head = *cq_head_;
+      if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        io_uring_cqe cqe = cqes_[head & *cq_mask_];
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        return cqe;
+      }
+      syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    }
+  }
+};
+
+AsyncBlockReader::AsyncBlockReader(size_t queue_depth, size_t num_threads, bool use_io_uring)
+    : queue_depth_(std::max<size_t>(queue_depth, 1)), in_flight_(0), stop_(false) {
+  if (use_io_uring) {
+    ring_ = IoUring::Create(static_cast<unsigned>(queue_depth_));
+  }
+  if (ring_ != nullptr) {
+    threads_.emplace_back(&AsyncBlockReader::CompletionLoop, this);
+    return;
+  }
+  for (size_t i = 0; i < std::max<size_t>(num_threads, 1); i++) {
+    threads_.emplace_back(&AsyncBlockReader::WorkerLoop, this);
+  }
+}
+
+AsyncBlockReader::~AsyncBlockReader() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return in_flight_ == 0 && (ring_ == nullptr || pending_.empty()); });
+    stop_ = true;
+    if (ring_ != nullptr) {
+      // wake up the completion thread, user_data 0 tells it to exit
+      ring_->Submit(IORING_OP_NOP, -1, nullptr, 0, 0);
+    }
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void AsyncBlockReader::Submit(const BlockReadRequest &request, const ReadOptions &options, Callback callback) {
+  std::shared_ptr<Block> block;
+  std::unique_ptr<Request> req;
+  try {
+    block = request.sst_->GetCachedBlock(request.block_idx_);
+    if (block == nullptr) {
+      req = std::make_unique<Request>(request, options, callback);
+    }
+  } catch (...) {
+    callback(nullptr, std::current_exception());
+    return;
+  }
+  if (block != nullptr) {
+    callback(std::move(block), nullptr);
+    return;
+  }
+
+  std::vector<std::pair<std::unique_ptr<Request>, std::exception_ptr>> failed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(std::move(req));
+    if (ring_ != nullptr) {
+      failed = SubmitPending();
+    }
+  }
+  cv_.notify_one();
+  Fail(std::move(failed));
+}
+
+std::vector<std::pair<std::unique_ptr<AsyncBlockReader::Request>, std::exception_ptr>>
+AsyncBlockReader::SubmitPending() {
+  std::vector<std::pair<std::unique_ptr<Request>, std::exception_ptr>> failed;
+  while (in_flight_ < queue_depth_ && !pending_.empty()) {
+    auto request = std::move(pending_.front());
+    pending_.pop_front();
+    try {
+      ring_->Submit(IORING_OP_READV, request->fd_, &request->iov_, request->aligned_offset_,
+                    reinterpret_cast<uint64_t>(request.get()));
+    } catch (...) {
+      failed.emplace_back(std::move(request), std::current_exception());
+      continue;
+    }
+    in_flight_++;
+    request.release();  // owned by the ring until completed
+  }
+  return failed;
+}
+
+void AsyncBlockReader::Fail(std::vector<std::pair<std::unique_ptr<Request>, std::exception_ptr>> failed) {
+  for (auto &[request, error] : failed) {
+    request->callback_(nullptr, error);
+  }
+}
+
+void AsyncBlockReader::CompletionLoop() {
+  current_reader = this;
+  while (true) {
+    auto cqe = ring_->WaitCompletion();
+    if (cqe.user_data == 0) {
+      return;
+    }
+    std::unique_ptr<Request> request(reinterpret_cast<Request *>(cqe.user_data));
+    std::vector<std::pair<std::unique_ptr<Request>, std::exception_ptr>> failed;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      in_flight_--;
+      failed = SubmitPending();
+    }
+    cv_.notify_all();
+    Fail(std::move(failed));
+    Complete(std::move(request), cqe.res);
+  }
+}
+
+void AsyncBlockReader::WorkerLoop() {
+  current_reader = this;
+  while (true) {
+    std::unique_ptr<Request> request;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        return;
+      }
+      request = std::move(pending_.front());
+      pending_.pop_front();
+    }
+    ssize_t n;
+    do {
+      n = pread(request->fd_, request->buffer_.Data(), request->buffer_.Capacity(),
+                static_cast<off_t>(request->aligned_offset_));
+    } while (n < 0 && errno == EINTR);
+    Complete(std::move(request), n < 0 ? -errno : n);
+  }
+}
+
+void AsyncBlockReader::Complete(std::unique_ptr<Request> request, ssize_t bytes_read) {
+  std::shared_ptr<Block> block;
+  std::exception_ptr error;
+  try {
+    if (bytes_read < 0) {
+      throw std::system_error(static_cast<int>(-bytes_read), std::generic_category(), "Failed to read block");
+    }
+    // finish a short read synchronously, restarting from an aligned position
+    size_t alignment = AlignedBufferPool::Default().GetAlignment();
+    size_t done = bytes_read;
+    size_t need = request->skip_ + request->size_;
+    while (done < need) {
+      size_t from = done / alignment * alignment;
+      ssize_t n = pread(request->fd_, request->buffer_.Data() + from, request->buffer_.Capacity() - from,
+                        static_cast<off_t>(request->aligned_offset_ + from));
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0) {
+        throw std::system_error(errno, std::generic_category(), "Failed to read block");
+      }
+      if (n == 0) {
+        throw std::runtime_error("Unexpected end of file when reading block");
+      }
+      done = from + n;
+    }
+
+    const uint8_t *begin = request->buffer_.Data() + request->skip_;
+    std::vector<uint8_t> block_data(begin, begin + request->size_);
+    block = request->sst_->LoadBlock(request->block_idx_, block_data, request->options_);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  auto callback = std::move(request->callback_);
+  request.reset();  // give the buffer back before running the callback
+  callback(std::move(block), error);
+}
+
+std::vector<std::shared_ptr<Block>> AsyncBlockReader::ReadBlocks(const std::vector<BlockReadRequest> &requests,
+                                                                 const ReadOptions &options) {
+  if (current_reader == this) {
+    // waiting here would block the thread which completes the reads
+    std::vector<std::shared_ptr<Block>> blocks;
+    blocks.reserve(requests.size());
+    for (const auto &request : requests) {
+      blocks.push_back(request.sst_->ReadBlock(request.block_idx_, options));
+    }
+    return blocks;
+  }
+
+  struct Latch {
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t remaining_;
+    std::exception_ptr error_;
+  };
+  auto latch = std::make_shared<Latch>();
+  latch->remaining_ = requests.size();
+  std::vector<std::shared_ptr<Block>> blocks(requests.size());
+
+  for (size_t i = 0; i < requests.size(); i++) {
+    Submit(requests[i], options, [latch, &blocks, i](std::shared_ptr<Block> block, std::exception_ptr error) {
+      std::lock_guard<std::mutex> lock(latch->mutex_);
+      blocks[i] = std::move(block);
+      if (error != nullptr && latch->error_ == nullptr) {
+        latch->error_ = error;
+      }
+      if (--latch->remaining_ == 0) {
+        latch->cv_.notify_all();
+      }
+    });
+  }
+
+  std::unique_lock<std::mutex> lock(latch->mutex_);
+  latch->cv_.wait(lock, [&latch] { return latch->remaining_ == 0; });
+  if (latch->error_ != nullptr) {
+    std::rethrow_exception(latch->error_);
+  }
+  return blocks;
+}
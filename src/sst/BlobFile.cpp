@@ -0,0 +1,128 @@
+#include <fcntl.h>
+#include <sst/BlobFile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils/Crc32c.h>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr size_t CHECKSUM_SIZE = sizeof(uint32_t);
+}  // namespace
+
+// **************** BlobIndex ****************
+std::string BlobIndex::Encode() const {
+  std::string res(ENCODED_SIZE, '\0');
+  memcpy(res.data(), &file_number_, sizeof(uint64_t));
+  memcpy(res.data() + sizeof(uint64_t), &offset_, sizeof(uint64_t));
+  memcpy(res.data() + 2 * sizeof(uint64_t), &size_, sizeof(uint32_t));
+  return res;
+}
+
+BlobIndex BlobIndex::Decode(const std::string &encoded) {
+  if (encoded.size() != ENCODED_SIZE) {
+    throw std::runtime_error("Corrupted blob index");
+  }
+  BlobIndex res{};
+  memcpy(&res.file_number_, encoded.data(), sizeof(uint64_t));
+  memcpy(&res.offset_, encoded.data() + sizeof(uint64_t), sizeof(uint64_t));
+  memcpy(&res.size_, encoded.data() + 2 * sizeof(uint64_t), sizeof(uint32_t));
+  return res;
+}
+
+// **************** BlobFileBuilder ****************
+BlobFileBuilder::BlobFileBuilder(std::string path, uint64_t file_number)
+    : path_(std::move(path)), file_number_(file_number), fd_(-1), file_size_(0), finished_(false) {}
+
+BlobFileBuilder::~BlobFileBuilder() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  if (!finished_ && file_size_ > 0) {
+    std::filesystem::remove(path_);
+  }
+}
+
+BlobIndex BlobFileBuilder::Add(const std::string &value) {
+  if (finished_) {
+    throw std::logic_error("BlobFileBuilder is finished");
+  }
+  if (fd_ < 0) {
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+      throw std::runtime_error("Failed to create blob file " + path_);
+    }
+  }
+
+  std::string record(CHECKSUM_SIZE, '\0');
+  uint32_t crc = Crc32c::Value(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+  memcpy(record.data(), &crc, CHECKSUM_SIZE);
+  record += value;
+  size_t done = 0;
+  while (done < record.size()) {
+    ssize_t n = ::write(fd_, record.data() + done, record.size() - done);
+    if (n <= 0) {
+      throw std::runtime_error("Failed to write blob file " + path_);
+    }
+    done += static_cast<size_t>(n);
+  }
+
+  BlobIndex index{file_number_, file_size_ + CHECKSUM_SIZE, static_cast<uint32_t>(value.size())};
+  file_size_ += record.size();
+  return index;
+}
+
+bool BlobFileBuilder::Finish() {
+  finished_ = true;
+  if (fd_ < 0) {
+    return false;
+  }
+  // the SSTs referencing the values are only written once they are durable
+  if (::fsync(fd_) != 0) {
+    throw std::runtime_error("Failed to sync blob file " + path_);
+  }
+  ::close(fd_);
+  fd_ = -1;
+  return true;
+}
+
+// **************** BlobFileReader ****************
+BlobFileReader::BlobFileReader(const std::string &path, uint64_t file_number) : file_number_(file_number) {
+  fd_ = ::open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw std::runtime_error("Failed to open blob file " + path);
+  }
+  struct stat st {};
+  if (::fstat(fd_, &st) != 0) {
+    ::close(fd_);
+    throw std::runtime_error("Failed to stat blob file " + path);
+  }
+  file_size_ = static_cast<uint64_t>(st.st_size);
+}
+
+BlobFileReader::~BlobFileReader() { ::close(fd_); }
+
+std::string BlobFileReader::Read(const BlobIndex &index) const {
+  if (index.file_number_ != file_number_ || index.offset_ < CHECKSUM_SIZE ||
+      index.offset_ + index.size_ > file_size_) {
+    throw std::runtime_error("Blob index out of blob file " + std::to_string(file_number_));
+  }
+  std::string record(CHECKSUM_SIZE + index.size_, '\0');
+  uint64_t offset = index.offset_ - CHECKSUM_SIZE;
+  size_t done = 0;
+  while (done < record.size()) {
+    ssize_t n = ::pread(fd_, record.data() + done, record.size() - done, static_cast<off_t>(offset + done));
+    if (n <= 0) {
+      throw std::runtime_error("Failed to read blob file " + std::to_string(file_number_));
+    }
+    done += static_cast<size_t>(n);
+  }
+  uint32_t crc;
+  memcpy(&crc, record.data(), CHECKSUM_SIZE);
+  if (Crc32c::Value(reinterpret_cast<const uint8_t *>(record.data()) + CHECKSUM_SIZE, index.size_) != crc) {
+    throw std::runtime_error("Blob checksum mismatch in blob file " + std::to_string(file_number_));
+  }
+  return record.substr(CHECKSUM_SIZE);
+}
@@ -0,0 +1,78 @@
+#include <sst/BloomFilter.h>
+#include <algorithm>
+#include <cstring>
+
+uint32_t BloomFilter::Hash(std::string_view key) {
+  // murmur-like hash, the same one as leveldb uses for its filters
+  const uint32_t seed = 0xbc9f1d34;
+  const uint32_t m = 0xc6a4a793;
+  const auto *data = reinterpret_cast<const uint8_t *>(key.data());
+  size_t n = key.size();
+  uint32_t h = seed ^ (n * m);
+
+  while (n >= 4) {
+    uint32_t w;
+    memcpy(&w, data, sizeof(uint32_t));
+    data += 4;
+    n -= 4;
+    h += w;
+    h *= m;
+    h ^= (h >> 16);
+  }
+
+  switch (n) {
+    case 3:
+      h += static_cast<uint32_t>(data[2]) << 16;
+      [[fallthrough]];
+    case 2:
+      h += static_cast<uint32_t>(data[1]) << 8;
+      [[fallthrough]];
+    case 1:
+      h += data[0];
+      h *= m;
+      h ^= (h >> 24);
+      break;
+    default:
+      break;
+  }
+  return h;
+}
+
+std::vector<uint8_t> BloomFilter::Build(const std::vector<uint32_t> &hashes, size_t bits_per_key) {
+  // k = bits_per_key * ln(2) minimizes the false positive rate
+  auto num_probes = static_cast<uint8_t>(std::clamp<size_t>(bits_per_key * 69 / 100, 1, 30));
+  // a small filter would have a high false positive rate, use 64 bits at least
+  size_t bits = std::max<size_t>(hashes.size() * bits_per_key, 64);
+  size_t bytes = (bits + 7) / 8;
+  bits = bytes * 8;
+
+  std::vector<uint8_t> filter(bytes + 1, 0);
+  for (auto h : hashes) {
+    const uint32_t delta = (h >> 17) | (h << 15);
+    for (uint8_t i = 0; i < num_probes; i++) {
+      const uint32_t bit_pos = h % bits;
+      filter[bit_pos / 8] |= (1 << (bit_pos % 8));
+      h += delta;
+    }
+  }
+  filter[bytes] = num_probes;
+  return filter;
+}
+
+bool BloomFilter::MayContain(const std::vector<uint8_t> &filter, uint32_t hash) {
+  if (filter.size() < 2) {
+    return true;
+  }
+  const size_t bits = (filter.size() - 1) * 8;
+  const uint8_t num_probes = filter.back();
+
+  const uint32_t delta = (hash >> 17) | (hash << 15);
+  for (uint8_t i = 0; i < num_probes; i++) {
+    const uint32_t bit_pos = hash % bits;
+    if ((filter[bit_pos / 8] & (1 << (bit_pos % 8))) == 0) {
+      return false;
+    }
+    hash += delta;
+  }
+  return true;
+}
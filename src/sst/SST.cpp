@@ -1,7 +1,48 @@
+#include <block/BlockIterator.h>
+#include <sst/BloomFilter.h>
 #include <sst/SST.h>
 #include <sst/SSTIterator.h>
+#include <type/Size.h>
+#include <utils/Crc32c.h>
+#include <utils/Macro.h>
+#include <cstring>
+#include <limits>
 #include <utility>
 
+namespace {
+// filter offset, num_blocks, index_partition_size, meta offset, checksum type and format version
+constexpr size_t EXTRA_SIZE = 6 * sizeof(uint32_t);
+constexpr uint32_t SST_FORMAT_VERSION = 1;
+constexpr uint32_t CHECKSUM_TYPE_CRC32C = 1;
+
+// append an encoded block followed by its crc32c
+void AppendBlock(const std::vector<uint8_t> &encoded, std::vector<uint8_t> *data) {
+  uint32_t crc = Crc32c::Value(encoded.data(), encoded.size());
+  data->insert(data->end(), encoded.begin(), encoded.end());
+  data->insert(data->end(), reinterpret_cast<uint8_t *>(&crc), reinterpret_cast<uint8_t *>(&crc) + sizeof(uint32_t));
+}
+
+std::string EncodeIndexEntry(const BlockMeta &meta, uint32_t block_size) {
+  std::string value(2 * sizeof(uint32_t), '\0');
+  auto offset = static_cast<uint32_t>(meta.offset_);
+  memcpy(value.data(), &offset, sizeof(uint32_t));
+  memcpy(value.data() + sizeof(uint32_t), &block_size, sizeof(uint32_t));
+  return value + meta.first_key_;
+}
+
+BlockMeta DecodeIndexEntry(const std::string &last_key, const std::string &value, size_t *block_size) {
+  if (value.size() < 2 * sizeof(uint32_t)) {
+    throw std::runtime_error("Invalid index entry");
+  }
+  uint32_t offset;
+  uint32_t size;
+  memcpy(&offset, value.data(), sizeof(uint32_t));
+  memcpy(&size, value.data() + sizeof(uint32_t), sizeof(uint32_t));
+  *block_size = size;
+  return {offset, value.substr(2 * sizeof(uint32_t)), last_key};
+}
+}  // namespace
+
 std::shared_ptr<SST> SST::Open(size_t sst_id, FileObj file, std::shared_ptr<BlockCache> block_cache) {
   auto sst = std::make_shared<SST>();
   sst->sst_id_ = sst_id;
@@ -9,19 +50,49 @@ std::shared_ptr<SST> SST::Open(size_t sst_id, FileObj file, std::shared_ptr<Bloc
   sst->block_cache_ = std::move(block_cache);
 
   size_t file_size = sst->file_.Size();
-  if (file_size < sizeof(size_t)) {
+  if (file_size < EXTRA_SIZE) {
     throw std::runtime_error("Invalid SST file size, too small");
   }
 
-  auto meta_offset_bytes = sst->file_.Read(file_size - sizeof(uint32_t), sizeof(uint32_t));
-  sst->meta_offset_ = *reinterpret_cast<uint32_t *>(meta_offset_bytes.data());
+  auto extra_bytes = sst->file_.Read(file_size - EXTRA_SIZE, EXTRA_SIZE);
+  uint32_t extra[6];
+  memcpy(extra, extra_bytes.data(), EXTRA_SIZE);
+  if (extra[5] != SST_FORMAT_VERSION) {
+    throw std::runtime_error("Unsupported SST format version " + std::to_string(extra[5]));
+  }
+  if (extra[4] != CHECKSUM_TYPE_CRC32C) {
+    throw std::runtime_error("Unsupported SST checksum type " + std::to_string(extra[4]));
+  }
+  sst->filter_offset_ = extra[0];
+  sst->num_blocks_ = extra[1];
+  sst->index_partition_size_ = extra[2];
+  sst->meta_offset_ = extra[3];
 
-  if (sst->meta_offset_ > file_size) {
+  if (sst->meta_offset_ > file_size - EXTRA_SIZE || sst->filter_offset_ > sst->meta_offset_) {
     throw std::runtime_error("Invalid SST meta offset");
   }
 
-  auto meta_bytes = sst->file_.Read(sst->meta_offset_, file_size - sst->meta_offset_ - sizeof(uint32_t));
+  auto meta_bytes = sst->file_.Read(sst->meta_offset_, file_size - sst->meta_offset_ - EXTRA_SIZE);
   sst->meta_ = BlockMeta::DecodeMeta(meta_bytes);
+  size_t expected_meta_size = sst->index_partition_size_ == 0
+                                  ? sst->num_blocks_
+                                  : (sst->num_blocks_ + sst->index_partition_size_ - 1) / sst->index_partition_size_;
+  if (sst->meta_.size() != expected_meta_size) {
+    throw std::runtime_error("Invalid SST meta, number of entries mismatch");
+  }
+
+  auto filter_bytes = sst->file_.Read(sst->filter_offset_, sst->meta_offset_ - sst->filter_offset_);
+  if (filter_bytes.size() < sizeof(uint16_t)) {
+    throw std::runtime_error("Invalid SST filter");
+  }
+  uint16_t name_len;
+  memcpy(&name_len, filter_bytes.data(), sizeof(uint16_t));
+  if (sizeof(uint16_t) + name_len > filter_bytes.size()) {
+    throw std::runtime_error("Invalid SST filter");
+  }
+  sst->prefix_extractor_name_.assign(reinterpret_cast<const char *>(filter_bytes.data()) + sizeof(uint16_t),
+                                     name_len);
+  sst->bloom_filter_.assign(filter_bytes.begin() + sizeof(uint16_t) + name_len, filter_bytes.end());
 
   if (sst->meta_.empty()) {
     throw std::runtime_error("Invalid SST meta");
@@ -33,6 +104,20 @@ std::shared_ptr<SST> SST::Open(size_t sst_id, FileObj file, std::shared_ptr<Bloc
   return sst;
 }
 
+SST::~SST() { SetPinIndex(false); }
+
+void SST::SetPinIndex(bool pin) {
+  if (pin == pin_index_ || block_cache_ == nullptr) {
+    return;
+  }
+  pin_index_ = pin;
+  if (pin) {
+    block_cache_->Pin(static_cast<int>(sst_id_));
+  } else {
+    block_cache_->Unpin(static_cast<int>(sst_id_));
+  }
+}
+
 std::shared_ptr<SST> SST::CreateSSTWithMetaOnly(size_t sst_id, size_t file_size, const std::string &first_key,
                                                 const std::string &last_key, std::shared_ptr<BlockCache> block_cache) {
   auto sst = std::make_shared<SST>();
@@ -42,44 +127,108 @@ std::shared_ptr<SST> SST::CreateSSTWithMetaOnly(size_t sst_id, size_t file_size,
   sst->last_key_ = last_key;
   sst->block_cache_ = std::move(block_cache);
 
+  sst->num_blocks_ = 0;
+  sst->index_partition_size_ = 0;
   sst->meta_offset_ = 0;
+  sst->filter_offset_ = 0;
   return sst;
 }
 
-std::shared_ptr<Block> SST::ReadBlock(size_t block_idx) {
-  if (block_idx >= meta_.size()) {
+std::shared_ptr<Block> SST::ReadBlock(size_t block_idx, const ReadOptions &options) {
+  if (block_idx >= num_blocks_) {
     throw std::out_of_range("Invalid block index");
   }
 
-  if (block_cache_ != nullptr) {
-    auto block = block_cache_->Get(sst_id_, block_idx);
+  auto block = GetCachedBlock(block_idx);
+  if (block != nullptr) {
+    return block;
+  }
+  auto secondary_cache = block_cache_->GetSecondaryCache();
+  if (secondary_cache != nullptr) {
+    block = secondary_cache->Lookup(sst_id_, block_idx);
     if (block != nullptr) {
+      block_cache_->Put(sst_id_, block_idx, block,
+                        options.fill_cache ? CachePriority::kNormal : CachePriority::kLow);
       return block;
     }
-  } else {
-    throw std::runtime_error("Block cache not set");
   }
 
-  auto &meta = meta_[block_idx];
   size_t block_size;
-  if (block_idx == meta_.size() - 1) {
-    block_size = meta_offset_ - meta.offset_;
-  } else {
-    block_size = meta_[block_idx + 1].offset_ - meta.offset_;
-  }
+  auto meta = ReadIndexEntry(block_idx, &block_size, options);
 
   auto block_data = file_.Read(meta.offset_, block_size);
-  auto res = Block::Decode(block_data, true);
+  return LoadBlock(block_idx, block_data, options);
+}
+
+std::shared_ptr<Block> SST::GetCachedBlock(size_t block_idx) {
+  if (block_cache_ == nullptr) {
+    throw std::runtime_error("Block cache not set");
+  }
+  return block_cache_->Get(sst_id_, block_idx);
+}
+
+void SST::GetBlockHandle(size_t block_idx, size_t *offset, size_t *size, const ReadOptions &options) {
+  if (block_idx >= num_blocks_) {
+    throw std::out_of_range("Invalid block index");
+  }
+  *offset = ReadIndexEntry(block_idx, size, options).offset_;
+}
 
-  block_cache_->Put(sst_id_, block_idx, res);
+std::shared_ptr<Block> SST::LoadBlock(size_t block_idx, const std::vector<uint8_t> &block_data,
+                                      const ReadOptions &options) {
+  auto res = Block::Decode(block_data, true, options.verify_checksums);
+  // the cached blocks are served without verification, so an unverified one is not cached
+  if (options.verify_checksums) {
+    block_cache_->Put(sst_id_, block_idx, res, options.fill_cache ? CachePriority::kNormal : CachePriority::kLow);
+  }
   return res;
 }
 
-size_t SST::FindBlockIndex(const std::string &key) {
-  if (key < first_key_ || key > last_key_) {
-    throw std::out_of_range("Key out of range");
+size_t SST::ReadAhead(size_t first_idx, size_t max_bytes, const ReadOptions &options) {
+  if (first_idx >= num_blocks_) {
+    throw std::out_of_range("Invalid block index");
+  }
+  // blocks are stored one after another, so adjacent blocks are read at once
+  std::vector<std::pair<size_t, size_t>> handles;  // offset and size of each block
+  size_t total = 0;
+  for (size_t idx = first_idx; idx < num_blocks_ && (handles.empty() || total < max_bytes); idx++) {
+    size_t offset;
+    size_t size;
+    GetBlockHandle(idx, &offset, &size, options);
+    handles.emplace_back(offset, size);
+    total += size;
+  }
+
+  // the prefetched blocks are verified even when the reader does not ask for it, an unverified block would not be
+  // cached and read again. One failing the check is left to the reader, which decodes it the way it asked for
+  ReadOptions verify_options = options;
+  verify_options.verify_checksums = true;
+  size_t begin = handles.front().first;
+  auto data = file_.Read(begin, handles.back().first + handles.back().second - begin);
+  for (size_t i = 0; i < handles.size(); i++) {
+    if (GetCachedBlock(first_idx + i) != nullptr) {
+      continue;
+    }
+    auto block_begin = data.begin() + (handles[i].first - begin);
+    try {
+      LoadBlock(first_idx + i, std::vector<uint8_t>(block_begin, block_begin + handles[i].second), verify_options);
+    } catch (const std::runtime_error &) {
+      if (options.verify_checksums) {
+        throw;
+      }
+    }
   }
+  return handles.size();
+}
+
+size_t SST::MetaEntrySize(size_t idx) const {
+  if (idx == meta_.size() - 1) {
+    return filter_offset_ - meta_[idx].offset_;
+  }
+  return meta_[idx + 1].offset_ - meta_[idx].offset_;
+}
 
+size_t SST::FindMetaIndex(const std::string &key) const {
   int left = -1;
   int right = meta_.size();
   while (left + 1 != right) {
@@ -93,7 +242,72 @@ size_t SST::FindBlockIndex(const std::string &key) {
   return right;
 }
 
-size_t SST::NumBlocks() const { return meta_.size(); }
+std::shared_ptr<Block> SST::ReadIndexPartition(size_t partition_idx, const ReadOptions &options) {
+  if (block_cache_ == nullptr) {
+    throw std::runtime_error("Block cache not set");
+  }
+  // partitions share the block cache with the data blocks, negative ids keep them apart
+  int cache_id = -static_cast<int>(partition_idx) - 1;
+  auto partition = block_cache_->Get(sst_id_, cache_id);
+  if (partition != nullptr) {
+    if (pin_index_) {
+      // it may have been cached before the SST was opened with pinning, pinning it again is a no-op
+      block_cache_->Put(sst_id_, cache_id, partition, CachePriority::kHigh, true);
+    }
+    return partition;
+  }
+  auto secondary_cache = block_cache_->GetSecondaryCache();
+  if (secondary_cache != nullptr) {
+    partition = secondary_cache->Lookup(sst_id_, cache_id);
+    if (partition != nullptr) {
+      block_cache_->Put(sst_id_, cache_id, partition, CachePriority::kHigh, pin_index_);
+      return partition;
+    }
+  }
+
+  auto partition_data = file_.Read(meta_[partition_idx].offset_, MetaEntrySize(partition_idx));
+  partition = Block::Decode(partition_data, true, options.verify_checksums);
+  if (options.verify_checksums) {
+    block_cache_->Put(sst_id_, cache_id, partition, CachePriority::kHigh, pin_index_);
+  }
+  return partition;
+}
+
+BlockMeta SST::ReadIndexEntry(size_t block_idx, size_t *block_size, const ReadOptions &options) {
+  if (index_partition_size_ == 0) {
+    *block_size = MetaEntrySize(block_idx);
+    return meta_[block_idx];
+  }
+  auto partition = ReadIndexPartition(block_idx / index_partition_size_, options);
+  auto [last_key, value] = *BlockIterator(partition, block_idx % index_partition_size_);
+  return DecodeIndexEntry(last_key, value, block_size);
+}
+
+size_t SST::FindBlockIndex(const std::string &key, const ReadOptions &options) {
+  if (key < first_key_ || key > last_key_) {
+    throw std::out_of_range("Key out of range");
+  }
+
+  size_t meta_idx = FindMetaIndex(key);
+  if (index_partition_size_ == 0) {
+    return meta_idx;
+  }
+  // the key is not greater than the last key of the partition, so the entry is in this partition
+  auto partition = ReadIndexPartition(meta_idx, options);
+  return meta_idx * index_partition_size_ + partition->LowerBoundIdx(key);
+}
+
+BlockMeta SST::GetBlockMeta(size_t block_idx) {
+  if (block_idx >= num_blocks_) {
+    throw std::out_of_range("Invalid block index");
+  }
+  size_t block_size;
+  return ReadIndexEntry(block_idx, &block_size, ReadOptions());
+}
+
+size_t SST::NumBlocks() const { return num_blocks_; }
+
+size_t SST::NumIndexPartitions() const { return index_partition_size_ == 0 ? 0 : meta_.size(); }
 
 std::string SST::GetFirstKey() const { return first_key_; }
 
@@ -101,34 +315,74 @@ std::string SST::GetLastKey() const { return last_key_; }
 
 size_t SST::GetSSTSize() const { return file_.Size(); }
 
+size_t SST::GetMemoryUsage() const {
+  size_t bytes = sizeof(SST) + bloom_filter_.capacity() + meta_.capacity() * sizeof(BlockMeta);
+  for (const auto &meta : meta_) {
+    bytes += GetAllocatedSize(meta.first_key_) + GetAllocatedSize(meta.last_key_);
+  }
+  return bytes + GetAllocatedSize(first_key_) + GetAllocatedSize(last_key_) + GetAllocatedSize(prefix_extractor_name_);
+}
+
 size_t SST::GetSSTId() const { return sst_id_; }
 
-SSTIterator SST::Get(const std::string &key) {
+bool SST::KeyMayMatch(const std::string &key) const {
   if (key < first_key_ || key > last_key_) {
+    return false;
+  }
+  return BloomFilter::MayContain(bloom_filter_, BloomFilter::Hash(key));
+}
+
+bool SST::PrefixMayMatch(const std::string &prefix, const PrefixExtractor *extractor) const {
+  // the keys with the prefix are in [prefix, last_key_]
+  if (last_key_ < prefix || (first_key_ > prefix && first_key_.compare(0, prefix.size(), prefix) != 0)) {
+    return false;
+  }
+  // every key with the prefix has the same extracted prefix only if the prefix itself is in the domain
+  if (extractor == nullptr || extractor->Name() != prefix_extractor_name_ || !extractor->InDomain(prefix)) {
+    return true;
+  }
+  return BloomFilter::MayContain(bloom_filter_, BloomFilter::Hash(extractor->Transform(prefix)));
+}
+
+SSTIterator SST::Get(const std::string &key, const ReadOptions &options) {
+  if (!KeyMayMatch(key)) {
     return this->End();
   }
 
-  return SSTIterator(this->shared_from_this(), key);
+  SSTIterator res(this->shared_from_this(), key, options);
+  if (!res.IsValid() || res.GetKey() != key) {
+    return this->End();
+  }
+  return res;
 }
 
 SSTIterator SST::Begin() { return SSTIterator(this->shared_from_this()); }
 
 SSTIterator SST::End() {
-  SSTIterator res(this->shared_from_this());
-  res.block_idx_ = meta_.size();
+  SSTIterator res(nullptr);
+  res.sst_ = this->shared_from_this();
+  res.block_idx_ = num_blocks_;
   res.block_iter_ = nullptr;
   return res;
 }
 
-SSTBuilder::SSTBuilder(size_t block_size) : block_(block_size) {}
+SSTBuilder::SSTBuilder(size_t block_size, std::shared_ptr<const PrefixExtractor> prefix_extractor)
+    : block_(block_size), block_size_(block_size), prefix_extractor_(std::move(prefix_extractor)) {}
 
 void SSTBuilder::Add(const std::string &key, const std::string &value) {
   if (first_key_.empty()) {
     first_key_ = key;
   }
 
-  uint32_t key_hash = std::hash<std::string>{}(key);
-  key_hashes_.push_back(key_hash);
+  key_hashes_.push_back(BloomFilter::Hash(key));
+  if (prefix_extractor_ != nullptr && prefix_extractor_->InDomain(key)) {
+    auto prefix = prefix_extractor_->Transform(key);
+    // the keys are sorted, so the same prefix repeats only with the adjacent keys
+    if (!last_prefix_.has_value() || last_prefix_.value() != prefix) {
+      key_hashes_.push_back(BloomFilter::Hash(prefix));
+      last_prefix_ = std::move(prefix);
+    }
+  }
 
   if (block_.AddEntry(key, value)) {
     last_key_ = key;
@@ -149,11 +403,7 @@ void SSTBuilder::FinishBlock() {
   auto encoded = old_block.Encode();
 
   meta_.emplace_back(data_.size(), first_key_, last_key_);
-
-  uint32_t hash =
-      std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(encoded.data()), encoded.size()));
-  data_.insert(data_.end(), encoded.begin(), encoded.end());
-  data_.insert(data_.end(), reinterpret_cast<uint8_t *>(&hash), reinterpret_cast<uint8_t *>(&hash) + sizeof(uint32_t));
+  AppendBlock(encoded, &data_);
 }
 
 std::shared_ptr<SST> SSTBuilder::Build(size_t sst_id, const std::string &path,
@@ -166,20 +416,69 @@ std::shared_ptr<SST> SSTBuilder::Build(size_t sst_id, const std::string &path,
     throw std::runtime_error("No data to build SST");
   }
 
+  // encode index partitions
+  uint32_t num_blocks = meta_.size();
+  std::optional<std::vector<BlockMeta>> top_level_index;
+  if (index_partition_size_ > 0 && meta_.size() > index_partition_size_) {
+    top_level_index = BuildIndexPartitions(&data_);
+  }
+  uint32_t index_partition_size = top_level_index.has_value() ? index_partition_size_ : 0;
+  if (top_level_index.has_value()) {
+    meta_ = std::move(top_level_index.value());
+  }
+
+  // encode filter
+  std::string extractor_name = prefix_extractor_ == nullptr ? "" : prefix_extractor_->Name();
+  auto bloom_filter = BloomFilter::Build(key_hashes_, BLOOM_FILTER_BITS_PER_KEY);
+  uint32_t filter_offset = data_.size();
+  uint16_t name_len = extractor_name.size();
+  data_.insert(data_.end(), reinterpret_cast<uint8_t *>(&name_len),
+               reinterpret_cast<uint8_t *>(&name_len) + sizeof(uint16_t));
+  data_.insert(data_.end(), extractor_name.begin(), extractor_name.end());
+  data_.insert(data_.end(), bloom_filter.begin(), bloom_filter.end());
+
   // encode meta
   std::vector<uint8_t> meta_data;
   BlockMeta::EncodeMeta(meta_, &meta_data);
 
   uint32_t meta_offset = data_.size();
   data_.insert(data_.end(), meta_data.begin(), meta_data.end());
-  data_.insert(data_.end(), reinterpret_cast<uint8_t *>(&meta_offset),
-               reinterpret_cast<uint8_t *>(&meta_offset) + sizeof(uint32_t));
+  uint32_t extra[6] = {filter_offset, num_blocks,           index_partition_size,
+                       meta_offset,   CHECKSUM_TYPE_CRC32C, SST_FORMAT_VERSION};
+  data_.insert(data_.end(), reinterpret_cast<uint8_t *>(extra), reinterpret_cast<uint8_t *>(extra) + EXTRA_SIZE);
 
-  FileObj file = FileObj::CreateAndWrite(path, data_);
+  FileObj file = FileObj::CreateAndWrite(path, data_, direct_io_);
   auto res = SST::CreateSSTWithMetaOnly(sst_id, file.Size(), meta_.front().first_key_, meta_.back().last_key_,
                                         std::move(block_cache));
   res->file_ = std::move(file);
+  res->num_blocks_ = num_blocks;
+  res->index_partition_size_ = index_partition_size;
   res->meta_offset_ = meta_offset;
+  res->filter_offset_ = filter_offset;
+  res->bloom_filter_ = std::move(bloom_filter);
+  res->prefix_extractor_name_ = std::move(extractor_name);
   res->meta_ = std::move(meta_);
   return res;
-}
\ No newline at end of file
+}
+std::optional<std::vector<BlockMeta>> SSTBuilder::BuildIndexPartitions(std::vector<uint8_t> *data) const {
+  std::vector<uint8_t> partitions_data;
+  std::vector<BlockMeta> top_level_index;
+  size_t partitions_offset = data->size();
+  for (size_t begin = 0; begin < meta_.size(); begin += index_partition_size_) {
+    size_t end = std::min(begin + index_partition_size_, meta_.size());
+    // the offsets of a block are 16 bits, a partition must be smaller than 64KB
+    Block partition(std::numeric_limits<uint16_t>::max());
+    for (size_t i = begin; i < end; i++) {
+      size_t block_end = i + 1 < meta_.size() ? meta_[i + 1].offset_ : partitions_offset;
+      if (!partition.AddEntry(meta_[i].last_key_, EncodeIndexEntry(meta_[i], block_end - meta_[i].offset_))) {
+        return std::nullopt;
+      }
+    }
+
+    top_level_index.emplace_back(partitions_offset + partitions_data.size(), meta_[begin].first_key_,
+                                 meta_[end - 1].last_key_);
+    AppendBlock(partition.Encode(), &partitions_data);
+  }
+  data->insert(data->end(), partitions_data.begin(), partitions_data.end());
+  return top_level_index;
+}
@@ -1,41 +1,154 @@
 #include <block/BlockIterator.h>
 #include <sst/SSTIterator.h>
+#include <algorithm>
 #include <utility>
 
-SSTIterator::SSTIterator(std::shared_ptr<SST> sst) : sst_(std::move(sst)), block_idx_(0), block_iter_(nullptr) {
+SSTIterator::SSTIterator(std::shared_ptr<SST> sst, const ReadOptions &options)
+    : sst_(std::move(sst)), block_idx_(0), block_iter_(nullptr), read_options_(options) {
+  ResetReadahead();
   if (sst_ != nullptr) {
-    SeekFirst();
+    SeekToFirst();
   }
 }
 
-SSTIterator::SSTIterator(std::shared_ptr<SST> sst, const std::string &key)
-    : sst_(std::move(sst)), block_idx_(0), block_iter_(nullptr) {
+SSTIterator::SSTIterator(std::shared_ptr<SST> sst, const std::string &key, const ReadOptions &options)
+    : sst_(std::move(sst)), block_idx_(0), block_iter_(nullptr), read_options_(options) {
+  ResetReadahead();
   if (sst_ != nullptr) {
     Seek(key);
   }
 }
 
-void SSTIterator::SeekFirst() {
+SSTIterator::SSTIterator(const SSTIterator &other)
+    : BaseIterator(),
+      sst_(other.sst_),
+      block_idx_(other.block_idx_),
+      block_iter_(nullptr),
+      read_options_(other.read_options_),
+      sequential_blocks_(other.sequential_blocks_),
+      readahead_end_(other.readahead_end_),
+      readahead_size_(other.readahead_size_) {
+  if (other.block_iter_ != nullptr) {
+    block_iter_ = std::make_shared<BlockIterator>(*other.block_iter_);
+  }
+}
+
+SSTIterator &SSTIterator::operator=(const SSTIterator &other) {
+  if (this != &other) {
+    sst_ = other.sst_;
+    block_idx_ = other.block_idx_;
+    read_options_ = other.read_options_;
+    sequential_blocks_ = other.sequential_blocks_;
+    readahead_end_ = other.readahead_end_;
+    readahead_size_ = other.readahead_size_;
+    block_iter_ = other.block_iter_ == nullptr ? nullptr : std::make_shared<BlockIterator>(*other.block_iter_);
+  }
+  return *this;
+}
+
+void SSTIterator::ResetReadahead() {
+  sequential_blocks_ = 0;
+  readahead_end_ = 0;
+  readahead_size_ = SST_INITIAL_READAHEAD_SIZE;
+}
+
+std::shared_ptr<Block> SSTIterator::ReadNextBlock() {
+  sequential_blocks_++;
+  // a single block after a seek is not a scan yet
+  if (read_options_.max_readahead_size > 0 && sequential_blocks_ >= 2 && block_idx_ >= readahead_end_ &&
+      sst_->GetCachedBlock(block_idx_) == nullptr) {
+    size_t window = std::min(readahead_size_, read_options_.max_readahead_size);
+    readahead_end_ = block_idx_ + sst_->ReadAhead(block_idx_, window, read_options_);
+    readahead_size_ = std::min(window * 2, read_options_.max_readahead_size);
+  }
+  return sst_->ReadBlock(block_idx_, read_options_);
+}
+
+void SSTIterator::SeekToFirst() {
+  ResetReadahead();
   if (!sst_ || sst_->NumBlocks() == 0) {
     block_iter_ = nullptr;
     return;
   }
 
   block_idx_ = 0;
-  auto block = sst_->ReadBlock(block_idx_);
+  auto block = sst_->ReadBlock(block_idx_, read_options_);
   block_iter_ = std::make_shared<BlockIterator>(block);
 }
 
+void SSTIterator::SeekToLast() {
+  ResetReadahead();
+  if (!sst_ || sst_->NumBlocks() == 0) {
+    block_iter_ = nullptr;
+    return;
+  }
+
+  block_idx_ = sst_->NumBlocks() - 1;
+  auto block = sst_->ReadBlock(block_idx_, read_options_);
+  block_iter_ = std::make_shared<BlockIterator>(block, block->NumEntries() - 1);
+}
+
+void SSTIterator::SeekToEntry(size_t block_idx, size_t idx) {
+  block_idx_ = block_idx;
+  auto block = sst_->ReadBlock(block_idx_, read_options_);
+  block_iter_ = std::make_shared<BlockIterator>(block, idx);
+}
+
+void SSTIterator::Invalidate() {
+  block_idx_ = sst_->NumBlocks();
+  block_iter_ = nullptr;
+}
+
 void SSTIterator::Seek(const std::string &key) {
+  ResetReadahead();
+  if (!sst_ || sst_->NumBlocks() == 0) {
+    block_iter_ = nullptr;
+    return;
+  }
+
+  if (key <= sst_->GetFirstKey()) {
+    SeekToFirst();
+    return;
+  }
+  if (key > sst_->GetLastKey()) {
+    Invalidate();
+    return;
+  }
+
+  // the first block whose last key is not less than key always contains the target
+  block_idx_ = sst_->FindBlockIndex(key, read_options_);
+  auto block = sst_->ReadBlock(block_idx_, read_options_);
+  block_iter_ = std::make_shared<BlockIterator>(block, block->LowerBoundIdx(key));
+}
+
+void SSTIterator::SeekForPrev(const std::string &key) {
+  ResetReadahead();
   if (!sst_ || sst_->NumBlocks() == 0) {
     block_iter_ = nullptr;
     return;
   }
 
-  block_idx_ = sst_->FindBlockIndex(key);
-  auto block = sst_->ReadBlock(block_idx_);
+  if (key >= sst_->GetLastKey()) {
+    SeekToLast();
+    return;
+  }
+  if (key < sst_->GetFirstKey()) {
+    Invalidate();
+    return;
+  }
 
-  block_iter_ = std::make_shared<BlockIterator>(block, key);
+  auto block_idx = sst_->FindBlockIndex(key, read_options_);
+  auto block = sst_->ReadBlock(block_idx, read_options_);
+  auto idx = block->LowerBoundIdx(key);
+  if (idx < block->NumEntries() && BlockIterator(block, idx)->first == key) {
+    SeekToEntry(block_idx, idx);
+  } else if (idx > 0) {
+    SeekToEntry(block_idx, idx - 1);
+  } else {
+    // key is between the last key of the previous block and the first key of this block
+    auto prev_block = sst_->ReadBlock(block_idx - 1, read_options_);
+    SeekToEntry(block_idx - 1, prev_block->NumEntries() - 1);
+  }
 }
 
 bool SSTIterator::IsEnd() { return block_iter_ == nullptr; }
@@ -44,42 +157,80 @@ bool SSTIterator::IsValid() const {
   return block_iter_ != nullptr && !block_iter_->IsEnd() && block_idx_ < sst_->NumBlocks();
 }
 
-std::string SSTIterator::GetKey() {
+std::string SSTIterator::GetKey() const {
   if (block_iter_ == nullptr) {
     throw std::runtime_error("SSTIterator: Invalid iterator dereference");
   }
   return (**block_iter_).first;
 }
 
-std::string SSTIterator::GetValue() {
+std::string SSTIterator::GetValue() const {
   if (block_iter_ == nullptr) {
     throw std::runtime_error("SSTIterator: Invalid iterator dereference");
   }
   return (**block_iter_).second;
 }
 
+std::optional<size_t> SSTIterator::NextBlockToRead() const {
+  if (block_iter_ == nullptr || block_idx_ + 1 >= sst_->NumBlocks()) {
+    return std::nullopt;
+  }
+  if (sst_->GetCachedBlock(block_idx_ + 1) != nullptr) {
+    return std::nullopt;
+  }
+  return block_idx_ + 1;
+}
+
+bool SSTIterator::AtBlockEnd() const { return block_iter_ != nullptr && block_iter_->IsLast(); }
+
 void SSTIterator::SetBlockIdx(size_t block_idx) { block_idx_ = block_idx; }
 
 void SSTIterator::SetBlockIter(std::shared_ptr<BlockIterator> block_iter) { block_iter_ = std::move(block_iter); }
 
+std::unique_ptr<BaseIterator> SSTIterator::Clone() const { return std::make_unique<SSTIterator>(*this); }
+
 SSTIterator &SSTIterator::operator++() {
+  Next();
+  return *this;
+}
+
+void SSTIterator::Next() {
   if (block_iter_ == nullptr) {
-    return *this;
+    return;
   }
 
   ++(*block_iter_);
   if (block_iter_->IsEnd()) {
     block_idx_++;
     if (block_idx_ < sst_->NumBlocks()) {
-      auto next_block = sst_->ReadBlock(block_idx_);
-      block_iter_ = std::make_shared<BlockIterator>(next_block);
+      block_iter_ = std::make_shared<BlockIterator>(ReadNextBlock());
     } else {
       block_iter_ = nullptr;
     }
   }
+}
+
+SSTIterator &SSTIterator::operator--() {
+  Prev();
   return *this;
 }
 
+void SSTIterator::Prev() {
+  if (block_iter_ == nullptr) {
+    return;
+  }
+
+  --(*block_iter_);
+  if (block_iter_->IsEnd()) {
+    if (block_idx_ == 0) {
+      Invalidate();
+      return;
+    }
+    auto prev_block = sst_->ReadBlock(block_idx_ - 1, read_options_);
+    SeekToEntry(block_idx_ - 1, prev_block->NumEntries() - 1);
+  }
+}
+
 bool SSTIterator::operator==(const SSTIterator &other) const {
   if (!this->IsValid() && !other.IsValid()) {
     return true;
@@ -106,12 +257,17 @@ std::optional<std::pair<SSTIterator, SSTIterator>> SSTItersMonotonyPredicate(
     const std::shared_ptr<SST> &sst, const std::function<int(const std::string &)> &predicate) {
   std::optional<SSTIterator> final_begin = std::nullopt;
   std::optional<SSTIterator> final_end = std::nullopt;
-  for (size_t block_idx = 0; block_idx < sst->meta_.size(); block_idx++) {
-    auto block = sst->ReadBlock(block_idx);
-    BlockMeta &meta = sst->meta_[block_idx];
-    if (predicate(meta.first_key_) < 0 || predicate(meta.last_key_) > 0) {
+  for (size_t block_idx = 0; block_idx < sst->NumBlocks(); block_idx++) {
+    BlockMeta meta = sst->GetBlockMeta(block_idx);
+    if (predicate(meta.last_key_) > 0) {
+      // the whole block is on the left of the range
+      continue;
+    }
+    if (predicate(meta.first_key_) < 0) {
+      // the whole block is on the right of the range
       break;
     }
+    auto block = sst->ReadBlock(block_idx);
 
     auto result = block->GetMonotonyPredicateIters(predicate);
     if (result.has_value()) {
@@ -0,0 +1,107 @@
+#include <sst/TableCache.h>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+TableCache::TableCache(std::string data_dir, size_t capacity, std::shared_ptr<BlockCache> block_cache,
+                       bool direct_io, bool pin_index_blocks)
+    : data_dir_(std::move(data_dir)),
+      capacity_(capacity),
+      block_cache_(std::move(block_cache)),
+      direct_io_(direct_io),
+      pin_index_blocks_(pin_index_blocks),
+      total_requests_(0),
+      hit_requests_(0),
+      memory_usage_(0) {
+  if (capacity_ == 0) {
+    throw std::invalid_argument("TableCache capacity should be positive");
+  }
+}
+
+std::shared_ptr<SST> TableCache::FindTable(size_t sst_id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++total_requests_;
+    auto it = table_map_.find(sst_id);
+    if (it != table_map_.end()) {
+      ++hit_requests_;
+      lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+      return *it->second;
+    }
+  }
+
+  // open the file without holding the lock, other tables can still be served meanwhile
+  auto sst = SST::Open(sst_id, FileObj::Open(GetSSTPath(sst_id), direct_io_), block_cache_);
+  sst->SetPinIndex(pin_index_blocks_);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = table_map_.find(sst_id);
+  if (it != table_map_.end()) {
+    // another thread opened it first, use that one and drop ours
+    lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+    return *it->second;
+  }
+  InternalInsert(sst);
+  return sst;
+}
+
+void TableCache::Insert(const std::shared_ptr<SST> &sst) {
+  sst->SetPinIndex(pin_index_blocks_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = table_map_.find(sst->GetSSTId());
+  if (it != table_map_.end()) {
+    memory_usage_ -= (*it->second)->GetMemoryUsage();
+    lru_list_.erase(it->second);
+    table_map_.erase(it);
+  }
+  InternalInsert(sst);
+}
+
+void TableCache::Erase(size_t sst_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = table_map_.find(sst_id);
+  if (it == table_map_.end()) {
+    return;
+  }
+  memory_usage_ -= (*it->second)->GetMemoryUsage();
+  lru_list_.erase(it->second);
+  table_map_.erase(it);
+}
+
+void TableCache::InternalInsert(const std::shared_ptr<SST> &sst) {
+  lru_list_.push_front(sst);
+  memory_usage_ += sst->GetMemoryUsage();
+  table_map_[sst->GetSSTId()] = lru_list_.begin();
+  while (table_map_.size() > capacity_) {
+    Evict();
+  }
+}
+
+void TableCache::Evict() {
+  // dropping the last reference closes the file and releases the meta
+  auto &victim = lru_list_.back();
+  memory_usage_ -= victim->GetMemoryUsage();
+  table_map_.erase(victim->GetSSTId());
+  lru_list_.pop_back();
+}
+
+std::string TableCache::GetSSTPath(size_t sst_id) const {
+  std::stringstream ss;
+  ss << data_dir_ << "/sst_" << std::setfill('0') << std::setw(4) << sst_id;
+  return ss.str();
+}
+
+size_t TableCache::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return table_map_.size();
+}
+
+size_t TableCache::GetMemoryUsage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return memory_usage_;
+}
+
+double TableCache::GetHitRate() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return total_requests_ == 0 ? 0 : static_cast<double>(hit_requests_) / total_requests_;
+}
@@ -0,0 +1,85 @@
+#include <utils/AlignedBufferPool.h>
+#include <utils/Macro.h>
+#include <cstdlib>
+#include <new>
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer &&other) noexcept
+    : pool_(other.pool_), data_(other.data_), capacity_(other.capacity_) {
+  other.data_ = nullptr;
+  other.capacity_ = 0;
+}
+
+AlignedBuffer &AlignedBuffer::operator=(AlignedBuffer &&other) noexcept {
+  if (this != &other) {
+    if (data_ != nullptr) {
+      pool_->Release(data_, capacity_);
+    }
+    pool_ = other.pool_;
+    data_ = other.data_;
+    capacity_ = other.capacity_;
+    other.data_ = nullptr;
+    other.capacity_ = 0;
+  }
+  return *this;
+}
+
+AlignedBuffer::~AlignedBuffer() {
+  if (data_ != nullptr) {
+    pool_->Release(data_, capacity_);
+  }
+}
+
+AlignedBufferPool::AlignedBufferPool(size_t alignment, size_t max_cached_bytes)
+    : alignment_(alignment), max_cached_bytes_(max_cached_bytes), cached_bytes_(0) {}
+
+AlignedBufferPool::~AlignedBufferPool() {
+  for (auto &[capacity, data] : free_buffers_) {
+    std::free(data);  // NOLINT
+  }
+}
+
+AlignedBufferPool &AlignedBufferPool::Default() {
+  static AlignedBufferPool pool(DIRECT_IO_ALIGNMENT, DIRECT_IO_BUFFER_POOL_SIZE);
+  return pool;
+}
+
+AlignedBuffer AlignedBufferPool::Acquire(size_t size) {
+  size_t capacity = (size + alignment_ - 1) / alignment_ * alignment_;
+  if (capacity == 0) {
+    capacity = alignment_;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // reuse the smallest free buffer which is large enough, but not more than twice as large
+    auto it = free_buffers_.lower_bound(capacity);
+    if (it != free_buffers_.end() && it->first <= 2 * capacity) {
+      AlignedBuffer buffer(this, it->second, it->first);
+      cached_bytes_ -= it->first;
+      free_buffers_.erase(it);
+      return buffer;
+    }
+  }
+
+  void *data = std::aligned_alloc(alignment_, capacity);  // NOLINT
+  if (data == nullptr) {
+    throw std::bad_alloc();
+  }
+  return {this, static_cast<uint8_t *>(data), capacity};
+}
+
+void AlignedBufferPool::Release(uint8_t *data, size_t capacity) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cached_bytes_ + capacity <= max_cached_bytes_) {
+      free_buffers_.emplace(capacity, data);
+      cached_bytes_ += capacity;
+      return;
+    }
+  }
+  std::free(data);  // NOLINT
+}
+
+size_t AlignedBufferPool::GetCachedBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cached_bytes_;
+}
@@ -0,0 +1,41 @@
+#include <utils/CompactionFilter.h>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+CompactionFilter::Decision TTLCompactionFilter::Filter(const std::string & /*key*/, const std::string &value,
+                                                       std::string * /*new_value*/) const {
+  return IsExpired(value, Now()) ? Decision::kRemove : Decision::kKeep;
+}
+
+bool TTLCompactionFilter::IsExpired(const std::string &value, uint64_t now) const {
+  // an entry lives for the whole ttl_ seconds, whatever the fraction of the second it was written at
+  return now > GetWriteTime(value) + ttl_;
+}
+
+uint64_t TTLCompactionFilter::Now() {
+  auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::seconds>(since_epoch).count();
+}
+
+std::string TTLCompactionFilter::AppendWriteTime(const std::string &value, uint64_t write_time) {
+  std::string res = value;
+  res.append(reinterpret_cast<const char *>(&write_time), sizeof(uint64_t));
+  return res;
+}
+
+uint64_t TTLCompactionFilter::GetWriteTime(const std::string &value) {
+  if (value.size() < sizeof(uint64_t)) {
+    throw std::runtime_error("Value has no write time");
+  }
+  uint64_t write_time;
+  memcpy(&write_time, value.data() + value.size() - sizeof(uint64_t), sizeof(uint64_t));
+  return write_time;
+}
+
+std::string TTLCompactionFilter::StripWriteTime(const std::string &value) {
+  if (value.size() < sizeof(uint64_t)) {
+    throw std::runtime_error("Value has no write time");
+  }
+  return value.substr(0, value.size() - sizeof(uint64_t));
+}
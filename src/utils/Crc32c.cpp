@@ -0,0 +1,106 @@
+#include <utils/Crc32c.h>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_HAS_SSE42_PATH 1
+#endif
+
+namespace {
+constexpr uint32_t CRC32C_POLY = 0x82f63b78;  // reversed Castagnoli polynomial
+
+// table[i][b] is the crc of byte b followed by i zero bytes, for slicing-by-8
+constexpr std::array<std::array<uint32_t, 256>, 8> MakeTables() {
+  std::array<std::array<uint32_t, 256>, 8> tables{};
+  for (uint32_t b = 0; b < 256; b++) {
+    uint32_t crc = b;
+    for (int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLY : 0);
+    }
+    tables[0][b] = crc;
+  }
+  for (uint32_t b = 0; b < 256; b++) {
+    for (size_t i = 1; i < 8; i++) {
+      tables[i][b] = (tables[i - 1][b] >> 8) ^ tables[0][tables[i - 1][b] & 0xff];
+    }
+  }
+  return tables;
+}
+
+constexpr auto TABLES = MakeTables();
+
+// the 8 bytes at data as a little-endian word, the order both the tables and the crc32 instruction expect
+uint64_t LoadWord(const uint8_t *data) {
+  uint64_t word;
+  memcpy(&word, data, sizeof(uint64_t));
+  if constexpr (std::endian::native == std::endian::big) {
+    word = __builtin_bswap64(word);
+  }
+  return word;
+}
+
+uint32_t ExtendSoftware(uint32_t crc, const uint8_t *data, size_t n) {
+  while (n >= 8) {
+    uint64_t word = LoadWord(data) ^ crc;
+    crc = TABLES[7][word & 0xff] ^ TABLES[6][(word >> 8) & 0xff] ^ TABLES[5][(word >> 16) & 0xff] ^
+          TABLES[4][(word >> 24) & 0xff] ^ TABLES[3][(word >> 32) & 0xff] ^ TABLES[2][(word >> 40) & 0xff] ^
+          TABLES[1][(word >> 48) & 0xff] ^ TABLES[0][word >> 56];
+    data += 8;
+    n -= 8;
+  }
+  while (n > 0) {
+    crc = (crc >> 8) ^ TABLES[0][(crc ^ *data) & 0xff];
+    data++;
+    n--;
+  }
+  return crc;
+}
+
+#ifdef CRC32C_HAS_SSE42_PATH
+__attribute__((target("sse4.2"))) uint32_t ExtendHardware(uint32_t crc, const uint8_t *data, size_t n) {
+#if defined(__x86_64__)
+  uint64_t crc64 = crc;
+  while (n >= 8) {
+    crc64 = _mm_crc32_u64(crc64, LoadWord(data));
+    data += 8;
+    n -= 8;
+  }
+  crc = static_cast<uint32_t>(crc64);
+#endif
+  while (n > 0) {
+    crc = _mm_crc32_u8(crc, *data);
+    data++;
+    n--;
+  }
+  return crc;
+}
+
+bool DetectSSE42() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2");
+}
+#else
+bool DetectSSE42() { return false; }
+#endif
+
+bool UseHardware() {
+  static const bool use_hardware = DetectSSE42();
+  return use_hardware;
+}
+}  // namespace
+
+uint32_t Crc32c::Extend(uint32_t crc, const uint8_t *data, size_t n) {
+  crc = ~crc;
+#ifdef CRC32C_HAS_SSE42_PATH
+  if (UseHardware()) {
+    return ~ExtendHardware(crc, data, n);
+  }
+#endif
+  return ~ExtendSoftware(crc, data, n);
+}
+
+uint32_t Crc32c::ExtendPortable(uint32_t crc, const uint8_t *data, size_t n) { return ~ExtendSoftware(~crc, data, n); }
+
+bool Crc32c::IsHardwareAccelerated() { return UseHardware(); }
@@ -0,0 +1,136 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils/AlignedBufferPool.h>
+#include <utils/File.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+DirectFileOperator::~DirectFileOperator() { Close(); }
+
+bool DirectFileOperator::Open(const std::string &filename, bool create) {
+  Close();
+  file_path_ = std::filesystem::path(filename);
+  int flags = O_RDWR | (create ? O_CREAT | O_TRUNC : 0);
+  fd_ = ::open(filename.c_str(), flags | O_DIRECT, 0644);
+  direct_ = fd_ >= 0;
+  if (fd_ < 0 && errno == EINVAL) {
+    // e.g. tmpfs does not support O_DIRECT
+    fd_ = ::open(filename.c_str(), flags, 0644);
+  }
+  return fd_ >= 0;
+}
+
+bool DirectFileOperator::Create(const std::string &filename, const std::vector<uint8_t> &data) {
+  if (!Open(filename, true)) {
+    throw std::runtime_error("Failed to open file");
+  }
+  return Write(0, data.data(), data.size());
+}
+
+void DirectFileOperator::Close() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+size_t DirectFileOperator::Size() {
+  struct stat st {};
+  if (::fstat(fd_, &st) != 0) {
+    throw std::runtime_error("Failed to stat file " + file_path_.string() + ": " + strerror(errno));
+  }
+  return static_cast<size_t>(st.st_size);
+}
+
+void DirectFileOperator::ReadAligned(size_t offset, size_t size, uint8_t *buffer) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = ::pread(fd_, buffer + done, size - done, static_cast<off_t>(offset + done));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Failed to read file " + file_path_.string() + ": " + strerror(errno));
+    }
+    if (n == 0) {
+      break;
+    }
+    done += n;
+  }
+  memset(buffer + done, 0, size - done);
+}
+
+std::vector<uint8_t> DirectFileOperator::Read(size_t offset, size_t size) {
+  auto &pool = AlignedBufferPool::Default();
+  size_t alignment = pool.GetAlignment();
+  size_t aligned_begin = offset / alignment * alignment;
+  size_t aligned_end = (offset + size + alignment - 1) / alignment * alignment;
+
+  auto buffer = pool.Acquire(aligned_end - aligned_begin);
+  ReadAligned(aligned_begin, aligned_end - aligned_begin, buffer.Data());
+  const uint8_t *begin = buffer.Data() + (offset - aligned_begin);
+  return {begin, begin + size};
+}
+
+bool DirectFileOperator::Write(size_t offset, const void *data, size_t size) {
+  if (size == 0) {
+    return true;
+  }
+  auto &pool = AlignedBufferPool::Default();
+  size_t alignment = pool.GetAlignment();
+  size_t old_size = Size();
+  size_t aligned_begin = offset / alignment * alignment;
+  size_t aligned_end = (offset + size + alignment - 1) / alignment * alignment;
+
+  auto buffer = pool.Acquire(aligned_end - aligned_begin);
+  // keep the existing bytes of the partially written sectors at both ends
+  if (aligned_begin < offset && aligned_begin < old_size) {
+    ReadAligned(aligned_begin, alignment, buffer.Data());
+  }
+  if (offset + size < aligned_end && aligned_end - alignment < old_size && aligned_end - alignment >= aligned_begin) {
+    ReadAligned(aligned_end - alignment, alignment, buffer.Data() + (aligned_end - alignment - aligned_begin));
+  }
+  memcpy(buffer.Data() + (offset - aligned_begin), data, size);
+
+  size_t done = 0;
+  size_t total = aligned_end - aligned_begin;
+  while (done < total) {
+    ssize_t n = ::pwrite(fd_, buffer.Data() + done, total - done, static_cast<off_t>(aligned_begin + done));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Failed to write file " + file_path_.string() + ": " + strerror(errno));
+    }
+    done += n;
+  }
+  // drop the padding of the last sector
+  size_t new_size = std::max(old_size, offset + size);
+  if (::ftruncate(fd_, static_cast<off_t>(new_size)) != 0) {
+    throw std::runtime_error("Failed to truncate file " + file_path_.string() + ": " + strerror(errno));
+  }
+  return Sync();
+}
+
+bool DirectFileOperator::Sync() {
+  if (fd_ < 0) {
+    return false;
+  }
+  return ::fdatasync(fd_) == 0;
+}
+
+void SyncPath(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open " + path + ": " + strerror(errno));
+  }
+  int res = ::fsync(fd);
+  int err = errno;
+  ::close(fd);
+  if (res != 0) {
+    throw std::runtime_error("Failed to sync " + path + ": " + strerror(err));
+  }
+}
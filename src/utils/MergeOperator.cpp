@@ -0,0 +1,31 @@
+#include <utils/MergeOperator.h>
+#include <cstring>
+
+std::string UInt64AddOperator::Merge(const std::string & /*key*/, const std::optional<std::string> &existing_value,
+                                     const std::string &operand) const {
+  uint64_t existing = existing_value.has_value() ? DecodeValue(existing_value.value()) : 0;
+  return EncodeValue(existing + DecodeValue(operand));
+}
+
+std::string UInt64AddOperator::EncodeValue(uint64_t value) {
+  std::string res(sizeof(uint64_t), '\0');
+  memcpy(res.data(), &value, sizeof(uint64_t));
+  return res;
+}
+
+uint64_t UInt64AddOperator::DecodeValue(const std::string &value) {
+  if (value.size() != sizeof(uint64_t)) {
+    return 0;
+  }
+  uint64_t res;
+  memcpy(&res, value.data(), sizeof(uint64_t));
+  return res;
+}
+
+std::string StringAppendOperator::Merge(const std::string & /*key*/, const std::optional<std::string> &existing_value,
+                                        const std::string &operand) const {
+  if (!existing_value.has_value()) {
+    return operand;
+  }
+  return existing_value.value() + delimiter_ + operand;
+}
@@ -0,0 +1,150 @@
+#include <utils/Options.h>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace {
+template <typename T>
+T ParseValue(const std::string &name, const std::string &value) {
+  try {
+    size_t pos = 0;
+    T res;
+    if constexpr (std::is_floating_point_v<T>) {
+      res = static_cast<T>(std::stod(value, &pos));
+      // NaN would pass every range check
+      if (!std::isfinite(res)) {
+        throw std::invalid_argument(value);
+      }
+    } else {
+      // stoull accepts a sign and wraps negative values around
+      if (value.empty() || value[0] < '0' || value[0] > '9') {
+        throw std::invalid_argument(value);
+      }
+      auto parsed = std::stoull(value, &pos);
+      if (parsed > std::numeric_limits<T>::max()) {
+        throw std::out_of_range(value);
+      }
+      res = static_cast<T>(parsed);
+    }
+    if (pos != value.size()) {
+      throw std::invalid_argument(value);
+    }
+    return res;
+  } catch (const std::logic_error &) {
+    throw std::invalid_argument("Invalid value of option " + name + ": " + value);
+  }
+}
+
+// parse the value right away, the returned function sets it
+template <typename T>
+std::function<void()> Assign(T *field, const std::string &name, const std::string &value) {
+  T parsed = ParseValue<T>(name, value);
+  return [field, parsed]() { *field = parsed; };
+}
+
+std::function<void()> ParseColumnFamilyOption(ColumnFamilyOptions *options, const std::string &name,
+                                              const std::string &value) {
+  if (name == "write_buffer_size") {
+    if (ParseValue<size_t>(name, value) == 0) {
+      throw std::invalid_argument("Option write_buffer_size should be positive");
+    }
+    return Assign(&options->write_buffer_size, name, value);
+  }
+  if (name == "frozen_memtables_slowdown_trigger") {
+    return Assign(&options->frozen_memtables_slowdown_trigger, name, value);
+  }
+  if (name == "frozen_memtables_stop_trigger") {
+    return Assign(&options->frozen_memtables_stop_trigger, name, value);
+  }
+  if (name == "level0_slowdown_writes_trigger") {
+    return Assign(&options->level0_slowdown_writes_trigger, name, value);
+  }
+  if (name == "level0_stop_writes_trigger") {
+    return Assign(&options->level0_stop_writes_trigger, name, value);
+  }
+  if (name == "soft_pending_bytes_limit") {
+    return Assign(&options->soft_pending_bytes_limit, name, value);
+  }
+  if (name == "hard_pending_bytes_limit") {
+    return Assign(&options->hard_pending_bytes_limit, name, value);
+  }
+  if (name == "level0_file_num_compaction_trigger") {
+    return Assign(&options->level0_file_num_compaction_trigger, name, value);
+  }
+  if (name == "universal.size_ratio") {
+    return Assign(&options->universal.size_ratio, name, value);
+  }
+  if (name == "universal.min_merge_width") {
+    return Assign(&options->universal.min_merge_width, name, value);
+  }
+  if (name == "universal.max_merge_width") {
+    return Assign(&options->universal.max_merge_width, name, value);
+  }
+  if (name == "universal.max_size_amplification_percent") {
+    return Assign(&options->universal.max_size_amplification_percent, name, value);
+  }
+  if (name == "fifo.max_table_files_size") {
+    return Assign(&options->fifo.max_table_files_size, name, value);
+  }
+  if (name == "fifo.ttl") {
+    return Assign(&options->fifo.ttl, name, value);
+  }
+  if (name == "min_blob_size") {
+    return Assign(&options->min_blob_size, name, value);
+  }
+  if (name == "blob_garbage_collection_age_cutoff") {
+    auto cutoff = ParseValue<double>(name, value);
+    if (cutoff < 0 || cutoff > 1) {
+      throw std::invalid_argument("Option blob_garbage_collection_age_cutoff should be in [0, 1]");
+    }
+    return Assign(&options->blob_garbage_collection_age_cutoff, name, value);
+  }
+  throw std::invalid_argument("Option " + name + " cannot be changed while the column family is open");
+}
+
+std::function<void()> ParseDBOption(Options *options, const std::string &name, const std::string &value) {
+  if (name == "db_write_buffer_size") {
+    return Assign(&options->db_write_buffer_size, name, value);
+  }
+  if (name == "memory_budget") {
+    return Assign(&options->memory_budget, name, value);
+  }
+  if (name == "block_cache_capacity") {
+    return Assign(&options->block_cache_capacity, name, value);
+  }
+  if (name == "row_cache_capacity") {
+    return Assign(&options->row_cache_capacity, name, value);
+  }
+  if (name == "delayed_write_rate") {
+    if (ParseValue<uint64_t>(name, value) == 0) {
+      throw std::invalid_argument("Option delayed_write_rate should be positive");
+    }
+    return Assign(&options->delayed_write_rate, name, value);
+  }
+  throw std::invalid_argument("Option " + name + " cannot be changed while the engine is open");
+}
+}  // namespace
+
+void SetColumnFamilyOptions(ColumnFamilyOptions *options, const std::unordered_map<std::string, std::string> &values) {
+  // every value is parsed before the first one is set
+  std::vector<std::function<void()>> setters;
+  for (const auto &[name, value] : values) {
+    setters.push_back(ParseColumnFamilyOption(options, name, value));
+  }
+  for (const auto &setter : setters) {
+    setter();
+  }
+}
+
+void SetDBOptions(Options *options, const std::unordered_map<std::string, std::string> &values) {
+  std::vector<std::function<void()>> setters;
+  for (const auto &[name, value] : values) {
+    setters.push_back(ParseDBOption(options, name, value));
+  }
+  for (const auto &setter : setters) {
+    setter();
+  }
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <sst/AsyncBlockReader.h>
+#include <utils/Macro.h>
+#include <atomic>
+#include <filesystem>
+#include <future>
+
+class AsyncBlockReaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!std::filesystem::exists(test_dir_)) {
+      std::filesystem::create_directory(test_dir_);
+    }
+  }
+
+  void TearDown() override { std::filesystem::remove_all(test_dir_); }
+
+  // 构建 SST 后用空的 block cache 重新打开, 保证 block 需要从文件读取
+  std::shared_ptr<SST> BuildSST(size_t sst_id, const std::shared_ptr<BlockCache> &block_cache, bool direct_io = false) {
+    SSTBuilder builder(512);
+    builder.SetDirectIO(direct_io);
+    for (int i = 0; i < 500; i++) {
+      builder.Add("key" + std::to_string(1000 + i), "value" + std::to_string(sst_id) + "_" + std::to_string(i));
+    }
+    std::string path = test_dir_ + "/sst_" + std::to_string(sst_id);
+    builder.Build(sst_id, path, std::make_shared<BlockCache>(16, 2));
+    return SST::Open(sst_id, FileObj::Open(path, direct_io), block_cache);
+  }
+
+  std::string test_dir_ = "test_async_reader_data";
+};
+
+// 比较两个 block 的编码
+void ExpectSameBlock(const std::shared_ptr<Block> &lhs, const std::shared_ptr<Block> &rhs) {
+  ASSERT_NE(lhs, nullptr);
+  ASSERT_NE(rhs, nullptr);
+  EXPECT_EQ(lhs->Encode(), rhs->Encode());
+}
+
+void CheckReadBlocks(AsyncBlockReader &reader, const std::vector<std::shared_ptr<SST>> &ssts,
+                     const std::vector<std::shared_ptr<SST>> &expected) {
+  std::vector<BlockReadRequest> requests;
+  for (const auto &sst : ssts) {
+    for (size_t i = 0; i < sst->NumBlocks(); i++) {
+      requests.push_back({sst, i});
+    }
+  }
+  auto blocks = reader.ReadBlocks(requests);
+  ASSERT_EQ(blocks.size(), requests.size());
+
+  size_t pos = 0;
+  for (size_t s = 0; s < ssts.size(); s++) {
+    for (size_t i = 0; i < ssts[s]->NumBlocks(); i++, pos++) {
+      ExpectSameBlock(blocks[pos], expected[s]->ReadBlock(i));
+      // 读取的 block 已经放入 block cache
+      EXPECT_EQ(ssts[s]->GetCachedBlock(i), blocks[pos]);
+    }
+  }
+}
+
+TEST_F(AsyncBlockReaderTest, ReadBlocks) {
+  auto block_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  auto expected_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  std::vector<std::shared_ptr<SST>> ssts;
+  std::vector<std::shared_ptr<SST>> expected;
+  for (size_t id = 0; id < 3; id++) {
+    ssts.push_back(BuildSST(id, block_cache));
+    expected.push_back(SST::Open(id, FileObj::Open(test_dir_ + "/sst_" + std::to_string(id)), expected_cache));
+  }
+  ASSERT_GT(ssts[0]->NumBlocks(), 4);
+
+  // io_uring 不可用时自动使用线程池, 两种实现都要测试
+  for (bool use_io_uring : {true, false}) {
+    AsyncBlockReader reader(8, 2, use_io_uring);
+    if (!use_io_uring) {
+      EXPECT_FALSE(reader.UsesIoUring());
+    }
+    auto cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+    std::vector<std::shared_ptr<SST>> fresh;
+    for (size_t id = 0; id < 3; id++) {
+      fresh.push_back(SST::Open(id, FileObj::Open(test_dir_ + "/sst_" + std::to_string(id)), cache));
+    }
+    CheckReadBlocks(reader, fresh, expected);
+    // 第二次全部命中 block cache
+    CheckReadBlocks(reader, fresh, expected);
+  }
+}
+
+TEST_F(AsyncBlockReaderTest, Callback) {
+  auto block_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  auto sst = BuildSST(0, block_cache);
+  AsyncBlockReader reader(ASYNC_READ_QUEUE_DEPTH, ASYNC_READ_THREADS);
+
+  std::atomic<size_t> done = 0;
+  std::promise<void> finished;
+  size_t num_blocks = sst->NumBlocks();
+  for (size_t i = 0; i < num_blocks; i++) {
+    reader.Submit({sst, i}, ReadOptions(), [&, i](std::shared_ptr<Block> block, std::exception_ptr error) {
+      EXPECT_EQ(error, nullptr);
+      EXPECT_NE(block, nullptr);
+      EXPECT_EQ(block->GetFirstKey(), sst->GetBlockMeta(i).first_key_);
+      if (++done == num_blocks) {
+        finished.set_value();
+      }
+    });
+  }
+  finished.get_future().wait();
+  EXPECT_EQ(done.load(), num_blocks);
+
+  // 非法的 block 编号通过回调返回错误
+  std::exception_ptr error;
+  reader.Submit({sst, num_blocks}, ReadOptions(), [&](std::shared_ptr<Block> block, std::exception_ptr e) {
+    EXPECT_EQ(block, nullptr);
+    error = e;
+  });
+  EXPECT_NE(error, nullptr);
+  EXPECT_THROW(reader.ReadBlocks({{sst, 0}, {sst, num_blocks}}), std::out_of_range);
+}
+
+TEST_F(AsyncBlockReaderTest, DirectIO) {
+  auto block_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  auto expected_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  std::vector<std::shared_ptr<SST>> ssts{BuildSST(0, block_cache, true), BuildSST(1, block_cache, true)};
+  std::vector<std::shared_ptr<SST>> expected;
+  for (size_t id = 0; id < 2; id++) {
+    expected.push_back(SST::Open(id, FileObj::Open(test_dir_ + "/sst_" + std::to_string(id)), expected_cache));
+  }
+  AsyncBlockReader reader(4, 2);
+  CheckReadBlocks(reader, ssts, expected);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <sst/BlobFile.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class BlobFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override { std::filesystem::create_directories("test_data"); }
+  void TearDown() override { std::filesystem::remove_all("test_data"); }
+};
+
+TEST_F(BlobFileTest, Index) {
+  BlobIndex index{42, 1ULL << 40, 65536};
+  auto encoded = index.Encode();
+  EXPECT_EQ(encoded.size(), BlobIndex::ENCODED_SIZE);
+  auto decoded = BlobIndex::Decode(encoded);
+  EXPECT_EQ(decoded.file_number_, 42);
+  EXPECT_EQ(decoded.offset_, 1ULL << 40);
+  EXPECT_EQ(decoded.size_, 65536);
+  EXPECT_THROW(BlobIndex::Decode("short"), std::runtime_error);
+}
+
+TEST_F(BlobFileTest, WriteAndRead) {
+  std::vector<std::string> values;
+  std::vector<BlobIndex> indexes;
+  {
+    BlobFileBuilder builder("test_data/blob_7", 7);
+    for (int i = 0; i < 50; i++) {
+      values.push_back(std::string(1000 * (i + 1), static_cast<char>('a' + i % 26)));
+      indexes.push_back(builder.Add(values.back()));
+    }
+    values.emplace_back();
+    indexes.push_back(builder.Add(values.back()));
+    EXPECT_TRUE(builder.Finish());
+    EXPECT_EQ(builder.GetFileSize(), std::filesystem::file_size("test_data/blob_7"));
+  }
+
+  BlobFileReader reader("test_data/blob_7", 7);
+  // 乱序读取
+  for (size_t i = values.size(); i-- > 0;) {
+    EXPECT_EQ(indexes[i].file_number_, 7);
+    EXPECT_EQ(reader.Read(indexes[i]), values[i]);
+  }
+  // 文件号不符或越界的索引
+  EXPECT_THROW(reader.Read(BlobIndex{8, indexes[0].offset_, indexes[0].size_}), std::runtime_error);
+  EXPECT_THROW(reader.Read(BlobIndex{7, reader.GetFileSize(), 1}), std::runtime_error);
+
+  // 删除后已打开的 reader 仍可读取
+  std::filesystem::remove("test_data/blob_7");
+  EXPECT_EQ(reader.Read(indexes[3]), values[3]);
+  EXPECT_THROW(BlobFileReader("test_data/blob_7", 7), std::runtime_error);
+}
+
+TEST_F(BlobFileTest, Checksum) {
+  BlobIndex index{};
+  {
+    BlobFileBuilder builder("test_data/blob_1", 1);
+    builder.Add("first");
+    index = builder.Add(std::string(4096, 'x'));
+    builder.Finish();
+  }
+  // 改写 value 的一个字节
+  {
+    std::fstream file("test_data/blob_1", std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(index.offset_ + 100));
+    file.put('y');
+  }
+  BlobFileReader reader("test_data/blob_1", 1);
+  EXPECT_THROW(reader.Read(index), std::runtime_error);
+}
+
+TEST_F(BlobFileTest, Abandon) {
+  // 没有写入 value 时不创建文件
+  {
+    BlobFileBuilder builder("test_data/blob_2", 2);
+    EXPECT_FALSE(builder.Finish());
+  }
+  EXPECT_FALSE(std::filesystem::exists("test_data/blob_2"));
+
+  // 未完成的文件在析构时删除
+  {
+    BlobFileBuilder builder("test_data/blob_3", 3);
+    builder.Add("value");
+    EXPECT_TRUE(std::filesystem::exists("test_data/blob_3"));
+  }
+  EXPECT_FALSE(std::filesystem::exists("test_data/blob_3"));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -115,6 +115,167 @@ TEST_F(BlockCacheTest, HitRate) {
   EXPECT_EQ(cache_->GetHitRate(), 2.0 / 3.0);
 }
 
+TEST(BlockCachePriorityTest, LowPriorityEvictedFirst) {
+  BlockCache cache(3, 2);
+  auto block1 = std::make_shared<Block>();
+  auto block2 = std::make_shared<Block>();
+  auto block3 = std::make_shared<Block>();
+  auto block4 = std::make_shared<Block>();
+
+  cache.Put(1, 1, block1, CachePriority::kHigh);
+  cache.Put(1, 2, block2, CachePriority::kLow);
+  cache.Put(1, 3, block3);
+  // 低优先级的 block 先被驱逐, 即使它更新
+  cache.Put(1, 4, block4);
+  EXPECT_EQ(cache.Get(1, 2), nullptr);
+  EXPECT_EQ(cache.Get(1, 1), block1);
+  EXPECT_EQ(cache.Get(1, 3), block3);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kLow), 0);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kNormal), 2);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kHigh), 1);
+
+  // 再次以更高的优先级插入时提升优先级
+  cache.Put(1, 3, block3, CachePriority::kHigh);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kNormal), 1);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kHigh), 2);
+  cache.Put(1, 3, block3, CachePriority::kLow);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kHigh), 2);
+}
+
+TEST(BlockCachePriorityTest, ReservedRatio) {
+  // 为高优先级保留一半容量, 为低优先级保留 2 个
+  BlockCache cache(10, 2, 0.5, 0.2);
+  std::vector<std::shared_ptr<Block>> blocks;
+  for (int i = 0; i < 100; i++) {
+    blocks.push_back(std::make_shared<Block>());
+  }
+  for (int i = 0; i < 5; i++) {
+    cache.Put(1, i, blocks[i], CachePriority::kHigh);
+  }
+  // 大量扫描的 block 只会驱逐低优先级和普通的 block
+  for (int i = 5; i < 8; i++) {
+    cache.Put(1, i, blocks[i]);
+  }
+  for (int i = 8; i < 100; i++) {
+    cache.Put(1, i, blocks[i], CachePriority::kLow);
+  }
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(cache.Get(1, i), blocks[i]);
+  }
+  EXPECT_EQ(cache.GetUsage(CachePriority::kHigh), 5);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kNormal), 3);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kLow), 2);
+  EXPECT_EQ(cache.Get(1, 99), blocks[99]);
+  EXPECT_EQ(cache.Get(1, 97), nullptr);
+
+  // 高优先级超出保留部分之后按 LRU-K 淘汰
+  for (int i = 0; i < 20; i++) {
+    cache.Put(2, i, blocks[i], CachePriority::kHigh);
+  }
+  EXPECT_EQ(cache.GetUsage(CachePriority::kHigh), 8);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kLow), 2);
+
+  // 没有普通 block 时从其他超出保留部分的优先级中驱逐
+  auto block = std::make_shared<Block>();
+  cache.Put(3, 0, block);
+  EXPECT_EQ(cache.Get(3, 0), block);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kHigh), 7);
+
+  EXPECT_THROW(BlockCache(10, 2, 0.8, 0.3), std::invalid_argument);
+  EXPECT_THROW(BlockCache(10, 2, -0.1, 0), std::invalid_argument);
+}
+
+TEST(BlockCachePriorityTest, Pinned) {
+  BlockCache cache(2, 2);
+  auto pinned = std::make_shared<Block>();
+  auto block1 = std::make_shared<Block>();
+  auto block2 = std::make_shared<Block>();
+  auto block3 = std::make_shared<Block>();
+
+  cache.Put(1, -1, pinned, CachePriority::kHigh, true);
+  cache.Put(1, 1, block1);
+  cache.Put(1, 2, block2);
+  cache.Put(1, 3, block3);
+  // 固定的 block 不占容量, 也不会被驱逐
+  EXPECT_EQ(cache.GetPinnedCount(), 1);
+  EXPECT_EQ(cache.Get(1, -1), pinned);
+  EXPECT_EQ(cache.Get(1, 1), nullptr);
+
+  // 已缓存的 block 可以被固定
+  cache.Put(1, 3, block3, CachePriority::kHigh, true);
+  EXPECT_EQ(cache.GetPinnedCount(), 2);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kNormal), 1);
+
+  // 取消固定后按高优先级留在缓存中
+  cache.Unpin(2);
+  EXPECT_EQ(cache.GetPinnedCount(), 2);
+  cache.Unpin(1);
+  EXPECT_EQ(cache.GetPinnedCount(), 0);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kHigh), 2);
+  EXPECT_EQ(cache.Get(1, -1), pinned);
+  EXPECT_EQ(cache.Get(1, 3), block3);
+}
+
+TEST(BlockCachePriorityTest, PinReferences) {
+  BlockCache cache(2, 2);
+  auto pinned = std::make_shared<Block>();
+  // 同一 SST 的两个对象各持有一个引用, 释放最后一个引用时才取消固定
+  cache.Pin(1);
+  cache.Pin(1);
+  cache.Put(1, -1, pinned, CachePriority::kHigh, true);
+  cache.Unpin(1);
+  EXPECT_EQ(cache.GetPinnedCount(), 1);
+  cache.Unpin(1);
+  EXPECT_EQ(cache.GetPinnedCount(), 0);
+  EXPECT_EQ(cache.Get(1, -1), pinned);
+}
+
+TEST(BlockCachePriorityTest, MaxBytes) {
+  BlockCache cache(100, 2);
+  for (int i = 0; i < 10; i++) {
+    auto block = std::make_shared<Block>(4096);
+    block->AddEntry("key", std::string(1000, 'v'));
+    cache.Put(1, i, block);
+  }
+  size_t block_bytes = cache.GetUsageBytes() / 10;
+  EXPECT_GT(block_bytes, 1000);
+
+  // 按字节限制驱逐, 固定的 block 不受影响
+  cache.Put(1, 0, cache.Get(1, 0), CachePriority::kHigh, true);
+  cache.SetMaxBytes(block_bytes * 5);
+  EXPECT_LE(cache.GetUsageBytes(), block_bytes * 5);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kNormal), 4);
+  EXPECT_NE(cache.Get(1, 0), nullptr);
+  EXPECT_NE(cache.Get(1, 9), nullptr);
+  EXPECT_EQ(cache.Get(1, 1), nullptr);
+  cache.Unpin(1);
+  EXPECT_LE(cache.GetUsageBytes(), block_bytes * 5);
+}
+
+TEST(BlockCachePriorityTest, SetCapacity) {
+  BlockCache cache(10, 2, 0.2, 0);
+  for (int i = 0; i < 10; i++) {
+    auto block = std::make_shared<Block>(4096);
+    block->AddEntry("key", "value");
+    cache.Put(1, i, block, i < 2 ? CachePriority::kHigh : CachePriority::kNormal);
+  }
+  // 缩小容量时先驱逐低优先级的 block, 最近插入的保留
+  cache.SetCapacity(5);
+  EXPECT_EQ(cache.GetCapacity(), 5);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kHigh), 2);
+  EXPECT_EQ(cache.GetUsage(CachePriority::kNormal), 3);
+  EXPECT_NE(cache.Get(1, 9), nullptr);
+  EXPECT_EQ(cache.Get(1, 2), nullptr);
+
+  cache.SetCapacity(20);
+  for (int i = 10; i < 20; i++) {
+    auto block = std::make_shared<Block>(4096);
+    block->AddEntry("key", "value");
+    cache.Put(1, i, block);
+  }
+  EXPECT_EQ(cache.GetUsage(CachePriority::kHigh) + cache.GetUsage(CachePriority::kNormal), 15);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -1,6 +1,7 @@
 #include <block/Block.h>
 #include <block/BlockIterator.h>
 #include <gtest/gtest.h>
+#include <utils/Crc32c.h>
 #include <utils/Macro.h>
 #include <iomanip>
 #include <memory>
@@ -159,6 +160,22 @@ TEST_F(BlockTest, ErrorHandlingTest) {
   EXPECT_THROW(Block::Decode(empty_data), std::runtime_error);
 }
 
+// 测试 CRC32C 校验
+TEST_F(BlockTest, ChecksumTest) {
+  auto encoded = GetEncodedBlock();
+  uint32_t crc = Crc32c::Value(encoded.data(), encoded.size());
+  encoded.insert(encoded.end(), reinterpret_cast<uint8_t *>(&crc), reinterpret_cast<uint8_t *>(&crc) + sizeof(crc));
+  auto block = Block::Decode(encoded, true);
+  EXPECT_EQ(block->FindValue("banana").value(), "yellow");
+
+  // 修改 value 中的一个字节后校验失败
+  encoded[9] = 'R';
+  EXPECT_THROW(Block::Decode(encoded, true), std::runtime_error);
+  // 跳过校验时仍然可以解码
+  block = Block::Decode(encoded, true, false);
+  EXPECT_EQ(block->FindValue("apple").value(), "Red");
+}
+
 // 测试迭代器
 TEST_F(BlockTest, IteratorTest) {
   // 使用 make_shared 创建 Block
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <lsm/CompactionPicker.h>
+#include <vector>
+
+namespace {
+std::vector<SortedRun> MakeRuns(const std::vector<size_t> &sizes) {
+  std::vector<SortedRun> runs;
+  for (size_t i = 0; i < sizes.size(); i++) {
+    runs.push_back({sizes.size() - i, sizes[i]});
+  }
+  return runs;
+}
+}  // namespace
+
+TEST(CompactionPickerTest, Trigger) {
+  UniversalCompactionPicker picker(UniversalCompactionOptions(), 4);
+  EXPECT_FALSE(picker.Pick({}).has_value());
+  EXPECT_FALSE(picker.Pick(MakeRuns({100, 100, 100})).has_value());
+  EXPECT_TRUE(picker.Pick(MakeRuns({100, 100, 100, 100})).has_value());
+}
+
+TEST(CompactionPickerTest, SizeAmplification) {
+  UniversalCompactionPicker picker(UniversalCompactionOptions(), 4);
+  // 较新的 run 之和达到最老 run 的 200%, 全部合并
+  auto pick = picker.Pick(MakeRuns({100, 100, 100, 150}));
+  ASSERT_TRUE(pick.has_value());
+  EXPECT_EQ(pick->num_runs_, 4);
+  EXPECT_EQ(pick->reason_, CompactionReason::kSizeAmplification);
+}
+
+TEST(CompactionPickerTest, SizeRatio) {
+  UniversalCompactionPicker picker(UniversalCompactionOptions(), 4);
+  // 只合并大小相近的 run, 大的 run 不被重写
+  auto pick = picker.Pick(MakeRuns({10, 10, 10, 1000}));
+  ASSERT_TRUE(pick.has_value());
+  EXPECT_EQ(pick->num_runs_, 3);
+  EXPECT_EQ(pick->reason_, CompactionReason::kSizeRatio);
+
+  pick = picker.Pick(MakeRuns({10, 10, 20, 45, 10000}));
+  ASSERT_TRUE(pick.has_value());
+  EXPECT_EQ(pick->num_runs_, 3);
+
+  UniversalCompactionOptions options;
+  options.max_merge_width = 2;
+  UniversalCompactionPicker narrow(options, 4);
+  pick = narrow.Pick(MakeRuns({10, 10, 10, 1000}));
+  ASSERT_TRUE(pick.has_value());
+  EXPECT_EQ(pick->num_runs_, 2);
+
+  options = UniversalCompactionOptions();
+  options.size_ratio = 100;
+  UniversalCompactionPicker loose(options, 4);
+  pick = loose.Pick(MakeRuns({10, 15, 60, 100000}));
+  ASSERT_TRUE(pick.has_value());
+  EXPECT_EQ(pick->num_runs_, 2);
+
+  // 最新的 run 太小时, 从后面大小相近的 run 开始选, 较新的 run 一起合并
+  pick = picker.Pick(MakeRuns({10, 2000, 2000, 100000}));
+  ASSERT_TRUE(pick.has_value());
+  EXPECT_EQ(pick->num_runs_, 3);
+  EXPECT_EQ(pick->reason_, CompactionReason::kSizeRatio);
+}
+
+TEST(CompactionPickerTest, RunCount) {
+  UniversalCompactionPicker picker(UniversalCompactionOptions(), 4);
+  // 大小差距大时, 合并最新的 run 使数量降到阈值以下
+  auto pick = picker.Pick(MakeRuns({10, 1000, 100000, 10000000}));
+  ASSERT_TRUE(pick.has_value());
+  EXPECT_EQ(pick->num_runs_, 2);
+  EXPECT_EQ(pick->reason_, CompactionReason::kRunCount);
+
+  pick = picker.Pick(MakeRuns({10, 1000, 100000, 10000000, 1000000000, 100000000000}));
+  ASSERT_TRUE(pick.has_value());
+  EXPECT_EQ(pick->num_runs_, 3);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
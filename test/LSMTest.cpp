@@ -1,8 +1,15 @@
 #include <gtest/gtest.h>
 #include <lsm/LSMEngine.h>
 #include <utils/Macro.h>
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstring>
 #include <filesystem>
+#include <future>
+#include <map>
 #include <random>
+#include <thread>
 #include <string>
 #include <unordered_map>
 
@@ -206,7 +213,1465 @@ TEST_F(LSMTest, MonotonyPredicate) {
   EXPECT_EQ(actual_keys, expected_keys);
 }
 
+// 测试从任意 key 开始的范围查询
+TEST_F(LSMTest, Seek) {
+  LSM lsm(test_dir_);
+  std::map<std::string, std::string> reference;
+  auto make_key = [](int i) {
+    std::ostringstream oss;
+    oss << "key" << std::setw(4) << std::setfill('0') << i;
+    return oss.str();
+  };
+
+  // 数据分布在多个 SST 和内存表中，包含覆盖写和删除
+  for (int round = 0; round < 3; round++) {
+    for (int i = round; i < 2000; i += 3) {
+      std::string value = "value" + std::to_string(i) + "_" + std::to_string(round);
+      lsm.Put(make_key(i), value);
+      reference[make_key(i)] = value;
+    }
+    for (int i = round * 7; i < 2000; i += 50) {
+      lsm.Remove(make_key(i));
+      reference.erase(make_key(i));
+    }
+    lsm.Put(make_key(100), "round" + std::to_string(round));
+    reference[make_key(100)] = "round" + std::to_string(round);
+    if (round < 2) {
+      lsm.Flush();
+    }
+  }
+
+  for (int start : {0, 1, 99, 100, 777, 1500, 1999}) {
+    auto it = lsm.Seek(make_key(start));
+    auto ref_it = reference.lower_bound(make_key(start));
+    for (int n = 0; n < 100 && ref_it != reference.end(); n++) {
+      ASSERT_FALSE(it.IsEnd());
+      EXPECT_EQ(it->first, ref_it->first);
+      EXPECT_EQ(it->second, ref_it->second);
+      ++it;
+      ++ref_it;
+    }
+    EXPECT_EQ(it.IsEnd(), ref_it == reference.end());
+  }
+
+  // 重新定位已有的迭代器
+  auto it = lsm.Begin();
+  EXPECT_EQ(it->first, reference.begin()->first);
+  it.Seek(make_key(1234));
+  EXPECT_EQ(it->first, reference.lower_bound(make_key(1234))->first);
+  it.SeekToFirst();
+  EXPECT_EQ(it->first, reference.begin()->first);
+  it.Seek("zzz");
+  EXPECT_TRUE(it == lsm.End());
+}
+
+// 测试反向遍历以及正反向切换
+TEST_F(LSMTest, ReverseIteration) {
+  LSM lsm(test_dir_);
+  std::map<std::string, std::string> reference;
+  auto make_key = [](int i) {
+    std::ostringstream oss;
+    oss << "key" << std::setw(4) << std::setfill('0') << i;
+    return oss.str();
+  };
+
+  // 数据分布在多个 SST 和内存表中，包含覆盖写和删除
+  for (int round = 0; round < 3; round++) {
+    for (int i = round; i < 2000; i += 3) {
+      std::string value = "value" + std::to_string(i) + "_" + std::to_string(round);
+      lsm.Put(make_key(i), value);
+      reference[make_key(i)] = value;
+    }
+    for (int i = round * 7; i < 2000; i += 50) {
+      lsm.Remove(make_key(i));
+      reference.erase(make_key(i));
+    }
+    if (round < 2) {
+      lsm.Flush();
+    }
+  }
+  // 最后一个 key 被删除
+  lsm.Remove(reference.rbegin()->first);
+  reference.erase(std::prev(reference.end()));
+
+  // 从最后一个 key 完整反向遍历
+  auto it = lsm.SeekToLast();
+  for (auto ref_it = reference.rbegin(); ref_it != reference.rend(); ++ref_it) {
+    ASSERT_FALSE(it.IsEnd());
+    EXPECT_EQ(it->first, ref_it->first);
+    EXPECT_EQ(it->second, ref_it->second);
+    --it;
+  }
+  EXPECT_TRUE(it.IsEnd());
+
+  for (int start : {0, 1, 99, 100, 777, 1500, 1999}) {
+    auto rit = lsm.SeekForPrev(make_key(start));
+    auto ref_it = reference.upper_bound(make_key(start));
+    for (int n = 0; n < 100 && ref_it != reference.begin(); n++) {
+      --ref_it;
+      ASSERT_FALSE(rit.IsEnd());
+      EXPECT_EQ(rit->first, ref_it->first);
+      EXPECT_EQ(rit->second, ref_it->second);
+      --rit;
+    }
+    if (ref_it == reference.begin()) {
+      EXPECT_TRUE(rit.IsEnd());
+    }
+  }
+
+  // 在遍历过程中切换方向
+  it = lsm.Seek(make_key(1000));
+  auto ref_it = reference.lower_bound(make_key(1000));
+  for (int n = 0; n < 200; n++) {
+    if (n % 7 < 4) {
+      ++it;
+      ++ref_it;
+    } else {
+      --it;
+      --ref_it;
+    }
+    ASSERT_FALSE(it.IsEnd());
+    EXPECT_EQ(it->first, ref_it->first);
+    EXPECT_EQ(it->second, ref_it->second);
+  }
+}
+
+// 测试前缀查询
+TEST_F(LSMTest, ScanPrefix) {
+  std::map<std::string, std::string> reference;
+  {
+    LSM lsm(test_dir_, std::make_shared<FixedPrefixExtractor>(4));
+    // 每一轮写入不同的用户, 每个 SST 只包含部分前缀
+    for (int round = 0; round < 4; round++) {
+      for (int user = round; user < 100; user += 4) {
+        for (int i = 0; i < 20; i++) {
+          char key[16];
+          snprintf(key, sizeof(key), "u%03d:%03d", user, i);
+          std::string value = "value" + std::to_string(round) + "_" + std::to_string(i);
+          lsm.Put(key, value);
+          reference[key] = value;
+        }
+      }
+      // 删除和覆盖较早 SST 中的数据
+      if (round > 0) {
+        char key[16];
+        snprintf(key, sizeof(key), "u%03d:%03d", round - 1, 5);
+        lsm.Remove(key);
+        reference.erase(key);
+      }
+      lsm.Flush();
+    }
+  }
+
+  // 重新打开, filter 从 SST 文件中读取
+  LSM lsm(test_dir_, std::make_shared<FixedPrefixExtractor>(4));
+  for (std::string prefix : {"u000", "u001", "u002", "u05", "u099:01", "u", "u100", "a", "z"}) {
+    std::vector<std::pair<std::string, std::string>> expected;
+    for (auto it = reference.lower_bound(prefix); it != reference.end() && it->first.rfind(prefix, 0) == 0; ++it) {
+      expected.emplace_back(*it);
+    }
+    std::vector<std::pair<std::string, std::string>> actual;
+    for (auto it = lsm.ScanPrefix(prefix); !it.IsEnd(); ++it) {
+      actual.emplace_back(*it);
+    }
+    EXPECT_EQ(actual, expected) << prefix;
+  }
+}
+
+TEST_F(LSMTest, MultiGet) {
+  std::map<std::string, std::string> reference;
+  {
+    LSM lsm(test_dir_);
+    // 每一轮覆盖部分 key 并删除一个 key, 每轮生成一个 SST
+    for (int round = 0; round < 4; round++) {
+      for (int i = round; i < 2000; i += 2) {
+        std::string key = "key" + std::to_string(i);
+        std::string value = "value" + std::to_string(round) + "_" + std::to_string(i);
+        lsm.Put(key, value);
+        reference[key] = value;
+      }
+      std::string removed = "key" + std::to_string(round * 10);
+      lsm.Remove(removed);
+      reference.erase(removed);
+      lsm.Flush();
+    }
+  }
+
+  // 重新打开, block cache 为空, 候选 block 需要并发读取
+  LSM lsm(test_dir_);
+  lsm.Put("key1", "memtable");
+  reference["key1"] = "memtable";
+  std::vector<std::string> keys;
+  for (int i = 0; i < 2100; i += 7) {
+    keys.push_back("key" + std::to_string(i));
+  }
+  auto values = lsm.MultiGet(keys);
+  ASSERT_EQ(values.size(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto it = reference.find(keys[i]);
+    if (it == reference.end()) {
+      EXPECT_FALSE(values[i].has_value()) << keys[i];
+    } else {
+      EXPECT_EQ(values[i], it->second) << keys[i];
+    }
+    EXPECT_EQ(lsm.Get(keys[i]), values[i]) << keys[i];
+  }
+}
+
+// 测试用的协程类型: 立即开始执行, 结束时不挂起
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+struct AsyncGetResult {
+  std::optional<std::string> value_;
+  std::thread::id resumed_on_;
+};
+
+DetachedTask AsyncGet(LSM &lsm, std::string key, std::promise<AsyncGetResult> *result) {
+  auto value = co_await lsm.GetAsync(key);
+  result->set_value({value, std::this_thread::get_id()});
+}
+
+DetachedTask AsyncScan(LSM &lsm, std::string key,
+                       std::promise<std::vector<std::pair<std::string, std::string>>> *result) {
+  std::vector<std::pair<std::string, std::string>> items;
+  auto it = co_await lsm.ScanAsync(key);
+  while (!it.IsEnd()) {
+    items.push_back(*it);
+    co_await it.Next();
+  }
+  result->set_value(std::move(items));
+}
+
+TEST_F(LSMTest, AsyncApi) {
+  std::map<std::string, std::string> reference;
+  {
+    LSM lsm(test_dir_);
+    for (int round = 0; round < 3; round++) {
+      for (int i = round; i < 3000; i += 3) {
+        std::string key = "key" + std::to_string(10000 + i);
+        std::string value = "value" + std::to_string(round) + "_" + std::to_string(i);
+        lsm.Put(key, value);
+        reference[key] = value;
+      }
+      std::string removed = "key" + std::to_string(10000 + round * 100);
+      lsm.Remove(removed);
+      reference.erase(removed);
+      lsm.Flush();
+    }
+  }
+
+  // 重新打开, block cache 为空
+  {
+    LSM lsm(test_dir_);
+    lsm.Put("key10001", "memtable");
+    reference["key10001"] = "memtable";
+    auto main_thread = std::this_thread::get_id();
+
+    // memtable 命中时不挂起, 在当前线程完成
+    std::promise<AsyncGetResult> memtable_get;
+    auto memtable_future = memtable_get.get_future();
+    AsyncGet(lsm, "key10001", &memtable_get);
+    ASSERT_EQ(memtable_future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    auto memtable_result = memtable_future.get();
+    EXPECT_EQ(memtable_result.value_, "memtable");
+    EXPECT_EQ(memtable_result.resumed_on_, main_thread);
+
+    // block 不在 cache 中时挂起, 在读取线程上恢复
+    std::promise<AsyncGetResult> sst_get;
+    AsyncGet(lsm, "key12000", &sst_get);
+    auto sst_result = sst_get.get_future().get();
+    EXPECT_EQ(sst_result.value_, reference["key12000"]);
+    EXPECT_NE(sst_result.resumed_on_, main_thread);
+
+    // 大量并发的查询
+    std::vector<std::string> keys;
+    for (int i = 0; i < 3100; i += 7) {
+      keys.push_back("key" + std::to_string(10000 + i));
+    }
+    std::vector<std::promise<AsyncGetResult>> results(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      AsyncGet(lsm, keys[i], &results[i]);
+    }
+    for (size_t i = 0; i < keys.size(); i++) {
+      auto value = results[i].get_future().get().value_;
+      auto it = reference.find(keys[i]);
+      if (it == reference.end()) {
+        EXPECT_FALSE(value.has_value()) << keys[i];
+      } else {
+        EXPECT_EQ(value, it->second) << keys[i];
+      }
+    }
+  }
+
+  // 异步扫描, 同样从空的 block cache 开始
+  LSM lsm(test_dir_);
+  for (std::string start : {"", "key11500", "key2"}) {
+    std::promise<std::vector<std::pair<std::string, std::string>>> scan;
+    AsyncScan(lsm, start, &scan);
+    std::vector<std::pair<std::string, std::string>> expected(reference.lower_bound(start), reference.end());
+    EXPECT_EQ(scan.get_future().get(), expected) << start;
+  }
+}
+
+TEST_F(LSMTest, WriteBufferManager) {
+  LSM lsm(test_dir_);
+  auto &manager = lsm.GetWriteBufferManager();
+  size_t empty_bytes = manager.MemoryUsage();
+  for (int i = 0; i < 1000; i++) {
+    lsm.Put("key" + std::to_string(i), "value" + std::to_string(i));
+  }
+  EXPECT_GT(manager.MemoryUsage(), empty_bytes + 1000 * 20);
+  lsm.Flush();
+  EXPECT_EQ(manager.MemoryUsage(), empty_bytes);
+
+  // 预算下 memtable 自动 flush
+  manager.SetMemoryBudget(1024 * 1024);
+  for (int i = 0; i < 20000; i++) {
+    lsm.Put("budget" + std::to_string(i), "value" + std::to_string(i));
+  }
+  EXPECT_LT(manager.MemoryUsage(), 1024 * 1024);
+  EXPECT_GT(std::distance(std::filesystem::directory_iterator(test_dir_), std::filesystem::directory_iterator{}), 1);
+  for (int i = 0; i < 20000; i += 100) {
+    EXPECT_EQ(lsm.Get("budget" + std::to_string(i)), "value" + std::to_string(i));
+  }
+}
+
+TEST_F(LSMTest, ColumnFamilies) {
+  ColumnFamilyOptions orders_options;
+  orders_options.block_size = 4096;
+  orders_options.index_partition_size = 16;
+  {
+    LSM lsm(test_dir_);
+    auto *users = lsm.CreateColumnFamily("users");
+    auto *orders = lsm.CreateColumnFamily("orders", orders_options);
+    EXPECT_THROW(lsm.CreateColumnFamily("users"), std::invalid_argument);
+    EXPECT_EQ(lsm.GetColumnFamily("users"), users);
+    EXPECT_EQ(lsm.GetColumnFamily("missing"), nullptr);
+
+    // 各列族的 key 空间相互独立
+    lsm.Put("key", "default");
+    lsm.Put(users, "key", "users");
+    EXPECT_EQ(lsm.Get("key"), "default");
+    EXPECT_EQ(lsm.Get(users, "key"), "users");
+    EXPECT_FALSE(lsm.Get(orders, "key").has_value());
+
+    // 跨列族的 WriteBatch
+    WriteBatch batch;
+    for (int i = 0; i < 1000; i++) {
+      batch.Put(orders, "order" + std::to_string(i), "value" + std::to_string(i));
+    }
+    batch.Remove(users, "key");
+    batch.Put("batch", "default");
+    EXPECT_EQ(batch.Count(), 1002);
+    lsm.Write(batch);
+    EXPECT_FALSE(lsm.Get(users, "key").has_value());
+    EXPECT_EQ(lsm.Get("batch"), "default");
+    EXPECT_EQ(lsm.Get(orders, "order42"), "value42");
+
+    lsm.Flush(orders);
+    lsm.Put(users, "user1", "alice");
+    lsm.Flush(users);
+    lsm.Put("key", "default2");
+    lsm.Flush();
+
+    // SST id 在列族之间唯一, 共享的 block cache 中不会冲突
+    EXPECT_TRUE(std::filesystem::exists(test_dir_ + "/cf_orders/sst_0000"));
+    EXPECT_TRUE(std::filesystem::exists(test_dir_ + "/cf_users/sst_0001"));
+    EXPECT_TRUE(std::filesystem::exists(test_dir_ + "/sst_0002"));
+    EXPECT_EQ(lsm.Get(orders, "order42"), "value42");
+    EXPECT_EQ(lsm.Get(users, "user1"), "alice");
+    EXPECT_EQ(lsm.Get("key"), "default2");
+  }
+
+  // 重新打开后通过 CreateColumnFamily 恢复列族
+  LSM lsm(test_dir_);
+  EXPECT_EQ(lsm.GetColumnFamily("orders"), nullptr);
+  auto *orders = lsm.CreateColumnFamily("orders", orders_options);
+  auto *users = lsm.CreateColumnFamily("users");
+  EXPECT_EQ(lsm.Get(orders, "order999"), "value999");
+  EXPECT_EQ(lsm.Get(users, "user1"), "alice");
+  EXPECT_EQ(lsm.Get("batch"), "default");
+
+  int count = 0;
+  for (auto it = lsm.Begin(orders); !it.IsEnd(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(count, 1000);
+
+  lsm.Put(orders, "order0", "new");
+  lsm.Flush(orders);
+  EXPECT_TRUE(std::filesystem::exists(test_dir_ + "/cf_orders/sst_0003"));
+  EXPECT_EQ(lsm.Get(orders, "order0"), "new");
+
+  // 删除列族
+  EXPECT_THROW(lsm.DropColumnFamily("default"), std::invalid_argument);
+  lsm.DropColumnFamily("orders");
+  EXPECT_EQ(lsm.GetColumnFamily("orders"), nullptr);
+  EXPECT_FALSE(std::filesystem::exists(test_dir_ + "/cf_orders"));
+  orders = lsm.CreateColumnFamily("orders");
+  EXPECT_FALSE(lsm.Get(orders, "order0").has_value());
+  EXPECT_EQ(lsm.Get(users, "user1"), "alice");
+}
+
+// 删除 "drop:" 开头的 key, 把 "upper:" 开头的 value 改成大写
+class TestCompactionFilter : public CompactionFilter {
+ public:
+  std::string Name() const override { return "test"; }
+  Decision Filter(const std::string &key, const std::string &value, std::string *new_value) const override {
+    if (key.rfind("drop:", 0) == 0) {
+      return Decision::kRemove;
+    }
+    if (key.rfind("upper:", 0) == 0) {
+      *new_value = value;
+      for (auto &c : *new_value) {
+        c = static_cast<char>(toupper(c));
+      }
+      return Decision::kChangeValue;
+    }
+    return Decision::kKeep;
+  }
+};
+
+TEST_F(LSMTest, CompactionFilter) {
+  LSM lsm(test_dir_);
+  ColumnFamilyOptions options;
+  options.compaction_filter = std::make_shared<TestCompactionFilter>();
+  auto *cf = lsm.CreateColumnFamily("filtered", options);
+
+  lsm.Put(cf, "drop:1", "old");
+  lsm.Put(cf, "keep:1", "value");
+  lsm.Flush(cf);
+  // 过滤器只在 flush 和 compaction 时生效
+  lsm.Put(cf, "drop:2", "value");
+  lsm.Put(cf, "upper:1", "value");
+  EXPECT_EQ(lsm.Get(cf, "drop:2"), "value");
+  EXPECT_EQ(lsm.Get(cf, "upper:1"), "value");
+  lsm.Flush(cf);
+
+  EXPECT_FALSE(lsm.Get(cf, "drop:1").has_value());
+  EXPECT_FALSE(lsm.Get(cf, "drop:2").has_value());
+  EXPECT_EQ(lsm.Get(cf, "upper:1"), "VALUE");
+  EXPECT_EQ(lsm.Get(cf, "keep:1"), "value");
+
+  // compaction 把所有 SST 合并成一个, 其它列族不受影响
+  lsm.Put("drop:1", "default");
+  lsm.Compact(cf);
+  int num_ssts = 0;
+  for (const auto &entry : std::filesystem::directory_iterator(test_dir_ + "/cf_filtered")) {
+    (void)entry;
+    num_ssts++;
+  }
+  EXPECT_EQ(num_ssts, 1);
+  std::vector<std::pair<std::string, std::string>> entries;
+  for (auto it = lsm.Begin(cf); !it.IsEnd(); ++it) {
+    entries.push_back(*it);
+  }
+  std::vector<std::pair<std::string, std::string>> expected{{"keep:1", "value"}, {"upper:1", "VALUE"}};
+  EXPECT_EQ(entries, expected);
+  EXPECT_EQ(lsm.Get("drop:1"), "default");
+}
+
+// 第一次被调用时阻塞, 直到 release_ 就绪
+class BlockingCompactionFilter : public CompactionFilter {
+ public:
+  mutable std::atomic<bool> block_{false};
+  mutable std::promise<void> entered_;
+  std::shared_future<void> release_;
+
+  std::string Name() const override { return "blocking"; }
+  Decision Filter(const std::string &, const std::string &, std::string *) const override {
+    if (block_.exchange(false)) {
+      entered_.set_value();
+      release_.wait();
+    }
+    return Decision::kKeep;
+  }
+};
+
+TEST_F(LSMTest, FlushDuringCompaction) {
+  auto filter = std::make_shared<BlockingCompactionFilter>();
+  std::promise<void> release;
+  filter->release_ = release.get_future().share();
+  ColumnFamilyOptions options;
+  options.compaction_filter = filter;
+  {
+    LSM lsm(test_dir_);
+    auto *cf = lsm.CreateColumnFamily("blocking", options);
+    for (int i = 0; i < 3; i++) {
+      lsm.Put(cf, "key" + std::to_string(i), "old");
+      lsm.Flush(cf);
+    }
+
+    filter->block_ = true;
+    std::thread compaction([&lsm, cf] { lsm.Compact(cf); });
+    filter->entered_.get_future().wait();
+    // compaction 合并期间 flush 不被阻塞
+    lsm.Put(cf, "key0", "new");
+    auto flushed = std::async(std::launch::async, [&lsm, cf] { lsm.Flush(cf); });
+    EXPECT_EQ(flushed.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    release.set_value();
+    compaction.join();
+    flushed.get();
+
+    // compaction 的输出排在合并期间 flush 的 SST 之后
+    EXPECT_EQ(std::distance(std::filesystem::directory_iterator(test_dir_ + "/cf_blocking"),
+                            std::filesystem::directory_iterator{}),
+              2);
+    EXPECT_EQ(lsm.Get(cf, "key0"), "new");
+    EXPECT_EQ(lsm.Get(cf, "key1"), "old");
+  }
+
+  // 重新打开后顺序不变
+  LSM lsm(test_dir_);
+  auto *cf = lsm.CreateColumnFamily("blocking", options);
+  EXPECT_EQ(lsm.Get(cf, "key0"), "new");
+  EXPECT_EQ(lsm.Get(cf, "key2"), "old");
+}
+
+TEST_F(LSMTest, Compact) {
+  std::map<std::string, std::string> reference;
+  LSM lsm(test_dir_);
+  for (int round = 0; round < 3; round++) {
+    for (int i = round; i < 1000; i += 2) {
+      std::string key = "key" + std::to_string(i);
+      lsm.Put(key, "value" + std::to_string(round));
+      reference[key] = "value" + std::to_string(round);
+    }
+    for (int i = round; i < 1000; i += 7) {
+      std::string key = "key" + std::to_string(i);
+      lsm.Remove(key);
+      reference.erase(key);
+    }
+    lsm.Flush();
+  }
+  lsm.Compact();
+  // compaction 之后的新数据比合并结果更新
+  lsm.Put("key1", "new");
+  reference["key1"] = "new";
+  lsm.Flush();
+
+  auto it = lsm.Begin();
+  for (const auto &[key, value] : reference) {
+    ASSERT_FALSE(it.IsEnd());
+    EXPECT_EQ(it->first, key);
+    EXPECT_EQ(it->second, value);
+    EXPECT_EQ(lsm.Get(key), value);
+    ++it;
+  }
+  EXPECT_TRUE(it.IsEnd());
+  EXPECT_FALSE(lsm.Get("key0").has_value());
+}
+
+TEST_F(LSMTest, TTL) {
+  {
+    LSM lsm(test_dir_);
+    ColumnFamilyOptions options;
+    options.ttl = 1;
+    auto *cf = lsm.CreateColumnFamily("sessions", options);
+    lsm.Put(cf, "session:1", "alice");
+    lsm.Put(cf, "session:2", "bob");
+    lsm.Flush(cf);
+    lsm.Put(cf, "session:3", "carol");
+    EXPECT_EQ(lsm.Get(cf, "session:1"), "alice");
+    EXPECT_EQ(lsm.Get(cf, "session:3"), "carol");
+    auto it = lsm.Begin(cf);
+    ASSERT_FALSE(it.IsEnd());
+    EXPECT_EQ(it->second, "alice");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    lsm.Put(cf, "session:2", "dave");
+
+    // 过期的数据在 compaction 之前就对读不可见
+    EXPECT_FALSE(lsm.Get(cf, "session:1").has_value());
+    EXPECT_FALSE(lsm.Get(cf, "session:3").has_value());
+    EXPECT_EQ(lsm.Get(cf, "session:2"), "dave");
+    auto values = lsm.MultiGet(cf, {"session:1", "session:2", "session:3"});
+    EXPECT_FALSE(values[0].has_value());
+    EXPECT_EQ(values[1], "dave");
+    EXPECT_FALSE(values[2].has_value());
+    std::vector<std::pair<std::string, std::string>> entries;
+    for (auto iter = lsm.Begin(cf); !iter.IsEnd(); ++iter) {
+      entries.push_back(*iter);
+    }
+    std::vector<std::pair<std::string, std::string>> expected{{"session:2", "dave"}};
+    EXPECT_EQ(entries, expected);
+
+    lsm.Flush(cf);
+    lsm.Compact(cf);
+  }
+
+  // compaction 回收了过期的数据
+  LSM lsm(test_dir_);
+  ColumnFamilyOptions options;
+  options.ttl = 1;
+  auto *cf = lsm.CreateColumnFamily("sessions", options);
+  EXPECT_EQ(lsm.Get(cf, "session:2"), "dave");
+  std::vector<std::string> files;
+  for (const auto &entry : std::filesystem::directory_iterator(test_dir_ + "/cf_sessions")) {
+    files.push_back(entry.path().string());
+  }
+  ASSERT_EQ(files.size(), 1);
+  auto sst = SST::Open(0, FileObj::Open(files[0], false), nullptr);
+  EXPECT_EQ(sst->GetFirstKey(), "session:2");
+  EXPECT_EQ(sst->GetLastKey(), "session:2");
+}
+
+TEST_F(LSMTest, Merge) {
+  ColumnFamilyOptions counter_options;
+  counter_options.merge_operator = std::make_shared<UInt64AddOperator>();
+  ColumnFamilyOptions list_options;
+  list_options.merge_operator = std::make_shared<StringAppendOperator>(",");
+  {
+    LSM lsm(test_dir_);
+    EXPECT_THROW(lsm.Merge("key", "operand"), std::invalid_argument);
+    auto *counters = lsm.CreateColumnFamily("counters", counter_options);
+    auto *lists = lsm.CreateColumnFamily("lists", list_options);
+
+    // 多个线程并发自增, 不需要先读再写
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&lsm, counters]() {
+        for (int i = 0; i < 1000; i++) {
+          lsm.Merge(counters, "counter" + std::to_string(i % 10), UInt64AddOperator::EncodeValue(1));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    for (int i = 0; i < 10; i++) {
+      EXPECT_EQ(UInt64AddOperator::DecodeValue(lsm.Get(counters, "counter" + std::to_string(i)).value()), 400);
+    }
+
+    // 操作数分布在多个 SST 和 memtable 中
+    lsm.Put(lists, "list", "a");
+    lsm.Flush(lists);
+    lsm.Merge(lists, "list", "b");
+    lsm.Flush(lists);
+    lsm.Merge(lists, "list", "c");
+    lsm.Merge(lists, "list", "d");
+    lsm.Merge(lists, "new", "x");
+    EXPECT_EQ(lsm.Get(lists, "list"), "a,b,c,d");
+    EXPECT_EQ(lsm.Get(lists, "new"), "x");
+    auto values = lsm.MultiGet(lists, {"list", "new", "missing"});
+    EXPECT_EQ(values[0], "a,b,c,d");
+    EXPECT_EQ(values[1], "x");
+    EXPECT_FALSE(values[2].has_value());
+
+    // 删除之后的操作数从空值开始合并
+    lsm.Flush(lists);
+    lsm.Remove(lists, "list");
+    lsm.Flush(lists);
+    lsm.Merge(lists, "list", "e");
+    EXPECT_EQ(lsm.Get(lists, "list"), "e");
+    lsm.Flush(lists);
+    lsm.Merge(lists, "list", "f");
+
+    WriteBatch batch;
+    batch.Merge(lists, "list", "g");
+    batch.Merge(counters, "counter0", UInt64AddOperator::EncodeValue(100));
+    lsm.Write(batch);
+    EXPECT_EQ(lsm.Get(lists, "list"), "e,f,g");
+    WriteBatch invalid;
+    invalid.Put(lists, "list", "h");
+    invalid.Merge("key", "operand");
+    EXPECT_THROW(lsm.Write(invalid), std::invalid_argument);
+    EXPECT_EQ(lsm.Get(lists, "list"), "e,f,g");
+
+    std::vector<std::pair<std::string, std::string>> entries;
+    for (auto it = lsm.Begin(lists); !it.IsEnd(); ++it) {
+      entries.push_back(*it);
+    }
+    std::vector<std::pair<std::string, std::string>> expected{{"list", "e,f,g"}, {"new", "x"}};
+    EXPECT_EQ(entries, expected);
+    auto it = lsm.SeekToLast(lists);
+    ASSERT_FALSE(it.IsEnd());
+    EXPECT_EQ(it->second, "x");
+    --it;
+    ASSERT_FALSE(it.IsEnd());
+    EXPECT_EQ(it->second, "e,f,g");
+  }
+
+  // compaction 把操作数合并成值
+  LSM lsm(test_dir_);
+  auto *counters = lsm.CreateColumnFamily("counters", counter_options);
+  auto *lists = lsm.CreateColumnFamily("lists", list_options);
+  EXPECT_EQ(lsm.Get(lists, "list"), "e,f,g");
+  lsm.Compact(lists);
+  lsm.Compact(counters);
+  EXPECT_EQ(lsm.Get(lists, "list"), "e,f,g");
+  EXPECT_EQ(lsm.Get(lists, "new"), "x");
+  EXPECT_EQ(UInt64AddOperator::DecodeValue(lsm.Get(counters, "counter0").value()), 500);
+  EXPECT_EQ(UInt64AddOperator::DecodeValue(lsm.Get(counters, "counter9").value()), 400);
+  lsm.Merge(lists, "list", "h");
+  EXPECT_EQ(lsm.Get(lists, "list"), "e,f,g,h");
+}
+
+TEST_F(LSMTest, RowCache) {
+  ColumnFamilyOptions options;
+  options.row_cache = true;
+  LSM lsm(test_dir_, options);
+  for (int i = 0; i < 1000; i++) {
+    lsm.Put("key" + std::to_string(i), "value" + std::to_string(i));
+  }
+  lsm.Flush();
+
+  // 第二次读命中 row cache
+  EXPECT_EQ(lsm.Get("key1"), "value1");
+  EXPECT_EQ(lsm.Get("key1"), "value1");
+  EXPECT_FALSE(lsm.Get("missing").has_value());
+  EXPECT_FALSE(lsm.Get("missing").has_value());
+  EXPECT_DOUBLE_EQ(lsm.GetRowCache().GetHitRate(), 0.5);
+
+  // 写操作使缓存失效
+  lsm.Put("key1", "new");
+  EXPECT_EQ(lsm.Get("key1"), "new");
+  lsm.Put("missing", "present");
+  EXPECT_EQ(lsm.Get("missing"), "present");
+  lsm.Remove("key1");
+  EXPECT_FALSE(lsm.Get("key1").has_value());
+  WriteBatch batch;
+  batch.Put("key1", "batch");
+  batch.Remove("key2");
+  EXPECT_EQ(lsm.Get("key2"), "value2");
+  lsm.Write(batch);
+  EXPECT_EQ(lsm.Get("key1"), "batch");
+  EXPECT_FALSE(lsm.Get("key2").has_value());
+  lsm.Flush();
+  EXPECT_EQ(lsm.Get("key1"), "batch");
+  auto values = lsm.MultiGet({"key1", "key2", "key3", "key3"});
+  EXPECT_EQ(values[0], "batch");
+  EXPECT_FALSE(values[1].has_value());
+  EXPECT_EQ(values[2], "value3");
+  EXPECT_EQ(values[3], "value3");
+
+  // merge 和 compaction filter 改变的值也不会读到旧的缓存
+  ColumnFamilyOptions cf_options;
+  cf_options.row_cache = true;
+  cf_options.merge_operator = std::make_shared<StringAppendOperator>(",");
+  cf_options.compaction_filter = std::make_shared<TestCompactionFilter>();
+  auto *cf = lsm.CreateColumnFamily("cached", cf_options);
+  lsm.Merge(cf, "upper:1", "a");
+  EXPECT_EQ(lsm.Get(cf, "upper:1"), "a");
+  lsm.Merge(cf, "upper:1", "b");
+  EXPECT_EQ(lsm.Get(cf, "upper:1"), "a,b");
+  lsm.Put(cf, "drop:1", "value");
+  EXPECT_EQ(lsm.Get(cf, "drop:1"), "value");
+  lsm.Flush(cf);
+  EXPECT_FALSE(lsm.Get(cf, "drop:1").has_value());
+  lsm.Put(cf, "upper:2", "c");
+  lsm.Flush(cf);
+  lsm.Merge(cf, "upper:2", "d");
+  EXPECT_EQ(lsm.Get(cf, "upper:2"), "C,d");
+  lsm.Compact(cf);
+  EXPECT_EQ(lsm.Get(cf, "upper:2"), "C,d");
+  lsm.Flush(cf);
+  lsm.Compact(cf);
+  EXPECT_EQ(lsm.Get(cf, "upper:2"), "C,D");
+}
+
+TEST_F(LSMTest, WriteStall) {
+  LSM lsm(test_dir_);
+  ColumnFamilyOptions options;
+  options.level0_slowdown_writes_trigger = 3;
+  options.level0_stop_writes_trigger = 5;
+  auto *cf = lsm.CreateColumnFamily("stalled", options);
+  auto count_ssts = [this]() {
+    return std::distance(std::filesystem::directory_iterator(test_dir_ + "/cf_stalled"),
+                         std::filesystem::directory_iterator{});
+  };
+  std::string large(16 * 1024, 'v');
+
+  for (int i = 0; i < 4; i++) {
+    lsm.Put(cf, "key" + std::to_string(i), "value" + std::to_string(i));
+    lsm.Flush(cf);
+  }
+  EXPECT_EQ(lsm.GetWriteController().GetStats().delayed_writes, 0);
+  // 超过减速阈值后写入被延迟
+  lsm.Put(cf, "large", large);
+  EXPECT_EQ(lsm.GetWriteController().GetState(), WriteStall::kDelayed);
+  auto stats = lsm.GetWriteController().GetStats();
+  EXPECT_EQ(stats.delayed_writes, 1);
+  EXPECT_GT(stats.delay_micros, 0);
+  EXPECT_EQ(stats.stopped_writes, 0);
+
+  // 达到停止阈值后, 写入等待 L0 被合并
+  lsm.Flush(cf);
+  EXPECT_EQ(count_ssts(), 5);
+  lsm.Put(cf, "key4", "value4");
+  EXPECT_EQ(count_ssts(), 1);
+  EXPECT_EQ(lsm.GetWriteController().GetState(), WriteStall::kNone);
+  stats = lsm.GetWriteController().GetStats();
+  EXPECT_EQ(stats.stopped_writes, 1);
+  EXPECT_GT(stats.stop_micros, 0);
+
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(lsm.Get(cf, "key" + std::to_string(i)), "value" + std::to_string(i));
+  }
+  EXPECT_EQ(lsm.Get(cf, "large"), large);
+}
+
+TEST_F(LSMTest, UniversalCompaction) {
+  ColumnFamilyOptions universal_options;
+  universal_options.compaction_style = CompactionStyle::kUniversal;
+  universal_options.merge_operator = std::make_shared<StringAppendOperator>(",");
+  std::map<std::string, std::string> reference;
+  auto count_ssts = [this](const std::string &name) {
+    return std::distance(std::filesystem::directory_iterator(test_dir_ + "/cf_" + name),
+                         std::filesystem::directory_iterator{});
+  };
+  {
+    LSM lsm(test_dir_);
+    auto *tiered = lsm.CreateColumnFamily("tiered", universal_options);
+    auto *full = lsm.CreateColumnFamily("full");
+    for (int round = 0; round < 40; round++) {
+      for (int i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(round * 100 + i);
+        std::string value = "value" + std::to_string(round) + std::string(100, 'v');
+        lsm.Put(tiered, key, value);
+        lsm.Put(full, key, value);
+        reference[key] = value;
+      }
+      // 删除和 merge 跨越部分合并的 run
+      std::string removed = "key" + std::to_string(round * 37 % (round * 100 + 1));
+      lsm.Remove(tiered, removed);
+      reference.erase(removed);
+      lsm.Merge(tiered, "list", std::to_string(round));
+      lsm.Flush(tiered);
+      lsm.Flush(full);
+      // 每次 flush 后都合并成一个 run
+      lsm.Compact(full);
+      // sorted run 的数量保持有界
+      EXPECT_LT(count_ssts("tiered"), 8);
+    }
+
+    // 分层合并只重写大小相近的 run, 写放大远低于每次全部合并
+    auto *tiered_cf = lsm.GetColumnFamily("tiered");
+    auto *full_cf = lsm.GetColumnFamily("full");
+    EXPECT_GT(tiered_cf->GetCompactionBytesWritten(), 0);
+    EXPECT_LT(tiered_cf->GetCompactionBytesWritten() * 3, full_cf->GetCompactionBytesWritten());
+  }
+
+  // 重新打开后 run 的新旧顺序不变
+  LSM lsm(test_dir_);
+  auto *tiered = lsm.CreateColumnFamily("tiered", universal_options);
+  std::string list;
+  for (int round = 0; round < 40; round++) {
+    list += (round == 0 ? "" : ",") + std::to_string(round);
+  }
+  EXPECT_EQ(lsm.Get(tiered, "list"), list);
+  for (int i = 0; i < 4000; i++) {
+    std::string key = "key" + std::to_string(i);
+    auto it = reference.find(key);
+    if (it == reference.end()) {
+      EXPECT_FALSE(lsm.Get(tiered, key).has_value()) << key;
+    } else {
+      EXPECT_EQ(lsm.Get(tiered, key), it->second) << key;
+    }
+  }
+}
+
+TEST_F(LSMTest, FifoCompaction) {
+  LSM lsm(test_dir_);
+  ColumnFamilyOptions options;
+  options.compaction_style = CompactionStyle::kFifo;
+  options.fifo.max_table_files_size = 64 * 1024;
+  options.level0_stop_writes_trigger = 4;
+  auto *metrics = lsm.CreateColumnFamily("metrics", options);
+  auto list_ssts = [this]() {
+    std::vector<std::string> paths;
+    for (const auto &entry : std::filesystem::directory_iterator(test_dir_ + "/cf_metrics")) {
+      paths.push_back(entry.path().string());
+    }
+    return paths;
+  };
+
+  // 时间递增的 key, 最老的 SST 被整个删除
+  std::string value(100, 'v');
+  for (int round = 0; round < 20; round++) {
+    for (int i = 0; i < 100; i++) {
+      lsm.Put(metrics, "ts" + std::to_string(10000 + round * 100 + i), value);
+    }
+    lsm.Flush(metrics);
+    size_t total = 0;
+    for (const auto &path : list_ssts()) {
+      total += std::filesystem::file_size(path);
+    }
+    EXPECT_LE(total, options.fifo.max_table_files_size);
+  }
+  // SST 不会被重写, 也不因 L0 的数量阻塞写入
+  EXPECT_EQ(metrics->GetCompactionBytesWritten(), 0);
+  EXPECT_GT(list_ssts().size(), 4);
+  EXPECT_EQ(lsm.GetWriteController().GetStats().stopped_writes, 0);
+  EXPECT_FALSE(lsm.Get(metrics, "ts10000").has_value());
+  EXPECT_EQ(lsm.Get(metrics, "ts11999"), value);
+  auto it = lsm.Begin(metrics);
+  EXPECT_GT(it->first, "ts10000");
+
+  // 超过保留时间的 SST 由 Compact() 删除
+  ColumnFamilyOptions ttl_options;
+  ttl_options.compaction_style = CompactionStyle::kFifo;
+  ttl_options.fifo.ttl = 60;
+  auto *events = lsm.CreateColumnFamily("events", ttl_options);
+  lsm.Put(events, "old", "value");
+  lsm.Flush(events);
+  lsm.Put(events, "new", "value");
+  lsm.Flush(events);
+  lsm.Compact(events);
+  EXPECT_EQ(lsm.Get(events, "old"), "value");
+  std::vector<std::string> paths;
+  for (const auto &entry : std::filesystem::directory_iterator(test_dir_ + "/cf_events")) {
+    paths.push_back(entry.path().string());
+  }
+  ASSERT_EQ(paths.size(), 2);
+  auto old_path = std::min(paths[0], paths[1]);
+  std::filesystem::last_write_time(old_path, std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+  lsm.Compact(events);
+  EXPECT_FALSE(std::filesystem::exists(old_path));
+  EXPECT_FALSE(lsm.Get(events, "old").has_value());
+  EXPECT_EQ(lsm.Get(events, "new"), "value");
+}
+
+TEST_F(LSMTest, BlobFiles) {
+  ColumnFamilyOptions options;
+  options.enable_blob_files = true;
+  options.blob_garbage_collection_age_cutoff = 0.5;
+  options.merge_operator = std::make_shared<StringAppendOperator>(",");
+  std::map<std::string, std::string> reference;
+  auto dir_bytes = [this](const std::string &prefix) {
+    size_t total = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(test_dir_ + "/cf_docs")) {
+      if (entry.path().filename().string().rfind(prefix, 0) == 0) {
+        total += std::filesystem::file_size(entry.path());
+      }
+    }
+    return total;
+  };
+  {
+    LSM lsm(test_dir_);
+    auto *docs = lsm.CreateColumnFamily("docs", options);
+    // 大于 64KB 的 value 也可以写入, SST 只保存 blob 索引
+    const size_t sizes[] = {100, 4096, 16 * 1024, 60 * 1024, 100 * 1024};
+    for (int i = 0; i < 100; i++) {
+      std::string key = "doc" + std::to_string(1000 + i);
+      std::string value = std::to_string(i) + std::string(sizes[i % 5], static_cast<char>('a' + i % 26));
+      lsm.Put(docs, key, value);
+      reference[key] = value;
+    }
+    lsm.Flush(docs);
+    auto *cf = lsm.GetColumnFamily("docs");
+    EXPECT_EQ(cf->GetBlobFileCount(), 1);
+    EXPECT_LT(dir_bytes("sst_") * 50, dir_bytes("blob_"));
+    for (const auto &[key, value] : reference) {
+      EXPECT_EQ(lsm.Get(docs, key), value) << key;
+    }
+
+    // 覆盖写和删除在旧 blob 文件中留下垃圾
+    for (int i = 0; i < 100; i += 2) {
+      std::string key = "doc" + std::to_string(1000 + i);
+      if (i % 4 == 0) {
+        lsm.Remove(docs, key);
+        reference.erase(key);
+      } else {
+        reference[key] = "new" + std::string(8192, 'n');
+        lsm.Put(docs, key, reference[key]);
+      }
+    }
+    // merge 的基值在 blob 文件中
+    lsm.Merge(docs, "doc1001", "tail");
+    reference["doc1001"] += ",tail";
+    lsm.Flush(docs);
+    EXPECT_EQ(cf->GetBlobFileCount(), 2);
+    EXPECT_EQ(lsm.Get(docs, "doc1001"), reference["doc1001"]);
+    auto blob_bytes = dir_bytes("blob_");
+
+    // 迭代器在 GC 删除 blob 文件后仍然可以读取
+    auto it = lsm.Begin(docs);
+    lsm.Compact(docs);
+    // 较老的一半 blob 文件被重写后删除
+    EXPECT_EQ(cf->GetBlobFileCount(), 2);
+    EXPECT_LT(dir_bytes("blob_"), blob_bytes * 3 / 4);
+    auto expected = reference.begin();
+    for (; it != lsm.End(); ++it, ++expected) {
+      ASSERT_NE(expected, reference.end());
+      EXPECT_EQ(it->first, expected->first);
+      EXPECT_EQ(it->second, expected->second);
+    }
+    EXPECT_EQ(expected, reference.end());
+    std::vector<std::string> keys;
+    for (const auto &[key, value] : reference) {
+      keys.push_back(key);
+    }
+    auto values = lsm.MultiGet(docs, keys);
+    for (size_t i = 0; i < keys.size(); i++) {
+      EXPECT_EQ(values[i], reference[keys[i]]) << keys[i];
+    }
+  }
+
+  // 重新打开后 blob 文件仍然可读
+  LSM lsm(test_dir_);
+  auto *docs = lsm.CreateColumnFamily("docs", options);
+  for (int i = 0; i < 100; i++) {
+    std::string key = "doc" + std::to_string(1000 + i);
+    auto it = reference.find(key);
+    if (it == reference.end()) {
+      EXPECT_FALSE(lsm.Get(docs, key).has_value()) << key;
+    } else {
+      EXPECT_EQ(lsm.Get(docs, key), it->second) << key;
+    }
+  }
+  size_t count = 0;
+  for (auto it = lsm.Begin(docs); it != lsm.End(); ++it) {
+    EXPECT_EQ(it->second, reference[it->first]);
+    count++;
+  }
+  EXPECT_EQ(count, reference.size());
+}
+
+TEST_F(LSMTest, SetOptions) {
+  Options options;
+  options.write_buffer_size = 64 * 1024;
+  options.db_write_buffer_size = 256 * 1024;
+  options.compaction_style = CompactionStyle::kUniversal;
+  options.level0_file_num_compaction_trigger = 100;
+  options.block_cache_capacity = 64;
+  LSM lsm(test_dir_, options);
+  auto *cf = lsm.DefaultColumnFamily();
+  auto count_ssts = [this]() {
+    size_t count = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(test_dir_)) {
+      count += entry.path().filename().string().rfind("sst_", 0) == 0 ? 1 : 0;
+    }
+    return count;
+  };
+
+  // memtable 和写缓冲的大小由 Options 决定, 不需要重新编译
+  std::string value(1024, 'v');
+  for (int i = 0; i < 1000; i++) {
+    lsm.Put("key" + std::to_string(i), value);
+  }
+  size_t ssts = count_ssts();
+  EXPECT_GT(ssts, 4);
+  EXPECT_EQ(lsm.GetDBOptions().block_cache_capacity, 64);
+
+  // 运行中降低合并阈值, 下一次 flush 触发合并
+  lsm.SetOptions(cf, {{"level0_file_num_compaction_trigger", "2"}, {"write_buffer_size", "1048576"}});
+  EXPECT_EQ(cf->GetOptions().level0_file_num_compaction_trigger, 2);
+  EXPECT_EQ(cf->GetOptions().write_buffer_size, 1048576);
+  EXPECT_EQ(lsm.GetDBOptions().level0_file_num_compaction_trigger, 2);
+  EXPECT_EQ(lsm.GetDBOptions().write_buffer_size, 1048576);
+  lsm.Put("key", value);
+  lsm.Flush();
+  EXPECT_LT(count_ssts(), ssts);
+  EXPECT_THROW(lsm.SetOptions(cf, {{"compaction_style", "0"}}), std::invalid_argument);
+
+  lsm.SetDBOptions({{"block_cache_capacity", "4"}, {"row_cache_capacity", "4096"}, {"db_write_buffer_size", "1"}});
+  EXPECT_EQ(lsm.GetDBOptions().block_cache_capacity, 4);
+  EXPECT_EQ(lsm.GetRowCache().GetCapacity(), 4096);
+  EXPECT_EQ(lsm.GetWriteBufferManager().GetBufferSize(), 1);
+  EXPECT_THROW(lsm.SetDBOptions({{"table_cache_capacity", "8"}}), std::invalid_argument);
+  for (int i = 0; i < 1000; i += 7) {
+    EXPECT_EQ(lsm.Get("key" + std::to_string(i)), value);
+  }
+}
+
+TEST_F(LSMTest, WriteAheadLog) {
+  ColumnFamilyOptions list_options;
+  list_options.merge_operator = std::make_shared<StringAppendOperator>(",");
+  std::string crashed_dir = test_dir_ + "_crashed";
+  // 引擎打开时复制数据目录, 相当于进程在此刻崩溃
+  auto crash = [](const std::string &from, const std::string &to) {
+    std::filesystem::remove_all(to);
+    std::filesystem::copy(from, to, std::filesystem::copy_options::recursive);
+  };
+  auto count_logs = [](const std::string &dir) {
+    size_t count = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(dir + "/wal")) {
+      count += entry.path().filename().string().rfind("log_", 0) == 0 ? 1 : 0;
+    }
+    return count;
+  };
+
+  {
+    LSM lsm(test_dir_, list_options);
+    auto *events = lsm.CreateColumnFamily("events");
+    lsm.Put("list", "a");
+    lsm.Merge("list", "b");
+    lsm.Flush();
+    // 以下写入只在日志中
+    lsm.Merge("list", "c");
+    for (int i = 0; i < 100; i++) {
+      lsm.Put(events, "event" + std::to_string(i), "value" + std::to_string(i));
+    }
+    lsm.Remove(events, "event7");
+    WriteBatch batch;
+    batch.Put("batch", "1");
+    batch.Merge("list", "d");
+    batch.Remove(events, "event8");
+    lsm.Write(batch, WriteOptions{true, false});
+    lsm.Put("unlogged", "x", WriteOptions{false, true});
+    crash(test_dir_, crashed_dir);
+  }
+
+  std::string crashed_again_dir = test_dir_ + "_crashed_again";
+  {
+    LSM lsm(crashed_dir, list_options);
+    // 已 flush 的操作数不会重放第二次
+    EXPECT_EQ(lsm.Get("list"), "a,b,c,d");
+    EXPECT_EQ(lsm.Get("batch"), "1");
+    EXPECT_FALSE(lsm.Get("unlogged").has_value());
+
+    // 未打开的列族在打开时重放, 之前的日志保留到那时
+    lsm.Put("after", "recovery");
+    lsm.Flush();
+    EXPECT_GE(count_logs(crashed_dir), 2);
+    auto *events = lsm.CreateColumnFamily("events");
+    for (int i = 0; i < 100; i++) {
+      auto value = lsm.Get(events, "event" + std::to_string(i));
+      if (i == 7 || i == 8) {
+        EXPECT_FALSE(value.has_value());
+      } else {
+        EXPECT_EQ(value, "value" + std::to_string(i));
+      }
+    }
+    lsm.FlushAll();
+    EXPECT_EQ(count_logs(crashed_dir), 1);
+
+    lsm.Merge("list", "e");
+    crash(crashed_dir, crashed_again_dir);
+  }
+  {
+    LSM lsm(crashed_again_dir, list_options);
+    auto *events = lsm.CreateColumnFamily("events");
+    EXPECT_EQ(lsm.Get("list"), "a,b,c,d,e");
+    EXPECT_EQ(lsm.Get("after"), "recovery");
+    EXPECT_EQ(lsm.Get(events, "event42"), "value42");
+    EXPECT_FALSE(lsm.Get(events, "event8").has_value());
+  }
+
+  // 删除后重建的列族不重放旧的写入
+  {
+    LSM lsm(crashed_again_dir, list_options);
+    auto *events = lsm.CreateColumnFamily("events");
+    lsm.Put(events, "event1000", "new");
+    lsm.DropColumnFamily("events");
+    events = lsm.CreateColumnFamily("events");
+    EXPECT_FALSE(lsm.Get(events, "event1000").has_value());
+    crash(crashed_again_dir, crashed_dir);
+  }
+  {
+    LSM lsm(crashed_dir, list_options);
+    auto *events = lsm.CreateColumnFamily("events");
+    EXPECT_FALSE(lsm.Get(events, "event1000").has_value());
+    EXPECT_FALSE(lsm.Get(events, "event42").has_value());
+  }
+
+  // 日志写满后切换到新文件, flush 之后删除旧文件
+  Options options(list_options);
+  options.max_wal_file_size = 16 * 1024;
+  options.write_buffer_size = 64 * 1024;
+  options.db_write_buffer_size = 256 * 1024;
+  {
+    LSM lsm(crashed_dir, options);
+    std::string value(1024, 'v');
+    for (int i = 0; i < 1000; i++) {
+      lsm.Put("key" + std::to_string(i), value);
+    }
+    // 只保留还没有 flush 的写入所在的日志
+    EXPECT_LE(count_logs(crashed_dir), 256 / 16 + 2);
+    lsm.FlushAll();
+    EXPECT_EQ(count_logs(crashed_dir), 1);
+  }
+  std::filesystem::remove_all(crashed_dir);
+  std::filesystem::remove_all(crashed_again_dir);
+}
+
+TEST_F(LSMTest, GroupCommit) {
+  LSM lsm(test_dir_);
+  // 并发的同步写入由 leader 合并写入日志
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&lsm, t]() {
+      for (int i = 0; i < 100; i++) {
+        lsm.Put("key" + std::to_string(t) + "_" + std::to_string(i), std::string(4096, 'v'), WriteOptions{true, false});
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto stats = lsm.GetWriteQueue().GetStats();
+  EXPECT_EQ(stats.writes, 800);
+  // 一个 leader 同步日志时, 其余线程的写入在队列中排队, 至少有一组包含多个写入
+  EXPECT_LT(stats.groups, stats.writes);
+  for (int t = 0; t < 8; t++) {
+    EXPECT_EQ(lsm.Get("key" + std::to_string(t) + "_99"), std::string(4096, 'v'));
+  }
+}
+
+TEST_F(LSMTest, HashTableMemtable) {
+  std::map<std::string, std::string> reference;
+  {
+    LSM lsm(test_dir_);
+    ColumnFamilyOptions options;
+    options.memtable_rep = MemTableRepType::kHashTable;
+    options.write_buffer_size = 16 * 1024;
+    auto *cf = lsm.CreateColumnFamily("hash", options);
+    // 哈希表 memtable 按 key 排序后 flush, 与 SST 中的数据一起读取
+    for (int i = 0; i < 2000; i++) {
+      std::string key = "key" + std::to_string(i * 7919 % 2000);
+      lsm.Put(cf, key, "value" + std::to_string(i));
+      reference[key] = "value" + std::to_string(i);
+    }
+    for (int i = 0; i < 2000; i += 5) {
+      std::string key = "key" + std::to_string(i);
+      lsm.Remove(cf, key);
+      reference.erase(key);
+    }
+    EXPECT_EQ(lsm.Get(cf, "key1"), reference["key1"]);
+    EXPECT_FALSE(lsm.Get(cf, "key5").has_value());
+    std::vector<std::pair<std::string, std::string>> entries;
+    for (auto it = lsm.Begin(cf); !it.IsEnd(); ++it) {
+      entries.push_back(*it);
+    }
+    EXPECT_EQ(entries, (std::vector<std::pair<std::string, std::string>>(reference.begin(), reference.end())));
+    lsm.Flush(cf);
+  }
+
+  LSM lsm(test_dir_);
+  ColumnFamilyOptions options;
+  options.memtable_rep = MemTableRepType::kHashTable;
+  auto *cf = lsm.CreateColumnFamily("hash", options);
+  for (const auto &[key, value] : reference) {
+    EXPECT_EQ(lsm.Get(cf, key), value);
+  }
+  std::vector<std::pair<std::string, std::string>> entries;
+  for (auto it = lsm.ScanPrefix(cf, "key19"); !it.IsEnd(); ++it) {
+    entries.push_back(*it);
+  }
+  EXPECT_EQ(entries.size(), 89);
+}
+
+TEST_F(LSMTest, VectorMemtable) {
+  std::map<std::string, std::string> reference;
+  {
+    LSM lsm(test_dir_);
+    ColumnFamilyOptions options;
+    options.memtable_rep = MemTableRepType::kVector;
+    options.write_buffer_size = 16 * 1024;
+    auto *cf = lsm.CreateColumnFamily("vector", options);
+    // 向量 memtable 追加写入, flush 时排序, 同一个 key 只写入最新的版本
+    for (int round = 0; round < 3; round++) {
+      for (int i = 0; i < 2000; i++) {
+        std::string key = "key" + std::to_string(i * 7919 % 2000);
+        lsm.Put(cf, key, "value" + std::to_string(round) + "_" + std::to_string(i));
+        reference[key] = "value" + std::to_string(round) + "_" + std::to_string(i);
+      }
+    }
+    for (int i = 0; i < 2000; i += 5) {
+      std::string key = "key" + std::to_string(i);
+      lsm.Remove(cf, key);
+      reference.erase(key);
+    }
+    EXPECT_EQ(lsm.Get(cf, "key1"), reference["key1"]);
+    EXPECT_FALSE(lsm.Get(cf, "key5").has_value());
+    std::vector<std::pair<std::string, std::string>> entries;
+    for (auto it = lsm.Begin(cf); !it.IsEnd(); ++it) {
+      entries.push_back(*it);
+    }
+    EXPECT_EQ(entries, (std::vector<std::pair<std::string, std::string>>(reference.begin(), reference.end())));
+    lsm.Flush(cf);
+  }
+
+  LSM lsm(test_dir_);
+  ColumnFamilyOptions options;
+  options.memtable_rep = MemTableRepType::kVector;
+  auto *cf = lsm.CreateColumnFamily("vector", options);
+  for (const auto &[key, value] : reference) {
+    EXPECT_EQ(lsm.Get(cf, key), value);
+  }
+  std::vector<std::pair<std::string, std::string>> entries;
+  for (auto it = lsm.ScanPrefix(cf, "key19"); !it.IsEnd(); ++it) {
+    entries.push_back(*it);
+  }
+  EXPECT_EQ(entries.size(), 89);
+}
+
+TEST_F(LSMTest, FlushCrash) {
+  ColumnFamilyOptions list_options;
+  list_options.merge_operator = std::make_shared<StringAppendOperator>(",");
+  std::string crashed_dir = test_dir_ + "_crashed";
+  std::string crashed_again_dir = test_dir_ + "_crashed_again";
+  auto crash = [](const std::string &from, const std::string &to) {
+    std::filesystem::remove_all(to);
+    std::filesystem::copy(from, to, std::filesystem::copy_options::recursive);
+  };
+
+  {
+    LSM lsm(test_dir_, list_options);
+    lsm.Merge("list", "a");
+    lsm.Merge("list", "b");
+    // 目录占住 flushed sequence 的临时文件, flush 在 SST 写完之后、记录 flushed sequence 之前失败
+    std::filesystem::create_directories(test_dir_ + "/wal/tmp_flushed_default/blocked");
+    EXPECT_THROW(lsm.Flush(), std::runtime_error);
+    crash(test_dir_, crashed_dir);
+    std::filesystem::remove_all(test_dir_ + "/wal/tmp_flushed_default");
+    std::filesystem::remove_all(crashed_dir + "/wal/tmp_flushed_default");
+  }
+  {
+    // 没有记录 flushed sequence 的 SST 被丢弃, 操作数只从日志重放一次
+    LSM lsm(crashed_dir, list_options);
+    EXPECT_EQ(lsm.Get("list"), "a,b");
+    lsm.Merge("list", "c");
+    lsm.Flush();
+    crash(crashed_dir, crashed_again_dir);
+  }
+
+  // 记录了 flushed sequence 但 SST 还没有改名时崩溃: 恢复时改名, 日志不再重放
+  std::string last_sst;
+  for (const auto &entry : std::filesystem::directory_iterator(crashed_again_dir)) {
+    auto filename = entry.path().filename().string();
+    if (filename.rfind("sst_", 0) == 0) {
+      last_sst = std::max(last_sst, filename);
+    }
+  }
+  ASSERT_FALSE(last_sst.empty());
+  std::filesystem::rename(crashed_again_dir + "/" + last_sst, crashed_again_dir + "/tmp_" + last_sst);
+  {
+    LSM lsm(crashed_again_dir, list_options);
+    EXPECT_EQ(lsm.Get("list"), "a,b,c");
+  }
+  std::filesystem::remove_all(crashed_dir);
+  std::filesystem::remove_all(crashed_again_dir);
+}
+
+TEST_F(LSMTest, CompactionCrash) {
+  ColumnFamilyOptions list_options;
+  list_options.merge_operator = std::make_shared<StringAppendOperator>(",");
+  std::string crashed_dir = test_dir_ + "_crashed";
+  std::string crashed_again_dir = test_dir_ + "_crashed_again";
+  auto crash = [](const std::string &from, const std::string &to) {
+    std::filesystem::remove_all(to);
+    std::filesystem::copy(from, to, std::filesystem::copy_options::recursive);
+  };
+  auto list_files = [](const std::string &dir, const std::string &prefix) {
+    std::vector<std::string> res;
+    for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+      auto filename = entry.path().filename().string();
+      if (entry.is_regular_file() && filename.rfind(prefix, 0) == 0) {
+        res.push_back(filename);
+      }
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+  };
+
+  std::vector<std::string> inputs;
+  {
+    LSM lsm(test_dir_, list_options);
+    for (std::string operand : {"a", "b", "c"}) {
+      lsm.Merge("list", operand);
+      lsm.Flush();
+    }
+    inputs = list_files(test_dir_, "sst_");
+    ASSERT_EQ(inputs.size(), 3);
+    // 目录占住 compaction 记录的临时文件, compaction 在输出写完之后、记录之前失败
+    std::filesystem::create_directories(test_dir_ + "/wal/tmp_compaction_default/blocked");
+    EXPECT_THROW(lsm.Compact(), std::runtime_error);
+    crash(test_dir_, crashed_dir);
+    std::filesystem::remove_all(test_dir_ + "/wal/tmp_compaction_default");
+    std::filesystem::remove_all(crashed_dir + "/wal/tmp_compaction_default");
+
+    // 失败的 compaction 占用了输出的 id, 重试的输出取下一个 id. 目录占住输出的文件名, 在记录之后、改名时失败
+    auto tmp_ssts = list_files(test_dir_, "tmp_sst_");
+    ASSERT_EQ(tmp_ssts.size(), 1);
+    auto width = tmp_ssts[0].size() - std::strlen("tmp_sst_");
+    auto output_id = std::to_string(std::stoul(tmp_ssts[0].substr(std::strlen("tmp_sst_"))) + 1);
+    auto output = "sst_" + std::string(width - output_id.size(), '0') + output_id;
+    std::filesystem::create_directories(test_dir_ + "/" + output + "/blocked");
+    EXPECT_THROW(lsm.Compact(), std::runtime_error);
+    crash(test_dir_, crashed_again_dir);
+    std::filesystem::remove_all(test_dir_ + "/" + output);
+    std::filesystem::remove_all(crashed_again_dir + "/" + output);
+    EXPECT_EQ(list_files(crashed_again_dir + "/wal", "compaction_").size(), 1);
+
+    // 没有记录的输出被丢弃, 输入保留
+    LSM crashed(crashed_dir, list_options);
+    EXPECT_EQ(list_files(crashed_dir, "sst_"), inputs);
+    EXPECT_TRUE(list_files(crashed_dir, "tmp_sst_").empty());
+    EXPECT_EQ(crashed.Get("list"), "a,b,c");
+
+    // 记录了的输出改名, 输入删除, 操作数只出现一次
+    LSM crashed_again(crashed_again_dir, list_options);
+    EXPECT_EQ(list_files(crashed_again_dir, "sst_"), std::vector<std::string>{output});
+    EXPECT_TRUE(list_files(crashed_again_dir, "tmp_sst_").empty());
+    EXPECT_TRUE(list_files(crashed_again_dir + "/wal", "compaction_").empty());
+    EXPECT_EQ(crashed_again.Get("list"), "a,b,c");
+  }
+  std::filesystem::remove_all(crashed_dir);
+  std::filesystem::remove_all(crashed_again_dir);
+}
+
+TEST_F(LSMTest, ConcurrentMergeFlush) {
+  ColumnFamilyOptions list_options;
+  list_options.merge_operator = std::make_shared<StringAppendOperator>(",");
+  LSM lsm(test_dir_, list_options);
+  // 操作数在 Merge() 返回之前就可以读到, 读到的个数在读之前写完的和读之后开始写的之间
+  std::atomic<int> started{0};
+  std::atomic<int> written{0};
+  std::atomic<bool> done{false};
+  auto count = [](const std::optional<std::string> &value) {
+    return value.has_value() ? static_cast<int>(std::count(value->begin(), value->end(), ',')) + 1 : 0;
+  };
+
+  // 读者在 flush 把冻结的 memtable 换成 SST 的同时读取, 每个操作数只能看到一次
+  std::vector<std::thread> readers;
+  std::atomic<int> errors{0};
+  for (int t = 0; t < 3; t++) {
+    readers.emplace_back([&, t]() {
+      while (!done) {
+        int before = written;
+        int seen = 0;
+        if (t == 0) {
+          seen = count(lsm.Get("list"));
+        } else if (t == 1) {
+          seen = count(lsm.MultiGet({"list", "other"})[0]);
+        } else {
+          auto it = lsm.Seek("list");
+          seen = !it.IsEnd() && it->first == "list" ? count(it->second) : 0;
+        }
+        int after = started;
+        if (seen < before || seen > after) {
+          errors++;
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 300; i++) {
+    started++;
+    lsm.Merge("list", std::to_string(i));
+    written++;
+    if (i % 10 == 9) {
+      lsm.Flush();
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(errors, 0);
+  EXPECT_EQ(count(lsm.Get("list")), 300);
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
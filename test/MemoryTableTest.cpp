@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include <memoryTable/MemoryTable.h>
+#include <atomic>
+#include <map>
+#include <memory>
 #include <string>
 #include <thread>
 #include <utility>
@@ -186,6 +189,20 @@ TEST(MemTableTest, IteratorComplexOperations) {
   EXPECT_TRUE(res.value().empty());
 }
 
+TEST(MemTableTest, IteratorOutlivesTable) {
+  auto memtable = std::make_unique<MemoryTable>();
+  memtable->Put("key1", "value1");
+  memtable->Put("key2", "value2");
+  auto it = memtable->Begin();
+  // 迭代器持有活跃表及其锁, 内存表析构后仍可继续遍历
+  memtable.reset();
+  std::vector<std::string> keys;
+  for (; !it.IsEnd(); ++it) {
+    keys.push_back((*it).first);
+  }
+  EXPECT_EQ(keys, std::vector<std::string>({"key1", "key2"}));
+}
+
 TEST(MemTableTest, ConcurrentOperations) {
   MemoryTable memtable;
   const int num_readers = 4;        // 读线程数
@@ -394,6 +411,213 @@ TEST(MemTableTest, PreffixIter) {
   }
 }
 
+// 测试 write buffer manager 统计所有 memtable 的内存
+TEST(MemTableTest, WriteBufferManager) {
+  WriteBufferManager manager(1024 * 1024);
+  {
+    MemoryTable memtable1(&manager);
+    MemoryTable memtable2(&manager);
+    size_t empty_bytes = manager.MemoryUsage();
+    EXPECT_EQ(empty_bytes, memtable1.GetAllocatedBytes() + memtable2.GetAllocatedBytes());
+
+    for (int i = 0; i < 100; i++) {
+      memtable1.Put("key" + std::to_string(i), "value" + std::to_string(i));
+      memtable2.Put("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    EXPECT_EQ(manager.MemoryUsage(), memtable1.GetAllocatedBytes() + memtable2.GetAllocatedBytes());
+    EXPECT_GT(memtable1.GetAllocatedBytes(), memtable1.GetTotalSize());
+    EXPECT_FALSE(manager.ShouldFlush(0));
+
+    // 冻结的表在 flush 之前仍然计入
+    memtable1.FrozenCurrentTable();
+    EXPECT_EQ(manager.MemoryUsage(), memtable1.GetAllocatedBytes() + memtable2.GetAllocatedBytes());
+    memtable1.ReleaseLast();
+    EXPECT_EQ(manager.MemoryUsage(), memtable1.GetAllocatedBytes() + memtable2.GetAllocatedBytes());
+    memtable2.Clear();
+    EXPECT_EQ(manager.MemoryUsage(), empty_bytes);
+
+    while (!manager.ShouldFlush(0)) {
+      memtable1.Put("key" + std::to_string(manager.MemoryUsage()), "value");
+    }
+    EXPECT_GE(manager.MemoryUsage(), 1024 * 1024);
+  }
+  EXPECT_EQ(manager.MemoryUsage(), 0);
+}
+
+// 测试内存预算: 先缩小 block cache, 再触发 flush
+TEST(MemTableTest, MemoryBudget) {
+  auto block_cache = std::make_shared<BlockCache>(1024, 2);
+  for (int i = 0; i < 100; i++) {
+    auto block = std::make_shared<Block>(4096);
+    block->AddEntry("key" + std::to_string(i), std::string(1000, 'v'));
+    block_cache->Put(1, i, block);
+  }
+  size_t cache_bytes = block_cache->GetUsageBytes();
+  EXPECT_GT(cache_bytes, 100 * 1000);
+
+  WriteBufferManager manager(64 * 1024 * 1024, 0, block_cache);
+  MemoryTable memtable(&manager);
+  EXPECT_FALSE(manager.ShouldFlush(0));
+  manager.SetMemoryBudget(cache_bytes + 100 * 1024);
+  EXPECT_FALSE(manager.ShouldFlush(0));
+  EXPECT_EQ(block_cache->GetUsageBytes(), cache_bytes);
+
+  // memtable 和 SST 的内存挤占 block cache
+  for (int i = 0; i < 500; i++) {
+    memtable.Put("key" + std::to_string(i), "value" + std::to_string(i));
+  }
+  EXPECT_FALSE(manager.ShouldFlush(20 * 1024));
+  EXPECT_LT(block_cache->GetUsageBytes(), cache_bytes);
+  EXPECT_LE(block_cache->GetUsageBytes() + manager.MemoryUsage() + 20 * 1024, manager.GetMemoryBudget());
+
+  // 超出预算时 flush
+  EXPECT_TRUE(manager.ShouldFlush(manager.GetMemoryBudget()));
+  EXPECT_EQ(block_cache->GetUsageBytes(), 0);
+  manager.SetMemoryBudget(0);
+  EXPECT_FALSE(manager.ShouldFlush(manager.GetMemoryBudget()));
+}
+
+// 测试哈希表实现: 点查与跳表一致, 有序读取时才排序
+TEST(MemTableTest, HashTableRep) {
+  MemoryTable memtable(nullptr, LSM_PER_MEM_SIZE_LIMIT, MemTableRepType::kHashTable);
+
+  memtable.Put("key3", "value3");
+  memtable.Put("key1", "value1");
+  memtable.Put("key2", "value2");
+  memtable.Put("key1", "value1_updated");
+  EXPECT_EQ(memtable.Get("key1").value(), "value1_updated");
+  EXPECT_FALSE(memtable.Get("nonexistent").has_value());
+  EXPECT_EQ(memtable.GetCurSize(), 3 * 4 + 6 + 6 + 14);
+
+  // 冻结后在新的哈希表中更新和删除
+  memtable.FrozenCurrentTable();
+  memtable.Put("key0", "value0");
+  memtable.Remove("key2");
+  memtable.Put("key3", "value3_new");
+  memtable.Put("other", "x");
+  EXPECT_TRUE(memtable.Get("key2").value().empty());
+  EXPECT_EQ(memtable.Get("key3").value(), "value3_new");
+
+  // 迭代器按 key 有序, 较新的表覆盖较旧的表
+  std::vector<std::pair<std::string, std::string>> result;
+  for (auto it = memtable.Begin(); it != memtable.End(); ++it) {
+    result.push_back(*it);
+  }
+  std::vector<std::pair<std::string, std::string>> expected{
+      {"key0", "value0"}, {"key1", "value1_updated"}, {"key3", "value3_new"}, {"other", "x"}};
+  EXPECT_EQ(result, expected);
+
+  // 迭代器读取创建时的数据, 之后的写入使排序结果失效
+  auto iters = memtable.NewIterators();
+  memtable.Put("key00", "value00");
+  iters[0]->SeekToFirst();
+  EXPECT_EQ(iters[0]->GetKey(), "key0");
+  iters[0]->Next();
+  EXPECT_EQ(iters[0]->GetKey(), "key2");
+
+  std::vector<std::string> keys;
+  for (auto it = memtable.ItersPreffix("key0"); !it.IsEnd(); ++it) {
+    keys.push_back(it->first);
+  }
+  EXPECT_EQ(keys, (std::vector<std::string>{"key0", "key00"}));
+
+  auto range = memtable.ItersMonotonyPredicate([](const std::string &key) {
+    if (key < "key1") {
+      return 1;
+    }
+    return key > "key3" ? -1 : 0;
+  });
+  ASSERT_TRUE(range.has_value());
+  keys.clear();
+  for (auto it = range->first; it != range->second; ++it) {
+    keys.push_back(it->first);
+  }
+  EXPECT_EQ(keys, (std::vector<std::string>{"key1", "key3"}));
+}
+
+// 测试向量实现: 写入只追加, flush 时并行排序并保留每个 key 的最新版本
+TEST(MemTableTest, VectorRep) {
+  MemoryTable memtable(nullptr, 64 * 1024 * 1024, MemTableRepType::kVector);
+
+  // 排序之前 Get 从最新的条目开始扫描
+  memtable.Put("key2", "value2");
+  memtable.Put("key1", "value1");
+  memtable.Put("key2", "value2_updated");
+  memtable.Remove("key1");
+  EXPECT_EQ(memtable.Get("key2").value(), "value2_updated");
+  EXPECT_TRUE(memtable.Get("key1").value().empty());
+  EXPECT_FALSE(memtable.Get("key3").has_value());
+  EXPECT_EQ(memtable.GetCurSize(), 4 * 4 + 6 + 6 + 14);
+
+  // 足够多的条目由多个线程排序, 结果与 std::map 一致
+  std::map<std::string, std::string> reference{{"key1", ""}, {"key2", "value2_updated"}};
+  for (int i = 0; i < 200000; i++) {
+    std::string key = "bulk" + std::to_string(i * 7919 % 50000);
+    memtable.Put(key, std::to_string(i));
+    reference[key] = std::to_string(i);
+  }
+  size_t allocated = memtable.GetAllocatedBytes();
+  memtable.FrozenCurrentTable();
+  EXPECT_EQ(memtable.GetAllocatedBytes() - memtable.GetCurSize(), allocated);
+  memtable.Put("key3", "value3");
+  reference["key3"] = "value3";
+  // 未 flush 的冻结表按写入顺序扫描, 抽查一部分 key
+  size_t checked = 0;
+  for (const auto &[key, value] : reference) {
+    if (checked++ % 97 == 0 || key.rfind("key", 0) == 0) {
+      EXPECT_EQ(memtable.Get(key).value(), value);
+    }
+  }
+  EXPECT_FALSE(memtable.Get("bulk").has_value());
+
+  auto iters = memtable.NewIterators();
+  ASSERT_EQ(iters.size(), 2);
+  size_t count = 0;
+  auto expected = reference.begin();
+  for (iters[1]->SeekToFirst(); iters[1]->IsValid(); iters[1]->Next()) {
+    if (expected->first == "key3") {
+      ++expected;
+    }
+    ASSERT_EQ(iters[1]->GetKey(), expected->first);
+    ASSERT_EQ(iters[1]->GetValue(), expected->second);
+    ++expected;
+    count++;
+  }
+  EXPECT_EQ(count, reference.size() - 1);
+
+  std::vector<std::string> keys;
+  for (auto it = memtable.ItersPreffix("key"); !it.IsEnd(); ++it) {
+    keys.push_back(it->first);
+  }
+  EXPECT_EQ(keys, (std::vector<std::string>{"key2", "key3"}));
+
+  // flush 在 memtable 的锁之外排序, 排序期间冻结的表仍可读取, 之后二分查找
+  VectorRep rep;
+  for (int i = 0; i < 100000; i++) {
+    rep.Put("key" + std::to_string(i % 1000), std::to_string(i));
+  }
+  std::atomic<bool> sorted{false};
+  std::thread reader([&rep, &sorted]() {
+    while (!sorted) {
+      EXPECT_EQ(rep.Get("key7").value(), "99007");
+    }
+  });
+  rep.PrepareFlush();
+  sorted = true;
+  reader.join();
+  EXPECT_EQ(rep.Get("key7").value(), "99007");
+  EXPECT_FALSE(rep.Get("key1000").has_value());
+  size_t sorted_count = 0;
+  std::string last_key;
+  auto iter = rep.NewIterator(nullptr);
+  for (iter->SeekToFirst(); iter->IsValid(); iter->Next()) {
+    EXPECT_LT(last_key, iter->GetKey());
+    last_key = iter->GetKey();
+    sorted_count++;
+  }
+  EXPECT_EQ(sorted_count, 1000);
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <lsm/RowCache.h>
+#include <stdexcept>
+#include <string>
+
+TEST(RowCacheTest, BasicOperations) {
+  RowCache cache(1024 * 1024, 4);
+  EXPECT_FALSE(cache.Get("key").has_value());
+
+  cache.Insert("key", "value", cache.GetGeneration("key"));
+  auto res = cache.Get("key");
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res.value(), "value");
+
+  // 不存在的 key 也可以缓存
+  cache.Insert("absent", std::nullopt, cache.GetGeneration("absent"));
+  res = cache.Get("absent");
+  ASSERT_TRUE(res.has_value());
+  EXPECT_FALSE(res.value().has_value());
+
+  cache.Erase("key");
+  EXPECT_FALSE(cache.Get("key").has_value());
+  EXPECT_DOUBLE_EQ(cache.GetHitRate(), 0.5);
+
+  // 分片数为 0 时拒绝创建
+  EXPECT_THROW(RowCache(1024, 0), std::invalid_argument);
+}
+
+TEST(RowCacheTest, StaleInsert) {
+  RowCache cache(1024 * 1024, 4);
+  // 读开始之后发生了写, 读到的结果不能进入缓存
+  auto generation = cache.GetGeneration("key");
+  cache.Erase("key");
+  cache.Insert("key", "old", generation);
+  EXPECT_FALSE(cache.Get("key").has_value());
+
+  cache.Insert("key", "new", cache.GetGeneration("key"));
+  EXPECT_EQ(cache.Get("key").value(), "new");
+}
+
+TEST(RowCacheTest, Eviction) {
+  RowCache cache(16 * 1024, 1);
+  std::string value(100, 'v');
+  for (int i = 0; i < 1000; i++) {
+    auto key = "key" + std::to_string(i);
+    cache.Insert(key, value, cache.GetGeneration(key));
+    EXPECT_LE(cache.GetUsage(), cache.GetCapacity());
+  }
+  // 最近插入的 key 还在, 最早的已经被淘汰
+  EXPECT_TRUE(cache.Get("key999").has_value());
+  EXPECT_FALSE(cache.Get("key0").has_value());
+
+  // 最近访问的 key 不会被淘汰
+  auto hot = cache.Get("key990");
+  ASSERT_TRUE(hot.has_value());
+  for (int i = 1000; i < 1050; i++) {
+    auto key = "key" + std::to_string(i);
+    cache.Insert(key, value, cache.GetGeneration(key));
+    cache.Get("key990");
+  }
+  EXPECT_TRUE(cache.Get("key990").has_value());
+
+  // 超过分片容量的条目不缓存
+  cache.Insert("large", std::string(32 * 1024, 'v'), cache.GetGeneration("large"));
+  EXPECT_FALSE(cache.Get("large").has_value());
+
+  // 缩小容量时淘汰最久未访问的条目
+  cache.SetCapacity(4 * 1024);
+  EXPECT_EQ(cache.GetCapacity(), 4 * 1024);
+  EXPECT_LE(cache.GetUsage(), 4 * 1024);
+  EXPECT_TRUE(cache.Get("key990").has_value());
+  EXPECT_FALSE(cache.Get("key1000").has_value());
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -2,6 +2,7 @@
 #include <sst/SSTIterator.h>
 #include <utils/Macro.h>
 #include <filesystem>
+#include <fstream>
 
 class SSTTest : public ::testing::Test {
  protected:
@@ -214,6 +215,451 @@ TEST_F(SSTTest, LargeSSTPredicate) {
   EXPECT_EQ(iter_end.GetKey(), "key501");
 }
 
+// 测试 SSTIterator::Seek 跨 block 定位
+TEST_F(SSTTest, IteratorSeek) {
+  SSTBuilder builder(256);
+  auto block_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  for (int i = 0; i < 1000; i += 2) {
+    char key[8];
+    snprintf(key, sizeof(key), "key%03d", i);
+    builder.Add(key, "value" + std::to_string(i));
+  }
+  auto sst = builder.Build(1, "test_data/seek.sst", block_cache);
+  ASSERT_GT(sst->NumBlocks(), 1);
+
+  SSTIterator iter(sst);
+  iter.Seek("key501");
+  ASSERT_TRUE(iter.IsValid());
+  EXPECT_EQ(iter.GetKey(), "key502");
+
+  // 遍历到 SST 末尾
+  int count = 0;
+  for (; iter.IsValid(); ++iter) {
+    count++;
+  }
+  EXPECT_EQ(count, 249);
+
+  // 边界情况
+  iter.Seek("a");
+  EXPECT_EQ(iter.GetKey(), "key000");
+  iter.Seek("key999");
+  EXPECT_FALSE(iter.IsValid());
+
+  // 精确查找不存在的 key
+  EXPECT_FALSE(sst->Get("key501").IsValid());
+  EXPECT_EQ(sst->Get("key500").GetValue(), "value500");
+}
+
+TEST_F(SSTTest, IteratorReverse) {
+  SSTBuilder builder(256);
+  auto block_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  for (int i = 0; i < 1000; i += 2) {
+    char key[8];
+    snprintf(key, sizeof(key), "key%03d", i);
+    builder.Add(key, "value" + std::to_string(i));
+  }
+  auto sst = builder.Build(1, "test_data/reverse.sst", block_cache);
+  ASSERT_GT(sst->NumBlocks(), 1);
+
+  // 从最后一个 key 反向遍历, 跨越多个 block
+  SSTIterator iter(sst);
+  iter.SeekToLast();
+  for (int i = 998; i >= 0; i -= 2) {
+    char key[8];
+    snprintf(key, sizeof(key), "key%03d", i);
+    ASSERT_TRUE(iter.IsValid());
+    EXPECT_EQ(iter.GetKey(), key);
+    EXPECT_EQ(iter.GetValue(), "value" + std::to_string(i));
+    --iter;
+  }
+  EXPECT_FALSE(iter.IsValid());
+
+  // SeekForPrev 定位到不大于 key 的最后一个 key
+  iter.SeekForPrev("key501");
+  ASSERT_TRUE(iter.IsValid());
+  EXPECT_EQ(iter.GetKey(), "key500");
+  iter.SeekForPrev("key500");
+  EXPECT_EQ(iter.GetKey(), "key500");
+  iter.SeekForPrev("zzz");
+  EXPECT_EQ(iter.GetKey(), "key998");
+  iter.SeekForPrev("a");
+  EXPECT_FALSE(iter.IsValid());
+
+  // 正反向交替移动
+  iter.Seek("key100");
+  --iter;
+  EXPECT_EQ(iter.GetKey(), "key098");
+  ++iter;
+  EXPECT_EQ(iter.GetKey(), "key100");
+}
+
+// 测试 bloom filter 和前缀 bloom filter
+TEST_F(SSTTest, PrefixBloomFilter) {
+  auto extractor = std::make_shared<FixedPrefixExtractor>(4);
+  SSTBuilder builder(256, extractor);
+  auto block_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  // 前缀 u000 ~ u198 (偶数), 每个前缀 10 个 key
+  for (int user = 0; user < 200; user += 2) {
+    for (int i = 0; i < 10; i++) {
+      char key[16];
+      snprintf(key, sizeof(key), "u%03d:%02d", user, i);
+      builder.Add(key, "value");
+    }
+  }
+  builder.Build(1, "test_data/prefix.sst", block_cache);
+
+  // 重新打开, filter 从文件中读取
+  auto sst = SST::Open(1, FileObj::Open("test_data/prefix.sst"), block_cache);
+  int false_positives = 0;
+  for (int user = 0; user < 200; user++) {
+    char prefix[8];
+    snprintf(prefix, sizeof(prefix), "u%03d", user);
+    if (user % 2 == 0) {
+      EXPECT_TRUE(sst->PrefixMayMatch(prefix, extractor.get()));
+      EXPECT_TRUE(sst->PrefixMayMatch(std::string(prefix) + ":05", extractor.get()));
+    } else if (sst->PrefixMayMatch(prefix, extractor.get())) {
+      false_positives++;
+    }
+  }
+  EXPECT_LT(false_positives, 10);
+
+  // 不在 extractor 定义域内的前缀无法过滤
+  EXPECT_TRUE(sst->PrefixMayMatch("u1", extractor.get()));
+  // extractor 不一致时不能使用 filter
+  FixedPrefixExtractor other(3);
+  EXPECT_TRUE(sst->PrefixMayMatch("u001", &other));
+  // 超出 SST key 范围的前缀直接过滤
+  EXPECT_FALSE(sst->PrefixMayMatch("v", extractor.get()));
+  EXPECT_FALSE(sst->PrefixMayMatch("a", extractor.get()));
+
+  // 整个 key 同样在 filter 中
+  EXPECT_TRUE(sst->KeyMayMatch("u100:05"));
+  EXPECT_EQ(sst->Get("u100:05").GetValue(), "value");
+  EXPECT_FALSE(sst->Get("u101:05").IsValid());
+}
+
+// 测试分区索引
+TEST_F(SSTTest, PartitionedIndex) {
+  auto block_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  SSTBuilder builder(256);
+  builder.SetIndexPartitionSize(4);
+  for (int i = 0; i < 2000; i++) {
+    char key[16];
+    snprintf(key, sizeof(key), "key%05d", i);
+    builder.Add(key, "value" + std::to_string(i));
+  }
+  auto built = builder.Build(1, "test_data/partitioned.sst", block_cache);
+  size_t num_blocks = built->NumBlocks();
+  ASSERT_GT(num_blocks, 4);
+  EXPECT_EQ(built->NumIndexPartitions(), (num_blocks + 3) / 4);
+
+  // 重新打开, 只有顶层索引常驻内存
+  auto sst = SST::Open(1, FileObj::Open("test_data/partitioned.sst"), block_cache);
+  EXPECT_EQ(sst->NumBlocks(), num_blocks);
+  EXPECT_EQ(sst->NumIndexPartitions(), (num_blocks + 3) / 4);
+  EXPECT_EQ(sst->GetFirstKey(), "key00000");
+  EXPECT_EQ(sst->GetLastKey(), "key01999");
+
+  // 每个 block 的元数据与 block 内容一致
+  for (size_t i = 0; i < num_blocks; i++) {
+    auto meta = sst->GetBlockMeta(i);
+    auto block = sst->ReadBlock(i);
+    EXPECT_EQ(meta.first_key_, block->GetFirstKey());
+    EXPECT_EQ(sst->FindBlockIndex(meta.last_key_), i);
+  }
+
+  // 点查与正反向遍历
+  for (int i = 0; i < 2000; i += 7) {
+    char key[16];
+    snprintf(key, sizeof(key), "key%05d", i);
+    EXPECT_EQ(sst->Get(key).GetValue(), "value" + std::to_string(i));
+  }
+  int count = 0;
+  for (auto it = sst->Begin(); it != sst->End(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(count, 2000);
+  SSTIterator iter(sst);
+  iter.SeekForPrev("key01000a");
+  EXPECT_EQ(iter.GetKey(), "key01000");
+
+  // block 数不超过分区大小时保持单层索引
+  SSTBuilder small_builder(256);
+  small_builder.SetIndexPartitionSize(1024);
+  small_builder.Add("a", "1");
+  auto small_sst = small_builder.Build(2, "test_data/small.sst", block_cache);
+  EXPECT_EQ(small_sst->NumIndexPartitions(), 0);
+}
+
+// 测试从磁盘缓存读取索引分区
+TEST_F(SSTTest, IndexPartitionFromSecondaryCache) {
+  auto block_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  SSTBuilder builder(256);
+  builder.SetIndexPartitionSize(4);
+  for (int i = 0; i < 200; i++) {
+    char key[16];
+    snprintf(key, sizeof(key), "key%05d", i);
+    builder.Add(key, "value" + std::to_string(i));
+  }
+  auto built = builder.Build(1, "test_data/partitioned.sst", block_cache);
+  ASSERT_GT(built->NumIndexPartitions(), 0);
+  EXPECT_EQ(built->Get("key00000").GetValue(), "value0");
+  // 第一个分区在 block cache 中的 id 为 -1, 两次驱逐后写入磁盘缓存
+  auto partition = block_cache->Get(1, -1);
+  ASSERT_NE(partition, nullptr);
+  auto secondary = std::make_shared<SecondaryCache>("test_data/secondary.cache", 1024 * 1024);
+  secondary->Insert(1, -1, partition);
+  ASSERT_TRUE(secondary->Insert(1, -1, partition));
+
+  // 新的 block cache 为空, 分区从磁盘缓存中读出
+  auto cold_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  cold_cache->SetSecondaryCache(secondary);
+  auto sst = SST::Open(1, FileObj::Open("test_data/partitioned.sst"), cold_cache);
+  EXPECT_EQ(sst->Get("key00001").GetValue(), "value1");
+  EXPECT_GT(secondary->GetHitRate(), 0);
+  EXPECT_NE(cold_cache->Get(1, -1), nullptr);
+}
+
+// 测试损坏的 SST 文件
+TEST_F(SSTTest, Checksum) {
+  auto block_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  SSTBuilder builder(4096);
+  builder.Add("key1", "value1");
+  builder.Add("key2", "value2");
+  builder.Build(1, "test_data/checksum.sst", block_cache);
+
+  auto corrupt = [](size_t pos_from_begin, std::optional<size_t> pos_from_end) {
+    std::fstream file("test_data/checksum.sst", std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(0, std::ios::end);
+    auto size = static_cast<size_t>(file.tellg());
+    size_t pos = pos_from_end.has_value() ? size - pos_from_end.value() : pos_from_begin;
+    file.seekg(static_cast<std::streamoff>(pos));
+    char c;
+    file.read(&c, 1);
+    c ^= 1;
+    file.seekp(static_cast<std::streamoff>(pos));
+    file.write(&c, 1);
+  };
+
+  // 修改第一个 value 的最后一个字节: 2 + 4 + 2 + 6
+  corrupt(13, std::nullopt);
+  auto sst = SST::Open(1, FileObj::Open("test_data/checksum.sst"), std::make_shared<BlockCache>(16, 2));
+  EXPECT_THROW(sst->Get("key1"), std::runtime_error);
+  ReadOptions no_verify;
+  no_verify.verify_checksums = false;
+  EXPECT_EQ(sst->Get("key2", no_verify).GetValue(), "value2");
+  // 未校验读出的 block 不进入缓存, 之后校验的读取仍会发现损坏
+  EXPECT_THROW(sst->Get("key2"), std::runtime_error);
+
+  // 未知的格式版本无法打开
+  corrupt(0, 1);
+  EXPECT_THROW(SST::Open(1, FileObj::Open("test_data/checksum.sst"), block_cache), std::runtime_error);
+}
+
+// 测试 O_DIRECT 模式下的 SST 读写
+TEST_F(SSTTest, DirectIO) {
+  auto block_cache = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  SSTBuilder builder(4096);
+  builder.SetDirectIO(true);
+  for (int i = 0; i < 1000; i++) {
+    builder.Add("key" + std::to_string(1000 + i), "value" + std::to_string(i));
+  }
+  auto built = builder.Build(1, "test_data/direct.sst", block_cache);
+
+  auto sst = SST::Open(1, FileObj::Open("test_data/direct.sst", true), std::make_shared<BlockCache>(16, 2));
+  EXPECT_EQ(sst->NumBlocks(), built->NumBlocks());
+  EXPECT_EQ(sst->GetSSTSize(), built->GetSSTSize());
+  int count = 0;
+  for (auto it = sst->Begin(); it != sst->End(); ++it) {
+    EXPECT_EQ((*it).second, "value" + std::to_string(count));
+    count++;
+  }
+  EXPECT_EQ(count, 1000);
+}
+
+// 测试顺序扫描时的预读
+TEST_F(SSTTest, ReadAhead) {
+  SSTBuilder builder(1024);
+  for (int i = 0; i < 5000; i++) {
+    builder.Add("key" + std::to_string(10000 + i), "value" + std::to_string(i));
+  }
+  builder.Build(1, "test_data/readahead.sst", std::make_shared<BlockCache>(16, 2));
+
+  // 一次读取多个相邻的 block
+  auto sst = SST::Open(1, FileObj::Open("test_data/readahead.sst"), std::make_shared<BlockCache>(4096, 2));
+  size_t num_blocks = sst->NumBlocks();
+  ASSERT_GT(num_blocks, 100);
+  EXPECT_EQ(sst->ReadAhead(0, 0), 1);
+  EXPECT_EQ(sst->ReadAhead(num_blocks - 1, 1 << 20), 1);
+  EXPECT_EQ(sst->ReadAhead(1, 1 << 20), num_blocks - 1);
+  for (size_t i = 0; i < num_blocks; i++) {
+    EXPECT_NE(sst->GetCachedBlock(i), nullptr);
+  }
+
+  // 顺序扫描: 第二次切换 block 后开始预读, 预读窗口逐步变大
+  sst = SST::Open(1, FileObj::Open("test_data/readahead.sst"), std::make_shared<BlockCache>(4096, 2));
+  SSTIterator it(sst);
+  int count = 0;
+  while (it.IsValid() && sst->GetCachedBlock(1) == nullptr) {
+    ++it;
+    count++;
+  }
+  EXPECT_EQ(sst->GetCachedBlock(2), nullptr);
+  while (it.IsValid() && sst->GetCachedBlock(2) == nullptr) {
+    ++it;
+    count++;
+  }
+  EXPECT_NE(sst->GetCachedBlock(3), nullptr);
+  size_t first_window = 2;
+  while (sst->GetCachedBlock(first_window + 1) != nullptr) {
+    first_window++;
+  }
+  EXPECT_GT(first_window, 3);
+  EXPECT_LT(first_window, num_blocks - 1);
+  for (; it.IsValid(); ++it) {
+    EXPECT_EQ(it.GetValue(), "value" + std::to_string(count));
+    count++;
+  }
+  EXPECT_EQ(count, 5000);
+
+  // 关闭预读和 Seek 之后的结果一致
+  ReadOptions options;
+  options.max_readahead_size = 0;
+  sst = SST::Open(1, FileObj::Open("test_data/readahead.sst"), std::make_shared<BlockCache>(4096, 2));
+  count = 0;
+  for (SSTIterator it(sst, options); it.IsValid(); ++it) {
+    EXPECT_EQ(it.GetValue(), "value" + std::to_string(count));
+    count++;
+  }
+  EXPECT_EQ(count, 5000);
+  EXPECT_EQ(sst->ReadBlock(num_blocks - 1, options)->GetFirstKey(), sst->GetBlockMeta(num_blocks - 1).first_key_);
+
+  sst = SST::Open(1, FileObj::Open("test_data/readahead.sst"), std::make_shared<BlockCache>(4096, 2));
+  count = 2500;
+  for (SSTIterator it(sst, "key12500"); it.IsValid(); ++it) {
+    EXPECT_EQ(it.GetValue(), "value" + std::to_string(count));
+    count++;
+  }
+  EXPECT_EQ(count, 5000);
+}
+
+// 测试不校验的顺序扫描: 预读的 block 仍然校验并进入缓存
+TEST_F(SSTTest, ReadAheadWithoutVerification) {
+  SSTBuilder builder(1024);
+  for (int i = 0; i < 5000; i++) {
+    builder.Add("key" + std::to_string(10000 + i), "value" + std::to_string(i));
+  }
+  builder.Build(1, "test_data/readahead_no_verify.sst", std::make_shared<BlockCache>(16, 2));
+
+  // 修改第 10 个 block 第一个 value 的第一个字节: 2 + 8 + 2
+  const size_t corrupted_block = 10;
+  auto sst = SST::Open(1, FileObj::Open("test_data/readahead_no_verify.sst"), std::make_shared<BlockCache>(16, 2));
+  size_t offset;
+  size_t size;
+  sst->GetBlockHandle(corrupted_block, &offset, &size);
+  auto corrupted_key = sst->GetBlockMeta(corrupted_block).first_key_;
+  {
+    std::fstream file("test_data/readahead_no_verify.sst", std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(offset + 12));
+    file.put('w');
+  }
+
+  ReadOptions no_verify;
+  no_verify.verify_checksums = false;
+  sst = SST::Open(1, FileObj::Open("test_data/readahead_no_verify.sst"), std::make_shared<BlockCache>(4096, 2));
+  size_t num_blocks = sst->NumBlocks();
+  ASSERT_GT(num_blocks, corrupted_block + 1);
+  int count = 0;
+  for (SSTIterator it(sst, no_verify); it.IsValid(); ++it) {
+    auto expected = "value" + std::to_string(count);
+    if (it.GetKey() == corrupted_key) {
+      expected[0] = 'w';
+    }
+    EXPECT_EQ(it.GetValue(), expected);
+    count++;
+  }
+  EXPECT_EQ(count, 5000);
+  // 预读从第二次切换 block 开始, 校验失败的 block 不进入缓存
+  for (size_t i = 2; i < num_blocks; i++) {
+    EXPECT_EQ(sst->GetCachedBlock(i) == nullptr, i == corrupted_block) << i;
+  }
+  EXPECT_THROW(sst->Get(corrupted_key), std::runtime_error);
+}
+
+// 测试扫描不填充缓存, 以及固定索引分区
+TEST_F(SSTTest, CachePriority) {
+  SSTBuilder builder(256);
+  builder.SetIndexPartitionSize(4);
+  for (int i = 0; i < 1000; i++) {
+    builder.Add("key" + std::to_string(10000 + i), "value" + std::to_string(i));
+  }
+  builder.Build(1, "test_data/priority.sst", std::make_shared<BlockCache>(16, 2));
+
+  auto block_cache = std::make_shared<BlockCache>(64, 2, 0.25, 0.25);
+  auto sst = SST::Open(1, FileObj::Open("test_data/priority.sst"), block_cache);
+  ASSERT_GT(sst->NumIndexPartitions(), 16);
+  ReadOptions options;
+  options.fill_cache = false;
+  int count = 0;
+  for (SSTIterator it(sst, options); it.IsValid(); ++it) {
+    EXPECT_EQ(it.GetValue(), "value" + std::to_string(count));
+    count++;
+  }
+  EXPECT_EQ(count, 1000);
+  EXPECT_EQ(block_cache->GetUsage(CachePriority::kNormal), 0);
+  EXPECT_GT(block_cache->GetUsage(CachePriority::kLow), 0);
+  EXPECT_GT(block_cache->GetUsage(CachePriority::kHigh), 0);
+
+  // 固定的索引分区在 SST 关闭前一直保留
+  sst->SetPinIndex(true);
+  for (int i = 0; i < 1000; i += 10) {
+    auto it = sst->Get("key" + std::to_string(10000 + i));
+    ASSERT_TRUE(it.IsValid());
+    EXPECT_EQ(it.GetValue(), "value" + std::to_string(i));
+  }
+  size_t pinned = block_cache->GetPinnedCount();
+  EXPECT_GT(pinned, 0);
+  // 同一 id 的另一个 SST 对象关闭时不影响已固定的分区
+  auto duplicate = SST::Open(1, FileObj::Open("test_data/priority.sst"), block_cache);
+  duplicate->SetPinIndex(true);
+  duplicate.reset();
+  EXPECT_EQ(block_cache->GetPinnedCount(), pinned);
+  sst.reset();
+  EXPECT_EQ(block_cache->GetPinnedCount(), 0);
+}
+
+// 测试从磁盘缓存读取被驱逐的 block
+TEST_F(SSTTest, SecondaryCache) {
+  SSTBuilder builder(256);
+  for (int i = 0; i < 1000; i++) {
+    builder.Add("key" + std::to_string(10000 + i), "value" + std::to_string(i));
+  }
+  builder.Build(1, "test_data/secondary.sst", std::make_shared<BlockCache>(16, 2));
+
+  auto block_cache = std::make_shared<BlockCache>(4, 2);
+  auto secondary = std::make_shared<SecondaryCache>("test_data/secondary.cache", 1024 * 1024);
+  block_cache->SetSecondaryCache(secondary);
+  auto sst = SST::Open(1, FileObj::Open("test_data/secondary.sst"), block_cache);
+  ReadOptions options;
+  options.max_readahead_size = 0;
+  for (int round = 0; round < 2; round++) {
+    int count = 0;
+    for (SSTIterator it(sst, options); it.IsValid(); ++it) {
+      EXPECT_EQ(it.GetValue(), "value" + std::to_string(count));
+      count++;
+    }
+    EXPECT_EQ(count, 1000);
+  }
+  EXPECT_GT(secondary->Size(), 0);
+  double hit_rate = secondary->GetHitRate();
+
+  // 被驱逐两次的 block 从磁盘缓存读出
+  EXPECT_EQ(block_cache->Get(1, 0), nullptr);
+  auto block = sst->ReadBlock(0);
+  EXPECT_EQ(block->GetFirstKey(), "key10000");
+  EXPECT_GT(secondary->GetHitRate(), hit_rate);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
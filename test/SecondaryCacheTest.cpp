@@ -0,0 +1,98 @@
+#include <block/Block.h>
+#include <block/BlockCache.h>
+#include <block/SecondaryCache.h>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+class SecondaryCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override { std::filesystem::create_directories("test_data"); }
+  void TearDown() override { std::filesystem::remove_all("test_data"); }
+
+  static std::shared_ptr<Block> MakeBlock(int id) {
+    auto block = std::make_shared<Block>(4096);
+    for (int i = 0; i < 20; i++) {
+      block->AddEntry("key" + std::to_string(id * 100 + i), "value" + std::to_string(id));
+    }
+    return block;
+  }
+};
+
+TEST_F(SecondaryCacheTest, AdmitOnSecondEviction) {
+  SecondaryCache cache("test_data/secondary.cache", 1024 * 1024);
+  auto block = MakeBlock(1);
+  // 第一次驱逐只记录 key, 第二次才写入磁盘
+  EXPECT_FALSE(cache.Insert(1, 1, block));
+  EXPECT_EQ(cache.Lookup(1, 1), nullptr);
+  EXPECT_TRUE(cache.Insert(1, 1, block));
+  EXPECT_FALSE(cache.Insert(1, 1, block));
+  EXPECT_EQ(cache.Size(), 1);
+
+  auto res = cache.Lookup(1, 1);
+  ASSERT_NE(res, nullptr);
+  EXPECT_EQ(res->NumEntries(), 20);
+  EXPECT_EQ(res->FindValue("key105"), "value1");
+  EXPECT_DOUBLE_EQ(cache.GetHitRate(), 0.5);
+
+  // 记录的 key 数量有限
+  SecondaryCache small("test_data/small.cache", 1024 * 1024, 2);
+  EXPECT_FALSE(small.Insert(1, 1, block));
+  EXPECT_FALSE(small.Insert(1, 2, block));
+  EXPECT_FALSE(small.Insert(1, 3, block));
+  EXPECT_FALSE(small.Insert(1, 1, block));
+  EXPECT_TRUE(small.Insert(1, 3, block));
+}
+
+TEST_F(SecondaryCacheTest, WrapAround) {
+  // 空间不足时覆盖最早写入的记录
+  SecondaryCache cache("test_data/secondary.cache", 1024);
+  for (int i = 0; i < 50; i++) {
+    cache.Insert(1, i, MakeBlock(i));
+    cache.Insert(1, i, MakeBlock(i));
+  }
+  EXPECT_GT(cache.Size(), 0);
+  EXPECT_LT(cache.Size(), 50);
+  EXPECT_EQ(cache.Lookup(1, 0), nullptr);
+  auto res = cache.Lookup(1, 49);
+  ASSERT_NE(res, nullptr);
+  EXPECT_EQ(res->FindValue("key4900"), "value49");
+  EXPECT_LE(std::filesystem::file_size("test_data/secondary.cache"), 1024);
+
+  cache.Erase(1);
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_EQ(cache.Lookup(1, 49), nullptr);
+}
+
+TEST_F(SecondaryCacheTest, BehindBlockCache) {
+  auto secondary = std::make_shared<SecondaryCache>("test_data/secondary.cache", 1024 * 1024);
+  BlockCache cache(2, 2);
+  cache.SetSecondaryCache(secondary);
+  EXPECT_EQ(cache.GetSecondaryCache(), secondary);
+
+  // 每个 block 被驱逐两次
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < 4; i++) {
+      cache.Put(1, i, MakeBlock(i));
+    }
+  }
+  EXPECT_EQ(secondary->Size(), 2);
+  EXPECT_EQ(cache.Get(1, 0), nullptr);
+  auto res = secondary->Lookup(1, 0);
+  ASSERT_NE(res, nullptr);
+  EXPECT_EQ(res->FindValue("key0"), "value0");
+
+  // 低优先级的 block 不进入磁盘缓存
+  for (int round = 0; round < 2; round++) {
+    for (int i = 10; i < 14; i++) {
+      cache.Put(1, i, MakeBlock(i), CachePriority::kLow);
+    }
+  }
+  EXPECT_EQ(secondary->Lookup(1, 10), nullptr);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -167,6 +167,99 @@ TEST(SkipListTest, MemorySizeTracking) {
   EXPECT_EQ(skip_list.UsedBytes(), 0);
 }
 
+// 测试实际分配的内存, 包括节点和指针
+TEST(SkipListTest, AllocatedBytes) {
+  KeyComparator<std::string> key_comparator;
+  SkipList<std::string, std::string, KeyComparator<std::string>> skip_list(key_comparator);
+  size_t empty_bytes = skip_list.AllocatedBytes();
+  EXPECT_GT(empty_bytes, 0);
+
+  for (int i = 0; i < 1000; i++) {
+    skip_list.Put("key" + std::to_string(i), "value" + std::to_string(i));
+  }
+  // 小的 key 和 value 的节点开销远大于数据本身
+  EXPECT_GT(skip_list.AllocatedBytes() - empty_bytes, 4 * skip_list.UsedBytes());
+
+  // 覆盖写时更新大小
+  size_t used = skip_list.UsedBytes();
+  size_t allocated = skip_list.AllocatedBytes();
+  skip_list.Put("key1", std::string(1000, 'v'));
+  EXPECT_EQ(skip_list.UsedBytes(), used + 1000 - 6);
+  EXPECT_GT(skip_list.AllocatedBytes(), allocated + 1000);
+  // 缩短的 value 仍然持有原来的缓冲区
+  skip_list.Put("key1", "value1");
+  EXPECT_EQ(skip_list.UsedBytes(), used);
+  EXPECT_GT(skip_list.AllocatedBytes(), allocated + 1000);
+
+  for (int i = 0; i < 1000; i++) {
+    skip_list.Remove("key" + std::to_string(i));
+  }
+  EXPECT_EQ(skip_list.AllocatedBytes(), empty_bytes);
+  skip_list.Put("key", "value");
+  skip_list.Clear();
+  EXPECT_EQ(skip_list.AllocatedBytes(), empty_bytes);
+}
+
+// 测试 Seek 定位到第一个不小于目标的 key
+TEST(SkipListTest, Seek) {
+  KeyComparator<std::string> key_comparator;
+  SkipList<std::string, std::string, KeyComparator<std::string>> skip_list(key_comparator);
+  for (int i = 0; i < 1000; i += 2) {
+    char key[8];
+    snprintf(key, sizeof(key), "key%03d", i);
+    skip_list.Put(key, std::to_string(i));
+  }
+
+  // 命中已存在的 key
+  EXPECT_EQ(skip_list.Seek("key100").GetKey(), "key100");
+  // 不存在的 key 定位到后继
+  EXPECT_EQ(skip_list.Seek("key101").GetKey(), "key102");
+  EXPECT_EQ(skip_list.Seek("a").GetKey(), "key000");
+  // 超过最大 key 时返回 End
+  EXPECT_TRUE(skip_list.Seek("key999") == skip_list.End());
+
+  // 从 Seek 的位置继续遍历
+  auto it = skip_list.Seek("key497");
+  for (int i = 498; i < 1000; i += 2) {
+    char key[8];
+    snprintf(key, sizeof(key), "key%03d", i);
+    ASSERT_TRUE(it != skip_list.End());
+    EXPECT_EQ(it.GetKey(), key);
+    ++it;
+  }
+  EXPECT_TRUE(it == skip_list.End());
+}
+
+TEST(SkipListTest, ReverseIterator) {
+  KeyComparator<std::string> key_comparator;
+  SkipList<std::string, std::string, KeyComparator<std::string>> skip_list(key_comparator);
+  // 空表的反向起点就是 REnd
+  EXPECT_TRUE(skip_list.RBegin() == skip_list.REnd());
+
+  for (int i = 0; i < 1000; i += 2) {
+    char key[8];
+    snprintf(key, sizeof(key), "key%03d", i);
+    skip_list.Put(key, std::to_string(i));
+  }
+
+  // 从最后一个元素反向遍历
+  auto it = skip_list.RBegin();
+  for (int i = 998; i >= 0; i -= 2) {
+    char key[8];
+    snprintf(key, sizeof(key), "key%03d", i);
+    ASSERT_TRUE(it != skip_list.REnd());
+    EXPECT_EQ(it.GetKey(), key);
+    --it;
+  }
+  EXPECT_TRUE(it == skip_list.REnd());
+
+  // SeekForPrev 定位到不大于 key 的最后一个元素
+  EXPECT_EQ(skip_list.SeekForPrev("key100").GetKey(), "key100");
+  EXPECT_EQ(skip_list.SeekForPrev("key101").GetKey(), "key100");
+  EXPECT_EQ(skip_list.SeekForPrev("zzz").GetKey(), "key998");
+  EXPECT_TRUE(skip_list.SeekForPrev("a") == skip_list.REnd());
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
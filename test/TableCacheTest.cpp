@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <sst/SSTIterator.h>
+#include <sst/TableCache.h>
+#include <utils/Macro.h>
+#include <filesystem>
+
+class TableCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!std::filesystem::exists(test_dir_)) {
+      std::filesystem::create_directory(test_dir_);
+    }
+    block_cache_ = std::make_shared<BlockCache>(BLOCK_CACHE_CAPACITY, BLOCK_CACHE_K);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(test_dir_); }
+
+  // build an SST file with keys "<sst_id>_key<i>" and drop the in-memory handle
+  void BuildSST(TableCache &cache, size_t sst_id, size_t num_entries) {
+    SSTBuilder builder(256);
+    for (size_t i = 0; i < num_entries; i++) {
+      builder.Add(std::to_string(sst_id) + "_key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    builder.Build(sst_id, cache.GetSSTPath(sst_id), block_cache_);
+  }
+
+  std::string test_dir_ = "test_table_cache_data";
+  std::shared_ptr<BlockCache> block_cache_;
+};
+
+TEST_F(TableCacheTest, LazyOpen) {
+  TableCache cache(test_dir_, 4, block_cache_);
+  BuildSST(cache, 1, 10);
+  EXPECT_EQ(cache.Size(), 0);
+
+  auto sst = cache.FindTable(1);
+  ASSERT_NE(sst, nullptr);
+  EXPECT_EQ(cache.Size(), 1);
+  EXPECT_EQ(sst->GetFirstKey(), "1_key0");
+  EXPECT_EQ(sst->Get("1_key5").GetValue(), "value5");
+
+  // the second lookup is served from the cache
+  EXPECT_EQ(cache.FindTable(1), sst);
+  EXPECT_DOUBLE_EQ(cache.GetHitRate(), 0.5);
+}
+
+TEST_F(TableCacheTest, EvictLeastRecentlyUsed) {
+  TableCache cache(test_dir_, 2, block_cache_);
+  for (size_t id = 0; id < 3; id++) {
+    BuildSST(cache, id, 10);
+  }
+
+  auto sst0 = cache.FindTable(0);
+  auto sst1 = cache.FindTable(1);
+  cache.FindTable(0);  // sst 1 becomes the least recently used one
+  cache.FindTable(2);
+  EXPECT_EQ(cache.Size(), 2);
+
+  // sst 0 is still cached, sst 1 has to be reopened
+  EXPECT_EQ(cache.FindTable(0), sst0);
+  auto reopened = cache.FindTable(1);
+  EXPECT_NE(reopened, sst1);
+  EXPECT_EQ(reopened->GetLastKey(), sst1->GetLastKey());
+
+  // an evicted table is still readable by the one holding it
+  EXPECT_EQ(sst1->Get("1_key3").GetValue(), "value3");
+}
+
+TEST_F(TableCacheTest, InsertAndErase) {
+  TableCache cache(test_dir_, 2, block_cache_);
+  SSTBuilder builder(256);
+  builder.Add("a", "1");
+  builder.Add("b", "2");
+  auto sst = builder.Build(7, cache.GetSSTPath(7), block_cache_);
+
+  cache.Insert(sst);
+  EXPECT_EQ(cache.FindTable(7), sst);
+
+  cache.Erase(7);
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_NE(cache.FindTable(7), sst);
+}
+
+TEST_F(TableCacheTest, MissingFile) {
+  TableCache cache(test_dir_, 2, block_cache_);
+  EXPECT_THROW(cache.FindTable(42), std::runtime_error);
+  EXPECT_EQ(cache.Size(), 0);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
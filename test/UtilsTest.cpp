@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
+#include <utils/AlignedBufferPool.h>
+#include <utils/CompactionFilter.h>
+#include <utils/Crc32c.h>
 #include <utils/File.h>
+#include <utils/MergeOperator.h>
+#include <utils/Options.h>
 #include <filesystem>
 #include <random>
 class FileTest : public ::testing::Test {
@@ -129,7 +134,173 @@ TEST_F(FileTest, MoveSemantics) {
   EXPECT_EQ(read_data, data);
 }
 
+// 测试 O_DIRECT 模式的读写
+TEST_F(FileTest, DirectIO) {
+  const std::string path = "test_data/direct.dat";
+  // 大小不是扇区的整数倍
+  auto data = GenerateRandomData(3 * 4096 + 123);
+  auto file = FileObj::CreateAndWrite(path, data, true);
+  EXPECT_EQ(file.Size(), data.size());
+
+  auto opened_file = FileObj::Open(path, true);
+  EXPECT_EQ(opened_file.Size(), data.size());
+  EXPECT_EQ(opened_file.Read(0, data.size()), data);
+  // 读取跨越扇区边界的非对齐区间
+  for (auto [offset, size] : std::vector<std::pair<size_t, size_t>>{{1, 10}, {4090, 20}, {8192, 4096}, {12300, 111}}) {
+    std::vector<uint8_t> expected(data.begin() + offset, data.begin() + offset + size);
+    EXPECT_EQ(opened_file.Read(offset, size), expected);
+  }
+  EXPECT_THROW(opened_file.Read(data.size() - 1, 2), std::out_of_range);
+
+  // 与普通模式读取的结果一致
+  auto std_file = FileObj::Open(path);
+  EXPECT_EQ(std_file.Read(4000, 5000), opened_file.Read(4000, 5000));
+}
+
+// 测试非对齐写入不会破坏相邻的数据
+TEST_F(FileTest, DirectIOUnalignedWrite) {
+  DirectFileOperator file;
+  ASSERT_TRUE(file.Open("test_data/direct_write.dat", true));
+  auto data = GenerateRandomData(10000);
+  ASSERT_TRUE(file.Write(0, data.data(), data.size()));
+
+  std::vector<uint8_t> patch(5000, 0xab);
+  ASSERT_TRUE(file.Write(3000, patch.data(), patch.size()));
+  std::copy(patch.begin(), patch.end(), data.begin() + 3000);
+  // 追加到文件末尾之后
+  ASSERT_TRUE(file.Write(9990, patch.data(), 100));
+  data.resize(10090);
+  std::copy(patch.begin(), patch.begin() + 100, data.begin() + 9990);
+
+  EXPECT_EQ(file.Size(), data.size());
+  EXPECT_EQ(file.Read(0, data.size()), data);
+}
+
+// 测试对齐缓冲区的复用
+TEST(AlignedBufferPoolTest, Reuse) {
+  AlignedBufferPool pool(4096, 16 * 4096);
+  uint8_t *first;
+  {
+    auto buffer = pool.Acquire(100);
+    EXPECT_EQ(buffer.Capacity(), 4096);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.Data()) % 4096, 0);
+    first = buffer.Data();
+  }
+  EXPECT_EQ(pool.GetCachedBytes(), 4096);
+  {
+    auto buffer = pool.Acquire(4000);
+    EXPECT_EQ(buffer.Data(), first);
+    EXPECT_EQ(pool.GetCachedBytes(), 0);
+  }
+
+  // 超过缓存上限的缓冲区直接释放
+  {
+    auto buffer = pool.Acquire(32 * 4096);
+  }
+  EXPECT_EQ(pool.GetCachedBytes(), 4096);
+}
+
+// 测试 CRC32C 的标准测试向量以及软硬件实现的一致性
+TEST(Crc32cTest, KnownValues) {
+  std::string digits = "123456789";
+  EXPECT_EQ(Crc32c::Value(reinterpret_cast<const uint8_t *>(digits.data()), digits.size()), 0xe3069283U);
+
+  std::vector<uint8_t> zeros(32, 0);
+  EXPECT_EQ(Crc32c::Value(zeros.data(), zeros.size()), 0x8a9136aaU);
+  std::vector<uint8_t> ones(32, 0xff);
+  EXPECT_EQ(Crc32c::Value(ones.data(), ones.size()), 0x62a8ab43U);
+  EXPECT_EQ(Crc32c::Value(nullptr, 0), 0U);
+}
+
+TEST(Crc32cTest, ExtendAndPortable) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<> dis(0, 255);
+  std::vector<uint8_t> data(1027);
+  for (auto &byte : data) {
+    byte = static_cast<uint8_t>(dis(gen));
+  }
+
+  for (size_t len : {0, 1, 7, 8, 9, 63, 64, 1027}) {
+    uint32_t crc = Crc32c::Value(data.data(), len);
+    EXPECT_EQ(crc, Crc32c::ExtendPortable(0, data.data(), len));
+    // 分段计算与整体计算结果一致
+    size_t half = len / 2;
+    EXPECT_EQ(crc, Crc32c::Extend(Crc32c::Value(data.data(), half), data.data() + half, len - half));
+  }
+}
+
+TEST(TTLCompactionFilterTest, WriteTime) {
+  TTLCompactionFilter filter(10);
+  auto value = TTLCompactionFilter::AppendWriteTime("value", 1000);
+  EXPECT_EQ(value.size(), 5 + sizeof(uint64_t));
+  EXPECT_EQ(TTLCompactionFilter::GetWriteTime(value), 1000);
+  EXPECT_EQ(TTLCompactionFilter::StripWriteTime(value), "value");
+
+  // 写入后的 ttl 秒内不过期
+  EXPECT_FALSE(filter.IsExpired(value, 1000));
+  EXPECT_FALSE(filter.IsExpired(value, 1010));
+  EXPECT_TRUE(filter.IsExpired(value, 1011));
+
+  std::string new_value;
+  auto now = TTLCompactionFilter::Now();
+  EXPECT_EQ(filter.Filter("key", TTLCompactionFilter::AppendWriteTime("v", now), &new_value),
+            CompactionFilter::Decision::kKeep);
+  EXPECT_EQ(filter.Filter("key", TTLCompactionFilter::AppendWriteTime("v", now - 11), &new_value),
+            CompactionFilter::Decision::kRemove);
+  EXPECT_THROW(TTLCompactionFilter::GetWriteTime("abc"), std::runtime_error);
+}
+
+TEST(MergeOperatorTest, BuiltIn) {
+  UInt64AddOperator add;
+  EXPECT_EQ(UInt64AddOperator::DecodeValue(add.Merge("key", std::nullopt, UInt64AddOperator::EncodeValue(3))), 3);
+  auto sum = add.Merge("key", UInt64AddOperator::EncodeValue(5), UInt64AddOperator::EncodeValue(3));
+  EXPECT_EQ(UInt64AddOperator::DecodeValue(sum), 8);
+  EXPECT_EQ(UInt64AddOperator::DecodeValue("bad"), 0);
+
+  // 结合律: 先合并操作数再合并到值上, 结果相同
+  StringAppendOperator append(",");
+  EXPECT_EQ(append.Merge("key", std::nullopt, "a"), "a");
+  EXPECT_EQ(append.Merge("key", append.Merge("key", "a", "b"), "c"),
+            append.Merge("key", "a", append.Merge("key", "b", "c")));
+}
+
+TEST(OptionsTest, SetByName) {
+  ColumnFamilyOptions options;
+  SetColumnFamilyOptions(&options, {{"write_buffer_size", "1048576"},
+                                    {"level0_file_num_compaction_trigger", "8"},
+                                    {"universal.size_ratio", "10"},
+                                    {"blob_garbage_collection_age_cutoff", "0.5"}});
+  EXPECT_EQ(options.write_buffer_size, 1048576);
+  EXPECT_EQ(options.level0_file_num_compaction_trigger, 8);
+  EXPECT_EQ(options.universal.size_ratio, 10);
+  EXPECT_DOUBLE_EQ(options.blob_garbage_collection_age_cutoff, 0.5);
+
+  // 出错时一个选项都不修改
+  EXPECT_THROW(SetColumnFamilyOptions(&options, {{"level0_stop_writes_trigger", "10"}, {"ttl", "60"}}),
+               std::invalid_argument);
+  EXPECT_THROW(SetColumnFamilyOptions(&options, {{"level0_stop_writes_trigger", "10"}, {"min_blob_size", "1k"}}),
+               std::invalid_argument);
+  EXPECT_EQ(options.level0_stop_writes_trigger, LSM_L0_STOP_TRIGGER);
+  EXPECT_THROW(SetColumnFamilyOptions(&options, {{"level0_stop_writes_trigger", "-1"}}), std::invalid_argument);
+  EXPECT_THROW(SetColumnFamilyOptions(&options, {{"universal.size_ratio", "99999999999"}}), std::invalid_argument);
+  EXPECT_THROW(SetColumnFamilyOptions(&options, {{"write_buffer_size", "0"}}), std::invalid_argument);
+  EXPECT_THROW(SetColumnFamilyOptions(&options, {{"blob_garbage_collection_age_cutoff", "2"}}),
+               std::invalid_argument);
+  EXPECT_THROW(SetColumnFamilyOptions(&options, {{"blob_garbage_collection_age_cutoff", "nan"}}),
+               std::invalid_argument);
+  EXPECT_THROW(SetColumnFamilyOptions(&options, {{"blob_garbage_collection_age_cutoff", "inf"}}),
+               std::invalid_argument);
+
+  Options db_options;
+  SetDBOptions(&db_options, {{"block_cache_capacity", "64"}, {"delayed_write_rate", "1024"}});
+  EXPECT_EQ(db_options.block_cache_capacity, 64);
+  EXPECT_EQ(db_options.delayed_write_rate, 1024);
+  // 列族选项和打开后不能修改的选项不接受
+  EXPECT_THROW(SetDBOptions(&db_options, {{"write_buffer_size", "1024"}}), std::invalid_argument);
+  EXPECT_THROW(SetDBOptions(&db_options, {{"row_cache_shards", "4"}}), std::invalid_argument);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <lsm/WriteController.h>
+
+TEST(WriteControllerTest, DelayByRate) {
+  WriteController controller(1000000);
+  // 未减速时不等待
+  EXPECT_EQ(controller.GetState(), WriteStall::kNone);
+  EXPECT_EQ(controller.GetDelay(100000), 0);
+
+  controller.SetState(WriteStall::kDelayed);
+  EXPECT_EQ(controller.GetCurrentRate(), 1000000);
+  auto delay = controller.GetDelay(100000);
+  EXPECT_GT(delay, 90000);
+  EXPECT_LE(delay, 100000);
+  // 没有睡眠的写入累积等待时间
+  EXPECT_GT(controller.GetDelay(100000), 190000);
+
+  // 很短的等待先记下, 累积后再由后续的写入等待
+  WriteController small(1000000);
+  small.SetState(WriteStall::kDelayed);
+  EXPECT_EQ(small.GetDelay(100), 0);
+  uint64_t total = 0;
+  for (int i = 0; i < 20; i++) {
+    total += small.GetDelay(100);
+  }
+  EXPECT_GT(total, 0);
+
+  controller.SetState(WriteStall::kStopped);
+  EXPECT_EQ(controller.GetDelay(100000), 0);
+}
+
+TEST(WriteControllerTest, SmoothSeverity) {
+  // 越接近停止阈值, 写入速率越低
+  WriteController controller(1000000);
+  uint64_t last_rate = controller.GetCurrentRate();
+  for (double severity : {0.25, 0.5, 0.75, 0.99}) {
+    controller.SetState(WriteStall::kDelayed, severity);
+    EXPECT_LT(controller.GetCurrentRate(), last_rate);
+    last_rate = controller.GetCurrentRate();
+  }
+  EXPECT_GE(last_rate, 100000);
+
+  WriteController slow(1000000);
+  slow.SetState(WriteStall::kDelayed, 0.5);
+  WriteController fast(1000000);
+  fast.SetState(WriteStall::kDelayed, 0);
+  EXPECT_GT(slow.GetDelay(100000), fast.GetDelay(100000));
+}
+
+TEST(WriteControllerTest, Stats) {
+  WriteController controller;
+  controller.RecordDelay(100);
+  controller.RecordDelay(50);
+  controller.RecordStop(1000);
+  auto stats = controller.GetStats();
+  EXPECT_EQ(stats.delayed_writes, 2);
+  EXPECT_EQ(stats.delay_micros, 150);
+  EXPECT_EQ(stats.stopped_writes, 1);
+  EXPECT_EQ(stats.stop_micros, 1000);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
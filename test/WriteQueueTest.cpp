@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <lsm/WriteQueue.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+WriteBatch MakeBatch(const std::string &key, size_t count) {
+  WriteBatch batch;
+  for (size_t i = 0; i < count; i++) {
+    batch.Put(key + std::to_string(i), "value");
+  }
+  return batch;
+}
+}  // namespace
+
+TEST(WriteQueueTest, SequenceOrder) {
+  std::mutex mutex;
+  std::vector<uint64_t> logged;
+  std::vector<uint64_t> applied;
+  auto record = [&mutex](std::vector<uint64_t> *sequences) {
+    return [&mutex, sequences](const std::vector<WriteQueue::Writer *> &group) {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto *writer : group) {
+        for (size_t i = 0; i < writer->batch_->Count(); i++) {
+          sequences->push_back(writer->sequence_ + i);
+        }
+      }
+    };
+  };
+  WriteQueue queue(record(&logged), record(&applied), 100);
+
+  // 多个线程并发写入, 每个 batch 的条目占用连续的序号
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&queue, t]() {
+      for (int i = 0; i < 200; i++) {
+        auto batch = MakeBatch("key" + std::to_string(t), i % 3 + 1);
+        queue.Write(batch);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // 两个阶段都按序号顺序处理, 序号从 101 开始没有空洞
+  ASSERT_EQ(logged.size(), applied.size());
+  for (size_t i = 0; i < applied.size(); i++) {
+    EXPECT_EQ(logged[i], 101 + i);
+    EXPECT_EQ(applied[i], 101 + i);
+  }
+  EXPECT_EQ(queue.GetLastSequence(), 100 + applied.size());
+  auto stats = queue.GetStats();
+  EXPECT_EQ(stats.writes, 1600);
+  EXPECT_LE(stats.groups, stats.writes);
+}
+
+TEST(WriteQueueTest, Pipeline) {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool second_logging = false;
+  std::atomic<int> log_calls{0};
+  std::atomic<bool> first_applying{false};
+  bool overlapped = false;
+
+  WriteQueue queue(
+      [&](const std::vector<WriteQueue::Writer *> &) {
+        if (log_calls++ == 1) {
+          std::lock_guard<std::mutex> lock(mutex);
+          second_logging = true;
+          cv.notify_all();
+        }
+      },
+      [&](const std::vector<WriteQueue::Writer *> &group) {
+        if (group[0]->sequence_ == 1) {
+          // 第一组插入 memtable 时, 第二组应能同时写日志
+          first_applying = true;
+          std::unique_lock<std::mutex> lock(mutex);
+          overlapped = cv.wait_for(lock, std::chrono::seconds(5), [&] { return second_logging; });
+        }
+      });
+
+  auto first_batch = MakeBatch("a", 1);
+  auto second_batch = MakeBatch("b", 1);
+  std::thread first([&]() { queue.Write(first_batch); });
+  while (!first_applying) {
+    std::this_thread::yield();
+  }
+  std::thread second([&]() { queue.Write(second_batch); });
+  first.join();
+  second.join();
+  EXPECT_TRUE(overlapped);
+  EXPECT_EQ(queue.GetStats().groups, 2);
+}
+
+TEST(WriteQueueTest, Grouping) {
+  constexpr int WRITERS = 8;
+  std::atomic<int> started{0};
+  std::atomic<int> log_calls{0};
+  std::vector<size_t> group_sizes;
+  WriteQueue queue(
+      [&](const std::vector<WriteQueue::Writer *> &group) {
+        if (log_calls++ == 0) {
+          // 第一组写日志期间, 其余写入在队列中排队
+          while (started < WRITERS) {
+            std::this_thread::yield();
+          }
+          std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        group_sizes.push_back(group.size());
+      },
+      [](const std::vector<WriteQueue::Writer *> &) {});
+
+  auto batch = MakeBatch("key", 1);
+  std::thread leader([&]() { queue.Write(batch); });
+  while (log_calls == 0) {
+    std::this_thread::yield();
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < WRITERS; i++) {
+    threads.emplace_back([&]() {
+      started++;
+      queue.Write(batch);
+    });
+  }
+  leader.join();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // 排队的写入由下一个 leader 作为一组写入日志
+  ASSERT_EQ(group_sizes.size(), 2);
+  EXPECT_EQ(group_sizes[0], 1);
+  EXPECT_EQ(group_sizes[1], WRITERS);
+  EXPECT_EQ(queue.GetStats().writes, WRITERS + 1);
+
+  // 超过 max_group_bytes 的 batch 分到不同的组
+  std::vector<size_t> small_groups;
+  WriteQueue small(
+      [&](const std::vector<WriteQueue::Writer *> &group) { small_groups.push_back(group.size()); },
+      [](const std::vector<WriteQueue::Writer *> &) {}, 0, 1);
+  small.Write(batch);
+  EXPECT_EQ(small_groups, std::vector<size_t>{1});
+}
+
+TEST(WriteQueueTest, Error) {
+  std::vector<uint64_t> applied;
+  WriteQueue queue(
+      [](const std::vector<WriteQueue::Writer *> &group) {
+        if (group[0]->batch_->GetEntries()[0].key_ == "bad0") {
+          throw std::runtime_error("log failed");
+        }
+      },
+      [&](const std::vector<WriteQueue::Writer *> &group) { applied.push_back(group[0]->sequence_); });
+
+  // 写日志失败的组不插入 memtable, 之后的写入不受影响
+  auto bad = MakeBatch("bad", 1);
+  auto good = MakeBatch("good", 1);
+  EXPECT_THROW(queue.Write(bad), std::runtime_error);
+  queue.Write(good);
+  EXPECT_EQ(applied, std::vector<uint64_t>{2});
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}